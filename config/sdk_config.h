@@ -70,6 +70,186 @@
 // </h>
 //==========================================================
 
+// <h> Secure Bootloader Configuration
+
+//==========================================================
+// <q> SECURE_KEY_DERIVATION_ENABLED  - Derive purpose-bound keys from the device root key before starting the application.
+
+
+// <i> The keys are derived with the CryptoCell AES-CMAC KDF while the KDR
+// <i> registers are loaded and are handed to the application in the
+// <i> retained handoff area at the end of RAM.
+
+#ifndef SECURE_KEY_DERIVATION_ENABLED
+#define SECURE_KEY_DERIVATION_ENABLED 1
+#endif
+
+// <e> MEASURED_BOOT_ENABLED - Measure the bootloader, its settings and the application before starting the application.
+
+// <i> The SHA-256 measurements and the hash chain extended from them
+// <i> are published in the handoff area for attestation.
+//==========================================================
+#ifndef MEASURED_BOOT_ENABLED
+#define MEASURED_BOOT_ENABLED 1
+#endif
+
+// </e>
+
+// <e> DFU_POWER_IDLE_ENABLED - Low power handling while waiting in DFU mode.
+
+// <i> Tracks the power state from the DFU and USB events, slows down
+// <i> the LED while no transport is active and logs the estimated current.
+//==========================================================
+#ifndef DFU_POWER_IDLE_ENABLED
+#define DFU_POWER_IDLE_ENABLED 1
+#endif
+// <q> DFU_POWER_DCDC_ENABLED  - Use the DCDC regulator. Requires the DCDC inductor on the board.
+
+
+#ifndef DFU_POWER_DCDC_ENABLED
+#define DFU_POWER_DCDC_ENABLED 1
+#endif
+
+// <o> DFU_LED_CONFIG_IDLE_BLINK_MS - Active and Inactive period of LED blinking when no DFU transport is active.
+#ifndef DFU_LED_CONFIG_IDLE_BLINK_MS
+#define DFU_LED_CONFIG_IDLE_BLINK_MS 1000
+#endif
+
+// <o> DFU_POWER_CURRENT_ACTIVE_UA - Estimated current in uA while a DFU is in progress.
+#ifndef DFU_POWER_CURRENT_ACTIVE_UA
+#define DFU_POWER_CURRENT_ACTIVE_UA 6000
+#endif
+
+// <o> DFU_POWER_CURRENT_IDLE_UA - Estimated current in uA while USB is configured but idle.
+#ifndef DFU_POWER_CURRENT_IDLE_UA
+#define DFU_POWER_CURRENT_IDLE_UA 1500
+#endif
+
+// <o> DFU_POWER_CURRENT_SUSPENDED_UA - Estimated current in uA while USB is suspended.
+#ifndef DFU_POWER_CURRENT_SUSPENDED_UA
+#define DFU_POWER_CURRENT_SUSPENDED_UA 300
+#endif
+
+// <o> DFU_POWER_CURRENT_DETACHED_UA - Estimated current in uA without USB power, LED excluded.
+#ifndef DFU_POWER_CURRENT_DETACHED_UA
+#define DFU_POWER_CURRENT_DETACHED_UA 5
+#endif
+
+// </e>
+
+// <q> TRACE_ENABLED  - Binary trace into a ring buffer in retained RAM.
+
+
+// <i> Call sites only store a string ID and raw arguments, the trace is
+// <i> decoded on the host with tools/trace_decode.py and the ELF file.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// <q> BOOT_PROBES_ENABLED  - Cycle count probes for the bootloader stages in debug builds.
+
+
+// <i> Only compiled in with NRF_DFU_DEBUG_VERSION. The probes are logged
+// <i> when entering and leaving DFU mode and returned for bulk request 0x52.
+
+#ifndef BOOT_PROBES_ENABLED
+#define BOOT_PROBES_ENABLED 1
+#endif
+
+// <e> NRF_DFU_SETTINGS_LOG_ENABLED - Append settings changes to the settings page instead of rewriting it.
+
+// <i> The page holds a snapshot in the SDK format followed by records of
+// <i> the changed bytes and is only erased when it is full.
+//==========================================================
+#ifndef NRF_DFU_SETTINGS_LOG_ENABLED
+#define NRF_DFU_SETTINGS_LOG_ENABLED 1
+#endif
+// <o> NRF_DFU_SETTINGS_LOG_RECORD_MAX - Maximum size of a record in bytes, larger changes rewrite the page.
+#ifndef NRF_DFU_SETTINGS_LOG_RECORD_MAX
+#define NRF_DFU_SETTINGS_LOG_RECORD_MAX 256
+#endif
+
+// <o> NRF_DFU_PROGRESS_CHECKPOINT_SIZE - Firmware bytes between saved progress checkpoints.
+// <i> Used with NRF_DFU_SAVE_PROGRESS_IN_FLASH. An interrupted transfer
+// <i> resumes from the last checkpoint. Should be a multiple of the data object size.
+
+#ifndef NRF_DFU_PROGRESS_CHECKPOINT_SIZE
+#define NRF_DFU_PROGRESS_CHECKPOINT_SIZE 16384
+#endif
+
+// </e>
+
+// <q> RAMFUNC_ENABLED  - Run the USB interrupt, SLIP and NVMC code from RAM in DFU mode.
+
+
+// <i> USB transfers in flight keep moving while the NVMC erases or writes
+// <i> flash. Costs RAM for the code, see ramfunc.h for what is moved.
+
+#ifndef RAMFUNC_ENABLED
+#define RAMFUNC_ENABLED 0
+#endif
+
+// <e> NVMC_PARTIAL_ERASE_ENABLED - Erase flash pages in slices and process USB events in between.
+
+// <i> Uses ERASEPAGEPARTIAL of the nRF52840 NVMC instead of blocking
+// <i> the CPU for the whole page erase time (85 ms).
+//==========================================================
+#ifndef NVMC_PARTIAL_ERASE_ENABLED
+#define NVMC_PARTIAL_ERASE_ENABLED 1
+#endif
+// <o> NVMC_PARTIAL_ERASE_SLICE_MS - Duration of an erase slice in ms. <1-85>
+// <i> The longest time USB events wait while a page is erased.
+#ifndef NVMC_PARTIAL_ERASE_SLICE_MS
+#define NVMC_PARTIAL_ERASE_SLICE_MS 10
+#endif
+
+// </e>
+
+// <e> WDT_FEED_POINTS_ENABLED - Feed the watchdog from long operations and record the longest gap.
+
+// <i> Hashing, page erases and settings writes feed a running watchdog
+// <i> between chunks. The longest gap is logged when leaving DFU mode.
+//==========================================================
+#ifndef WDT_FEED_POINTS_ENABLED
+#define WDT_FEED_POINTS_ENABLED 1
+#endif
+// <o> WDT_FEED_GAP_BUDGET_MS - Gaps between feed points longer than this are counted.
+// <i> The watchdog period the production application is meant to use.
+#ifndef WDT_FEED_GAP_BUDGET_MS
+#define WDT_FEED_GAP_BUDGET_MS 200
+#endif
+
+// </e>
+
+// <e> DFU_TELEMETRY_ENABLED - Stream DFU statistics on an RTT channel while in DFU mode.
+
+// <i> Records are decoded with tools/dfu_telemetry.py. Reading RTT
+// <i> requires ALLOW_DEBUGGER_ACCESS.
+//==========================================================
+#ifndef DFU_TELEMETRY_ENABLED
+#define DFU_TELEMETRY_ENABLED 0
+#endif
+// <o> DFU_TELEMETRY_RTT_CHANNEL - RTT up channel of the records. Channel 0 is used by the RTT log backend.
+#ifndef DFU_TELEMETRY_RTT_CHANNEL
+#define DFU_TELEMETRY_RTT_CHANNEL 1
+#endif
+
+// <o> DFU_TELEMETRY_BUFFER_SIZE - Size of the RTT up buffer in bytes.
+#ifndef DFU_TELEMETRY_BUFFER_SIZE
+#define DFU_TELEMETRY_BUFFER_SIZE 512
+#endif
+
+// <o> DFU_TELEMETRY_INTERVAL_MS - Interval of the periodic records.
+#ifndef DFU_TELEMETRY_INTERVAL_MS
+#define DFU_TELEMETRY_INTERVAL_MS 250
+#endif
+
+// </e>
+
+// </h>
+//==========================================================
+
 // </h>
 //==========================================================
 
@@ -1331,7 +1511,7 @@
 // <i> The init packet is always saved in flash, regardless of this setting.
 
 #ifndef NRF_DFU_SAVE_PROGRESS_IN_FLASH
-#define NRF_DFU_SAVE_PROGRESS_IN_FLASH 0
+#define NRF_DFU_SAVE_PROGRESS_IN_FLASH 1
 #endif
 
 // <q> NRF_DFU_SUPPORTS_EXTERNAL_APP  - [Experimental] Support for external app.
@@ -1471,7 +1651,7 @@
 // <i> This settings means only that components for DCDC regulator are installed and it can be enabled.
 
 #ifndef NRFX_POWER_CONFIG_DEFAULT_DCDCEN
-#define NRFX_POWER_CONFIG_DEFAULT_DCDCEN 0
+#define NRFX_POWER_CONFIG_DEFAULT_DCDCEN 1
 #endif
 
 // <q> NRFX_POWER_CONFIG_DEFAULT_DCDCENHV  - The default configuration of High Voltage DCDC regulator
@@ -1531,7 +1711,7 @@
 // <i> function is called, so the option is independent of the algorithm chosen.
 
 #ifndef NRFX_USBD_CONFIG_DMASCHEDULER_ISO_BOOST
-#define NRFX_USBD_CONFIG_DMASCHEDULER_ISO_BOOST 1
+#define NRFX_USBD_CONFIG_DMASCHEDULER_ISO_BOOST 0
 #endif
 
 // <q> NRFX_USBD_CONFIG_ISO_IN_ZLP  - Respond to an IN token on ISO IN endpoint with ZLP when no data is ready
@@ -1617,7 +1797,7 @@
 // <i> This settings means only that components for DCDC regulator are installed and it can be enabled.
 
 #ifndef POWER_CONFIG_DEFAULT_DCDCEN
-#define POWER_CONFIG_DEFAULT_DCDCEN 0
+#define POWER_CONFIG_DEFAULT_DCDCEN 1
 #endif
 
 // <q> POWER_CONFIG_DEFAULT_DCDCENHV  - The default configuration of High Voltage DCDC regulator
@@ -1679,7 +1859,7 @@
 // <i> function is called, so the option is independent of the algorithm chosen.
 
 #ifndef USBD_CONFIG_DMASCHEDULER_ISO_BOOST
-#define USBD_CONFIG_DMASCHEDULER_ISO_BOOST 1
+#define USBD_CONFIG_DMASCHEDULER_ISO_BOOST 0
 #endif
 
 // <q> USBD_CONFIG_ISO_IN_ZLP  - Respond to an IN token on ISO IN endpoint with ZLP when no data is ready
@@ -1886,7 +2066,7 @@
 // <i> Functions that modify USBD state are functions for sleep, wakeup, start, stop, enable, and disable.
 //==========================================================
 #ifndef APP_USBD_CONFIG_EVENT_QUEUE_ENABLE
-#define APP_USBD_CONFIG_EVENT_QUEUE_ENABLE 0
+#define APP_USBD_CONFIG_EVENT_QUEUE_ENABLE 1
 #endif
 // <o> APP_USBD_CONFIG_EVENT_QUEUE_SIZE - The size of the event queue.  <16-64>
 
@@ -5347,6 +5527,56 @@
 // </h>
 //==========================================================
 
+// <h> nRF_Segger_RTT
+
+//==========================================================
+// <h> segger_rtt - SEGGER RTT
+
+//==========================================================
+// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_UP - Size of upstream buffer.
+// <i> Note that either @ref NRF_LOG_BACKEND_RTT_OUTPUT_BUFFER_SIZE
+// <i> or this value is actually used. It depends on which one is bigger.
+
+#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_UP
+#define SEGGER_RTT_CONFIG_BUFFER_SIZE_UP 512
+#endif
+
+// <o> SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS - Maximum number of upstream buffers.
+#ifndef SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS
+#define SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS 2
+#endif
+
+// <o> SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN - Size of downstream buffer.
+#ifndef SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN
+#define SEGGER_RTT_CONFIG_BUFFER_SIZE_DOWN 16
+#endif
+
+// <o> SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS - Maximum number of downstream buffers.
+#ifndef SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS
+#define SEGGER_RTT_CONFIG_MAX_NUM_DOWN_BUFFERS 2
+#endif
+
+// <o> SEGGER_RTT_CONFIG_DEFAULT_MODE  - RTT behavior if the buffer is full.
+
+
+// <i> The following modes are supported:
+// <i> - SKIP  - Do not block, output nothing.
+// <i> - TRIM  - Do not block, output as much as fits.
+// <i> - BLOCK - Wait until there is space in the buffer.
+// <0=> SKIP
+// <1=> TRIM
+// <2=> BLOCK_IF_FIFO_FULL
+
+#ifndef SEGGER_RTT_CONFIG_DEFAULT_MODE
+#define SEGGER_RTT_CONFIG_DEFAULT_MODE 0
+#endif
+
+// </h>
+//==========================================================
+
+// </h>
+//==========================================================
+
 // <h> nRF_USB_DFU
 
 //==========================================================
@@ -5359,6 +5589,56 @@
 #define NRF_DFU_SERIAL_USB_RX_BUFFERS 3
 #endif
 
+// <o> NRF_DFU_SERIAL_USB_TX_BUFFERS - Number of CDC ACM responses that can be queued
+// <i> Responses wait here, SLIP encoded, while an earlier one is still being sent to the host.
+
+#ifndef NRF_DFU_SERIAL_USB_TX_BUFFERS
+#define NRF_DFU_SERIAL_USB_TX_BUFFERS 4
+#endif
+
+// <e> NRF_DFU_USB_BULK_ENABLED - Vendor specific bulk DFU interface next to CDC ACM
+// <i> Carries one unframed DFU request per bulk transfer (interface 2, endpoints 0x01/0x81).
+//==========================================================
+#ifndef NRF_DFU_USB_BULK_ENABLED
+#define NRF_DFU_USB_BULK_ENABLED 1
+#endif
+// <o> NRF_DFU_USB_BULK_MTU - Largest request in bytes, including the opcode
+// <i> Must be a multiple of 64, the bulk max packet size.
+
+#ifndef NRF_DFU_USB_BULK_MTU
+#define NRF_DFU_USB_BULK_MTU 4096
+#endif
+
+// <o> NRF_DFU_USB_BULK_RX_BUFFERS - Number of bulk receive buffers
+// <i> Requests that can be received while earlier ones are still written to flash.
+
+#ifndef NRF_DFU_USB_BULK_RX_BUFFERS
+#define NRF_DFU_USB_BULK_RX_BUFFERS 3
+#endif
+
+// <o> NRF_DFU_USB_BULK_TX_BUFFERS - Number of bulk responses that can be queued
+// <i> Responses wait here while an earlier one is still being sent to the host.
+
+#ifndef NRF_DFU_USB_BULK_TX_BUFFERS
+#define NRF_DFU_USB_BULK_TX_BUFFERS 4
+#endif
+
+// <q> NRF_DFU_USB_BULK_STATS_ENABLED  - Per endpoint transfer statistics
+// <i> Logged when the host disconnects and returned by request 0x51.
+
+#ifndef NRF_DFU_USB_BULK_STATS_ENABLED
+#define NRF_DFU_USB_BULK_STATS_ENABLED 1
+#endif
+
+// </e>
+
+// <q> USB_EVENT_LATENCY_STATS_ENABLED  - Histograms of the USB event dispatch latency
+// <i> Per event type, logged when USB power is removed.
+
+#ifndef USB_EVENT_LATENCY_STATS_ENABLED
+#define USB_EVENT_LATENCY_STATS_ENABLED 1
+#endif
+
 // </h>
 //==========================================================
 
@@ -0,0 +1,109 @@
+#ifndef __APP_USBD_DFU_BULK_H__
+#define __APP_USBD_DFU_BULK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "app_usbd.h"
+#include "app_usbd_class_base.h"
+#include "app_usbd_descriptor.h"
+#include "nrf_drv_usbd.h"
+#include "sdk_config.h"
+
+/*
+* Vendor specific interface carrying DFU requests over one bulk OUT and one
+* bulk IN endpoint. Every request is sent as a single bulk transfer, i.e. the
+* opcode followed by its parameters without any framing. A transfer ends with
+* a short packet, so a request that is a multiple of the max packet size must
+* be followed by a zero length packet. Responses are sent the same way.
+*/
+#define APP_USBD_DFU_BULK_CLASS 0xFF
+#define APP_USBD_DFU_BULK_SUBCLASS 0x44 // 'D'
+#define APP_USBD_DFU_BULK_PROTOCOL 0x01
+
+APP_USBD_CLASS_FORWARD(app_usbd_dfu_bulk);
+
+typedef enum {
+  APP_USBD_DFU_BULK_USER_EVT_READY,    // host selected a configuration, reads can be queued
+  APP_USBD_DFU_BULK_USER_EVT_CLOSED,   // bus reset or USB stopped, pending transfers are lost
+  APP_USBD_DFU_BULK_USER_EVT_RX_DONE,  // transfer queued with app_usbd_dfu_bulk_read() finished, size 0 if it was dropped
+  APP_USBD_DFU_BULK_USER_EVT_TX_DONE   // transfer queued with app_usbd_dfu_bulk_write() finished or was aborted
+} app_usbd_dfu_bulk_user_event_t;
+
+typedef void (*app_usbd_dfu_bulk_user_ev_handler_t)(app_usbd_class_inst_t const * p_inst,
+                                                    app_usbd_dfu_bulk_user_event_t event);
+
+typedef struct {
+  app_usbd_dfu_bulk_user_ev_handler_t user_ev_handler;
+} app_usbd_dfu_bulk_inst_t;
+
+/*
+* Per endpoint transfer statistics. The time is measured in CPU cycles from
+* queueing a transfer until its completion is processed, i.e. it includes
+* waiting for the host, for the shared EasyDMA and for the event to be
+* scheduled.
+*/
+typedef struct {
+  uint32_t transfers;
+  uint32_t bytes;
+  uint64_t cycles_total;
+  uint32_t cycles_max;
+} app_usbd_dfu_bulk_ep_stats_t;
+
+typedef struct {
+  size_t rx_size;
+  bool rx_busy;
+  bool tx_busy;
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+  uint32_t rx_start;
+  uint32_t tx_start;
+  app_usbd_dfu_bulk_ep_stats_t rx_stats;
+  app_usbd_dfu_bulk_ep_stats_t tx_stats;
+#endif
+} app_usbd_dfu_bulk_ctx_t;
+
+#define APP_USBD_DFU_BULK_CONFIG(iface, epin, epout) ((iface, epin, epout))
+
+#define APP_USBD_DFU_BULK_INSTANCE_SPECIFIC_DEC app_usbd_dfu_bulk_inst_t inst;
+#define APP_USBD_DFU_BULK_DATA_SPECIFIC_DEC app_usbd_dfu_bulk_ctx_t ctx;
+
+APP_USBD_CLASS_TYPEDEF(app_usbd_dfu_bulk,
+                       APP_USBD_DFU_BULK_CONFIG(0, 0, 0),
+                       APP_USBD_DFU_BULK_INSTANCE_SPECIFIC_DEC,
+                       APP_USBD_DFU_BULK_DATA_SPECIFIC_DEC
+);
+
+extern const app_usbd_class_methods_t app_usbd_dfu_bulk_class_methods;
+
+/*
+* Defines a bulk DFU class instance, e.g.
+* APP_USBD_DFU_BULK_GLOBAL_DEF(m_bulk, handler, 2, NRF_DRV_USBD_EPIN3, NRF_DRV_USBD_EPOUT3);
+*/
+#define APP_USBD_DFU_BULK_GLOBAL_DEF(instance_name, user_event_handler, iface, epin, epout) \
+  APP_USBD_CLASS_INST_GLOBAL_DEF(instance_name,                                             \
+                                 app_usbd_dfu_bulk,                                         \
+                                 &app_usbd_dfu_bulk_class_methods,                          \
+                                 APP_USBD_DFU_BULK_CONFIG(iface, epin, epout),              \
+                                 (.inst = { .user_ev_handler = user_event_handler }))
+
+static inline app_usbd_class_inst_t const * app_usbd_dfu_bulk_class_inst_get(app_usbd_dfu_bulk_t const * p_bulk) {
+  return &p_bulk->base;
+}
+
+static inline app_usbd_dfu_bulk_t const * app_usbd_dfu_bulk_class_get(app_usbd_class_inst_t const * p_inst) {
+  return (app_usbd_dfu_bulk_t const *)p_inst;
+}
+
+ret_code_t app_usbd_dfu_bulk_read(app_usbd_dfu_bulk_t const * p_bulk, void * p_buf, size_t length);
+size_t app_usbd_dfu_bulk_rx_size(app_usbd_dfu_bulk_t const * p_bulk);
+ret_code_t app_usbd_dfu_bulk_write(app_usbd_dfu_bulk_t const * p_bulk, void const * p_buf, size_t length);
+bool app_usbd_dfu_bulk_rx_busy(app_usbd_dfu_bulk_t const * p_bulk);
+bool app_usbd_dfu_bulk_tx_busy(app_usbd_dfu_bulk_t const * p_bulk);
+
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+void app_usbd_dfu_bulk_stats_get(app_usbd_dfu_bulk_t const * p_bulk,
+                                 app_usbd_dfu_bulk_ep_stats_t * p_rx_stats,
+                                 app_usbd_dfu_bulk_ep_stats_t * p_tx_stats);
+#endif
+
+#endif
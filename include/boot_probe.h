@@ -0,0 +1,79 @@
+#ifndef __BOOT_PROBE_H__
+#define __BOOT_PROBE_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+
+/*
+* Cycle count probes for the bootloader stages. Every probe accumulates the
+* number of runs and the minimum, maximum and total duration in a static
+* table. A scoped probe brackets a block in one function:
+*
+*   BOOT_PROBE_BEGIN(BOOT_PROBE_COPY_KDR);
+*   ret_val = copy_kdr();
+*   BOOT_PROBE_END(BOOT_PROBE_COPY_KDR);
+*
+* Durations that start and end in different places are taken with
+* boot_probe_now() and passed to boot_probe_record().
+*
+* The probes only exist in debug builds (NRF_DFU_DEBUG_VERSION) with
+* BOOT_PROBES_ENABLED, otherwise all macros expand to nothing. On the target
+* the unit is CPU cycles (DWT CYCCNT), host builds use CLOCK_MONOTONIC in
+* nanoseconds so the same instrumentation works in simulation.
+*/
+typedef enum {
+  BOOT_PROBE_COPY_KDR = 0,     // copy_kdr(), incl. provisioning on the first boot
+  BOOT_PROBE_BOOTLOADER_INIT,  // nrf_bootloader_init() until it starts the application or enters DFU mode
+  BOOT_PROBE_MEASURED_BOOT,    // measured_boot_run()
+  BOOT_PROBE_DFU_REQUEST,      // USB DFU request from reception until its buffer is released
+  BOOT_PROBE_COUNT
+} boot_probe_id_t;
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+} boot_probe_stats_t;
+
+#if BOOT_PROBES_ENABLED && defined(NRF_DFU_DEBUG_VERSION)
+
+#define BOOT_PROBES_ACTIVE 1
+
+#if defined(__arm__)
+#include "nrf.h"
+
+static inline uint32_t boot_probe_now() {
+  return DWT->CYCCNT;
+}
+#else
+#include <time.h>
+
+static inline uint32_t boot_probe_now() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+#endif
+
+#define BOOT_PROBE_BEGIN(id) uint32_t const _boot_probe_start_##id = boot_probe_now()
+#define BOOT_PROBE_END(id) boot_probe_record((id), boot_probe_now() - _boot_probe_start_##id)
+
+void boot_probe_init();
+void boot_probe_record(boot_probe_id_t id, uint32_t duration);
+void boot_probe_get(boot_probe_id_t id, boot_probe_stats_t * p_stats);
+void boot_probe_log();
+
+#else
+
+#define BOOT_PROBES_ACTIVE 0
+
+#define BOOT_PROBE_BEGIN(id)
+#define BOOT_PROBE_END(id)
+#define boot_probe_init()
+#define boot_probe_log()
+
+#endif
+
+#endif
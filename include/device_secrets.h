@@ -0,0 +1,90 @@
+#ifndef __DEVICE_SECRETS_H__
+#define __DEVICE_SECRETS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "memory_layout.h"
+
+#define DEVICE_SECRETS_PAGE_SIZE MEMORY_DEVICE_SECRETS_SIZE
+
+#define DEVICE_SECRETS_MAGIC 0x43455344
+#define DEVICE_SECRETS_VERSION 1
+#define DEVICE_SECRETS_MAX_SLOTS 16
+
+#define DEVICE_ROOT_KEY_SIZE 16
+#define DEVICE_ID_SIZE 16
+#define ATTESTATION_SEED_SIZE 32
+
+/*
+* Slot numbers double as index into the slot table, which is what makes a
+* lookup constant time. Never renumber existing slots.
+*/
+typedef enum {
+  SECRET_ROOT_KEY = 0,
+  SECRET_DEVICE_ID = 1,
+  SECRET_ATTESTATION_SEED = 2,
+  SECRET_PROVISIONING_DATA = 3,
+  SECRET_CERTIFICATE = 4
+} secret_slot_t;
+
+/*
+* Location of a slot relative to the start of the page. A length of zero
+* marks an unused slot.
+*/
+typedef struct {
+  uint16_t offset;
+  uint16_t length;
+} secret_slot_entry_t;
+
+/*
+* Versioned layout of the device secrets page. The flag keeps its position
+* at the start of the page. The crc covers the page from magic up to size
+* bytes, i.e. the rest of the header, the slot table and the slot data.
+*/
+typedef struct {
+  uint32_t flag;
+  uint32_t crc;
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  secret_slot_entry_t slots[DEVICE_SECRETS_MAX_SLOTS];
+} device_secrets_header_t;
+
+/*
+* Layout written when the bootloader generates the secrets itself and the
+* page does not already carry a slot table.
+*/
+typedef struct {
+  device_secrets_header_t header;
+  uint8_t root_key[DEVICE_ROOT_KEY_SIZE];
+  uint8_t device_id[DEVICE_ID_SIZE];
+  uint8_t attestation_seed[ATTESTATION_SEED_SIZE];
+} device_secrets_default_t;
+
+/*
+* Flat layout used before the slot table was introduced. Pages without the
+* table magic are read this way so keys burned at 0x000E0004 keep working.
+*/
+typedef struct {
+  uint32_t flag;
+  uint8_t root_key[DEVICE_ROOT_KEY_SIZE];
+  uint8_t device_id[DEVICE_ID_SIZE];
+  uint8_t attestation_seed[ATTESTATION_SEED_SIZE];
+} device_secrets_legacy_t;
+
+/*
+* Result of validating a page once, after which every lookup is O(1).
+*/
+typedef struct {
+  uint8_t const * p_page;
+  bool legacy;
+} device_secrets_t;
+
+uint32_t device_secrets_open(device_secrets_t * p_secrets, uint8_t const * p_page);
+uint32_t device_secrets_find(device_secrets_t const * p_secrets, secret_slot_t slot, uint8_t const ** pp_data, uint16_t * p_length);
+bool device_secrets_table_present(uint8_t const * p_page);
+bool device_secrets_table_valid(uint8_t const * p_page);
+void device_secrets_default_init(uint8_t * p_page);
+void device_secrets_seal(uint8_t * p_page);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef __DFU_POWER_H__
+#define __DFU_POWER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf_dfu_types.h"
+
+/*
+* Power states of the bootloader while it waits in DFU mode, from the most
+* to the least expensive one.
+*/
+typedef enum {
+  DFU_POWER_ACTIVE = 0,  // DFU in progress, USB and flash busy
+  DFU_POWER_IDLE,        // USB configured, waiting for the host (HFXO running)
+  DFU_POWER_SUSPENDED,   // USB suspended by the host, HFCLK released
+  DFU_POWER_DETACHED,    // no USB power, only LFCLK, RTC and the LED are running
+  DFU_POWER_STATE_COUNT
+} dfu_power_state_t;
+
+void dfu_power_init();
+void dfu_power_on_dfu_evt(nrf_dfu_evt_type_t evt_type);
+void dfu_power_on_usb_suspend(bool suspended);
+dfu_power_state_t dfu_power_state_get();
+uint64_t dfu_power_ticks_get(dfu_power_state_t state);
+void dfu_power_log();
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __DFU_TELEMETRY_H__
+#define __DFU_TELEMETRY_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+#include "nrf_dfu_types.h"
+
+/*
+* Records streamed on an RTT up channel while in DFU mode, decoded by
+* tools/dfu_telemetry.py. A record starts with DFU_TELEMETRY_SYNC and its
+* length and ends with a checksum that makes the sum of all its bytes zero,
+* so a reader can resync after records were skipped because the host did not
+* empty the buffer in time.
+*/
+#define DFU_TELEMETRY_SYNC 0xA5
+#define DFU_TELEMETRY_VERSION 1
+
+#define DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE 0x01
+#define DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS 0x02
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync;
+  uint8_t length;            // of the whole record
+  uint8_t version;
+  uint8_t flags;
+  uint16_t sequence;
+  uint16_t objects_committed;
+  uint32_t time_ms;          // since DFU mode was entered
+  uint32_t bytes_received;   // firmware bytes accepted by the request handler
+  uint32_t bytes_committed;  // firmware bytes in executed (CRC checked) objects
+  uint32_t flash_backlog;    // received bytes still waiting for the flash
+  uint32_t rx_held;          // bulk OUT transfers held back (NAKed) for lack of buffers
+  uint8_t rx_buffers_used;
+  uint8_t checksum;
+} dfu_telemetry_record_t;
+
+#if DFU_TELEMETRY_ENABLED
+void dfu_telemetry_init();
+void dfu_telemetry_on_dfu_evt(nrf_dfu_evt_type_t evt_type);
+#endif
+
+#endif
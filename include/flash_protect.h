@@ -0,0 +1,32 @@
+#ifndef __FLASH_PROTECT_H__
+#define __FLASH_PROTECT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+* Flash protection of the bootloader. The protected regions are listed in one
+* table built from memory_layout.h and applied to the ACL peripheral in two
+* passes at boot: the MBR and the bootloader code are write protected before
+* copy_kdr() runs, the device secrets are read protected once the key is in
+* the KDR registers. Within a pass adjacent regions with the same permissions
+* share an ACL region, regions an ACL region already covers are skipped and
+* every written region is read back. The ACL keeps its configuration until
+* the next reset.
+*/
+typedef enum {
+  FLASH_PROTECT_CODE,    // before copy_kdr()
+  FLASH_PROTECT_SECRETS  // after copy_kdr()
+} flash_protect_pass_t;
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  bool read_protect; // also deny reads, otherwise only writes and erases
+  flash_protect_pass_t pass;
+} flash_protect_region_t;
+
+uint32_t flash_protect_apply(flash_protect_pass_t pass);
+uint32_t flash_protect_verify();
+
+#endif
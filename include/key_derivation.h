@@ -0,0 +1,41 @@
+#ifndef __KEY_DERIVATION_H__
+#define __KEY_DERIVATION_H__
+
+#include <stdint.h>
+#include "memory_layout.h"
+
+/*
+* The handoff area is a small region at the very end of RAM which is neither
+* initialized by the bootloader nor by the application. The application must
+* exclude it from its own RAM region in the linker script.
+*/
+#define BOOT_HANDOFF_ADDRESS MEMORY_HANDOFF_ADDRESS
+#define BOOT_HANDOFF_SIZE MEMORY_HANDOFF_SIZE
+
+#define KEY_HANDOFF_MAGIC 0x4B455953
+#define DERIVED_KEY_SIZE 16
+
+/*
+* Every derived key is bound to a purpose through the label that is fed into
+* the KDF. Append new purposes at the end so existing keys do not change.
+*/
+typedef enum {
+  DERIVED_KEY_STORAGE = 0,
+  DERIVED_KEY_ATTESTATION,
+  DERIVED_KEY_TRANSPORT,
+  DERIVED_KEY_COUNT
+} derived_key_id_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t key_count;
+  uint8_t keys[DERIVED_KEY_COUNT][DERIVED_KEY_SIZE];
+} key_handoff_t;
+
+/* Location of the derived keys as seen by the application. */
+#define KEY_HANDOFF ((key_handoff_t *)BOOT_HANDOFF_ADDRESS)
+
+uint32_t derive_keys();
+void clear_derived_keys();
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __MEASURED_BOOT_H__
+#define __MEASURED_BOOT_H__
+
+#include <stdint.h>
+#include "key_derivation.h"
+
+/*
+* The measurements are published in the handoff area right after the derived
+* keys, at a fixed offset so the application can locate them.
+*/
+#define MEASURED_BOOT_ADDRESS MEMORY_MEASURED_BOOT_ADDRESS
+
+#define MEASURED_BOOT_MAGIC 0x4D454153
+#define MEASUREMENT_SIZE 32
+
+/*
+* Components in the order they are extended into the hash chain.
+*/
+typedef enum {
+  MEASURED_BOOTLOADER = 0,
+  MEASURED_SETTINGS,
+  MEASURED_APPLICATION,
+  MEASURED_COMPONENT_COUNT
+} measured_component_t;
+
+/*
+* components[i] holds SHA-256 of the i-th component (the settings as loaded
+* into s_dfu_settings, the others as in flash), chain holds
+* H(...H(H(0 || components[0]) || components[1])... || components[n-1]).
+* The crc covers every field before it, the application can use it to check
+* that the measurements are complete.
+*/
+typedef struct {
+  uint32_t magic;
+  uint32_t app_size;
+  uint8_t components[MEASURED_COMPONENT_COUNT][MEASUREMENT_SIZE];
+  uint8_t chain[MEASUREMENT_SIZE];
+  uint32_t crc;
+} measured_boot_t;
+
+//the measurements as written by the bootloader
+extern measured_boot_t measured_boot;
+
+/* Location of the measurements as seen by the application. */
+#define MEASURED_BOOT ((measured_boot_t *)MEASURED_BOOT_ADDRESS)
+
+uint32_t measured_boot_run();
+
+#endif
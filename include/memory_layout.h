@@ -0,0 +1,84 @@
+#ifndef __MEMORY_LAYOUT_H__
+#define __MEMORY_LAYOUT_H__
+
+/*
+* Memory map of the bootloader. This header is the only place where the
+* addresses are defined: the linker script is run through the preprocessor
+* with it (see the Makefile), the C code uses the constants directly and the
+* settings page address is passed on to nrfutil.
+*
+* Only plain integer expressions are allowed above the C section, the linker
+* does not understand casts or suffixes.
+*/
+
+//flash
+#define MEMORY_MBR_ADDRESS 0x00000000
+#define MEMORY_MBR_SIZE 0x1000
+
+/*
+* The bootloader ends at the MBR parameters page and the device secrets page
+* is directly below it, so both start addresses follow from the size. The
+* Makefile overrides it with BOOTLOADER_SIZE, tools/size_report.py suggests a
+* size from the built image. The default leaves room for the debug profile.
+*/
+#ifndef MEMORY_BOOTLOADER_SIZE
+#define MEMORY_BOOTLOADER_SIZE 0x1D000
+#endif
+#define MEMORY_BOOTLOADER_ADDRESS (MEMORY_MBR_PARAMS_ADDRESS - MEMORY_BOOTLOADER_SIZE)
+
+#define MEMORY_DEVICE_SECRETS_SIZE 0x1000
+#define MEMORY_DEVICE_SECRETS_ADDRESS (MEMORY_BOOTLOADER_ADDRESS - MEMORY_DEVICE_SECRETS_SIZE)
+
+#define MEMORY_MBR_PARAMS_ADDRESS 0x000FE000
+#define MEMORY_MBR_PARAMS_SIZE 0x1000
+
+#define MEMORY_SETTINGS_ADDRESS 0x000FF000
+#define MEMORY_SETTINGS_SIZE 0x1000
+
+#define MEMORY_FLASH_END 0x00100000
+
+//UICR
+#define MEMORY_UICR_BOOTLOADER_ADDRESS 0x00000FF8
+#define MEMORY_UICR_MBR_PARAMS_ADDRESS 0x00000FFC
+#define MEMORY_CTRLAP_ADDRESS 0x10001208
+
+//RAM, the first 8 bytes are reserved for the MBR
+#define MEMORY_RAM_ADDRESS 0x20000008
+#define MEMORY_RAM_END 0x20040000
+
+//retained regions at the end of RAM, not initialized at startup
+#define MEMORY_TRACE_ADDRESS 0x2003FA00
+#define MEMORY_TRACE_SIZE 0x400
+
+#define MEMORY_HANDOFF_ADDRESS 0x2003FE00
+#define MEMORY_HANDOFF_SIZE 0x200
+
+//measurements follow the derived keys in the handoff area
+#define MEMORY_MEASURED_BOOT_ADDRESS (MEMORY_HANDOFF_ADDRESS + 0x100)
+
+#define MEMORY_RAM_SIZE (MEMORY_TRACE_ADDRESS - MEMORY_RAM_ADDRESS)
+
+#ifndef __LINKER__
+
+/*
+* The regions must follow each other without overlapping.
+*/
+_Static_assert(MEMORY_DEVICE_SECRETS_ADDRESS + MEMORY_DEVICE_SECRETS_SIZE == MEMORY_BOOTLOADER_ADDRESS,
+               "device secrets must be directly below the bootloader");
+_Static_assert(MEMORY_BOOTLOADER_ADDRESS + MEMORY_BOOTLOADER_SIZE <= MEMORY_MBR_PARAMS_ADDRESS,
+               "bootloader overlaps the MBR parameters page");
+_Static_assert(MEMORY_MBR_PARAMS_ADDRESS + MEMORY_MBR_PARAMS_SIZE <= MEMORY_SETTINGS_ADDRESS,
+               "MBR parameters page overlaps the settings page");
+_Static_assert(MEMORY_SETTINGS_ADDRESS + MEMORY_SETTINGS_SIZE == MEMORY_FLASH_END,
+               "settings page must be the last flash page");
+_Static_assert(MEMORY_TRACE_ADDRESS + MEMORY_TRACE_SIZE <= MEMORY_HANDOFF_ADDRESS,
+               "trace ring overlaps the handoff area");
+_Static_assert(MEMORY_HANDOFF_ADDRESS + MEMORY_HANDOFF_SIZE == MEMORY_RAM_END,
+               "handoff area must be at the end of RAM");
+_Static_assert(MEMORY_BOOTLOADER_SIZE % 0x1000 == 0, "the bootloader size must be a multiple of the page size");
+_Static_assert((MEMORY_DEVICE_SECRETS_ADDRESS % 0x1000 == 0) && (MEMORY_BOOTLOADER_ADDRESS % 0x1000 == 0),
+               "flash regions must be page aligned");
+
+#endif
+
+#endif
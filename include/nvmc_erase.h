@@ -0,0 +1,34 @@
+#ifndef __NVMC_ERASE_H__
+#define __NVMC_ERASE_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+
+/*
+* Sliced page erase. nrf_nvmc_page_erase() of the SDK, used by the NVMC
+* fstorage backend, is wrapped at link time (see the Makefile) and erases the
+* page with ERASEPAGEPARTIAL in slices of NVMC_PARTIAL_ERASE_SLICE_MS instead
+* of blocking for the whole page erase time. Between the slices the CPU
+* serves interrupts and calls the slice handler, which processes pending
+* USB events in DFU mode. The erase itself stays synchronous for fstorage
+* and its users.
+*
+* The slice handler must not start flash operations.
+*/
+
+//accumulated partial erase time after which a page is erased, tERASEPAGE in the product specification
+#define NVMC_PAGE_ERASE_TIME_MS 85
+
+typedef void (*nvmc_erase_slice_handler_t)(void);
+
+typedef struct {
+  uint32_t pages;   // pages erased in slices
+  uint32_t slices;  // partial erases issued
+  uint32_t retries; // pages that needed more than NVMC_PAGE_ERASE_TIME_MS
+} nvmc_erase_stats_t;
+
+void nvmc_erase_slice_handler_set(nvmc_erase_slice_handler_t handler);
+void nvmc_erase_stats_get(nvmc_erase_stats_t * p_stats);
+void nvmc_erase_stats_log();
+
+#endif
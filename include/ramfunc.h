@@ -0,0 +1,36 @@
+#ifndef __RAMFUNC_H__
+#define __RAMFUNC_H__
+
+#include "sdk_config.h"
+
+/*
+* Execute-in-RAM mode. While the NVMC erases or writes a page every fetch from
+* flash halts the CPU, a page erase for about 85 ms. Code in the .ramfunc
+* section is copied to RAM at startup together with .data and keeps running,
+* so the USB interrupt can move the packets of a bulk transfer in flight
+* while the DFU request handler waits for the NVMC.
+*
+* Functions of this project are placed with RAMFUNC, the NVMC, SLIP, USB and
+* POWER_CLOCK interrupt modules of the SDK and the memcpy() and memset() of
+* libc by the linker script (secure_bootloader.ld). Interrupts only run from
+* RAM after ramfunc_init() moved the vector table.
+*
+* Everything else stays in flash: the class handlers of app_usbd, which only
+* run from the event queue in thread context (ramfunc.c checks the
+* configuration), the request handler of nrf_dfu and the RTC interrupt of
+* app_timer, which halts until the erase is done.
+*/
+#if RAMFUNC_ENABLED
+
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+void ramfunc_init();
+
+#else
+
+#define RAMFUNC
+#define ramfunc_init()
+
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef __SETTINGS_LOG_H__
+#define __SETTINGS_LOG_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+
+/*
+* Log structured bootloader settings page. The page starts with a full
+* nrf_dfu_settings_t snapshot in the format of the SDK, so nrfutil generated
+* settings and the SDK loader keep working, and the rest of the page is a log
+* of records holding only the bytes that changed since the previous state:
+*
+*   snapshot | record | record | ... | erased
+*
+* A record is a header followed by runs of changed bytes. The header stores
+* its length twice (inverted) and a CRC-32 of the runs, so a record torn by a
+* reset is detected and ignored. The page is only erased and a new snapshot
+* written when a record does not fit anymore.
+*
+* The SDK functions are wrapped at link time (-Wl,--wrap), the SDK code
+* itself is unchanged.
+*
+* With NRF_DFU_SAVE_PROGRESS_IN_FLASH the request handler saves the progress
+* after every data object. Such writes are only persisted once the committed
+* offset advanced by NRF_DFU_PROGRESS_CHECKPOINT_SIZE, each checkpoint is a
+* record of a few dozen bytes. After a reset the host resumes from the last
+* checkpoint.
+*/
+#define SETTINGS_LOG_RUN_MAX_GAP 8
+
+typedef struct {
+  uint16_t length;     // of the runs in bytes, a multiple of 4
+  uint16_t length_inv; // ~length
+  uint32_t crc;        // CRC-32 of the runs
+} settings_log_header_t;
+
+typedef struct {
+  uint16_t offset;     // in nrf_dfu_settings_t
+  uint16_t size;       // followed by the data, padded to a multiple of 4
+} settings_log_run_t;
+
+/*
+* Counters since boot, to see the effect of the log.
+*/
+typedef struct {
+  uint32_t records;      // settings writes appended to the log
+  uint32_t compactions;  // settings writes that erased the page
+  uint32_t skipped;      // settings writes without changes
+  uint32_t checkpoints;  // data progress writes that were persisted
+  uint32_t deferred;     // data progress writes below the checkpoint size
+} settings_log_stats_t;
+
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+void settings_log_stats_get(settings_log_stats_t * p_stats);
+void settings_log_stats_log();
+#endif
+
+#endif
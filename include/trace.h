@@ -0,0 +1,64 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+#include "memory_layout.h"
+
+/*
+* Binary trace. A call site stores only the ID of its format string and up to
+* four raw 32-bit arguments in a ring buffer in retained RAM, the formatting
+* is done on the host by tools/trace_decode.py using the ELF file.
+*
+* The format strings are placed in the non-allocated section .trace_fmt, so
+* they cost no flash, and the ID of a string is its offset in that section.
+* Arguments must be integers or pointers, %s is not supported.
+*
+*   TRACE("KDR loaded in %u cycles", cycles);
+*/
+#define TRACE_ADDRESS MEMORY_TRACE_ADDRESS
+#define TRACE_SIZE MEMORY_TRACE_SIZE
+
+#define TRACE_MAGIC 0x54524345
+#define TRACE_MAX_ARGS 4
+
+/*
+* Every entry starts with a header word: sync nibble, argument count and the
+* string ID, followed by the cycle counter and the arguments.
+*/
+#define TRACE_SYNC 0xA
+#define TRACE_HEADER(id, nargs) (((uint32_t)TRACE_SYNC << 28) | ((uint32_t)(nargs) << 24) | ((uint32_t)(id) & 0x00FFFFFF))
+
+typedef struct {
+  uint32_t magic;
+  uint32_t words;  // capacity of data
+  uint32_t head;   // number of words written since the ring was reset, wraps around data
+  uint32_t data[(TRACE_SIZE - 3 * sizeof(uint32_t)) / sizeof(uint32_t)];
+} trace_ring_t;
+
+#if TRACE_ENABLED
+
+#define TRACE_ID(fmt) __extension__({                                                      \
+  static const char _trace_fmt[] __attribute__((section(".trace_fmt"), used)) = fmt;    \
+  (uint32_t)_trace_fmt;                                                                   \
+})
+
+#define TRACE_NARGS_(_0, _1, _2, _3, _4, n, ...) n
+#define TRACE_NARGS(...) TRACE_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+
+#define TRACE(fmt, ...) trace_write(TRACE_ID(fmt), TRACE_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+
+//the ring as written by the bootloader
+extern trace_ring_t trace_ring;
+
+void trace_init();
+void trace_write(uint32_t id, uint32_t nargs, ...);
+
+#else
+
+#define TRACE(fmt, ...)
+#define trace_init()
+
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __USB_DFU_TRANSPORT_H__
+#define __USB_DFU_TRANSPORT_H__
+
+#include <stdint.h>
+#include "nrf_drv_usbd.h"
+
+/*
+* Interfaces and endpoints of the two DFU interfaces. All endpoints share one
+* EasyDMA channel. In the prioritized DMA scheduler mode the pending
+* transfer with the lowest endpoint number wins (IN before OUT), so the bulk
+* DFU endpoints get number 1 and image data on the bulk OUT endpoint is only
+* ever preceded by control and IN transfers, CDC ACM IN included. The order
+* only matters when packets pile up behind a late USBD interrupt, at full
+* speed the bus takes ten times longer than the DMA of a packet
+* (test/test_dfu_bulk.c).
+*/
+#define CDC_ACM_COMM_INTERFACE 0
+#define CDC_ACM_COMM_EPIN NRF_DRV_USBD_EPIN2
+#define CDC_ACM_DATA_INTERFACE 1
+#define CDC_ACM_DATA_EPIN NRF_DRV_USBD_EPIN3
+#define CDC_ACM_DATA_EPOUT NRF_DRV_USBD_EPOUT3
+
+#define DFU_BULK_INTERFACE 2
+#define DFU_BULK_EPIN NRF_DRV_USBD_EPIN1
+#define DFU_BULK_EPOUT NRF_DRV_USBD_EPOUT1
+
+/*
+* Request answered by the USB transport itself, on both the CDC ACM and the
+* bulk interface. It has no parameters and is answered right away with
+* 0x60 0x50 0x01 followed by usb_dfu_flow_status_t, even while earlier
+* requests are still waiting to be processed.
+*/
+#define DFU_OP_FLOW_STATUS 0x50
+
+/*
+* Only on the bulk interface: answered with 0x60 0x51 0x01 followed by
+* usb_dfu_ep_stats_t for the OUT and then the IN endpoint.
+*/
+#define DFU_OP_USB_STATS 0x51
+
+/*
+* Only on the bulk interface of debug builds with BOOT_PROBES_ENABLED:
+* answered with 0x60 0x52 0x01 followed by one usb_dfu_probe_t per entry of
+* boot_probe_id_t.
+*/
+#define DFU_OP_BOOT_PROBES 0x52
+
+/*
+* Receive side state of one interface. Buffers are taken when a request is
+* received and released once it has been processed, for write requests that
+* is after the data was written to flash. flash_backlog counts the payload
+* bytes of write requests still waiting for that.
+*
+* On the bulk interface every response is followed by this structure so a
+* host can tune the PRN interval without extra round trips.
+*/
+typedef struct __attribute__((packed)) {
+  uint8_t rx_buffers_free;
+  uint8_t rx_buffers_total;
+  uint32_t flash_backlog;
+} usb_dfu_flow_status_t;
+
+/*
+* Transfer statistics of one bulk endpoint, times in CPU cycles from queueing
+* a transfer until its completion was processed.
+*/
+typedef struct __attribute__((packed)) {
+  uint32_t transfers;
+  uint32_t bytes;
+  uint32_t cycles_avg;
+  uint32_t cycles_max;
+} usb_dfu_ep_stats_t;
+
+/*
+* Accumulated durations of one boot probe (see boot_probe.h) in CPU cycles.
+*/
+typedef struct __attribute__((packed)) {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint32_t avg;
+} usb_dfu_probe_t;
+
+/*
+* Load of the transport summed over both interfaces. rx_held counts the bulk
+* OUT transfers that could not be queued for lack of buffers, the endpoint
+* NAKs the host until a buffer is released.
+*/
+typedef struct {
+  uint32_t rx_buffers_used;
+  uint32_t flash_backlog;
+  uint32_t rx_held;
+} usb_dfu_transport_load_t;
+
+void usb_dfu_transport_load_get(usb_dfu_transport_load_t * p_load);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __USB_EVENT_QUEUE_H__
+#define __USB_EVENT_QUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "app_usbd.h"
+
+/*
+* Buckets of the dispatch latency histograms. Bucket 0 counts events that
+* waited less than 2^USB_EVT_LATENCY_SHIFT cycles, every further bucket
+* doubles the limit and the last one counts everything above.
+*/
+#define USB_EVT_LATENCY_SHIFT 8
+#define USB_EVT_LATENCY_BUCKETS 12
+
+typedef enum {
+  USB_EVT_TYPE_TRANSFER = 0, // endpoint transfer finished or data waiting
+  USB_EVT_TYPE_SETUP,        // setup packet on endpoint 0
+  USB_EVT_TYPE_BUS,          // reset, suspend, resume
+  USB_EVT_TYPE_OTHER,        // SOF, power and library internal events
+  USB_EVT_TYPE_COUNT
+} usb_evt_type_t;
+
+typedef struct {
+  uint32_t count;
+  uint32_t cycles_max;
+  uint32_t buckets[USB_EVT_LATENCY_BUCKETS];
+} usb_evt_latency_t;
+
+void usb_event_queue_init();
+void usb_event_queue_isr_handler(app_usbd_internal_evt_t const * const p_event, bool queued);
+void usb_event_queue_process();
+
+#if USB_EVENT_LATENCY_STATS_ENABLED
+void usb_event_queue_latency_get(usb_evt_type_t type, usb_evt_latency_t * p_latency);
+void usb_event_queue_latency_log();
+#endif
+
+#endif
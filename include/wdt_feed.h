@@ -0,0 +1,42 @@
+#ifndef __WDT_FEED_H__
+#define __WDT_FEED_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+
+/*
+* Watchdog feed points for long operations. When the application left the
+* watchdog running, nrf_bootloader_wdt.c feeds it from a timer and relies on
+* the scheduler never being blocked for more than
+* NRF_BL_WDT_MAX_SCHEDULER_LATENCY_MS. Image hashing, the page erases of the
+* activation copy and settings writes call wdt_feed_point() between their
+* chunks instead, so they can not starve the watchdog however long they take.
+*
+* Every feed point and the end of every scheduler run (app_sched_execute()
+* is wrapped at link time, see the Makefile) record the time since the
+* previous mark. The largest gap is the bound for the watchdog period, gaps
+* over WDT_FEED_GAP_BUDGET_MS are counted.
+*/
+
+typedef struct {
+  uint32_t feeds;       // feed points passed with the watchdog running
+  uint32_t gap_max_ms;  // longest time between two marks
+  uint32_t over_budget; // gaps longer than WDT_FEED_GAP_BUDGET_MS
+} wdt_feed_stats_t;
+
+#if WDT_FEED_POINTS_ENABLED
+
+void wdt_feed_init();
+void wdt_feed_point();
+void wdt_feed_stats_get(wdt_feed_stats_t * p_stats);
+void wdt_feed_stats_log();
+
+#else
+
+#define wdt_feed_init()
+#define wdt_feed_point()
+#define wdt_feed_stats_log()
+
+#endif
+
+#endif
@@ -0,0 +1,272 @@
+#include <string.h>
+#include "app_usbd_dfu_bulk.h"
+#include "app_usbd_core.h"
+#include "app_util.h"
+#include "nrf.h"
+
+#define DFU_BULK_IFACE_IDX 0
+#define DFU_BULK_EPIN_IDX 0
+#define DFU_BULK_EPOUT_IDX 1
+
+static inline app_usbd_dfu_bulk_t const * dfu_bulk_get(app_usbd_class_inst_t const * p_inst) {
+  return (app_usbd_dfu_bulk_t const *)p_inst;
+}
+
+static inline app_usbd_dfu_bulk_ctx_t * dfu_bulk_ctx_get(app_usbd_dfu_bulk_t const * p_bulk) {
+  return &p_bulk->specific.p_data->ctx;
+}
+
+static nrf_drv_usbd_ep_t dfu_bulk_ep_get(app_usbd_class_inst_t const * p_inst, uint8_t ep_idx) {
+  app_usbd_class_iface_conf_t const * p_iface = app_usbd_class_iface_get(p_inst, DFU_BULK_IFACE_IDX);
+  return app_usbd_class_ep_address_get(app_usbd_class_iface_ep_get(p_iface, ep_idx));
+}
+
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+static void stats_update(app_usbd_dfu_bulk_ep_stats_t * p_stats, uint32_t start, size_t size) {
+  uint32_t cycles = DWT->CYCCNT - start;
+
+  p_stats->transfers++;
+  p_stats->bytes += size;
+  p_stats->cycles_total += cycles;
+
+  if (cycles > p_stats->cycles_max) {
+    p_stats->cycles_max = cycles;
+  }
+}
+
+void app_usbd_dfu_bulk_stats_get(app_usbd_dfu_bulk_t const * p_bulk,
+                                 app_usbd_dfu_bulk_ep_stats_t * p_rx_stats,
+                                 app_usbd_dfu_bulk_ep_stats_t * p_tx_stats) {
+  app_usbd_dfu_bulk_ctx_t const * p_ctx = dfu_bulk_ctx_get(p_bulk);
+
+  *p_rx_stats = p_ctx->rx_stats;
+  *p_tx_stats = p_ctx->tx_stats;
+}
+#endif
+
+static void user_event(app_usbd_class_inst_t const * p_inst, app_usbd_dfu_bulk_user_event_t event) {
+  app_usbd_dfu_bulk_t const * p_bulk = dfu_bulk_get(p_inst);
+
+  if (p_bulk->specific.inst.user_ev_handler != NULL) {
+    p_bulk->specific.inst.user_ev_handler(p_inst, event);
+  }
+}
+
+/*
+* Queues one OUT transfer. The endpoint keeps receiving max packet size
+* packets straight into p_buf (EasyDMA) until length bytes or a short packet
+* arrived, only then RX_DONE is reported. Until the next read is queued the
+* endpoint NAKs, which is what throttles the host while no buffer is free.
+*/
+ret_code_t app_usbd_dfu_bulk_read(app_usbd_dfu_bulk_t const * p_bulk, void * p_buf, size_t length) {
+  app_usbd_dfu_bulk_ctx_t * p_ctx = dfu_bulk_ctx_get(p_bulk);
+  ret_code_t ret;
+
+  if (p_ctx->rx_busy) {
+    return NRF_ERROR_BUSY;
+  }
+
+  nrf_drv_usbd_transfer_t transfer = {
+    .p_data = { .rx = p_buf },
+    .size = length,
+    .flags = 0
+  };
+
+  ret = app_usbd_ep_transfer(dfu_bulk_ep_get(&p_bulk->base, DFU_BULK_EPOUT_IDX), &transfer);
+
+  if (ret == NRF_SUCCESS) {
+    p_ctx->rx_busy = true;
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+    p_ctx->rx_start = DWT->CYCCNT;
+#endif
+  }
+
+  return ret;
+}
+
+size_t app_usbd_dfu_bulk_rx_size(app_usbd_dfu_bulk_t const * p_bulk) {
+  return dfu_bulk_ctx_get(p_bulk)->rx_size;
+}
+
+bool app_usbd_dfu_bulk_rx_busy(app_usbd_dfu_bulk_t const * p_bulk) {
+  return dfu_bulk_ctx_get(p_bulk)->rx_busy;
+}
+
+bool app_usbd_dfu_bulk_tx_busy(app_usbd_dfu_bulk_t const * p_bulk) {
+  return dfu_bulk_ctx_get(p_bulk)->tx_busy;
+}
+
+/*
+* Queues one IN transfer. The buffer must stay valid until TX_DONE.
+*/
+ret_code_t app_usbd_dfu_bulk_write(app_usbd_dfu_bulk_t const * p_bulk, void const * p_buf, size_t length) {
+  app_usbd_dfu_bulk_ctx_t * p_ctx = dfu_bulk_ctx_get(p_bulk);
+  ret_code_t ret;
+
+  if (p_ctx->tx_busy) {
+    return NRF_ERROR_BUSY;
+  }
+
+  //a response that fills the last packet completely needs a ZLP to end the transfer
+  nrf_drv_usbd_transfer_t transfer = {
+    .p_data = { .tx = p_buf },
+    .size = length,
+    .flags = ((length % NRF_DRV_USBD_EPSIZE) == 0) ? NRF_DRV_USBD_TRANSFER_ZLP_FLAG : 0
+  };
+
+  ret = app_usbd_ep_transfer(dfu_bulk_ep_get(&p_bulk->base, DFU_BULK_EPIN_IDX), &transfer);
+
+  if (ret == NRF_SUCCESS) {
+    p_ctx->tx_busy = true;
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+    p_ctx->tx_start = DWT->CYCCNT;
+#endif
+  }
+
+  return ret;
+}
+
+static void dfu_bulk_reset(app_usbd_class_inst_t const * p_inst) {
+  app_usbd_dfu_bulk_ctx_t * p_ctx = dfu_bulk_ctx_get(dfu_bulk_get(p_inst));
+
+  p_ctx->rx_busy = false;
+  p_ctx->tx_busy = false;
+  p_ctx->rx_size = 0;
+
+  user_event(p_inst, APP_USBD_DFU_BULK_USER_EVT_CLOSED);
+}
+
+static ret_code_t dfu_bulk_endpoint_ev(app_usbd_class_inst_t const * p_inst, app_usbd_complex_evt_t const * p_event) {
+  app_usbd_dfu_bulk_ctx_t * p_ctx = dfu_bulk_ctx_get(dfu_bulk_get(p_inst));
+  nrf_drv_usbd_ep_t ep = p_event->drv_evt.data.eptransfer.ep;
+
+  if (NRF_USBD_EPIN_CHECK(ep)) {
+    p_ctx->tx_busy = false;
+
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+    if (p_event->drv_evt.data.eptransfer.status == NRF_USBD_EP_OK) {
+      size_t tx_size = 0;
+      (void)nrf_drv_usbd_ep_status_get(ep, &tx_size);
+      stats_update(&p_ctx->tx_stats, p_ctx->tx_start, tx_size);
+    }
+#endif
+
+    //also reported for aborted transfers, the endpoint is free for the next response either way
+    user_event(p_inst, APP_USBD_DFU_BULK_USER_EVT_TX_DONE);
+    return NRF_SUCCESS;
+  }
+
+  switch (p_event->drv_evt.data.eptransfer.status) {
+    case NRF_USBD_EP_OK:
+      p_ctx->rx_busy = false;
+      (void)nrf_drv_usbd_ep_status_get(ep, &p_ctx->rx_size);
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+      stats_update(&p_ctx->rx_stats, p_ctx->rx_start, p_ctx->rx_size);
+#endif
+      user_event(p_inst, APP_USBD_DFU_BULK_USER_EVT_RX_DONE);
+      return NRF_SUCCESS;
+
+    case NRF_USBD_EP_WAITING:
+      //data arrived before a read was queued, it is picked up by the next read
+      return NRF_SUCCESS;
+
+    case NRF_USBD_EP_OVERLOAD:
+      /*
+      * The host sent more than the queued buffer holds. The request is
+      * dropped and reported as an empty transfer, which makes the user queue
+      * the next read into the same buffer. Returning an error would stall
+      * the endpoint instead and bulk OUT would be dead until a bus reset.
+      */
+      p_ctx->rx_busy = false;
+      p_ctx->rx_size = 0;
+      user_event(p_inst, APP_USBD_DFU_BULK_USER_EVT_RX_DONE);
+      return NRF_SUCCESS;
+
+    default:
+      p_ctx->rx_busy = false;
+      return NRF_SUCCESS;
+  }
+}
+
+static ret_code_t dfu_bulk_event_handler(app_usbd_class_inst_t const * p_inst, app_usbd_complex_evt_t const * p_event) {
+  switch (p_event->app_evt.type) {
+    case APP_USBD_EVT_DRV_EPTRANSFER:
+      return dfu_bulk_endpoint_ev(p_inst, p_event);
+
+    case APP_USBD_EVT_DRV_RESET:
+    case APP_USBD_EVT_STOPPED:
+      dfu_bulk_reset(p_inst);
+      return NRF_SUCCESS;
+
+    case APP_USBD_EVT_STATE_CHANGED:
+      if (app_usbd_core_state_get() == APP_USBD_STATE_Configured) {
+        user_event(p_inst, APP_USBD_DFU_BULK_USER_EVT_READY);
+      }
+      return NRF_SUCCESS;
+
+    case APP_USBD_EVT_INST_APPEND:
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+      //the cycle counter is shared, only make sure it runs
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+      return NRF_SUCCESS;
+
+    case APP_USBD_EVT_DRV_SOF:
+    case APP_USBD_EVT_DRV_SUSPEND:
+    case APP_USBD_EVT_DRV_RESUME:
+    case APP_USBD_EVT_INST_REMOVE:
+    case APP_USBD_EVT_STARTED:
+      return NRF_SUCCESS;
+
+    default:
+      //no class or vendor requests
+      return NRF_ERROR_NOT_SUPPORTED;
+  }
+}
+
+/*
+* One vendor specific interface with a bulk IN and a bulk OUT endpoint. The
+* statics are required by the descriptor macros, which resume the function
+* where it left off when the descriptor does not fit into max_size.
+*/
+static bool dfu_bulk_feed_descriptors(app_usbd_class_descriptor_ctx_t * p_ctx,
+                                      app_usbd_class_inst_t const * p_inst,
+                                      uint8_t * p_buff,
+                                      size_t max_size) {
+  static app_usbd_class_iface_conf_t const * p_cur_iface = NULL;
+  static uint8_t endpoints = 0;
+  static uint8_t i = 0;
+
+  p_cur_iface = app_usbd_class_iface_get(p_inst, DFU_BULK_IFACE_IDX);
+  endpoints = app_usbd_class_iface_ep_count_get(p_cur_iface);
+
+  APP_USBD_CLASS_DESCRIPTOR_BEGIN(p_ctx, p_buff, max_size);
+
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(0x09); // bLength
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_INTERFACE); // bDescriptorType
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(app_usbd_class_iface_number_get(p_cur_iface)); // bInterfaceNumber
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // bAlternateSetting
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(endpoints); // bNumEndpoints
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DFU_BULK_CLASS); // bInterfaceClass
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DFU_BULK_SUBCLASS); // bInterfaceSubClass
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DFU_BULK_PROTOCOL); // bInterfaceProtocol
+  APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // iInterface
+
+  for (i = 0; i < endpoints; i++) {
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(0x07); // bLength
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_ENDPOINT); // bDescriptorType
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(app_usbd_class_ep_address_get(app_usbd_class_iface_ep_get(p_cur_iface, i))); // bEndpointAddress
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_EP_ATTR_TYPE_BULK); // bmAttributes
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(LSB_16(NRF_DRV_USBD_EPSIZE)); // wMaxPacketSize LSB
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(MSB_16(NRF_DRV_USBD_EPSIZE)); // wMaxPacketSize MSB
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // bInterval
+  }
+
+  APP_USBD_CLASS_DESCRIPTOR_END();
+}
+
+const app_usbd_class_methods_t app_usbd_dfu_bulk_class_methods = {
+  .event_handler = dfu_bulk_event_handler,
+  .feed_descriptors = dfu_bulk_feed_descriptors,
+};
@@ -0,0 +1,72 @@
+#include <string.h>
+#include "boot_probe.h"
+
+#if BOOT_PROBES_ACTIVE
+
+#include "app_util_platform.h"
+
+#define NRF_LOG_MODULE_NAME boot_probe
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+static boot_probe_stats_t m_probes[BOOT_PROBE_COUNT];
+
+static char const * const m_probe_names[BOOT_PROBE_COUNT] = {
+  "copy_kdr", "bootloader_init", "measured_boot", "dfu_request"
+};
+
+/*
+* Must run before the first probe, i.e. at the start of main().
+*/
+void boot_probe_init() {
+  memset(m_probes, 0, sizeof(m_probes));
+
+#if defined(__arm__)
+  //the cycle counter is shared, only make sure it runs
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+void boot_probe_record(boot_probe_id_t id, uint32_t duration) {
+  boot_probe_stats_t * p_probe = &m_probes[id];
+
+  //probes may end in interrupt context
+  CRITICAL_REGION_ENTER();
+
+  if ((p_probe->count == 0) || (duration < p_probe->min)) {
+    p_probe->min = duration;
+  }
+
+  if (duration > p_probe->max) {
+    p_probe->max = duration;
+  }
+
+  p_probe->count++;
+  p_probe->total += duration;
+
+  CRITICAL_REGION_EXIT();
+}
+
+void boot_probe_get(boot_probe_id_t id, boot_probe_stats_t * p_stats) {
+  CRITICAL_REGION_ENTER();
+  *p_stats = m_probes[id];
+  CRITICAL_REGION_EXIT();
+}
+
+void boot_probe_log() {
+  for (uint32_t id = 0; id < BOOT_PROBE_COUNT; id++) {
+    boot_probe_stats_t probe;
+
+    boot_probe_get((boot_probe_id_t)id, &probe);
+
+    if (probe.count == 0) {
+      continue;
+    }
+
+    NRF_LOG_INFO("%s: %d runs, %d/%d/%d cycles min/avg/max",
+                 m_probe_names[id], probe.count, probe.min, (uint32_t)(probe.total / probe.count), probe.max);
+  }
+}
+
+#endif
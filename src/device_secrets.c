@@ -0,0 +1,157 @@
+#include <stddef.h>
+#include <string.h>
+#include "device_secrets.h"
+#include "nrf_error.h"
+#include "crc32.h"
+
+static uint32_t table_crc(uint8_t const * p_page, uint16_t size) {
+  uint32_t start = offsetof(device_secrets_header_t, magic);
+  return crc32_compute(p_page + start, size - start, NULL);
+}
+
+/*
+* True if the page carries the magic of the slot table, whether or not the
+* table is intact. A legacy key has the magic at bytes 4..7 of the key only
+* with a probability of 2^-32.
+*/
+bool device_secrets_table_present(uint8_t const * p_page) {
+  return ((device_secrets_header_t const *)p_page)->magic == DEVICE_SECRETS_MAGIC;
+}
+
+/*
+* Checks the header, the bounds of every used slot and the crc. This is the
+* only part of the page access that is not constant time and is meant to be
+* done once per boot through device_secrets_open().
+*/
+bool device_secrets_table_valid(uint8_t const * p_page) {
+  device_secrets_header_t const * p_header = (device_secrets_header_t const *)p_page;
+
+  if ((p_header->magic != DEVICE_SECRETS_MAGIC) || (p_header->version != DEVICE_SECRETS_VERSION)) {
+    return false;
+  }
+
+  if ((p_header->size < sizeof(device_secrets_header_t)) ||
+      (p_header->size > DEVICE_SECRETS_PAGE_SIZE) ||
+      (p_header->size % sizeof(uint32_t) != 0)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < DEVICE_SECRETS_MAX_SLOTS; i++) {
+    secret_slot_entry_t const * p_slot = &p_header->slots[i];
+
+    if (p_slot->length == 0) {
+      continue;
+    }
+
+    if ((p_slot->offset < sizeof(device_secrets_header_t)) ||
+        (p_slot->offset % sizeof(uint32_t) != 0) ||
+        ((uint32_t)p_slot->offset + p_slot->length > p_header->size)) {
+      return false;
+    }
+  }
+
+  return (p_header->crc == table_crc(p_page, p_header->size));
+}
+
+/*
+* Validates the page and remembers which layout it uses. Only pages without
+* the table magic are read as the flat legacy layout. A table that is present
+* but fails the checks is an error, reading it as legacy would hand out its
+* header as the root key.
+*/
+uint32_t device_secrets_open(device_secrets_t * p_secrets, uint8_t const * p_page) {
+  p_secrets->p_page = p_page;
+  p_secrets->legacy = !device_secrets_table_present(p_page);
+
+  if (!p_secrets->legacy && !device_secrets_table_valid(p_page)) {
+    return NRF_ERROR_INVALID_DATA;
+  }
+
+  return NRF_SUCCESS;
+}
+
+static uint32_t legacy_find(uint8_t const * p_page, secret_slot_t slot, uint8_t const ** pp_data, uint16_t * p_length) {
+  device_secrets_legacy_t const * p_legacy = (device_secrets_legacy_t const *)p_page;
+
+  switch (slot) {
+    case SECRET_ROOT_KEY:
+      *pp_data = p_legacy->root_key;
+      *p_length = sizeof(p_legacy->root_key);
+      break;
+    case SECRET_DEVICE_ID:
+      *pp_data = p_legacy->device_id;
+      *p_length = sizeof(p_legacy->device_id);
+      break;
+    case SECRET_ATTESTATION_SEED:
+      *pp_data = p_legacy->attestation_seed;
+      *p_length = sizeof(p_legacy->attestation_seed);
+      break;
+    default:
+      return NRF_ERROR_NOT_FOUND;
+  }
+
+  //secrets that were never written are still erased
+  for (uint16_t i = 0; i < *p_length; i++) {
+    if ((*pp_data)[i] != 0xFF) {
+      return NRF_SUCCESS;
+    }
+  }
+
+  return NRF_ERROR_NOT_FOUND;
+}
+
+/*
+* Locates a secret in a page opened with device_secrets_open(). The slot number
+* indexes the slot table directly so no search is involved.
+*/
+uint32_t device_secrets_find(device_secrets_t const * p_secrets, secret_slot_t slot, uint8_t const ** pp_data, uint16_t * p_length) {
+  device_secrets_header_t const * p_header = (device_secrets_header_t const *)p_secrets->p_page;
+
+  if ((uint32_t)slot >= DEVICE_SECRETS_MAX_SLOTS) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+
+  if (p_secrets->legacy) {
+    return legacy_find(p_secrets->p_page, slot, pp_data, p_length);
+  }
+
+  if (p_header->slots[slot].length == 0) {
+    return NRF_ERROR_NOT_FOUND;
+  }
+
+  *pp_data = p_secrets->p_page + p_header->slots[slot].offset;
+  *p_length = p_header->slots[slot].length;
+
+  return NRF_SUCCESS;
+}
+
+/*
+* Lays out the default slot table (root key, device ID and attestation seed)
+* in a RAM copy of the page. The slot data is left erased.
+*/
+void device_secrets_default_init(uint8_t * p_page) {
+  device_secrets_header_t * p_header = (device_secrets_header_t *)p_page;
+
+  memset(p_page, 0xFF, sizeof(device_secrets_default_t));
+  memset(p_header->slots, 0, sizeof(p_header->slots));
+
+  p_header->magic = DEVICE_SECRETS_MAGIC;
+  p_header->version = DEVICE_SECRETS_VERSION;
+  p_header->size = sizeof(device_secrets_default_t);
+
+  p_header->slots[SECRET_ROOT_KEY].offset = offsetof(device_secrets_default_t, root_key);
+  p_header->slots[SECRET_ROOT_KEY].length = DEVICE_ROOT_KEY_SIZE;
+  p_header->slots[SECRET_DEVICE_ID].offset = offsetof(device_secrets_default_t, device_id);
+  p_header->slots[SECRET_DEVICE_ID].length = DEVICE_ID_SIZE;
+  p_header->slots[SECRET_ATTESTATION_SEED].offset = offsetof(device_secrets_default_t, attestation_seed);
+  p_header->slots[SECRET_ATTESTATION_SEED].length = ATTESTATION_SEED_SIZE;
+}
+
+/*
+* Updates the crc of a RAM copy of the page after its content changed.
+*/
+void device_secrets_seal(uint8_t * p_page) {
+  device_secrets_header_t * p_header = (device_secrets_header_t *)p_page;
+
+  p_header->crc = table_crc(p_page, p_header->size);
+}
@@ -0,0 +1,159 @@
+#include <string.h>
+#include "dfu_power.h"
+#include "sdk_config.h"
+#include "app_timer.h"
+#include "app_error.h"
+#include "nrf_power.h"
+
+#define NRF_LOG_MODULE_NAME dfu_power
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+/*
+* Keeps track of the power state while waiting in DFU mode and estimates the
+* current drawn from the time spent in each state. The RTC counter behind
+* app_timer is only 24 bits wide, so the time is also accounted periodically
+* and not only on state changes.
+*/
+
+#define ACCOUNT_INTERVAL_MS 60000
+#define TICKS_PER_SECOND APP_TIMER_TICKS(1000)
+
+APP_TIMER_DEF(m_account_timer);
+
+static dfu_power_state_t m_state = DFU_POWER_DETACHED;
+static uint32_t m_last_ticks;
+static uint64_t m_state_ticks[DFU_POWER_STATE_COUNT];
+
+static const uint32_t m_state_current_ua[DFU_POWER_STATE_COUNT] = {
+  DFU_POWER_CURRENT_ACTIVE_UA,
+  DFU_POWER_CURRENT_IDLE_UA,
+  DFU_POWER_CURRENT_SUSPENDED_UA,
+  DFU_POWER_CURRENT_DETACHED_UA
+};
+
+static char const * const m_state_names[DFU_POWER_STATE_COUNT] = {
+  "active", "idle", "suspended", "detached"
+};
+
+static void account() {
+  uint32_t now = app_timer_cnt_get();
+
+  m_state_ticks[m_state] += app_timer_cnt_diff_compute(now, m_last_ticks);
+  m_last_ticks = now;
+}
+
+static void state_set(dfu_power_state_t state) {
+  if (state == m_state) {
+    return;
+  }
+
+  account();
+  NRF_LOG_DEBUG("%s -> %s", m_state_names[m_state], m_state_names[state]);
+  m_state = state;
+}
+
+static void account_timeout_handler(void * p_context) {
+  account();
+}
+
+/*
+* Must be called after app_timer_init(), i.e. when entering DFU mode.
+*/
+void dfu_power_init() {
+  uint32_t err_code;
+
+#if DFU_POWER_DCDC_ENABLED
+  //the board must have the DCDC inductor fitted (PCA10059 has)
+  nrf_power_dcdcen_set(true);
+#endif
+
+  memset(m_state_ticks, 0, sizeof(m_state_ticks));
+  m_state = DFU_POWER_DETACHED;
+  m_last_ticks = app_timer_cnt_get();
+
+  err_code = app_timer_create(&m_account_timer, APP_TIMER_MODE_REPEATED, account_timeout_handler);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = app_timer_start(m_account_timer, APP_TIMER_TICKS(ACCOUNT_INTERVAL_MS), NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+void dfu_power_on_dfu_evt(nrf_dfu_evt_type_t evt_type) {
+  switch (evt_type) {
+    case NRF_DFU_EVT_TRANSPORT_ACTIVATED:
+      state_set(DFU_POWER_IDLE);
+      break;
+
+    case NRF_DFU_EVT_TRANSPORT_DEACTIVATED:
+      state_set(DFU_POWER_DETACHED);
+      dfu_power_log();
+      break;
+
+    case NRF_DFU_EVT_DFU_STARTED:
+    case NRF_DFU_EVT_OBJECT_RECEIVED:
+      if (m_state != DFU_POWER_DETACHED) {
+        state_set(DFU_POWER_ACTIVE);
+      }
+      break;
+
+    case NRF_DFU_EVT_DFU_COMPLETED:
+    case NRF_DFU_EVT_DFU_FAILED:
+    case NRF_DFU_EVT_DFU_ABORTED:
+      if (m_state == DFU_POWER_ACTIVE) {
+        state_set(DFU_POWER_IDLE);
+      }
+      dfu_power_log();
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*
+* Called by the USB transport when the host suspends or resumes the bus.
+*/
+void dfu_power_on_usb_suspend(bool suspended) {
+  if (m_state == DFU_POWER_DETACHED) {
+    return;
+  }
+
+  state_set(suspended ? DFU_POWER_SUSPENDED : DFU_POWER_IDLE);
+}
+
+dfu_power_state_t dfu_power_state_get() {
+  return m_state;
+}
+
+/*
+* Time spent in a state so far, in app_timer ticks.
+*/
+uint64_t dfu_power_ticks_get(dfu_power_state_t state) {
+  account();
+
+  return m_state_ticks[state];
+}
+
+/*
+* Logs the time spent in each state and the estimated average current.
+*/
+void dfu_power_log() {
+  uint64_t total_ticks = 0;
+  uint64_t charge = 0; // uA * ticks
+
+  account();
+
+  for (uint32_t state = 0; state < DFU_POWER_STATE_COUNT; state++) {
+    total_ticks += m_state_ticks[state];
+    charge += m_state_ticks[state] * m_state_current_ua[state];
+
+    NRF_LOG_INFO("%s: %d s", m_state_names[state], (uint32_t)(m_state_ticks[state] / TICKS_PER_SECOND));
+  }
+
+  if (total_ticks > 0) {
+    NRF_LOG_INFO("Estimated average current %d uA, %d uAh",
+                 (uint32_t)(charge / total_ticks),
+                 (uint32_t)(charge / (TICKS_PER_SECOND * 3600ULL)));
+  }
+}
@@ -0,0 +1,131 @@
+#include <stddef.h>
+#include "dfu_telemetry.h"
+
+#if DFU_TELEMETRY_ENABLED
+
+#include "usb_dfu_transport.h"
+#include "nrf_dfu_settings.h"
+#include "app_timer.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "SEGGER_RTT.h"
+
+/*
+* Writes a telemetry record to its RTT channel every
+* DFU_TELEMETRY_INTERVAL_MS and on every DFU event that changes the progress.
+* The channel does not block, a record that does not fit is dropped and the
+* gap shows in the sequence number.
+*/
+
+#define TICKS_PER_SECOND APP_TIMER_TICKS(1000)
+
+APP_TIMER_DEF(m_telemetry_timer);
+
+static uint8_t m_rtt_buffer[DFU_TELEMETRY_BUFFER_SIZE];
+static uint16_t m_sequence;
+static uint16_t m_objects_committed;
+static uint8_t m_flags;
+static uint32_t m_last_ticks;
+static uint64_t m_ticks;
+
+static void record_send() {
+  dfu_telemetry_record_t record;
+  usb_dfu_transport_load_t load;
+  uint8_t const * p_bytes = (uint8_t const *)&record;
+  uint8_t sum = 0;
+  uint32_t now;
+
+  //called from the timer interrupt and from the scheduler
+  CRITICAL_REGION_ENTER();
+
+  now = app_timer_cnt_get();
+  m_ticks += app_timer_cnt_diff_compute(now, m_last_ticks);
+  m_last_ticks = now;
+
+  usb_dfu_transport_load_get(&load);
+
+  record.sync = DFU_TELEMETRY_SYNC;
+  record.length = sizeof(record);
+  record.version = DFU_TELEMETRY_VERSION;
+  record.flags = m_flags;
+  record.sequence = m_sequence++;
+  record.objects_committed = m_objects_committed;
+  record.time_ms = (uint32_t)(m_ticks * 1000 / TICKS_PER_SECOND);
+  record.bytes_received = s_dfu_settings.progress.firmware_image_offset;
+  record.bytes_committed = s_dfu_settings.progress.firmware_image_offset_last;
+  record.flash_backlog = load.flash_backlog;
+  record.rx_held = load.rx_held;
+  record.rx_buffers_used = (uint8_t)load.rx_buffers_used;
+
+  for (uint32_t i = 0; i < offsetof(dfu_telemetry_record_t, checksum); i++) {
+    sum += p_bytes[i];
+  }
+
+  record.checksum = (uint8_t)(0x100 - sum);
+
+  (void)SEGGER_RTT_Write(DFU_TELEMETRY_RTT_CHANNEL, &record, sizeof(record));
+
+  CRITICAL_REGION_EXIT();
+}
+
+static void telemetry_timeout_handler(void * p_context) {
+  record_send();
+}
+
+/*
+* Must be called after app_timer_init(), i.e. when entering DFU mode.
+*/
+void dfu_telemetry_init() {
+  uint32_t err_code;
+
+  SEGGER_RTT_Init();
+  (void)SEGGER_RTT_ConfigUpBuffer(DFU_TELEMETRY_RTT_CHANNEL, "DfuTelemetry",
+                                  m_rtt_buffer, sizeof(m_rtt_buffer),
+                                  SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+  m_sequence = 0;
+  m_objects_committed = 0;
+  m_flags = 0;
+  m_ticks = 0;
+  m_last_ticks = app_timer_cnt_get();
+
+  err_code = app_timer_create(&m_telemetry_timer, APP_TIMER_MODE_REPEATED, telemetry_timeout_handler);
+  APP_ERROR_CHECK(err_code);
+
+  err_code = app_timer_start(m_telemetry_timer, APP_TIMER_TICKS(DFU_TELEMETRY_INTERVAL_MS), NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+void dfu_telemetry_on_dfu_evt(nrf_dfu_evt_type_t evt_type) {
+  switch (evt_type) {
+    case NRF_DFU_EVT_TRANSPORT_ACTIVATED:
+      m_flags |= DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE;
+      break;
+
+    case NRF_DFU_EVT_TRANSPORT_DEACTIVATED:
+      m_flags &= ~(DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE | DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS);
+      break;
+
+    case NRF_DFU_EVT_DFU_STARTED:
+      m_flags |= DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS;
+      m_objects_committed = 0;
+      break;
+
+    case NRF_DFU_EVT_OBJECT_RECEIVED:
+      m_objects_committed++;
+      break;
+
+    case NRF_DFU_EVT_DFU_COMPLETED:
+    case NRF_DFU_EVT_DFU_FAILED:
+    case NRF_DFU_EVT_DFU_ABORTED:
+      m_flags &= ~DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS;
+      break;
+
+    default:
+      return;
+  }
+
+  record_send();
+}
+
+#endif
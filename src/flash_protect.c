@@ -0,0 +1,143 @@
+#include "flash_protect.h"
+#include "memory_layout.h"
+#include "nrf.h"
+#include "nrf_error.h"
+#include "nrf_bootloader_info.h"
+#include "app_util.h"
+
+#define NRF_LOG_MODULE_NAME flash_protect
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+/*
+* Sorted by address, only neighbouring entries of the same pass are merged.
+* The device secrets are read protected, so they are only protected once
+* copy_kdr() has loaded the key and provisioned the page.
+*/
+static const flash_protect_region_t m_regions[] = {
+  { MEMORY_MBR_ADDRESS, MEMORY_MBR_SIZE, false, FLASH_PROTECT_CODE },
+  { MEMORY_DEVICE_SECRETS_ADDRESS, MEMORY_DEVICE_SECRETS_SIZE, true, FLASH_PROTECT_SECRETS },
+  { MEMORY_BOOTLOADER_ADDRESS, MEMORY_BOOTLOADER_SIZE, false, FLASH_PROTECT_CODE },
+};
+
+#if defined(ACL_PRESENT)
+static uint32_t perm_get(bool read_protect) {
+  uint32_t perm = ACL_ACL_PERM_WRITE_Disable << ACL_ACL_PERM_WRITE_Pos;
+
+  if (read_protect) {
+    perm |= ACL_ACL_PERM_READ_Disable << ACL_ACL_PERM_READ_Pos;
+  }
+
+  return perm;
+}
+
+/*
+* True if a configured ACL region spans the range and denies at least the
+* same accesses.
+*/
+static bool acl_covers(uint32_t address, uint32_t size, uint32_t perm) {
+  for (uint32_t i = 0; i < ACL_REGIONS_COUNT; i++) {
+    uint32_t acl_address = NRF_ACL->ACL[i].ADDR;
+    uint32_t acl_size = NRF_ACL->ACL[i].SIZE;
+
+    if ((acl_size != 0) && (acl_address <= address) && (address + size <= acl_address + acl_size) &&
+        ((NRF_ACL->ACL[i].PERM & perm) == perm)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint32_t flash_protect_apply(flash_protect_pass_t pass) {
+  uint32_t slot = 0;
+  uint32_t written = 0;
+  uint32_t i = 0;
+
+  while (i < ARRAY_SIZE(m_regions)) {
+    uint32_t address = m_regions[i].address;
+    uint32_t size = m_regions[i].size;
+    uint32_t perm = perm_get(m_regions[i].read_protect);
+
+    if (m_regions[i].pass != pass) {
+      i++;
+      continue;
+    }
+
+    for (i++; (i < ARRAY_SIZE(m_regions)) && (m_regions[i].pass == pass) &&
+              (m_regions[i].address == address + size) &&
+              (perm_get(m_regions[i].read_protect) == perm); i++) {
+      size += m_regions[i].size;
+    }
+
+    if (acl_covers(address, size, perm)) {
+      continue;
+    }
+
+    //regions are write once until reset, take the next unused one
+    while ((slot < ACL_REGIONS_COUNT) && (NRF_ACL->ACL[slot].SIZE != 0)) {
+      slot++;
+    }
+
+    if (slot == ACL_REGIONS_COUNT) {
+      return NRF_ERROR_NO_MEM;
+    }
+
+    NRF_ACL->ACL[slot].ADDR = address;
+    NRF_ACL->ACL[slot].SIZE = size;
+    NRF_ACL->ACL[slot].PERM = perm;
+
+    if ((NRF_ACL->ACL[slot].ADDR != address) || (NRF_ACL->ACL[slot].SIZE != size) ||
+        (NRF_ACL->ACL[slot].PERM != perm)) {
+      NRF_LOG_ERROR("ACL region %d does not hold 0x%08x", slot, address);
+      return NRF_ERROR_INTERNAL;
+    }
+
+    written++;
+  }
+
+  NRF_LOG_DEBUG("%d ACL regions written", written);
+
+  return NRF_SUCCESS;
+}
+
+/*
+* Checks every region of the table against the ACL registers again, without
+* relying on the result of flash_protect_apply(). Called right before the
+* application is started.
+*/
+uint32_t flash_protect_verify() {
+  for (uint32_t i = 0; i < ARRAY_SIZE(m_regions); i++) {
+    if (!acl_covers(m_regions[i].address, m_regions[i].size, perm_get(m_regions[i].read_protect))) {
+      NRF_LOG_ERROR("0x%08x is not protected", m_regions[i].address);
+      return NRF_ERROR_INTERNAL;
+    }
+  }
+
+  return NRF_SUCCESS;
+}
+#else
+uint32_t flash_protect_apply(flash_protect_pass_t pass) {
+  uint32_t ret_code;
+
+  //BPROT has no shared configuration to merge, use the SDK per region
+  for (uint32_t i = 0; i < ARRAY_SIZE(m_regions); i++) {
+    if (m_regions[i].pass != pass) {
+      continue;
+    }
+
+    ret_code = nrf_bootloader_flash_protect(m_regions[i].address, m_regions[i].size, m_regions[i].read_protect);
+
+    if (ret_code != NRF_SUCCESS) {
+      return ret_code;
+    }
+  }
+
+  return NRF_SUCCESS;
+}
+
+uint32_t flash_protect_verify() {
+  //the BPROT configuration is not read back
+  return NRF_SUCCESS;
+}
+#endif
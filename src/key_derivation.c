@@ -0,0 +1,67 @@
+/* NRF52840 Hardware Interface Library. */
+#include "nrf52840.h"
+#include <string.h>
+#include "key_derivation.h"
+#include "nrf_error.h"
+#include "sasi_util_key_derivation.h"
+
+/*
+* Derived keys handed over to the application. The section is placed at the
+* start of the handoff area by the linker script and is not zeroed at startup.
+*/
+key_handoff_t key_handoff __attribute__((section(".key_handoff")));
+
+/*
+* Labels used as the purpose input of the KDF, indexed by derived_key_id_t.
+*/
+static const char * const derivation_labels[DERIVED_KEY_COUNT] = {
+  "storage",
+  "attestation",
+  "transport",
+};
+
+/*
+* Clears the handoff area so the application never sees stale or partially
+* derived keys.
+*/
+void clear_derived_keys() {
+  memset(&key_handoff, 0, sizeof(key_handoff));
+}
+
+/*
+* Derives one key per purpose from the device root key using the CryptoCell
+* AES-CMAC based KDF (NIST SP800-108 counter mode). The root key never leaves
+* the KDR registers, only the derived keys are written into the handoff area.
+* The device ID is used as context so keys are bound to this chip.
+*
+* Must be called while the cryptocell is enabled, the life cycle state is
+* secure and the KDR registers have been loaded i.e. from within copy_kdr().
+*/
+uint32_t derive_keys() {
+  uint32_t ret;
+  uint8_t context[8];
+
+  clear_derived_keys();
+
+  memcpy(&context[0], (const void *)&NRF_FICR->DEVICEID[0], sizeof(uint32_t));
+  memcpy(&context[4], (const void *)&NRF_FICR->DEVICEID[1], sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < DERIVED_KEY_COUNT; i++) {
+    ret = SaSi_UtilDeviceRootKeyDerivation((const uint8_t *)derivation_labels[i],
+                                           strlen(derivation_labels[i]),
+                                           context,
+                                           sizeof(context),
+                                           key_handoff.keys[i],
+                                           DERIVED_KEY_SIZE);
+
+    if (ret != SASI_UTIL_OK) {
+      clear_derived_keys();
+      return NRF_ERROR_INTERNAL;
+    }
+  }
+
+  key_handoff.key_count = DERIVED_KEY_COUNT;
+  key_handoff.magic = KEY_HANDOFF_MAGIC;
+
+  return NRF_SUCCESS;
+}
@@ -64,12 +64,47 @@
 #include "nrf_delay.h"
 #include "nrf_clock.h"
 #include "secure.h"
+#include "measured_boot.h"
+#include "dfu_power.h"
+#include "trace.h"
+#include "boot_probe.h"
+#include "dfu_telemetry.h"
+#include "settings_log.h"
+#include "ramfunc.h"
+#include "nvmc_erase.h"
+#include "flash_protect.h"
+#include "wdt_feed.h"
 
 /* Timer used to blink LED on DFU progress. */
 APP_TIMER_DEF(m_dfu_progress_led_timer);
 
+#if BOOT_PROBES_ACTIVE
+/* Start of nrf_bootloader_init(), which ends in DFU mode or in the start of the application. */
+static uint32_t m_bootloader_init_start;
+#endif
+
+/* Whether the log backends have been started. */
+static bool m_log_backends_initialized = false;
+
+/**@brief Function for starting the log backends.
+ *
+ * @details The logger is initialized at the start of main() and only buffers messages. Starting
+ *          the backends and processing the buffered messages is deferred until DFU mode is
+ *          entered or an error occurs, so a normal boot goes straight from validation to starting
+ *          the application.
+ */
+static void log_backends_init(void)
+{
+    if (!m_log_backends_initialized)
+    {
+        NRF_LOG_DEFAULT_BACKENDS_INIT();
+        m_log_backends_initialized = true;
+    }
+}
+
 static void on_error(void)
 {
+    log_backends_init();
     NRF_LOG_FINAL_FLUSH();
 
 #if NRF_MODULE_ENABLED(NRF_LOG_BACKEND_RTT)
@@ -85,6 +120,7 @@ static void on_error(void)
 
 void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t * p_file_name)
 {
+    TRACE("Error %u at line %u", error_code, line_num);
     NRF_LOG_ERROR("app_error_handler err_code:%d %s:%d", error_code, p_file_name, line_num);
     on_error();
 }
@@ -92,6 +128,7 @@ void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t * p
 
 void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
 {
+    TRACE("Fault 0x%08x at pc 0x%08x, info 0x%08x", id, pc, info);
     NRF_LOG_ERROR("Received a fault! id: 0x%08x, pc: 0x%08x, info: 0x%08x", id, pc, info);
     on_error();
 }
@@ -99,6 +136,7 @@ void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
 
 void app_error_handler_bare(uint32_t error_code)
 {
+    TRACE("Error 0x%08x", error_code);
     NRF_LOG_ERROR("Received an error: 0x%08x!", error_code);
     on_error();
 }
@@ -133,6 +171,21 @@ static void dfu_observer(nrf_dfu_evt_type_t evt_type)
         timer_created = true;
     }
 
+    TRACE("DFU event %u", evt_type);
+
+#if DFU_POWER_IDLE_ENABLED
+    if (evt_type != NRF_DFU_EVT_DFU_INITIALIZED)
+    {
+        dfu_power_on_dfu_evt(evt_type);
+    }
+#endif
+#if DFU_TELEMETRY_ENABLED
+    if (evt_type != NRF_DFU_EVT_DFU_INITIALIZED)
+    {
+        dfu_telemetry_on_dfu_evt(evt_type);
+    }
+#endif
+
     switch (evt_type)
     {
         case NRF_DFU_EVT_DFU_FAILED:
@@ -158,6 +211,23 @@ static void dfu_observer(nrf_dfu_evt_type_t evt_type)
             err_code = app_timer_init();
             APP_ERROR_CHECK(err_code);
 
+            ramfunc_init();
+
+            log_backends_init();
+            NRF_LOG_INFO("Entering DFU mode");
+
+#if BOOT_PROBES_ACTIVE
+            boot_probe_record(BOOT_PROBE_BOOTLOADER_INIT, boot_probe_now() - m_bootloader_init_start);
+            boot_probe_log();
+#endif
+
+#if DFU_POWER_IDLE_ENABLED
+            dfu_power_init();
+#endif
+#if DFU_TELEMETRY_ENABLED
+            dfu_telemetry_init();
+#endif
+
             led_sb_init_params_t led_sb_init_param = LED_SB_INIT_DEFAULT_PARAMS(BSP_LED_1_MASK);
 
             uint32_t ticks = APP_TIMER_TICKS(DFU_LED_CONFIG_TRANSPORT_INACTIVE_BREATH_MS);
@@ -182,7 +252,21 @@ static void dfu_observer(nrf_dfu_evt_type_t evt_type)
         }
         case NRF_DFU_EVT_TRANSPORT_DEACTIVATED:
         {
+#if DFU_POWER_IDLE_ENABLED
+            // Nothing to show until the host returns, blink slowly to save wakeups.
+            uint32_t ticks =  APP_TIMER_TICKS(DFU_LED_CONFIG_IDLE_BLINK_MS);
+#else
             uint32_t ticks =  APP_TIMER_TICKS(DFU_LED_CONFIG_PROGRESS_BLINK_MS);
+#endif
+            boot_probe_log();
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+            settings_log_stats_log();
+#endif
+#if NVMC_PARTIAL_ERASE_ENABLED
+            nvmc_erase_stats_log();
+#endif
+            wdt_feed_stats_log();
+
             err_code = led_softblink_stop();
             APP_ERROR_CHECK(err_code);
 
@@ -195,36 +279,82 @@ static void dfu_observer(nrf_dfu_evt_type_t evt_type)
             break;
     }
 }
+
+void __real_nrf_bootloader_app_start(void);
+
+/**@brief Function for starting the application, wraps nrf_bootloader_app_start().
+ *
+ * @details nrf_bootloader_init() of SDK 15.3 starts the application itself when there is no
+ *          DFU to do and never returns in DFU mode, so the handoff is the only place that runs
+ *          after the settings are loaded and before the application does.
+ */
+void __wrap_nrf_bootloader_app_start(void)
+{
+    uint32_t ret_val;
+
+#if BOOT_PROBES_ACTIVE
+    boot_probe_record(BOOT_PROBE_BOOTLOADER_INIT, boot_probe_now() - m_bootloader_init_start);
+#endif
+
+#if MEASURED_BOOT_ENABLED
+    // Publish the measurements of the image that is about to be started.
+    BOOT_PROBE_BEGIN(BOOT_PROBE_MEASURED_BOOT);
+    ret_val = measured_boot_run();
+    BOOT_PROBE_END(BOOT_PROBE_MEASURED_BOOT);
+    APP_ERROR_CHECK(ret_val);
+#endif
+
+    // Checked again right before the jump, a glitch that skipped the protection in main() or
+    // its error check does not get past both.
+    ret_val = flash_protect_verify();
+    APP_ERROR_CHECK(ret_val);
+
+    TRACE("Starting application");
+    __real_nrf_bootloader_app_start();
+}
+
 /**@brief Function for application main entry.
  */
 int main(void)
 {
     uint32_t ret_val;
 
-    // Protect MBR and bootloader code from being overwritten.
-    ret_val = nrf_bootloader_flash_protect(0, MBR_SIZE, false);
+    // Only sets up the log buffer, the backends are started when entering DFU mode.
+    ret_val = NRF_LOG_INIT(app_timer_cnt_get);
     APP_ERROR_CHECK(ret_val);
-    ret_val = nrf_bootloader_flash_protect(BOOTLOADER_START_ADDR, BOOTLOADER_SIZE, false);
+
+    // Keeps the trace of the previous boot if it survived the reset.
+    trace_init();
+    boot_probe_init();
+    wdt_feed_init();
+    TRACE("Boot, reset reason 0x%08x", NRF_POWER->RESETREAS);
+
+    // Protect MBR and bootloader code from being overwritten.
+    ret_val = flash_protect_apply(FLASH_PROTECT_CODE);
     APP_ERROR_CHECK(ret_val);
 
     //copy keys before flash protecting it
+    BOOT_PROBE_BEGIN(BOOT_PROBE_COPY_KDR);
     ret_val = copy_kdr();
-    APP_ERROR_CHECK(ret_val);
-    ret_val = nrf_bootloader_flash_protect(DEVICE_SECRET_ADDRESS, DEVICE_SECRET_SIZE, true);
+    BOOT_PROBE_END(BOOT_PROBE_COPY_KDR);
+    TRACE("copy_kdr returned %u", ret_val);
     APP_ERROR_CHECK(ret_val);
 
-    ret_val = NRF_LOG_INIT(app_timer_cnt_get);
+    ret_val = flash_protect_apply(FLASH_PROTECT_SECRETS);
     APP_ERROR_CHECK(ret_val);
-    NRF_LOG_DEFAULT_BACKENDS_INIT();
 
     NRF_LOG_INFO("Open USB bootloader started");
-    NRF_LOG_FLUSH();
+    if (get_provisioning_cycles() != 0)
+    {
+        NRF_LOG_INFO("Device provisioned in %d cycles", get_provisioning_cycles());
+    }
 
+#if BOOT_PROBES_ACTIVE
+    m_bootloader_init_start = boot_probe_now();
+#endif
     ret_val = nrf_bootloader_init(dfu_observer);
     APP_ERROR_CHECK(ret_val);
 
-    NRF_LOG_FLUSH();
-
     // Either there was no DFU functionality enabled in this project or the DFU module detected
     // no ongoing DFU operation and found a valid main application.
     // Boot the main application.
@@ -0,0 +1,161 @@
+#include <stddef.h>
+#include <string.h>
+#include "measured_boot.h"
+#include "sdk_config.h"
+#include "nrf_error.h"
+#include "crc32.h"
+#include "nrf_crypto.h"
+#include "nrf_dfu_types.h"
+#include "nrf_dfu_settings.h"
+#include "nrf_dfu_utils.h"
+#include "nrf_bootloader_info.h"
+#include "wdt_feed.h"
+
+/*
+* Size of the flash chunks fed into the hash. The cc310_bl backend copies
+* flash data through its automatic RAM buffer, so keep both the same size.
+*/
+#define MEASURE_CHUNK_SIZE NRF_CRYPTO_BACKEND_CC310_BL_HASH_AUTOMATIC_RAM_BUFFER_SIZE
+
+/*
+* Measurements published to the application. The section is placed in the
+* handoff area by the linker script and survives warm resets.
+*/
+measured_boot_t measured_boot __attribute__((section(".measured_boot")));
+
+static nrf_crypto_hash_context_t hash_context;
+
+/*
+* Computes the SHA-256 of a memory region chunk by chunk.
+*/
+static uint32_t measure_region(uint8_t const * p_data, uint32_t size, uint8_t * p_digest) {
+  ret_code_t ret;
+  size_t digest_len = MEASUREMENT_SIZE;
+
+  ret = nrf_crypto_hash_init(&hash_context, &g_nrf_crypto_hash_sha256_info);
+
+  if (ret != NRF_SUCCESS) {
+    return NRF_ERROR_INTERNAL;
+  }
+
+  while (size > 0) {
+    uint32_t chunk = (size > MEASURE_CHUNK_SIZE) ? MEASURE_CHUNK_SIZE : size;
+
+    ret = nrf_crypto_hash_update(&hash_context, p_data, chunk);
+
+    if (ret != NRF_SUCCESS) {
+      return NRF_ERROR_INTERNAL;
+    }
+
+    p_data += chunk;
+    size -= chunk;
+
+    wdt_feed_point();
+  }
+
+  ret = nrf_crypto_hash_finalize(&hash_context, p_digest, &digest_len);
+
+  if (ret != NRF_SUCCESS) {
+    return NRF_ERROR_INTERNAL;
+  }
+
+  return NRF_SUCCESS;
+}
+
+/*
+* chain = SHA-256(chain || measurement)
+*/
+static uint32_t extend_chain(uint8_t * p_chain, uint8_t const * p_measurement) {
+  ret_code_t ret;
+  uint8_t buffer[2 * MEASUREMENT_SIZE];
+  size_t digest_len = MEASUREMENT_SIZE;
+
+  memcpy(buffer, p_chain, MEASUREMENT_SIZE);
+  memcpy(buffer + MEASUREMENT_SIZE, p_measurement, MEASUREMENT_SIZE);
+
+  ret = nrf_crypto_hash_calculate(&hash_context,
+                                  &g_nrf_crypto_hash_sha256_info,
+                                  buffer,
+                                  sizeof(buffer),
+                                  p_chain,
+                                  &digest_len);
+
+  if (ret != NRF_SUCCESS) {
+    return NRF_ERROR_INTERNAL;
+  }
+
+  return NRF_SUCCESS;
+}
+
+static uint32_t measured_boot_crc() {
+  return crc32_compute((uint8_t const *)&measured_boot, offsetof(measured_boot_t, crc), NULL);
+}
+
+/*
+* Measures the bootloader, the bootloader settings and the application and
+* publishes the resulting hash chain in the handoff area. Called on the
+* handoff to the application (main.c), when the settings have been loaded and
+* validated.
+*
+* Everything is hashed on every boot. The handoff area is writable by the
+* application, and the application flash can change without the settings
+* page changing, so nothing retained from an earlier boot is trusted.
+*
+* The settings are measured as loaded, not as stored: with the settings log
+* the page holds a snapshot and the records behind it, so the same settings
+* can be stored in many ways. Without records the measurement equals that of
+* the first sizeof(nrf_dfu_settings_t) bytes of the page.
+*/
+uint32_t measured_boot_run() {
+  uint32_t ret_code;
+
+  if (!nrf_crypto_is_initialized()) {
+    ret_code = nrf_crypto_init();
+
+    if (ret_code != NRF_SUCCESS) {
+      return NRF_ERROR_INTERNAL;
+    }
+  }
+
+  //invalidate the published measurements until the new ones are complete
+  memset(&measured_boot, 0, sizeof(measured_boot));
+
+  ret_code = measure_region((uint8_t const *)&s_dfu_settings, sizeof(s_dfu_settings),
+                            measured_boot.components[MEASURED_SETTINGS]);
+
+  if (ret_code != NRF_SUCCESS) {
+    return ret_code;
+  }
+
+  ret_code = measure_region((uint8_t const *)BOOTLOADER_START_ADDR, BOOTLOADER_SIZE,
+                            measured_boot.components[MEASURED_BOOTLOADER]);
+
+  if (ret_code != NRF_SUCCESS) {
+    return ret_code;
+  }
+
+  if (s_dfu_settings.bank_0.bank_code == NRF_DFU_BANK_VALID_APP) {
+    measured_boot.app_size = s_dfu_settings.bank_0.image_size;
+  }
+
+  ret_code = measure_region((uint8_t const *)nrf_dfu_bank0_start_addr(), measured_boot.app_size,
+                            measured_boot.components[MEASURED_APPLICATION]);
+
+  if (ret_code != NRF_SUCCESS) {
+    return ret_code;
+  }
+
+  for (uint32_t i = 0; i < MEASURED_COMPONENT_COUNT; i++) {
+    ret_code = extend_chain(measured_boot.chain, measured_boot.components[i]);
+
+    if (ret_code != NRF_SUCCESS) {
+      memset(&measured_boot, 0, sizeof(measured_boot));
+      return ret_code;
+    }
+  }
+
+  measured_boot.magic = MEASURED_BOOT_MAGIC;
+  measured_boot.crc = measured_boot_crc();
+
+  return NRF_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include "nvmc_erase.h"
+#include "ramfunc.h"
+#include "wdt_feed.h"
+#include "nrf.h"
+
+#define NRF_LOG_MODULE_NAME nvmc_erase
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+//a page that is still not blank after twice the erase time gets a full erase
+#define SLICE_TIME_MAX_MS (2 * NVMC_PAGE_ERASE_TIME_MS)
+
+void __real_nrf_nvmc_page_erase(uint32_t address);
+
+static nvmc_erase_slice_handler_t m_slice_handler;
+static nvmc_erase_stats_t m_stats;
+
+void nvmc_erase_slice_handler_set(nvmc_erase_slice_handler_t handler) {
+  m_slice_handler = handler;
+}
+
+#if NVMC_PARTIAL_ERASE_ENABLED
+RAMFUNC static void nvmc_wait() {
+  while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+  }
+}
+
+RAMFUNC static void partial_erase(uint32_t address) {
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een;
+  __ISB();
+  __DSB();
+
+  NRF_NVMC->ERASEPAGEPARTIAL = address;
+  nvmc_wait();
+
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren;
+  __ISB();
+  __DSB();
+
+  m_stats.slices++;
+  wdt_feed_point();
+
+  if (m_slice_handler != NULL) {
+    m_slice_handler();
+  }
+}
+
+static bool page_blank(uint32_t address) {
+  uint32_t const * p_word = (uint32_t const *)address;
+
+  for (uint32_t i = 0; i < NRF_FICR->CODEPAGESIZE / sizeof(uint32_t); i++) {
+    if (p_word[i] != 0xFFFFFFFF) {
+      return false;
+    }
+  }
+
+  return true;
+}
+#endif
+
+/*
+* Replaces nrf_nvmc_page_erase(), the linker redirects the calls of the SDK
+* here.
+*/
+RAMFUNC void __wrap_nrf_nvmc_page_erase(uint32_t address) {
+#if NVMC_PARTIAL_ERASE_ENABLED
+  uint32_t elapsed = 0;
+
+  NRF_NVMC->ERASEPAGEPARTIALCFG = NVMC_PARTIAL_ERASE_SLICE_MS;
+
+  //the slices add up, the page is only checked once it should be erased
+  while (elapsed < NVMC_PAGE_ERASE_TIME_MS) {
+    partial_erase(address);
+    elapsed += NVMC_PARTIAL_ERASE_SLICE_MS;
+  }
+
+  if (!page_blank(address)) {
+    m_stats.retries++;
+
+    while ((elapsed < SLICE_TIME_MAX_MS) && !page_blank(address)) {
+      partial_erase(address);
+      elapsed += NVMC_PARTIAL_ERASE_SLICE_MS;
+    }
+  }
+
+  m_stats.pages++;
+
+  if (page_blank(address)) {
+    return;
+  }
+#endif
+
+  __real_nrf_nvmc_page_erase(address);
+}
+
+void nvmc_erase_stats_get(nvmc_erase_stats_t * p_stats) {
+  *p_stats = m_stats;
+}
+
+void nvmc_erase_stats_log() {
+  if (m_stats.pages > 0) {
+    NRF_LOG_INFO("Pages erased in %d ms slices: %d, slices: %d, retried: %d",
+                 NVMC_PARTIAL_ERASE_SLICE_MS, m_stats.pages, m_stats.slices, m_stats.retries);
+  }
+}
@@ -0,0 +1,47 @@
+#include <string.h>
+#include "ramfunc.h"
+#include "memory_layout.h"
+#include "app_util.h"
+#include "nrf.h"
+
+#if RAMFUNC_ENABLED
+
+/*
+* The class handlers of app_usbd and their callbacks (the DFU transports) are
+* not in .ramfunc. They must run from the event queue in thread context, the
+* USB interrupt only queues events, SOF events included (<2=> Interrupt).
+*/
+STATIC_ASSERT(APP_USBD_CONFIG_EVENT_QUEUE_ENABLE);
+STATIC_ASSERT(APP_USBD_CONFIG_SOF_HANDLING_MODE != 2);
+
+//the 16 core exceptions and the 48 interrupts of the nRF52840
+#define VECTOR_COUNT (16 + 48)
+#define VECTOR_ADDRESS(table, irq) ((table) + 4 * (16 + (irq)))
+
+/*
+* VTOR requires the table to be aligned to its size rounded up to a power of
+* two.
+*/
+static uint32_t m_vectors[VECTOR_COUNT] __ALIGNED(256);
+
+/*
+* Points the core at a RAM copy of the bootloader vector table. Otherwise
+* interrupts are dispatched through the tables in flash (the MBR forwards them
+* to the table of the bootloader) and stall until the NVMC is done.
+*
+* Must only be called in DFU mode: DFU mode always ends with a reset, which
+* restores the table of the MBR before an application is started.
+*/
+void ramfunc_init() {
+  memcpy(m_vectors, (void const *)MEMORY_BOOTLOADER_ADDRESS, sizeof(m_vectors));
+
+  //supervisor calls (sd_mbr_command) are still handled by the MBR
+  m_vectors[16 + SVCall_IRQn] = *(uint32_t const volatile *)VECTOR_ADDRESS(MEMORY_MBR_ADDRESS, SVCall_IRQn);
+
+  __DSB();
+  SCB->VTOR = (uint32_t)m_vectors;
+  __DSB();
+  __ISB();
+}
+
+#endif
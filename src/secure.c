@@ -7,6 +7,9 @@
 #include "ssi_pal_mem.h"
 #include "sns_silib.h"
 #include "nrf_dfu_flash.h"
+#include "sdk_config.h"
+#include "key_derivation.h"
+#include "device_secrets.h"
 
 /*
 * Set the read back protection using Control Access Ports. By specifying it as
@@ -34,6 +37,19 @@ const uint32_t private_key_option __attribute__((section(".device_secrets"))) __
 CRYS_RND_State_t rnd_state;
 CRYS_RND_WorkBuff_t  rnd_work_buff;
 
+/*
+* Number of CPU cycles the provisioning (GENERATE_AND_WRITE) took, from the
+* cryptocell bring-up until the root key is in the KDR registers. Zero if the
+* device was already provisioned.
+*/
+static uint32_t provisioning_cycles = 0;
+
+/*
+* RAM copy of the device secrets page used while generating the secrets, so
+* the whole page can be written with a single erase and write.
+*/
+static uint8_t secrets_page_buffer[DEVICE_SECRETS_PAGE_SIZE] __attribute__((aligned(4)));
+
 /*
 * Initializes SEGGER RTT, SaSi and RNG functions. It also enables external
 * interrupt requests and the hardware cryptocell.
@@ -102,11 +118,134 @@ uint32_t crypto_deinit() {
   return NRF_SUCCESS;
 }
 
-static uint32_t convert_to_word(uint8_t* byte_array) {
-  uint32_t converted_word = byte_array[0] | (byte_array[1] << 8) | (byte_array[2] << 16) | (byte_array[3] << 24);
+static uint32_t convert_to_word(uint8_t const * byte_array) {
+  uint32_t converted_word = byte_array[0] | (byte_array[1] << 8) | (byte_array[2] << 16) | ((uint32_t)byte_array[3] << 24);
   return converted_word;
 }
 
+/*
+* Makes sure the DWT cycle counter runs and returns its current value. The
+* logger and timers are not running this early in the boot so the counter is
+* the only time base available. It is shared with the trace, the boot probes
+* and the watchdog feed points, so it is never reset and only deltas are
+* taken.
+*/
+static uint32_t cycle_counter_start() {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  return DWT->CYCCNT;
+}
+
+uint32_t get_provisioning_cycles() {
+  return provisioning_cycles;
+}
+
+/*
+* Error code of an early return. A glitch that takes the error branch after a
+* call succeeded must not return NRF_SUCCESS without the work after it done.
+*/
+static uint32_t error_code(uint32_t ret_code) {
+  return (ret_code != NRF_SUCCESS) ? ret_code : NRF_ERROR_INTERNAL;
+}
+
+/*
+* Reads the flag of the device secrets page twice. A glitched read that turns
+* ALREADY_WRITTEN into GENERATE_AND_WRITE would replace the root key, so when
+* the reads differ neither flag is returned and copy_kdr() fails.
+*/
+static uint32_t secrets_flag_read(uint8_t const * p_page) {
+  uint32_t const volatile * p_flag = (uint32_t const volatile *)p_page;
+  uint32_t first = p_flag[0];
+  uint32_t second = p_flag[0];
+
+  if (first != second) {
+    return 0;
+  }
+
+  return first;
+}
+
+/*
+* Generates the root key, device ID and attestation seed into their slots and
+* writes the page back with the flag changed to ALREADY_WRITTEN. A slot table
+* that was programmed at production time (e.g. with certificates) is kept and
+* only the generated slots are filled in, a page without a table gets the
+* default table. A table that is present but damaged is not replaced.
+*
+* All slots are filled from a single RNG request, generated into the unused
+* end of the page buffer and distributed from there, as the slots of a
+* production table need not be adjacent.
+*/
+static uint32_t generate_secrets(uint8_t const * p_page) {
+  uint32_t ret_code;
+  device_secrets_header_t *p_header = (device_secrets_header_t *)secrets_page_buffer;
+  uint32_t random_size = 0;
+  uint8_t *p_random;
+  static const secret_slot_t generated_slots[] = {
+    SECRET_ROOT_KEY,
+    SECRET_DEVICE_ID,
+    SECRET_ATTESTATION_SEED
+  };
+
+  if (device_secrets_table_valid(p_page)) {
+    memcpy(secrets_page_buffer, p_page, ((device_secrets_header_t const *)p_page)->size);
+  }
+  else if (device_secrets_table_present(p_page)) {
+    return NRF_ERROR_INVALID_DATA;
+  }
+  else {
+    device_secrets_default_init(secrets_page_buffer);
+  }
+
+  if (p_header->slots[SECRET_ROOT_KEY].length != DEVICE_ROOT_KEY_SIZE) {
+    return NRF_ERROR_INVALID_DATA;
+  }
+
+  for (uint32_t i = 0; i < sizeof(generated_slots) / sizeof(generated_slots[0]); i++) {
+    random_size += p_header->slots[generated_slots[i]].length;
+  }
+
+  if (p_header->size + random_size > sizeof(secrets_page_buffer)) {
+    return NRF_ERROR_NO_MEM;
+  }
+
+  p_random = &secrets_page_buffer[p_header->size];
+  ret_code = CRYS_RND_GenerateVector(&rnd_state, random_size, p_random);
+
+  if (ret_code != CRYS_OK) {
+    return error_code(ret_code);
+  }
+
+  for (uint32_t i = 0; i < sizeof(generated_slots) / sizeof(generated_slots[0]); i++) {
+    secret_slot_entry_t *p_slot = &p_header->slots[generated_slots[i]];
+
+    memcpy(&secrets_page_buffer[p_slot->offset], p_random, p_slot->length);
+    p_random += p_slot->length;
+  }
+
+  //the random bytes past the table are not written, clear them anyway
+  memset(&secrets_page_buffer[p_header->size], 0, random_size);
+
+  //after generating random numbers, we also want to change the flag
+  p_header->flag = ALREADY_WRITTEN;
+  device_secrets_seal(secrets_page_buffer);
+
+  //checked again right before the erase, long after the first read in copy_kdr()
+  if (secrets_flag_read(p_page) != GENERATE_AND_WRITE) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+
+  //store all secrets onto the flash with a single erase and write
+  ret_code = nrf_dfu_flash_erase(DEVICE_SECRET_ADDRESS, 1, NULL);
+
+  if (ret_code != NRF_SUCCESS) {
+    return error_code(ret_code);
+  }
+
+  return nrf_dfu_flash_store(DEVICE_SECRET_ADDRESS, secrets_page_buffer, p_header->size, NULL);
+}
+
 /*
 * This function copies the device root key from a flash section and copies into
 * the secure RAM of the cryptocell (a.k.a KDR registers). This function is
@@ -117,6 +256,9 @@ uint32_t __attribute__((optimize("-O0"))) copy_kdr() {
 
   uint32_t ret_code;
 
+  //the cryptocell bring-up is part of the provisioning time
+  uint32_t start_cycles = cycle_counter_start();
+
   ret_code = crypto_init();
 
   if (ret_code != CRYS_OK) {
@@ -132,62 +274,62 @@ uint32_t __attribute__((optimize("-O0"))) copy_kdr() {
   while (!(NRF_CC_HOST_RGF->HOST_IOT_LCS & (1<<8))) {;}
 
   //check if the flash region contains a key
-  uint32_t *device_secrets = ((uint32_t *)(DEVICE_SECRET_ADDRESS));
-  uint32_t secrets_flag_read = device_secrets[0];
+  uint8_t const *device_secrets_page = (uint8_t const *)DEVICE_SECRET_ADDRESS;
+  uint32_t secrets_flag = secrets_flag_read(device_secrets_page);
 
-  if (secrets_flag_read == ALREADY_WRITTEN) {
-    //copy key from flash to KDR registers
-    NRF_CC_HOST_RGF->HOST_IOT_KDR0 = device_secrets[1];
-    NRF_CC_HOST_RGF->HOST_IOT_KDR1 = device_secrets[2];
-    NRF_CC_HOST_RGF->HOST_IOT_KDR2 = device_secrets[3];
-    NRF_CC_HOST_RGF->HOST_IOT_KDR3 = device_secrets[4];
-  }
-  else if (secrets_flag_read == GENERATE_AND_WRITE) {
-    //generate random key
-    uint16_t rnd_bytes_size = 16;
-    uint8_t rnd_bytes[rnd_bytes_size];
+  if (secrets_flag == ALREADY_WRITTEN) {
+    device_secrets_t secrets;
+    uint8_t const *root_key;
+    uint8_t const *root_key_again;
+    uint16_t root_key_length;
+    uint16_t root_key_length_again;
 
-    ret_code = CRYS_RND_GenerateVector (&rnd_state, rnd_bytes_size, rnd_bytes);
+    //validate the page once, the key is then located through the slot table
+    ret_code = device_secrets_open(&secrets, device_secrets_page);
 
-    if (ret_code != CRYS_OK) {
-      return ret_code;
+    if (ret_code != NRF_SUCCESS) {
+      return NRF_ERROR_INTERNAL;
     }
 
-    //create a buffer which holds the new flag value and the random bytes
-    uint32_t device_page_buffer_size = (uint32_t)rnd_bytes_size + 4;
-    uint8_t device_page_buffer[device_page_buffer_size];
-
-    //after generating random number, we also want to change the flag
-    uint32_t secrets_flag_change = ALREADY_WRITTEN;
+    ret_code = device_secrets_find(&secrets, SECRET_ROOT_KEY, &root_key, &root_key_length);
 
-    //copy the flag change value and the random number.
-    memcpy(device_page_buffer, &secrets_flag_change, sizeof(uint32_t));
-    memcpy(device_page_buffer + sizeof(secrets_flag_change), rnd_bytes, sizeof(rnd_bytes));
+    if ((ret_code != NRF_SUCCESS) || (root_key_length != DEVICE_ROOT_KEY_SIZE)) {
+      return NRF_ERROR_INTERNAL;
+    }
 
-    //store the key onto the flash
-    ret_code = nrf_dfu_flash_erase(DEVICE_SECRET_ADDRESS, 1, NULL);
+    //located twice, a glitched lookup would load other bytes of the page as the key
+    ret_code = device_secrets_find(&secrets, SECRET_ROOT_KEY, &root_key_again, &root_key_length_again);
 
-    if (ret_code != NRF_SUCCESS) {
-      return ret_code;
+    if ((ret_code != NRF_SUCCESS) || (root_key_again != root_key) || (root_key_length_again != root_key_length)) {
+      return NRF_ERROR_INTERNAL;
     }
 
-    ret_code = nrf_dfu_flash_store(DEVICE_SECRET_ADDRESS, device_page_buffer, device_page_buffer_size, NULL);
+    //copy key from flash to KDR registers
+    NRF_CC_HOST_RGF->HOST_IOT_KDR0 = convert_to_word(&root_key[0]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR1 = convert_to_word(&root_key[4]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR2 = convert_to_word(&root_key[8]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR3 = convert_to_word(&root_key[12]);
+  }
+  else if (secrets_flag == GENERATE_AND_WRITE) {
+    ret_code = generate_secrets(device_secrets_page);
 
     if (ret_code != NRF_SUCCESS) {
-      return ret_code;
+      memset(secrets_page_buffer, 0, sizeof(secrets_page_buffer));
+      return error_code(ret_code);
     }
 
-    //clear off the device page buffer
-    memset(device_page_buffer, 0, sizeof(device_page_buffer));
-
     //copy key into KDR registers
-    NRF_CC_HOST_RGF->HOST_IOT_KDR0 = convert_to_word(&rnd_bytes[0]);
-    NRF_CC_HOST_RGF->HOST_IOT_KDR1 = convert_to_word(&rnd_bytes[4]);
-    NRF_CC_HOST_RGF->HOST_IOT_KDR2 = convert_to_word(&rnd_bytes[8]);
-    NRF_CC_HOST_RGF->HOST_IOT_KDR3 = convert_to_word(&rnd_bytes[12]);
+    uint8_t *root_key = &secrets_page_buffer[((device_secrets_header_t *)secrets_page_buffer)->slots[SECRET_ROOT_KEY].offset];
+
+    NRF_CC_HOST_RGF->HOST_IOT_KDR0 = convert_to_word(&root_key[0]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR1 = convert_to_word(&root_key[4]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR2 = convert_to_word(&root_key[8]);
+    NRF_CC_HOST_RGF->HOST_IOT_KDR3 = convert_to_word(&root_key[12]);
 
-    //clear off the value in the rnd_bytes buffer
-    memset(rnd_bytes, 0, sizeof(rnd_bytes));
+    //clear off the secrets buffer
+    memset(secrets_page_buffer, 0, sizeof(secrets_page_buffer));
+
+    provisioning_cycles = DWT->CYCCNT - start_cycles;
   }
   else {
     return NRF_ERROR_INTERNAL;
@@ -196,6 +338,17 @@ uint32_t __attribute__((optimize("-O0"))) copy_kdr() {
   //check if the key is retained in the registers
   while (NRF_CC_HOST_RGF->HOST_IOT_KDR0 != 1UL) {;}
 
+#if SECURE_KEY_DERIVATION_ENABLED
+  //derive the application keys while the cryptocell session is still open
+  ret_code = derive_keys();
+
+  if (ret_code != NRF_SUCCESS) {
+    return error_code(ret_code);
+  }
+#else
+  clear_derived_keys();
+#endif
+
   ret_code = crypto_deinit();
 
   if (ret_code != CRYS_OK) {
@@ -0,0 +1,364 @@
+#include <stddef.h>
+#include <string.h>
+#include "settings_log.h"
+#include "nrf_dfu_settings.h"
+#include "nrf_dfu_flash.h"
+#include "nrf_dfu_types.h"
+#include "nrf_bootloader_info.h"
+#include "crc32.h"
+#include "app_util.h"
+#include "wdt_feed.h"
+
+#define NRF_LOG_MODULE_NAME settings_log
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+ret_code_t __real_nrf_dfu_settings_init(bool sd_irq_initialized);
+ret_code_t __real_nrf_dfu_settings_write(nrf_dfu_flash_callback_t callback);
+ret_code_t __real_nrf_dfu_settings_write_and_backup(nrf_dfu_flash_callback_t callback);
+
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+
+#define SNAPSHOT ((nrf_dfu_settings_t const *)BOOTLOADER_SETTINGS_ADDRESS)
+#define LOG_START (BOOTLOADER_SETTINGS_ADDRESS + ALIGN_NUM(sizeof(uint32_t), sizeof(nrf_dfu_settings_t)))
+#define LOG_END (BOOTLOADER_SETTINGS_ADDRESS + CODE_PAGE_SIZE)
+#define ERASED_WORD 0xFFFFFFFF
+
+STATIC_ASSERT(LOG_START + sizeof(settings_log_header_t) < LOG_END);
+STATIC_ASSERT(sizeof(nrf_dfu_settings_t) <= UINT16_MAX);
+
+/*
+* Settings as stored in flash, rebuilt from the page before every write so
+* writes done by the SDK itself (e.g. on a settings version upgrade) are
+* always taken into account. The bootloader runs without SoftDevice, so
+* flash operations complete before nrf_dfu_flash returns and the page is
+* always up to date.
+*/
+static nrf_dfu_settings_t m_persisted;
+static uint32_t m_record[NRF_DFU_SETTINGS_LOG_RECORD_MAX / sizeof(uint32_t)];
+static settings_log_stats_t m_stats;
+
+#if NRF_DFU_SAVE_PROGRESS_IN_FLASH
+#define FIELD(name) { offsetof(nrf_dfu_settings_t, name), sizeof(((nrf_dfu_settings_t *)0)->name) }
+
+/*
+* Fields changed by the request handler after every data object, together
+* with the CRCs computed over the settings.
+*/
+static const settings_log_run_t m_data_progress_fields[] = {
+  FIELD(crc),
+  FIELD(boot_validation_crc),
+  FIELD(progress.data_object_size),
+  FIELD(progress.firmware_image_crc),
+  FIELD(progress.firmware_image_crc_last),
+  FIELD(progress.firmware_image_offset),
+  FIELD(progress.firmware_image_offset_last)
+};
+
+static bool data_progress_field(uint32_t offset) {
+  for (uint32_t i = 0; i < ARRAY_SIZE(m_data_progress_fields); i++) {
+    if ((offset >= m_data_progress_fields[i].offset) &&
+        (offset < m_data_progress_fields[i].offset + m_data_progress_fields[i].size)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+* Whether s_dfu_settings differs from the persisted settings, and only in
+* the progress of the data object transfer.
+*/
+static bool data_progress_only() {
+  uint8_t const * p_old = (uint8_t const *)&m_persisted;
+  uint8_t const * p_new = (uint8_t const *)&s_dfu_settings;
+  bool changed = false;
+
+  for (uint32_t i = 0; i < sizeof(nrf_dfu_settings_t); i++) {
+    if (p_old[i] != p_new[i]) {
+      if (!data_progress_field(i)) {
+        return false;
+      }
+
+      changed = true;
+    }
+  }
+
+  //unchanged settings are counted as skipped by log_append()
+  return changed;
+}
+#endif
+
+/*
+* CRC over the three boot validation entries, refreshed on every write like
+* nrf_dfu_settings_write() of the SDK does.
+*/
+static uint32_t boot_validation_crc(nrf_dfu_settings_t const * p_settings) {
+  return crc32_compute((uint8_t const *)&p_settings->boot_validation_softdevice, 3 * sizeof(boot_validation_t), NULL);
+}
+
+/*
+* Applies the runs of one record, which has already passed its CRC check.
+*/
+static bool record_apply(nrf_dfu_settings_t * p_state, uint8_t const * p_runs, uint32_t length) {
+  uint32_t offset;
+
+  //check all runs first so a bad record leaves the state unchanged
+  for (offset = 0; offset < length; ) {
+    settings_log_run_t const * p_run = (settings_log_run_t const *)&p_runs[offset];
+
+    if ((p_run->offset + p_run->size > sizeof(nrf_dfu_settings_t)) || (p_run->size == 0)) {
+      return false;
+    }
+
+    offset += sizeof(settings_log_run_t) + ALIGN_NUM(sizeof(uint32_t), p_run->size);
+  }
+
+  if (offset != length) {
+    return false;
+  }
+
+  for (offset = 0; offset < length; ) {
+    settings_log_run_t const * p_run = (settings_log_run_t const *)&p_runs[offset];
+
+    memcpy((uint8_t *)p_state + p_run->offset, &p_runs[offset + sizeof(settings_log_run_t)], p_run->size);
+    offset += sizeof(settings_log_run_t) + ALIGN_NUM(sizeof(uint32_t), p_run->size);
+  }
+
+  return true;
+}
+
+/*
+* Loads the snapshot and applies all valid records to p_state. Returns the
+* address where the next record goes, or 0 if nothing can be appended
+* because the snapshot is invalid, the page is full or a torn record is in
+* the way.
+*/
+static uint32_t log_replay(nrf_dfu_settings_t * p_state) {
+  uint32_t address = LOG_START;
+
+  memcpy(p_state, SNAPSHOT, sizeof(nrf_dfu_settings_t));
+
+  if (SNAPSHOT->crc != nrf_dfu_settings_crc_get(SNAPSHOT)) {
+    return 0;
+  }
+
+  while (address + sizeof(settings_log_header_t) < LOG_END) {
+    settings_log_header_t const * p_header = (settings_log_header_t const *)address;
+    uint8_t const * p_runs = (uint8_t const *)(p_header + 1);
+
+    if (*(uint32_t const *)address == ERASED_WORD) {
+      return address;
+    }
+
+    if ((p_header->length_inv != (uint16_t)~p_header->length) ||
+        (p_header->length % sizeof(uint32_t) != 0) ||
+        (address + sizeof(settings_log_header_t) + p_header->length > LOG_END) ||
+        (crc32_compute(p_runs, p_header->length, NULL) != p_header->crc) ||
+        !record_apply(p_state, p_runs, p_header->length)) {
+      NRF_LOG_WARNING("Invalid record at 0x%x", address);
+      return 0;
+    }
+
+    address += sizeof(settings_log_header_t) + p_header->length;
+  }
+
+  return 0;
+}
+
+/*
+* Collects the bytes that differ between p_old and p_new into runs. Unchanged
+* gaps shorter than SETTINGS_LOG_RUN_MAX_GAP are included in the run since a
+* new run header costs more. Returns false if the runs exceed max_length.
+*/
+static bool record_build(uint8_t const * p_old, uint8_t const * p_new, uint8_t * p_runs, uint32_t max_length, uint32_t * p_length) {
+  uint32_t length = 0;
+  uint32_t i = 0;
+
+  while (i < sizeof(nrf_dfu_settings_t)) {
+    settings_log_run_t * p_run;
+    uint32_t start;
+    uint32_t end;
+
+    if (p_old[i] == p_new[i]) {
+      i++;
+      continue;
+    }
+
+    start = i;
+    end = i + 1;
+
+    for (i = end; (i < sizeof(nrf_dfu_settings_t)) && (i - end < SETTINGS_LOG_RUN_MAX_GAP); i++) {
+      if (p_old[i] != p_new[i]) {
+        end = i + 1;
+      }
+    }
+
+    if (length + sizeof(settings_log_run_t) + ALIGN_NUM(sizeof(uint32_t), end - start) > max_length) {
+      return false;
+    }
+
+    p_run = (settings_log_run_t *)&p_runs[length];
+    p_run->offset = start;
+    p_run->size = end - start;
+    length += sizeof(settings_log_run_t);
+
+    memset(&p_runs[length], 0, ALIGN_NUM(sizeof(uint32_t), end - start));
+    memcpy(&p_runs[length], &p_new[start], end - start);
+    length += ALIGN_NUM(sizeof(uint32_t), end - start);
+  }
+
+  *p_length = length;
+  return true;
+}
+
+/*
+* Erases the page and writes s_dfu_settings as the new snapshot.
+*/
+static ret_code_t log_compact(nrf_dfu_flash_callback_t callback) {
+  ret_code_t ret_code;
+
+  m_stats.compactions++;
+  NRF_LOG_DEBUG("Compacting settings page");
+
+  //the SDK skips the write when the snapshot is unchanged, but the records behind it must go
+  if (memcmp(SNAPSHOT, &s_dfu_settings, sizeof(nrf_dfu_settings_t)) == 0) {
+    ret_code = nrf_dfu_flash_erase(BOOTLOADER_SETTINGS_ADDRESS, 1, NULL);
+
+    if (ret_code != NRF_SUCCESS) {
+      return ret_code;
+    }
+  }
+
+  return __real_nrf_dfu_settings_write(callback);
+}
+
+static ret_code_t log_append(uint32_t address, nrf_dfu_flash_callback_t callback) {
+  settings_log_header_t * p_header = (settings_log_header_t *)m_record;
+  uint8_t * p_runs = (uint8_t *)(p_header + 1);
+  uint32_t max_length;
+  uint32_t length;
+
+  if (address == 0) {
+    return log_compact(callback);
+  }
+
+  max_length = MIN(sizeof(m_record), LOG_END - address) - sizeof(settings_log_header_t);
+
+  if (!record_build((uint8_t const *)&m_persisted, (uint8_t const *)&s_dfu_settings, p_runs, max_length, &length)) {
+    return log_compact(callback);
+  }
+
+  if (length == 0) {
+    m_stats.skipped++;
+
+    if (callback != NULL) {
+      callback(NULL);
+    }
+
+    return NRF_SUCCESS;
+  }
+
+  p_header->length = length;
+  p_header->length_inv = ~length;
+  p_header->crc = crc32_compute(p_runs, length, NULL);
+
+  m_stats.records++;
+
+  return nrf_dfu_flash_store(address, m_record, sizeof(settings_log_header_t) + length, callback);
+}
+
+/*
+* Persists s_dfu_settings, optionally followed by the backup page. The
+* callback is called once everything is written.
+*/
+static ret_code_t log_write(nrf_dfu_flash_callback_t callback, bool backup) {
+  ret_code_t ret_code;
+  uint32_t address;
+
+  s_dfu_settings.crc = nrf_dfu_settings_crc_get(&s_dfu_settings);
+  s_dfu_settings.boot_validation_crc = boot_validation_crc(&s_dfu_settings);
+
+  address = log_replay(&m_persisted);
+
+  //the replay scans the whole page, a compaction feeds from the erase slices
+  wdt_feed_point();
+
+#if NRF_DFU_SAVE_PROGRESS_IN_FLASH
+  if (data_progress_only()) {
+    //resuming only needs the settings page, the backup covers the rest
+    backup = false;
+
+    //wraps around and is written when the progress is reset
+    if (s_dfu_settings.progress.firmware_image_offset_last - m_persisted.progress.firmware_image_offset_last <
+        NRF_DFU_PROGRESS_CHECKPOINT_SIZE) {
+      m_stats.deferred++;
+
+      if (callback != NULL) {
+        callback(NULL);
+      }
+
+      return NRF_SUCCESS;
+    }
+
+    m_stats.checkpoints++;
+  }
+#endif
+
+  ret_code = log_append(address, backup ? NULL : callback);
+
+  if ((ret_code == NRF_SUCCESS) && backup) {
+    nrf_dfu_settings_backup(callback);
+  }
+
+  return ret_code;
+}
+
+void settings_log_stats_get(settings_log_stats_t * p_stats) {
+  *p_stats = m_stats;
+}
+
+void settings_log_stats_log() {
+  NRF_LOG_INFO("Settings writes: %d appended, %d page erases, %d unchanged",
+               m_stats.records, m_stats.compactions, m_stats.skipped);
+  NRF_LOG_INFO("Progress checkpoints: %d written, %d deferred", m_stats.checkpoints, m_stats.deferred);
+}
+
+#endif
+
+/*
+* The SDK loads the snapshot, or the backup if the page is invalid. The
+* records only apply if the settings came from the snapshot.
+*/
+ret_code_t __wrap_nrf_dfu_settings_init(bool sd_irq_initialized) {
+  ret_code_t ret_code = __real_nrf_dfu_settings_init(sd_irq_initialized);
+
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+  if ((ret_code == NRF_SUCCESS) && (memcmp(SNAPSHOT, &s_dfu_settings, sizeof(nrf_dfu_settings_t)) == 0)) {
+    (void)log_replay(&s_dfu_settings);
+  }
+#endif
+
+  return ret_code;
+}
+
+ret_code_t __wrap_nrf_dfu_settings_write(nrf_dfu_flash_callback_t callback) {
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+  return log_write(callback, false);
+#else
+  return __real_nrf_dfu_settings_write(callback);
+#endif
+}
+
+/*
+* The backup page keeps the SDK format, it is only written when the
+* settings differ from it.
+*/
+ret_code_t __wrap_nrf_dfu_settings_write_and_backup(nrf_dfu_flash_callback_t callback) {
+#if NRF_DFU_SETTINGS_LOG_ENABLED
+  return log_write(callback, true);
+#else
+  return __real_nrf_dfu_settings_write_and_backup(callback);
+#endif
+}
@@ -0,0 +1,63 @@
+#include <stdarg.h>
+#include <string.h>
+#include "trace.h"
+#include "nrf.h"
+#include "app_util_platform.h"
+
+#if TRACE_ENABLED
+
+/*
+* The ring is placed in its own RAM region by the linker script and is not
+* initialized by the startup code, so the entries of earlier boots survive
+* warm resets until the application reuses the memory.
+*/
+trace_ring_t trace_ring __attribute__((section(".trace_ring")));
+
+/*
+* Keeps the entries of earlier boots when the ring is intact.
+*/
+void trace_init() {
+  if ((trace_ring.magic != TRACE_MAGIC) || (trace_ring.words != ARRAY_SIZE(trace_ring.data))) {
+    memset(&trace_ring, 0, sizeof(trace_ring));
+    trace_ring.words = ARRAY_SIZE(trace_ring.data);
+    trace_ring.magic = TRACE_MAGIC;
+  }
+
+  //the cycle counter is shared, only make sure it runs
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline void ring_put(uint32_t word) {
+  trace_ring.data[trace_ring.head % ARRAY_SIZE(trace_ring.data)] = word;
+  trace_ring.head++;
+}
+
+void trace_write(uint32_t id, uint32_t nargs, ...) {
+  va_list args;
+
+  if (trace_ring.magic != TRACE_MAGIC) {
+    return;
+  }
+
+  if (nargs > TRACE_MAX_ARGS) {
+    nargs = TRACE_MAX_ARGS;
+  }
+
+  va_start(args, nargs);
+
+  CRITICAL_REGION_ENTER();
+
+  ring_put(TRACE_HEADER(id, nargs));
+  ring_put(DWT->CYCCNT);
+
+  for (uint32_t i = 0; i < nargs; i++) {
+    ring_put(va_arg(args, uint32_t));
+  }
+
+  CRITICAL_REGION_EXIT();
+
+  va_end(args);
+}
+
+#endif
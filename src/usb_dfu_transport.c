@@ -0,0 +1,721 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sdk_config.h"
+#include "nrf_dfu_serial.h"
+#include "nrf_dfu_transport.h"
+#include "nrf_dfu_req_handler.h"
+#include "app_usbd.h"
+#include "app_usbd_core.h"
+#include "app_usbd_cdc_acm.h"
+#include "app_usbd_serial_num.h"
+#include "app_usbd_dfu_bulk.h"
+#include "usb_dfu_transport.h"
+#include "usb_event_queue.h"
+#include "dfu_power.h"
+#include "boot_probe.h"
+#include "ramfunc.h"
+#include "nvmc_erase.h"
+#include "nrf_drv_usbd.h"
+#include "nrf_drv_power.h"
+#include "nrf_drv_clock.h"
+#include "nrf_balloc.h"
+#include "slip.h"
+#include "app_util.h"
+
+#define NRF_LOG_MODULE_NAME usb_dfu_transport
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+/*
+* DFU over USB, replacing the SDK's nrf_dfu_serial_usb.c. Two interfaces are
+* offered and both end up in the same nrf_dfu_serial request parser:
+*
+* CDC ACM (interfaces 0 and 1) with SLIP framing, compatible with nrfutil.
+* Vendor bulk (interface 2) with one unframed request per bulk transfer.
+*
+* The bulk interface avoids the SLIP escaping and the byte by byte decoding
+* of the CDC path: the request is received by EasyDMA directly into the pool
+* buffer that is later handed to the flash driver, and a new transfer is
+* queued as soon as the previous one is parsed, so the host can keep several
+* requests in flight while earlier ones are still being written to flash.
+*
+* Both interfaces report their buffer usage and flash backlog (see
+* usb_dfu_transport.h) so a host can pick the PRN interval at run time.
+*/
+
+#define NRF_SERIAL_OPCODE_SIZE (sizeof(uint8_t))
+#define NRF_USB_MAX_RESPONSE_SIZE_SLIP (2 * NRF_SERIAL_MAX_RESPONSE_SIZE + 1)
+#define RX_BUF_SIZE (1024)
+#define SLIP_MTU (2 * (RX_BUF_SIZE + 1) + 1)
+
+/*
+* Layout of a receive buffer: rx_header_t, padding, then the request. The
+* opcode is placed right before a word boundary so the payload is word
+* aligned for fstorage.
+*/
+#define RX_HEADER_SIZE (sizeof(rx_header_t))
+#define OPCODE_OFFSET (RX_HEADER_SIZE + sizeof(uint32_t) - NRF_SERIAL_OPCODE_SIZE)
+#define DATA_OFFSET (OPCODE_OFFSET + NRF_SERIAL_OPCODE_SIZE)
+
+#define RSP_HEADER_SIZE 3
+
+typedef struct {
+  uint32_t backlog;  // payload length accounted in the flash backlog
+  uint32_t received; // boot_probe_now() when the request was dispatched
+} rx_header_t;
+
+#ifndef USBD_POWER_DETECTION
+#define USBD_POWER_DETECTION true
+#endif
+
+STATIC_ASSERT(NRF_DFU_USB_BULK_MTU % NRF_DRV_USBD_EPSIZE == 0);
+STATIC_ASSERT(NRFX_USBD_CONFIG_DMASCHEDULER_MODE == 0);
+STATIC_ASSERT(NRF_DFU_USB_BULK_TX_BUFFERS > 0);
+STATIC_ASSERT(NRF_DFU_SERIAL_USB_TX_BUFFERS > 0);
+
+static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_cdc_acm_user_event_t event);
+static void dfu_bulk_user_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_dfu_bulk_user_event_t event);
+
+static uint32_t usb_dfu_transport_init(nrf_dfu_observer_t observer);
+static uint32_t usb_dfu_transport_close(nrf_dfu_transport_t const * p_exception);
+
+/*
+* Receive buffers of one interface and the requests parsed from them.
+*/
+typedef struct {
+  nrf_balloc_t const * p_pool;
+  nrf_dfu_serial_t * p_serial;
+  uint8_t buffers_free;
+  uint8_t buffers_total;
+  uint32_t flash_backlog;
+  bool status_trailer; // responses already carry the flow status
+} rx_path_t;
+
+NRF_BALLOC_DEF(m_payload_pool, (OPCODE_OFFSET + SLIP_MTU + 1), NRF_DFU_SERIAL_USB_RX_BUFFERS);
+
+/*
+* CDC responses are SLIP encoded into a ring of slots, like the bulk ones,
+* so a response is never encoded into a buffer the IN endpoint still sends
+* from. Flow status replies and the serial layer's responses share it.
+*/
+typedef struct {
+  uint8_t data[NRF_USB_MAX_RESPONSE_SIZE_SLIP];
+  uint32_t length;
+} cdc_tx_slot_t;
+
+static nrf_dfu_serial_t m_serial;
+static rx_path_t m_cdc_rx;
+static slip_t m_slip;
+static uint8_t m_rsp_buf[NRF_SERIAL_MAX_RESPONSE_SIZE];
+static uint8_t m_rx_buf[NRF_DRV_USBD_EPSIZE];
+static cdc_tx_slot_t m_cdc_tx[NRF_DFU_SERIAL_USB_TX_BUFFERS];
+static uint8_t m_cdc_tx_head;
+static uint8_t m_cdc_tx_count;
+
+static nrf_dfu_observer_t m_observer;
+
+APP_USBD_CDC_ACM_GLOBAL_DEF(m_app_cdc_acm,
+                            cdc_acm_user_ev_handler,
+                            CDC_ACM_COMM_INTERFACE,
+                            CDC_ACM_DATA_INTERFACE,
+                            CDC_ACM_COMM_EPIN,
+                            CDC_ACM_DATA_EPIN,
+                            CDC_ACM_DATA_EPOUT,
+                            APP_USBD_CDC_COMM_PROTOCOL_NONE);
+
+#if NRF_DFU_USB_BULK_ENABLED
+#define BULK_MAX_RESPONSE_SIZE MAX(MAX(NRF_SERIAL_MAX_RESPONSE_SIZE, RSP_HEADER_SIZE + 2 * sizeof(usb_dfu_ep_stats_t)), \
+                                   RSP_HEADER_SIZE + BOOT_PROBE_COUNT * sizeof(usb_dfu_probe_t))
+
+NRF_BALLOC_DEF(m_bulk_pool, (OPCODE_OFFSET + NRF_DFU_USB_BULK_MTU), NRF_DFU_USB_BULK_RX_BUFFERS);
+
+/*
+* Responses wait in a ring until the IN endpoint is free. The serial layer
+* builds every response in m_bulk_rsp_buf, so it is copied into a slot before
+* rsp_func returns and the buffer of a transfer in flight is never touched.
+*/
+typedef struct {
+  uint8_t data[BULK_MAX_RESPONSE_SIZE + sizeof(usb_dfu_flow_status_t)];
+  uint32_t length;
+} bulk_tx_slot_t;
+
+static nrf_dfu_serial_t m_bulk_serial;
+static rx_path_t m_bulk_rx;
+static uint8_t m_bulk_rsp_buf[BULK_MAX_RESPONSE_SIZE];
+static bulk_tx_slot_t m_bulk_tx[NRF_DFU_USB_BULK_TX_BUFFERS];
+static uint8_t m_bulk_tx_head;
+static uint8_t m_bulk_tx_count;
+static uint8_t * mp_bulk_rx_buf;
+static bool m_bulk_ready;
+static uint32_t m_bulk_rx_held;
+
+APP_USBD_DFU_BULK_GLOBAL_DEF(m_app_dfu_bulk,
+                             dfu_bulk_user_ev_handler,
+                             DFU_BULK_INTERFACE,
+                             DFU_BULK_EPIN,
+                             DFU_BULK_EPOUT);
+#endif
+
+DFU_TRANSPORT_REGISTER(nrf_dfu_transport_t const usb_dfu_transport) = {
+  .init_func = usb_dfu_transport_init,
+  .close_func = usb_dfu_transport_close,
+};
+
+/*
+* Starts the IN transfer of the oldest queued response. A response the class
+* does not accept is dropped, no TX_DONE would ever release its slot.
+*/
+static void cdc_tx_start() {
+  ret_code_t ret_code;
+
+  while (m_cdc_tx_count > 0) {
+    cdc_tx_slot_t * p_slot = &m_cdc_tx[m_cdc_tx_head];
+
+    ret_code = app_usbd_cdc_acm_write(&m_app_cdc_acm, p_slot->data, p_slot->length);
+
+    if (ret_code == NRF_SUCCESS) {
+      return;
+    }
+
+    NRF_LOG_WARNING("Could not send CDC response. Error: 0x%x.", ret_code);
+    m_cdc_tx_head = (m_cdc_tx_head + 1) % NRF_DFU_SERIAL_USB_TX_BUFFERS;
+    m_cdc_tx_count--;
+  }
+}
+
+static void cdc_tx_done() {
+  if (m_cdc_tx_count > 0) {
+    m_cdc_tx_head = (m_cdc_tx_head + 1) % NRF_DFU_SERIAL_USB_TX_BUFFERS;
+    m_cdc_tx_count--;
+  }
+
+  cdc_tx_start();
+}
+
+static uint32_t rsp_send(uint8_t const * p_data, uint32_t length) {
+  cdc_tx_slot_t * p_slot;
+
+  if (m_cdc_tx_count == NRF_DFU_SERIAL_USB_TX_BUFFERS) {
+    NRF_LOG_ERROR("CDC response queue full");
+    return NRF_ERROR_NO_MEM;
+  }
+
+  p_slot = &m_cdc_tx[(m_cdc_tx_head + m_cdc_tx_count) % NRF_DFU_SERIAL_USB_TX_BUFFERS];
+
+  //cannot fail if inputs are non-NULL
+  (void)slip_encode(p_slot->data, (uint8_t *)p_data, length, &p_slot->length);
+  m_cdc_tx_count++;
+
+  //otherwise started by cdc_tx_done() of the response in flight
+  if (m_cdc_tx_count == 1) {
+    cdc_tx_start();
+  }
+
+  return NRF_SUCCESS;
+}
+
+static uint8_t * rx_buf_alloc(rx_path_t * p_rx) {
+  uint8_t * p_buf = nrf_balloc_alloc(p_rx->p_pool);
+
+  if (p_buf != NULL) {
+    memset(p_buf, 0, RX_HEADER_SIZE);
+    p_rx->buffers_free--;
+  }
+
+  return p_buf;
+}
+
+/*
+* The serial layer hands back a pointer to the payload, behind the opcode.
+*/
+static void rx_buf_free(rx_path_t * p_rx, void * p_payload) {
+  uint8_t * p_buf = (uint8_t *)p_payload - DATA_OFFSET;
+  rx_header_t const * p_header = (rx_header_t const *)p_buf;
+
+#if BOOT_PROBES_ACTIVE
+  if (p_header->received != 0) {
+    boot_probe_record(BOOT_PROBE_DFU_REQUEST, boot_probe_now() - p_header->received);
+  }
+#endif
+
+  p_rx->flash_backlog -= p_header->backlog;
+  p_rx->buffers_free++;
+  nrf_balloc_free(p_rx->p_pool, p_buf);
+}
+
+#if NRF_DFU_USB_BULK_ENABLED && NRF_DFU_USB_BULK_STATS_ENABLED
+static void ep_stats_convert(app_usbd_dfu_bulk_ep_stats_t const * p_stats, usb_dfu_ep_stats_t * p_out) {
+  p_out->transfers = p_stats->transfers;
+  p_out->bytes = p_stats->bytes;
+  p_out->cycles_avg = (p_stats->transfers > 0) ? (uint32_t)(p_stats->cycles_total / p_stats->transfers) : 0;
+  p_out->cycles_max = p_stats->cycles_max;
+}
+
+static void bulk_stats_send() {
+  app_usbd_dfu_bulk_ep_stats_t rx_stats;
+  app_usbd_dfu_bulk_ep_stats_t tx_stats;
+  uint8_t rsp[RSP_HEADER_SIZE + 2 * sizeof(usb_dfu_ep_stats_t)] = {
+    NRF_DFU_OP_RESPONSE, DFU_OP_USB_STATS, NRF_DFU_RES_CODE_SUCCESS
+  };
+
+  app_usbd_dfu_bulk_stats_get(&m_app_dfu_bulk, &rx_stats, &tx_stats);
+  ep_stats_convert(&rx_stats, (usb_dfu_ep_stats_t *)&rsp[RSP_HEADER_SIZE]);
+  ep_stats_convert(&tx_stats, (usb_dfu_ep_stats_t *)&rsp[RSP_HEADER_SIZE + sizeof(usb_dfu_ep_stats_t)]);
+
+  (void)m_bulk_serial.rsp_func(rsp, sizeof(rsp));
+}
+
+static void bulk_stats_log() {
+  app_usbd_dfu_bulk_ep_stats_t rx_stats;
+  app_usbd_dfu_bulk_ep_stats_t tx_stats;
+  usb_dfu_ep_stats_t rx;
+  usb_dfu_ep_stats_t tx;
+
+  app_usbd_dfu_bulk_stats_get(&m_app_dfu_bulk, &rx_stats, &tx_stats);
+  ep_stats_convert(&rx_stats, &rx);
+  ep_stats_convert(&tx_stats, &tx);
+
+  NRF_LOG_INFO("Bulk OUT: %d transfers, %d bytes, %d/%d cycles avg/max", rx.transfers, rx.bytes, rx.cycles_avg, rx.cycles_max);
+  NRF_LOG_INFO("Bulk IN: %d transfers, %d bytes, %d/%d cycles avg/max", tx.transfers, tx.bytes, tx.cycles_avg, tx.cycles_max);
+}
+#endif
+
+#if NRF_DFU_USB_BULK_ENABLED && BOOT_PROBES_ACTIVE
+static void boot_probes_send() {
+  uint8_t rsp[RSP_HEADER_SIZE + BOOT_PROBE_COUNT * sizeof(usb_dfu_probe_t)] = {
+    NRF_DFU_OP_RESPONSE, DFU_OP_BOOT_PROBES, NRF_DFU_RES_CODE_SUCCESS
+  };
+  usb_dfu_probe_t * p_out = (usb_dfu_probe_t *)&rsp[RSP_HEADER_SIZE];
+
+  for (uint32_t id = 0; id < BOOT_PROBE_COUNT; id++) {
+    boot_probe_stats_t probe;
+
+    boot_probe_get((boot_probe_id_t)id, &probe);
+    p_out[id].count = probe.count;
+    p_out[id].min = probe.min;
+    p_out[id].max = probe.max;
+    p_out[id].avg = (probe.count > 0) ? (uint32_t)(probe.total / probe.count) : 0;
+  }
+
+  (void)m_bulk_serial.rsp_func(rsp, sizeof(rsp));
+}
+#endif
+
+static void flow_status_get(rx_path_t const * p_rx, usb_dfu_flow_status_t * p_status) {
+  p_status->rx_buffers_free = p_rx->buffers_free;
+  p_status->rx_buffers_total = p_rx->buffers_total;
+  p_status->flash_backlog = p_rx->flash_backlog;
+}
+
+void usb_dfu_transport_load_get(usb_dfu_transport_load_t * p_load) {
+  p_load->rx_buffers_used = m_cdc_rx.buffers_total - m_cdc_rx.buffers_free;
+  p_load->flash_backlog = m_cdc_rx.flash_backlog;
+  p_load->rx_held = 0;
+
+#if NRF_DFU_USB_BULK_ENABLED
+  p_load->rx_buffers_used += m_bulk_rx.buffers_total - m_bulk_rx.buffers_free;
+  p_load->flash_backlog += m_bulk_rx.flash_backlog;
+  p_load->rx_held = m_bulk_rx_held;
+#endif
+}
+
+/*
+* Hands a received request to the serial layer, which takes ownership of the
+* buffer. Flow status requests are answered here directly so they are not
+* queued behind pending flash writes.
+*/
+static void rx_packet_dispatch(rx_path_t * p_rx, uint8_t * p_buf, uint32_t length) {
+  rx_header_t * p_header = (rx_header_t *)p_buf;
+  uint8_t * p_request = &p_buf[OPCODE_OFFSET];
+
+  if (p_request[0] == DFU_OP_FLOW_STATUS) {
+    uint8_t rsp[RSP_HEADER_SIZE + sizeof(usb_dfu_flow_status_t)] = {
+      NRF_DFU_OP_RESPONSE, DFU_OP_FLOW_STATUS, NRF_DFU_RES_CODE_SUCCESS
+    };
+    uint32_t rsp_len = RSP_HEADER_SIZE;
+    ret_code_t ret_code;
+
+    //released through the interface so a read held back for lack of buffers is resumed
+    p_rx->p_serial->payload_free_func(&p_buf[DATA_OFFSET]);
+
+    if (!p_rx->status_trailer) {
+      flow_status_get(p_rx, (usb_dfu_flow_status_t *)&rsp[RSP_HEADER_SIZE]);
+      rsp_len += sizeof(usb_dfu_flow_status_t);
+    }
+
+    ret_code = p_rx->p_serial->rsp_func(rsp, rsp_len);
+
+    if (ret_code != NRF_SUCCESS) {
+      NRF_LOG_WARNING("Flow status not sent. Error: 0x%x.", ret_code);
+    }
+
+    return;
+  }
+
+#if NRF_DFU_USB_BULK_ENABLED && NRF_DFU_USB_BULK_STATS_ENABLED
+  if ((p_request[0] == DFU_OP_USB_STATS) && (p_rx == &m_bulk_rx)) {
+    p_rx->p_serial->payload_free_func(&p_buf[DATA_OFFSET]);
+    bulk_stats_send();
+    return;
+  }
+#endif
+
+#if NRF_DFU_USB_BULK_ENABLED && BOOT_PROBES_ACTIVE
+  if ((p_request[0] == DFU_OP_BOOT_PROBES) && (p_rx == &m_bulk_rx)) {
+    p_rx->p_serial->payload_free_func(&p_buf[DATA_OFFSET]);
+    boot_probes_send();
+    return;
+  }
+#endif
+
+  if (p_request[0] == NRF_DFU_OP_OBJECT_WRITE) {
+    p_header->backlog = length - NRF_SERIAL_OPCODE_SIZE;
+    p_rx->flash_backlog += p_header->backlog;
+  }
+
+#if BOOT_PROBES_ACTIVE
+  p_header->received = boot_probe_now();
+#endif
+
+  nrf_dfu_serial_on_packet_received(p_rx->p_serial, p_request, length);
+}
+
+static void payload_free(void * p_buf) {
+  rx_buf_free(&m_cdc_rx, p_buf);
+}
+
+static void slip_buffer_reset(uint8_t * p_rx_buf) {
+  m_slip.p_buffer = &p_rx_buf[OPCODE_OFFSET];
+  m_slip.current_index = 0;
+  m_slip.buffer_len = SLIP_MTU;
+  m_slip.state = SLIP_STATE_DECODING;
+}
+
+//called for every received byte, decodes from RAM together with slip.c
+RAMFUNC static void on_rx_complete(uint8_t const * p_data, uint8_t len) {
+  uint8_t * p_rx_buf;
+
+  //a zero length transfer means there is nothing to decode
+  if ((len == 0) || (slip_decode_add_byte(&m_slip, p_data[0]) != NRF_SUCCESS)) {
+    return;
+  }
+
+  rx_packet_dispatch(&m_cdc_rx, m_slip.p_buffer - OPCODE_OFFSET, m_slip.current_index);
+
+  p_rx_buf = rx_buf_alloc(&m_cdc_rx);
+
+  if (p_rx_buf == NULL) {
+    NRF_LOG_ERROR("Failed to allocate buffer");
+    return;
+  }
+
+  slip_buffer_reset(p_rx_buf);
+}
+
+static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_cdc_acm_user_event_t event) {
+  ret_code_t ret_code;
+
+  switch (event) {
+    case APP_USBD_CDC_ACM_USER_EVT_PORT_OPEN:
+      ret_code = app_usbd_cdc_acm_read(&m_app_cdc_acm, m_rx_buf, 1);
+      if (ret_code != NRF_SUCCESS && ret_code != NRF_ERROR_IO_PENDING) {
+        NRF_LOG_WARNING("Could not read from CDC. Error: 0x%x.", ret_code);
+      }
+      break;
+
+    case APP_USBD_CDC_ACM_USER_EVT_PORT_CLOSE:
+      //responses to a host that is gone are dropped
+      m_cdc_tx_head = 0;
+      m_cdc_tx_count = 0;
+      break;
+
+    case APP_USBD_CDC_ACM_USER_EVT_RX_DONE:
+      do {
+        on_rx_complete(m_rx_buf, 1);
+        ret_code = app_usbd_cdc_acm_read(&m_app_cdc_acm, m_rx_buf, 1);
+      } while (ret_code == NRF_SUCCESS);
+      break;
+
+    case APP_USBD_CDC_ACM_USER_EVT_TX_DONE:
+      cdc_tx_done();
+      break;
+
+    default:
+      break;
+  }
+}
+
+#if NRF_DFU_USB_BULK_ENABLED
+/*
+* Starts the IN transfer of the oldest queued response. The flow status is
+* appended only now so the host sees the state at the time it is sent.
+*/
+static void bulk_tx_start() {
+  bulk_tx_slot_t * p_slot = &m_bulk_tx[m_bulk_tx_head];
+  ret_code_t ret_code;
+
+  if ((m_bulk_tx_count == 0) || app_usbd_dfu_bulk_tx_busy(&m_app_dfu_bulk)) {
+    return;
+  }
+
+  flow_status_get(&m_bulk_rx, (usb_dfu_flow_status_t *)&p_slot->data[p_slot->length]);
+
+  ret_code = app_usbd_dfu_bulk_write(&m_app_dfu_bulk, p_slot->data, p_slot->length + sizeof(usb_dfu_flow_status_t));
+
+  if (ret_code != NRF_SUCCESS) {
+    NRF_LOG_WARNING("Could not send bulk response. Error: 0x%x.", ret_code);
+  }
+}
+
+static void bulk_tx_done() {
+  if (m_bulk_tx_count > 0) {
+    m_bulk_tx_head = (m_bulk_tx_head + 1) % NRF_DFU_USB_BULK_TX_BUFFERS;
+    m_bulk_tx_count--;
+  }
+
+  bulk_tx_start();
+}
+
+static uint32_t bulk_rsp_send(uint8_t const * p_data, uint32_t length) {
+  bulk_tx_slot_t * p_slot;
+
+  if (m_bulk_tx_count == NRF_DFU_USB_BULK_TX_BUFFERS) {
+    NRF_LOG_ERROR("Bulk response queue full");
+    return NRF_ERROR_NO_MEM;
+  }
+
+  p_slot = &m_bulk_tx[(m_bulk_tx_head + m_bulk_tx_count) % NRF_DFU_USB_BULK_TX_BUFFERS];
+  memcpy(p_slot->data, p_data, length);
+  p_slot->length = length;
+  m_bulk_tx_count++;
+
+  bulk_tx_start();
+
+  return NRF_SUCCESS;
+}
+
+/*
+* Queues the next OUT transfer if the host is connected and a pool buffer is
+* available. Otherwise the endpoint NAKs until a buffer is released.
+*/
+static void bulk_rx_start() {
+  ret_code_t ret_code;
+
+  if (!m_bulk_ready || app_usbd_dfu_bulk_rx_busy(&m_app_dfu_bulk)) {
+    return;
+  }
+
+  if (mp_bulk_rx_buf == NULL) {
+    mp_bulk_rx_buf = rx_buf_alloc(&m_bulk_rx);
+
+    if (mp_bulk_rx_buf == NULL) {
+      m_bulk_rx_held++;
+      return;
+    }
+  }
+
+  ret_code = app_usbd_dfu_bulk_read(&m_app_dfu_bulk, &mp_bulk_rx_buf[OPCODE_OFFSET], NRF_DFU_USB_BULK_MTU);
+
+  if (ret_code != NRF_SUCCESS) {
+    NRF_LOG_WARNING("Could not queue bulk read. Error: 0x%x.", ret_code);
+  }
+}
+
+static void bulk_payload_free(void * p_buf) {
+  rx_buf_free(&m_bulk_rx, p_buf);
+
+  //a read may have been held back for lack of buffers
+  bulk_rx_start();
+}
+
+static void dfu_bulk_user_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_dfu_bulk_user_event_t event) {
+  uint8_t * p_rx_buf;
+  size_t rx_size;
+
+  switch (event) {
+    case APP_USBD_DFU_BULK_USER_EVT_READY:
+      m_bulk_ready = true;
+      bulk_rx_start();
+      break;
+
+    case APP_USBD_DFU_BULK_USER_EVT_CLOSED:
+      m_bulk_ready = false;
+      //responses to a host that is gone are dropped
+      m_bulk_tx_head = 0;
+      m_bulk_tx_count = 0;
+#if NRF_DFU_USB_BULK_STATS_ENABLED
+      bulk_stats_log();
+#endif
+      break;
+
+    case APP_USBD_DFU_BULK_USER_EVT_RX_DONE:
+      p_rx_buf = mp_bulk_rx_buf;
+      rx_size = app_usbd_dfu_bulk_rx_size(&m_app_dfu_bulk);
+
+      if (rx_size < NRF_SERIAL_OPCODE_SIZE) {
+        //zero length or dropped transfer, reuse the buffer
+        bulk_rx_start();
+        break;
+      }
+
+      //the serial layer owns the buffer from here and releases it through bulk_payload_free()
+      mp_bulk_rx_buf = NULL;
+      bulk_rx_start();
+      rx_packet_dispatch(&m_bulk_rx, p_rx_buf, rx_size);
+      break;
+
+    case APP_USBD_DFU_BULK_USER_EVT_TX_DONE:
+      bulk_tx_done();
+      break;
+
+    default:
+      break;
+  }
+}
+#endif
+
+static void usbd_dfu_transport_ev_handler(app_usbd_event_type_t event) {
+  switch (event) {
+    case APP_USBD_EVT_STOPPED:
+      app_usbd_disable();
+      break;
+
+    case APP_USBD_EVT_POWER_DETECTED:
+      NRF_LOG_INFO("USB power detected");
+      if (!nrf_drv_usbd_is_enabled()) {
+        app_usbd_enable();
+      }
+      if (m_observer) {
+        m_observer(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+      }
+      break;
+
+    case APP_USBD_EVT_POWER_REMOVED:
+      NRF_LOG_INFO("USB power removed");
+#if USB_EVENT_LATENCY_STATS_ENABLED
+      usb_event_queue_latency_log();
+#endif
+      app_usbd_stop();
+      if (m_observer) {
+        m_observer(NRF_DFU_EVT_TRANSPORT_DEACTIVATED);
+      }
+      break;
+
+    case APP_USBD_EVT_DRV_SUSPEND:
+      //lets app_usbd put the peripheral to sleep and release HFCLK
+      (void)app_usbd_suspend_req();
+#if DFU_POWER_IDLE_ENABLED
+      dfu_power_on_usb_suspend(true);
+#endif
+      break;
+
+    case APP_USBD_EVT_DRV_RESUME:
+#if DFU_POWER_IDLE_ENABLED
+      dfu_power_on_usb_suspend(false);
+#endif
+      break;
+
+    case APP_USBD_EVT_POWER_READY:
+      NRF_LOG_INFO("USB ready");
+      app_usbd_start();
+      break;
+
+    default:
+      break;
+  }
+}
+
+static uint32_t usb_dfu_transport_init(nrf_dfu_observer_t observer) {
+  uint32_t err_code;
+  uint8_t * p_rx_buf;
+
+  //events are queued by app_usbd and drained from the scheduler, see usb_event_queue.c
+  static const app_usbd_config_t usbd_config = {
+    .ev_isr_handler = usb_event_queue_isr_handler,
+    .ev_state_proc = usbd_dfu_transport_ev_handler
+  };
+
+  //result is checked when trying to allocate memory
+  (void)nrf_balloc_init(&m_payload_pool);
+
+  m_observer = observer;
+
+  m_serial.rsp_func = rsp_send;
+  m_serial.payload_free_func = payload_free;
+  m_serial.mtu = SLIP_MTU;
+  m_serial.p_rsp_buf = m_rsp_buf;
+  m_serial.p_low_level_transport = &usb_dfu_transport;
+
+  m_cdc_rx.p_pool = &m_payload_pool;
+  m_cdc_rx.p_serial = &m_serial;
+  m_cdc_rx.buffers_free = NRF_DFU_SERIAL_USB_RX_BUFFERS;
+  m_cdc_rx.buffers_total = NRF_DFU_SERIAL_USB_RX_BUFFERS;
+
+  p_rx_buf = rx_buf_alloc(&m_cdc_rx);
+
+  if (p_rx_buf == NULL) {
+    return NRF_ERROR_NO_MEM;
+  }
+
+  slip_buffer_reset(p_rx_buf);
+
+#if NRF_DFU_USB_BULK_ENABLED
+  (void)nrf_balloc_init(&m_bulk_pool);
+
+  m_bulk_serial.rsp_func = bulk_rsp_send;
+  m_bulk_serial.payload_free_func = bulk_payload_free;
+  m_bulk_serial.mtu = NRF_DFU_USB_BULK_MTU;
+  m_bulk_serial.p_rsp_buf = m_bulk_rsp_buf;
+  m_bulk_serial.p_low_level_transport = &usb_dfu_transport;
+
+  m_bulk_rx.p_pool = &m_bulk_pool;
+  m_bulk_rx.p_serial = &m_bulk_serial;
+  m_bulk_rx.buffers_free = NRF_DFU_USB_BULK_RX_BUFFERS;
+  m_bulk_rx.buffers_total = NRF_DFU_USB_BULK_RX_BUFFERS;
+  m_bulk_rx.status_trailer = true;
+#endif
+
+  err_code = nrf_drv_clock_init();
+
+  if (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED) {
+    VERIFY_SUCCESS(err_code);
+  }
+
+  err_code = nrf_drv_power_init(NULL);
+  VERIFY_SUCCESS(err_code);
+
+  app_usbd_serial_num_generate();
+  usb_event_queue_init();
+
+  //keeps USB serviced while a page is erased, requests are only queued there
+  nvmc_erase_slice_handler_set(usb_event_queue_process);
+
+  err_code = app_usbd_init(&usbd_config);
+  VERIFY_SUCCESS(err_code);
+
+  err_code = app_usbd_class_append(app_usbd_cdc_acm_class_inst_get(&m_app_cdc_acm));
+  VERIFY_SUCCESS(err_code);
+
+#if NRF_DFU_USB_BULK_ENABLED
+  err_code = app_usbd_class_append(app_usbd_dfu_bulk_class_inst_get(&m_app_dfu_bulk));
+  VERIFY_SUCCESS(err_code);
+#endif
+
+  if (USBD_POWER_DETECTION) {
+    err_code = app_usbd_power_events_enable();
+    VERIFY_SUCCESS(err_code);
+  } else {
+    NRF_LOG_DEBUG("No USB power detection enabled, starting USB now");
+    app_usbd_enable();
+    app_usbd_start();
+  }
+
+  NRF_LOG_DEBUG("USB Transport initialized");
+
+  return err_code;
+}
+
+static uint32_t usb_dfu_transport_close(nrf_dfu_transport_t const * p_exception) {
+  return NRF_SUCCESS;
+}
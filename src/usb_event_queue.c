@@ -0,0 +1,188 @@
+#include <string.h>
+#include "usb_event_queue.h"
+#include "ramfunc.h"
+#include "app_scheduler.h"
+#include "nrf_atfifo.h"
+#include "nrf_atomic.h"
+#include "nrf.h"
+
+#define NRF_LOG_MODULE_NAME usb_event_queue
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+/*
+* USB events are queued by app_usbd itself (APP_USBD_CONFIG_EVENT_QUEUE_ENABLE,
+* a lock free nrf_atfifo) and this module only decides when they are
+* processed. The interrupt handler kicks a single drain event into the
+* scheduler when the queue goes from idle to pending, and the drain processes
+* everything queued by then. This keeps all USB class and DFU request
+* handling in the scheduler context, runs the interrupt without any critical
+* section and needs one scheduler slot instead of one per USB event. Between
+* events the bootloader main loop sleeps in WFE.
+*/
+
+static nrf_atomic_flag_t m_drain_pending;
+static bool m_processing;
+
+#if USB_EVENT_LATENCY_STATS_ENABLED
+/*
+* Type and time of every queued event, in the same order as the app_usbd
+* queue and with the same depth.
+*/
+typedef struct {
+  uint32_t timestamp;
+  uint8_t type;
+} usb_evt_stamp_t;
+
+NRF_ATFIFO_DEF(m_stamp_fifo, usb_evt_stamp_t, APP_USBD_CONFIG_EVENT_QUEUE_SIZE);
+
+static usb_evt_latency_t m_latency[USB_EVT_TYPE_COUNT];
+
+RAMFUNC static usb_evt_type_t event_type_get(app_usbd_event_type_t type) {
+  switch (type) {
+    case APP_USBD_EVT_DRV_EPTRANSFER:
+      return USB_EVT_TYPE_TRANSFER;
+    case APP_USBD_EVT_DRV_SETUP:
+      return USB_EVT_TYPE_SETUP;
+    case APP_USBD_EVT_DRV_RESET:
+    case APP_USBD_EVT_DRV_SUSPEND:
+    case APP_USBD_EVT_DRV_RESUME:
+    case APP_USBD_EVT_DRV_WUREQ:
+      return USB_EVT_TYPE_BUS;
+    default:
+      return USB_EVT_TYPE_OTHER;
+  }
+}
+
+RAMFUNC static void stamp_put(app_usbd_event_type_t type) {
+  usb_evt_stamp_t stamp = {
+    .timestamp = DWT->CYCCNT,
+    .type = (uint8_t)event_type_get(type)
+  };
+
+  (void)nrf_atfifo_alloc_put(m_stamp_fifo, &stamp, sizeof(stamp), NULL);
+}
+
+/*
+* Accounts the event that is about to be processed. The stamp is pushed right
+* after app_usbd queued the event, so in rare cases an event is processed
+* before its stamp exists and the stamp is attributed to the next one.
+*/
+static void latency_record() {
+  usb_evt_stamp_t stamp;
+  usb_evt_latency_t * p_latency;
+  uint32_t cycles;
+  uint32_t bucket;
+
+  if (nrf_atfifo_get_free(m_stamp_fifo, &stamp, sizeof(stamp), NULL) != NRF_SUCCESS) {
+    return;
+  }
+
+  cycles = DWT->CYCCNT - stamp.timestamp;
+  p_latency = &m_latency[stamp.type];
+
+  //index of the highest bit above the first bucket limit
+  bucket = 32 - __CLZ(cycles >> USB_EVT_LATENCY_SHIFT);
+
+  if (bucket >= USB_EVT_LATENCY_BUCKETS) {
+    bucket = USB_EVT_LATENCY_BUCKETS - 1;
+  }
+
+  p_latency->count++;
+  p_latency->buckets[bucket]++;
+
+  if (cycles > p_latency->cycles_max) {
+    p_latency->cycles_max = cycles;
+  }
+}
+
+void usb_event_queue_latency_get(usb_evt_type_t type, usb_evt_latency_t * p_latency) {
+  *p_latency = m_latency[type];
+}
+
+void usb_event_queue_latency_log() {
+  static char const * const names[USB_EVT_TYPE_COUNT] = { "transfer", "setup", "bus", "other" };
+
+  for (uint32_t type = 0; type < USB_EVT_TYPE_COUNT; type++) {
+    usb_evt_latency_t const * p_latency = &m_latency[type];
+
+    if (p_latency->count == 0) {
+      continue;
+    }
+
+    NRF_LOG_INFO("USB %s events: %d, max latency %d cycles", names[type], p_latency->count, p_latency->cycles_max);
+
+    for (uint32_t bucket = 0; bucket < USB_EVT_LATENCY_BUCKETS; bucket++) {
+      if (p_latency->buckets[bucket] != 0) {
+        NRF_LOG_INFO("  < 2^%d cycles: %d", bucket + USB_EVT_LATENCY_SHIFT, p_latency->buckets[bucket]);
+      }
+    }
+  }
+}
+#endif
+
+static void events_process() {
+  m_processing = true;
+
+  do {
+#if USB_EVENT_LATENCY_STATS_ENABLED
+    latency_record();
+#endif
+  } while (app_usbd_event_queue_process());
+
+  m_processing = false;
+}
+
+static void queue_drain(void * p_event_data, uint16_t event_size) {
+  //cleared first, an event queued while draining schedules another (possibly empty) drain
+  nrf_atomic_flag_clear(&m_drain_pending);
+
+  events_process();
+}
+
+/*
+* Processes the queued events right away, for code that blocks the scheduler
+* for a long time, e.g. between the slices of a page erase. Does nothing when
+* called from within the processing of an event. The scheduled drain may
+* find the queue empty afterwards.
+*/
+void usb_event_queue_process() {
+  if (!m_processing) {
+    events_process();
+  }
+}
+
+void usb_event_queue_init() {
+  nrf_atomic_flag_clear(&m_drain_pending);
+  m_processing = false;
+
+#if USB_EVENT_LATENCY_STATS_ENABLED
+  memset(m_latency, 0, sizeof(m_latency));
+  (void)NRF_ATFIFO_INIT(m_stamp_fifo);
+
+  //the cycle counter is shared, only make sure it runs
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/*
+* Called by app_usbd from the USBD and POWER interrupts for every event.
+*/
+RAMFUNC void usb_event_queue_isr_handler(app_usbd_internal_evt_t const * const p_event, bool queued) {
+  if (!queued) {
+    return;
+  }
+
+#if USB_EVENT_LATENCY_STATS_ENABLED
+  //every queued event, SOF included, or the stamps get out of step with the queue
+  stamp_put(p_event->app_evt.type);
+#endif
+
+  if (nrf_atomic_flag_set_fetch(&m_drain_pending) == 0) {
+    if (app_sched_event_put(NULL, 0, queue_drain) != NRF_SUCCESS) {
+      //retried on the next event
+      nrf_atomic_flag_clear(&m_drain_pending);
+    }
+  }
+}
@@ -0,0 +1,102 @@
+#include <stdbool.h>
+#include "wdt_feed.h"
+#include "ramfunc.h"
+#include "nrf.h"
+#include "nrf_wdt.h"
+
+#define NRF_LOG_MODULE_NAME wdt_feed
+#include "nrf_log.h"
+NRF_LOG_MODULE_REGISTER();
+
+void __real_app_sched_execute(void);
+
+#if WDT_FEED_POINTS_ENABLED
+#define CYCLES_PER_MS (SystemCoreClock / 1000)
+
+static uint32_t m_last_mark;
+static uint32_t m_gap_max;
+static wdt_feed_stats_t m_stats;
+
+/*
+* Records the cycles since the previous mark. The cycle counter wraps after
+* 67 s at 64 MHz, far beyond any watchdog period worth measuring.
+*/
+RAMFUNC static void mark() {
+  uint32_t now = DWT->CYCCNT;
+  uint32_t gap = now - m_last_mark;
+
+  m_last_mark = now;
+
+  if (gap > m_gap_max) {
+    m_gap_max = gap;
+  }
+
+  if (gap > WDT_FEED_GAP_BUDGET_MS * CYCLES_PER_MS) {
+    m_stats.over_budget++;
+  }
+}
+
+/*
+* Called at the start of main(), the time before it is not accounted.
+*/
+void wdt_feed_init() {
+  //the cycle counter is shared, only make sure it runs
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  m_last_mark = DWT->CYCCNT;
+}
+
+/*
+* Feeds the reload registers the application enabled, the watchdog can not be
+* reconfigured once started.
+*/
+RAMFUNC void wdt_feed_point() {
+  mark();
+
+  if (!nrf_wdt_started()) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < NRF_WDT_CHANNEL_NUMBER; i++) {
+    nrf_wdt_rr_register_t rr = (nrf_wdt_rr_register_t)(NRF_WDT_RR0 + i);
+
+    if (nrf_wdt_reload_request_is_enabled(rr)) {
+      nrf_wdt_reload_request_set(rr);
+    }
+  }
+
+  m_stats.feeds++;
+}
+
+void wdt_feed_stats_get(wdt_feed_stats_t * p_stats) {
+  *p_stats = m_stats;
+  p_stats->gap_max_ms = m_gap_max / CYCLES_PER_MS;
+}
+
+void wdt_feed_stats_log() {
+  wdt_feed_stats_t stats;
+
+  wdt_feed_stats_get(&stats);
+
+  NRF_LOG_INFO("Longest gap between feed points %d ms, over %d ms: %d, watchdog fed: %d",
+               stats.gap_max_ms, WDT_FEED_GAP_BUDGET_MS, stats.over_budget, stats.feeds);
+}
+#endif
+
+/*
+* Replaces app_sched_execute(), called by the main loop of nrf_bootloader.c
+* whenever the CPU wakes up. The time spent waiting for events before a run
+* is not a gap, the run itself is.
+*/
+void __wrap_app_sched_execute(void) {
+#if WDT_FEED_POINTS_ENABLED
+  m_last_mark = DWT->CYCCNT;
+#endif
+
+  __real_app_sched_execute();
+
+#if WDT_FEED_POINTS_ENABLED
+  mark();
+#endif
+}
@@ -0,0 +1,13 @@
+#ifndef __FAKE_SEGGER_RTT_H__
+#define __FAKE_SEGGER_RTT_H__
+
+#define SEGGER_RTT_MODE_NO_BLOCK_SKIP 0
+#define SEGGER_RTT_MODE_NO_BLOCK_TRIM 1
+#define SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL 2
+
+void SEGGER_RTT_Init(void);
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char * sName, void * pBuffer, unsigned BufferSize,
+                              unsigned Flags);
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void * pBuffer, unsigned NumBytes);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __FAKE_APP_ERROR_H__
+#define __FAKE_APP_ERROR_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nordic_common.h"
+
+/*
+* Same expansion as the SDK without DEBUG, the handlers are those of main.c.
+*/
+void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t * p_file_name);
+void app_error_handler_bare(ret_code_t error_code);
+void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info);
+
+#define NRF_BREAKPOINT_COND
+
+#define APP_ERROR_HANDLER(ERR_CODE)                                                   \
+  do {                                                                                \
+    app_error_handler_bare((ERR_CODE));                                               \
+  } while (0)
+
+#define APP_ERROR_CHECK(ERR_CODE)                                                     \
+  do {                                                                                \
+    const uint32_t LOCAL_ERR_CODE = (ERR_CODE);                                       \
+    if (LOCAL_ERR_CODE != NRF_SUCCESS) {                                              \
+      APP_ERROR_HANDLER(LOCAL_ERR_CODE);                                              \
+    }                                                                                 \
+  } while (0)
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FAKE_APP_ERROR_WEAK_H__
+#define __FAKE_APP_ERROR_WEAK_H__
+
+#include "app_error.h"
+
+#endif
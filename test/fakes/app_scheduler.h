@@ -0,0 +1,12 @@
+#ifndef __FAKE_APP_SCHEDULER_H__
+#define __FAKE_APP_SCHEDULER_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+typedef void (*app_sched_event_handler_t)(void * p_event_data, uint16_t event_size);
+
+//queued in fake_usbd.c, run by fake_usbd_sched_run()
+ret_code_t app_sched_event_put(void const * p_event_data, uint16_t event_size, app_sched_event_handler_t handler);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __FAKE_APP_TIMER_H__
+#define __FAKE_APP_TIMER_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+typedef struct {
+  uint32_t ticks;
+  void * p_context;
+} app_timer_t;
+
+typedef app_timer_t * app_timer_id_t;
+
+typedef enum {
+  APP_TIMER_MODE_SINGLE_SHOT,
+  APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+typedef void (*app_timer_timeout_handler_t)(void * p_context);
+
+#define APP_TIMER_DEF(timer_id)                                                       \
+  static app_timer_t timer_id##_data;                                                 \
+  static const app_timer_id_t timer_id = &timer_id##_data
+
+#define APP_TIMER_TICKS(ms) ((uint32_t)(((uint64_t)(ms) * 32768) / 1000))
+
+ret_code_t app_timer_init(void);
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+uint32_t app_timer_cnt_get(void);
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from);
+
+#endif
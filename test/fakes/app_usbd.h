@@ -0,0 +1,50 @@
+#ifndef __FAKE_APP_USBD_H__
+#define __FAKE_APP_USBD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_drv_usbd.h"
+
+/*
+* The event queue of app_usbd (APP_USBD_CONFIG_EVENT_QUEUE_ENABLE), fed by
+* fake_usbd_event() in place of the USBD and POWER interrupts, and the class
+* list, see fake_usbd.c.
+*/
+typedef enum {
+  APP_USBD_EVT_DRV_SOF,
+  APP_USBD_EVT_DRV_RESET,
+  APP_USBD_EVT_DRV_SUSPEND,
+  APP_USBD_EVT_DRV_RESUME,
+  APP_USBD_EVT_DRV_WUREQ,
+  APP_USBD_EVT_DRV_SETUP,
+  APP_USBD_EVT_DRV_EPTRANSFER,
+  APP_USBD_EVT_FIRST_POWER,
+  APP_USBD_EVT_POWER_DETECTED = APP_USBD_EVT_FIRST_POWER,
+  APP_USBD_EVT_POWER_REMOVED,
+  APP_USBD_EVT_POWER_READY,
+  APP_USBD_EVT_STARTED,
+  APP_USBD_EVT_STOPPED,
+  APP_USBD_EVT_INST_APPEND,
+  APP_USBD_EVT_INST_REMOVE,
+  APP_USBD_EVT_STATE_CHANGED
+} app_usbd_event_type_t;
+
+typedef struct {
+  app_usbd_event_type_t type;
+} app_usbd_evt_t;
+
+typedef union {
+  app_usbd_event_type_t type;
+  app_usbd_evt_t app_evt;
+  nrf_drv_usbd_evt_t drv_evt;
+} app_usbd_complex_evt_t;
+
+typedef app_usbd_complex_evt_t app_usbd_internal_evt_t;
+
+typedef struct app_usbd_class_inst_s app_usbd_class_inst_t;
+
+bool app_usbd_event_queue_process(void);
+ret_code_t app_usbd_class_append(app_usbd_class_inst_t const * p_cinst);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __FAKE_APP_USBD_CLASS_BASE_H__
+#define __FAKE_APP_USBD_CLASS_BASE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "app_usbd.h"
+#include "nrf_drv_usbd.h"
+
+/*
+* Class instances of app_usbd with one interface each, which is all the
+* classes built for the host have. The instance layout is the one of the
+* SDK: the base followed by a pointer to the class data and the class
+* configuration, in a union with the base alone.
+*/
+#define FAKE_USBD_CLASS_EPS 3
+
+typedef nrf_drv_usbd_ep_t app_usbd_class_ep_conf_t;
+
+typedef struct {
+  uint8_t number;
+  uint8_t ep_count;
+  app_usbd_class_ep_conf_t ep[FAKE_USBD_CLASS_EPS];
+} app_usbd_class_iface_conf_t;
+
+//the descriptor is written in one call, max_size must hold it
+typedef struct {
+  size_t size;
+} app_usbd_class_descriptor_ctx_t;
+
+typedef struct {
+  ret_code_t (*event_handler)(app_usbd_class_inst_t const * p_inst, app_usbd_complex_evt_t const * p_event);
+  bool (*feed_descriptors)(app_usbd_class_descriptor_ctx_t * p_ctx, app_usbd_class_inst_t const * p_inst,
+                           uint8_t * p_buff, size_t max_size);
+} app_usbd_class_methods_t;
+
+struct app_usbd_class_inst_s {
+  app_usbd_class_methods_t const * p_class_methods;
+  app_usbd_class_iface_conf_t iface;
+};
+
+#define APP_USBD_CLASS_FORWARD(type_name) typedef union type_name##_u type_name##_t
+
+#define APP_USBD_CLASS_TYPEDEF(type_name, interfaces_configs, class_config_dec, class_data_dec) \
+  typedef struct {                                                                            \
+    class_data_dec                                                                            \
+  } type_name##_data_t;                                                                       \
+  union type_name##_u {                                                                       \
+    app_usbd_class_inst_t base;                                                               \
+    struct {                                                                                  \
+      app_usbd_class_inst_t base;                                                             \
+      type_name##_data_t * p_data;                                                            \
+      class_config_dec                                                                        \
+    } specific;                                                                               \
+  }
+
+#define FAKE_USBD_UNPAREN(...) __VA_ARGS__
+#define FAKE_USBD_IFACE(config) FAKE_USBD_IFACE_ config
+#define FAKE_USBD_IFACE_(iface_number, ...)                                                   \
+  {                                                                                           \
+    .number = (iface_number),                                                                 \
+    .ep_count = sizeof((nrf_drv_usbd_ep_t[]){ __VA_ARGS__ }) / sizeof(nrf_drv_usbd_ep_t),    \
+    .ep = { __VA_ARGS__ }                                                                     \
+  }
+
+#define APP_USBD_CLASS_INST_GLOBAL_DEF(instance_name, type_name, interface_methods, interfaces_configs, \
+                                       class_config_part)                                            \
+  static type_name##_data_t instance_name##_data;                                                    \
+  static const type_name##_t instance_name = {                                                       \
+    .specific = {                                                                                    \
+      .base = { .p_class_methods = (interface_methods), .iface = FAKE_USBD_IFACE interfaces_configs },\
+      .p_data = &instance_name##_data,                                                               \
+      FAKE_USBD_UNPAREN class_config_part                                                            \
+    }                                                                                                \
+  }
+
+#define APP_USBD_CLASS_DESCRIPTOR_BEGIN(p_ctx, p_buff, max_size)                              \
+  app_usbd_class_descriptor_ctx_t * p_fake_ctx = (p_ctx);                                     \
+  uint8_t * p_fake_buff = (p_buff);                                                           \
+  size_t fake_max_size = (max_size);                                                          \
+  p_fake_ctx->size = 0
+
+#define APP_USBD_CLASS_DESCRIPTOR_WRITE(data)                                                 \
+  do {                                                                                        \
+    if ((p_fake_buff != NULL) && (p_fake_ctx->size < fake_max_size)) {                        \
+      p_fake_buff[p_fake_ctx->size] = (data);                                                 \
+    }                                                                                         \
+    p_fake_ctx->size++;                                                                       \
+  } while (0)
+
+#define APP_USBD_CLASS_DESCRIPTOR_END() return false
+
+static inline app_usbd_class_iface_conf_t const * app_usbd_class_iface_get(app_usbd_class_inst_t const * p_inst,
+                                                                           uint8_t iface_idx) {
+  return (iface_idx == 0) ? &p_inst->iface : NULL;
+}
+
+static inline uint8_t app_usbd_class_iface_number_get(app_usbd_class_iface_conf_t const * p_iface) {
+  return p_iface->number;
+}
+
+static inline uint8_t app_usbd_class_iface_ep_count_get(app_usbd_class_iface_conf_t const * p_iface) {
+  return p_iface->ep_count;
+}
+
+static inline app_usbd_class_ep_conf_t const * app_usbd_class_iface_ep_get(app_usbd_class_iface_conf_t const * p_iface,
+                                                                           uint8_t ep_idx) {
+  return &p_iface->ep[ep_idx];
+}
+
+static inline nrf_drv_usbd_ep_t app_usbd_class_ep_address_get(app_usbd_class_ep_conf_t const * p_ep) {
+  return *p_ep;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __FAKE_APP_USBD_CORE_H__
+#define __FAKE_APP_USBD_CORE_H__
+
+#include "app_usbd.h"
+#include "app_usbd_class_base.h"
+
+typedef enum {
+  APP_USBD_STATE_Disabled,
+  APP_USBD_STATE_Unattached,
+  APP_USBD_STATE_Powered,
+  APP_USBD_STATE_Default,
+  APP_USBD_STATE_Addressed,
+  APP_USBD_STATE_Configured
+} app_usbd_state_t;
+
+app_usbd_state_t app_usbd_core_state_get(void);
+ret_code_t app_usbd_ep_transfer(nrf_drv_usbd_ep_t ep, nrf_drv_usbd_transfer_t const * p_transfer);
+
+#endif
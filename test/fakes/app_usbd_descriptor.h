@@ -0,0 +1,9 @@
+#ifndef __FAKE_APP_USBD_DESCRIPTOR_H__
+#define __FAKE_APP_USBD_DESCRIPTOR_H__
+
+#define APP_USBD_DESCRIPTOR_INTERFACE 0x04
+#define APP_USBD_DESCRIPTOR_ENDPOINT 0x05
+
+#define APP_USBD_DESCRIPTOR_EP_ATTR_TYPE_BULK 0x02
+
+#endif
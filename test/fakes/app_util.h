@@ -0,0 +1,24 @@
+#ifndef __FAKE_APP_UTIL_H__
+#define __FAKE_APP_UTIL_H__
+
+#include <stdint.h>
+#include "nordic_common.h"
+
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
+
+#define ALIGN_NUM(alignment, number) (((number) - 1) + (alignment) - (((number) - 1) % (alignment)))
+
+#define LSB_16(a) ((uint8_t)((a) & 0x00FF))
+#define MSB_16(a) ((uint8_t)(((a) & 0xFF00) >> 8))
+
+#define STATIC_ASSERT(expr) _Static_assert((expr), #expr)
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef __FAKE_APP_UTIL_PLATFORM_H__
+#define __FAKE_APP_UTIL_PLATFORM_H__
+
+#include "app_util.h"
+
+//the tests run single threaded
+#define CRITICAL_REGION_ENTER() {
+#define CRITICAL_REGION_EXIT() }
+
+#endif
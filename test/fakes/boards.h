@@ -0,0 +1,15 @@
+#ifndef __FAKE_BOARDS_H__
+#define __FAKE_BOARDS_H__
+
+#include <stdint.h>
+#include "nrf.h"
+
+#define BSP_INIT_LEDS (1 << 0)
+#define BSP_BOARD_LED_1 1
+#define BSP_LED_1_MASK (1 << 14)
+#define BSP_LED_1_PORT NULL
+
+void bsp_board_init(uint32_t init_flags);
+void bsp_board_led_invert(uint32_t led_idx);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef __FAKE_CRC32_H__
+#define __FAKE_CRC32_H__
+
+#include <stdint.h>
+
+uint32_t crc32_compute(uint8_t const * p_data, uint32_t size, uint32_t const * p_crc);
+
+#endif
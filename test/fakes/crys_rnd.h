@@ -0,0 +1,26 @@
+#ifndef __FAKE_CRYS_RND_H__
+#define __FAKE_CRYS_RND_H__
+
+#include <stdint.h>
+
+typedef uint32_t CRYSError_t;
+
+#define CRYS_OK 0
+#define CRYS_RND_MODULE_ERROR_BASE 0x00F00C00
+#define CRYS_RND_INSTANTIATION_NOT_DONE_ERROR (CRYS_RND_MODULE_ERROR_BASE + 0x1AUL)
+#define CRYS_RND_TRNG_ERRORS_ERROR (CRYS_RND_MODULE_ERROR_BASE + 0x2DUL)
+
+//only the size matters to the callers
+typedef struct {
+  uint32_t state[64];
+} CRYS_RND_State_t;
+
+typedef struct {
+  uint32_t buff[1404];
+} CRYS_RND_WorkBuff_t;
+
+CRYSError_t CRYS_RndInit(void * rndState_ptr, CRYS_RND_WorkBuff_t * rndWorkBuff_ptr);
+CRYSError_t CRYS_RND_UnInstantiation(void * rndState_ptr);
+CRYSError_t CRYS_RND_GenerateVector(void * rndState_ptr, uint16_t outSizeBytes, uint8_t * out_ptr);
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef __FAKE_H__
+#define __FAKE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+/*
+* Control side of the fakes in this directory. They stand in for the nRF52840
+* peripherals (nrf52840.h), the CryptoCell runtime (crys_rnd.h, sns_silib.h,
+* sasi_util_key_derivation.h) and the SDK flash, settings and boot modules,
+* so the sources of src/ build for the host unchanged. Tests preset and
+* inspect the fakes through this header.
+*
+* Flash is real memory: the address range of the nRF52840 flash (apart from
+* the first page, which the host does not map) is mapped at the same host
+* address, so the code reads the device secrets and the settings page through
+* the same pointers as on the target. Read protected ACL regions are unmapped
+* from reading, a read of them after the protection is applied crashes.
+*/
+
+#define FAKE_CPU_HZ 64000000
+#define FAKE_CYCLES_PER_MS (FAKE_CPU_HZ / 1000)
+
+#define FAKE_FLASH_PAGE_SIZE 0x1000
+#define FAKE_FLASH_START FAKE_FLASH_PAGE_SIZE
+#define FAKE_FLASH_END 0x00100000
+
+/*
+* Peripherals whose registers have side effects. Writes take effect when the
+* peripheral is accessed again, or on fake_periph_sync().
+*/
+typedef enum {
+  FAKE_CRYPTOCELL,
+  FAKE_CC_HOST_RGF,
+  FAKE_FICR,
+  FAKE_POWER,
+  FAKE_NVMC,
+  FAKE_ACL,
+  FAKE_WDT,
+  FAKE_PERIPH_COUNT
+} fake_periph_t;
+
+void * fake_periph(fake_periph_t periph);
+void * fake_periph_peek(fake_periph_t periph); // for the fakes, not counted and never faulted
+void fake_periph_sync();
+
+/*
+* Things the fakes saw, in order, for tests that check the order of the boot
+* steps.
+*/
+typedef enum {
+  FAKE_EVT_ACL_REGION,   // arg: address of an ACL region that was configured
+  FAKE_EVT_KDR_LOADED,   // all four KDR registers written
+  FAKE_EVT_RNG,          // arg: bytes requested from CRYS_RND_GenerateVector()
+  FAKE_EVT_FLASH_ERASE,  // arg: page address
+  FAKE_EVT_FLASH_STORE,  // arg: destination address
+  FAKE_EVT_ACL_VIOLATION,// arg: address of a store the ACL denied
+  FAKE_EVT_WDT_TIMEOUT,  // the watchdog period passed without a feed
+  FAKE_EVT_APP_START,    // nrf_bootloader_app_start()
+  FAKE_EVT_RESET         // NVIC_SystemReset()
+} fake_evt_type_t;
+
+typedef struct {
+  fake_evt_type_t type;
+  uint32_t arg;
+} fake_evt_t;
+
+#define FAKE_EVT_MAX 256
+
+extern fake_evt_t fake_evts[FAKE_EVT_MAX];
+extern uint32_t fake_evt_count;
+
+void fake_evt(fake_evt_type_t type, uint32_t arg);
+int fake_evt_find(fake_evt_type_t type, uint32_t arg); // index of the first match, -1 if none
+int fake_evt_find_any(fake_evt_type_t type);
+
+/*
+* One fault per run, injected when the counter of its kind reaches at. The
+* counters run whether or not a fault is armed, so a clean run tells how many
+* candidates there are.
+*/
+typedef enum {
+  FAKE_FAULT_NONE,
+  FAKE_FAULT_BRANCH,      // the branch hook inverts branch number at
+  FAKE_FAULT_REGISTER,    // peripheral access number at reads value in every register, its write is lost
+  FAKE_FAULT_RNG,         // CRYS_RND_GenerateVector() call number at fails
+  FAKE_FAULT_FLASH_STORE, // nrf_dfu_flash_store() call number at fails
+  FAKE_FAULT_TYPE_COUNT
+} fake_fault_type_t;
+
+typedef struct {
+  fake_fault_type_t type;
+  uint32_t at;
+  uint32_t value;
+  bool injected;
+  char const * p_file; // where a branch fault was injected
+  uint32_t line;
+} fake_fault_t;
+
+typedef struct {
+  uint32_t branches;
+  uint32_t registers;
+  uint32_t rng_calls;
+  uint32_t flash_stores;
+} fake_counters_t;
+
+extern fake_fault_t fake_fault;
+extern fake_counters_t fake_counters;
+
+bool fake_fault_hit(fake_fault_type_t type, uint32_t * p_counter);
+bool fake_branch(bool taken, char const * p_file, uint32_t line);
+
+/*
+* CryptoCell state behind the fakes.
+*/
+typedef struct {
+  uint32_t lcs;           // life cycle state last written
+  uint32_t kdr[4];        // key in the KDR registers
+  uint32_t kdr_loaded;    // bit per KDR register written
+  uint32_t kdr_writes;    // writes including the ignored ones
+  uint32_t lib_init;      // SaSi_LibInit() calls
+  uint32_t lib_open;      // SaSi_LibInit() without SaSi_LibFini()
+  uint32_t rnd_open;      // CRYS_RndInit() without CRYS_RND_UnInstantiation()
+  uint32_t rng_bytes;     // bytes generated in total
+  uint32_t rng_seed;
+} fake_cc_t;
+
+extern fake_cc_t fake_cc;
+
+//AES-CMAC of RFC 4493 with a 16 byte key, the PRF of the key derivation
+void fake_aes_cmac(uint8_t const * p_key, uint8_t const * p_data, size_t size, uint8_t * p_mac);
+
+/*
+* nrf_crypto, the hash calls are counted and call number fail_call fails.
+*/
+typedef struct {
+  bool initialized;
+  uint32_t hash_calls;
+  uint32_t fail_call;
+} fake_crypto_t;
+
+extern fake_crypto_t fake_crypto;
+
+/*
+* NVMC and flash. A page is only erased once its partial erases add up to
+* erase_time_ms, a full erase takes that long at once. Time is the cycle
+* counter, every erase advances it.
+*/
+typedef struct {
+  uint32_t erase_time_ms;
+  uint32_t partial_erases;
+  uint32_t full_erases;
+  uint32_t stores;
+  uint32_t bytes_stored;
+  uint32_t cut_after;     // bytes the next store writes before the power is cut
+  uint32_t erase_progress_ms[FAKE_FLASH_END / FAKE_FLASH_PAGE_SIZE];
+} fake_flash_t;
+
+extern fake_flash_t fake_flash;
+
+void fake_flash_program(uint32_t address, void const * p_data, uint32_t length);
+void fake_flash_fill(uint32_t address, uint8_t value, uint32_t length);
+void fake_flash_read(uint32_t address, void * p_data, uint32_t length); // ignores the read protection
+
+//whether an applied ACL region spans the range and denies at least the accesses in perm
+bool fake_flash_protected(uint32_t address, uint32_t size, uint32_t perm);
+
+//used by the fake NVMC and ACL, the ACL applies to the erase and the stores
+void fake_flash_page_erase(uint32_t address);
+void fake_flash_protect(uint32_t address, uint32_t size, uint32_t perm);
+
+/*
+* Watchdog, started by the application when crv_ms is not zero. A timeout is
+* counted whenever fake_cycles_advance() moves the time past the period since
+* the last feed.
+*/
+typedef struct {
+  uint32_t crv_ms;
+  uint32_t feeds;
+  uint32_t last_feed;
+  uint32_t timeouts;
+} fake_wdt_t;
+
+extern fake_wdt_t fake_wdt;
+
+void fake_wdt_start(uint32_t crv_ms, uint32_t channels);
+void fake_cycles_advance(uint32_t cycles);
+
+/*
+* app_usbd event queue and the scheduler, for usb_event_queue.c.
+* fake_usbd_event() is the USBD interrupt: app_usbd queues the event (drops
+* it when its queue is full) and calls usb_event_queue_isr_handler().
+* Processing an event advances the cycle counter by process_cycles and calls
+* process_handler. app_sched_event_put() fails while sched_full is set.
+* usb_dfu_transport_load_get() of the USB transport returns the load set in
+* rx_buffers_used, flash_backlog and rx_held.
+*
+* The endpoints of nrfx_usbd as the host sees them, for the classes appended
+* with app_usbd_class_append(). app_usbd_ep_transfer() queues a transfer,
+* fake_usbd_host_out() sends one OUT transfer in max packet size packets
+* (ended by a ZLP if it fills its last packet) and fake_usbd_host_in() reads
+* the queued IN transfer. A packet without a queued transfer is NAKed. The
+* class gets the endpoint events directly, not through the event queue.
+* Every transaction, also a NAKed one, is counted in out or in with its
+* payload and FAKE_USBD_PACKET_OVERHEAD bytes: SYNC, PID, address or CRC of
+* the token, data and handshake packets (full speed, without bit stuffing).
+*
+* All endpoints share one EasyDMA channel. While dma_deferred is set, a
+* packet is not moved between the endpoint and RAM when the host sends or
+* reads it. An OUT packet waits in its endpoint, which NAKs the next one. The
+* next packet of an IN transfer is not loaded, the host gets NAKs. Each
+* waiting endpoint raises its request bit at the position nrfx_usbd gives
+* it (FAKE_USBD_DMA_BIT: IN endpoints in bits 0 to 8, OUT endpoints in bits
+* 16 to 24). fake_usbd_dma_run() moves one packet of the endpoint the
+* scheduler of dma_mode (NRFX_USBD_CONFIG_DMASCHEDULER_MODE) picks: the
+* lowest bit when prioritized, the next bit after the last one served in
+* round robin. It advances the cycle counter by FAKE_USBD_DMA_CYCLES, the
+* estimated EasyDMA transfer and driver interrupt of one packet, and
+* records the cycles each endpoint waited. The bus is not timed. In this
+* mode fake_usbd_host_in() reads one packet (and the ZLP after it) and a
+* full last OUT packet needs a separate empty fake_usbd_host_out().
+* Transfers of endpoints no appended class owns complete without an event.
+*/
+#define FAKE_USBD_PACKET_OVERHEAD 10
+
+#define FAKE_USBD_DMA_MODE_PRIORITIZED 0
+#define FAKE_USBD_DMA_MODE_ROUND_ROBIN 1
+#define FAKE_USBD_DMA_CYCLES 300
+#define FAKE_USBD_DMA_BITS 32
+#define FAKE_USBD_DMA_BIT(ep) ((((ep) & 0x80) ? 0 : 16) + ((ep) & 0x0F))
+#define FAKE_USBD_DMA_IDLE 0xFF
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t naks;
+  uint32_t zlps;
+  uint32_t payload;
+  uint32_t wire;
+} fake_usbd_bus_t;
+
+typedef struct {
+  uint32_t process_cycles;
+  void (*process_handler)(void);
+  bool sched_full;
+  uint32_t queued;
+  uint32_t dropped;
+  uint32_t processed;
+  uint32_t sched_puts;
+  uint32_t rx_buffers_used;
+  uint32_t flash_backlog;
+  uint32_t rx_held;
+  fake_usbd_bus_t out;
+  fake_usbd_bus_t in;
+  bool dma_deferred;
+  uint32_t dma_mode;
+  uint32_t dma_packets[FAKE_USBD_DMA_BITS];
+  uint32_t dma_wait_total[FAKE_USBD_DMA_BITS];
+  uint32_t dma_wait_max[FAKE_USBD_DMA_BITS];
+} fake_usbd_t;
+
+extern fake_usbd_t fake_usbd;
+
+void fake_usbd_event(uint32_t type);
+uint32_t fake_usbd_sched_run(); // runs the scheduled events, returns how many ran
+
+void fake_usbd_configure();  // the host selects a configuration
+void fake_usbd_bus_reset();
+uint32_t fake_usbd_host_out(uint32_t ep, void const * p_data, uint32_t size); // returns the bytes sent before a NAK
+uint32_t fake_usbd_host_in(uint32_t ep, void * p_data, uint32_t size); // returns the size of the transfer read
+uint32_t fake_usbd_dma_run(); // returns the endpoint served or FAKE_USBD_DMA_IDLE
+
+/*
+* Up buffers of SEGGER RTT. fake_rtt_read() empties a buffer the way the
+* debugger does, a write that does not fit is counted in dropped.
+*/
+#define FAKE_RTT_CHANNELS 3
+
+typedef struct {
+  uint8_t * p_buffer;
+  uint32_t size;
+  uint32_t flags;
+  uint32_t wr;
+  uint32_t rd;
+  uint32_t written;
+  uint32_t dropped;
+} fake_rtt_up_t;
+
+typedef struct {
+  bool initialized;
+  fake_rtt_up_t up[FAKE_RTT_CHANNELS];
+} fake_rtt_t;
+
+extern fake_rtt_t fake_rtt;
+
+uint32_t fake_rtt_read(uint32_t channel, void * p_data, uint32_t size); // returns the bytes read
+
+/*
+* Boot environment of main(): nrf_bootloader_init() keeps the observer for
+* fake_boot_dfu_evt() and returns init_result if it is an error. Otherwise it
+* enters DFU mode if dfu_enter is set and starts the application if not, both
+* without returning like in SDK 15.3. app_sched_execute() runs sched_handler.
+* app_timer_cnt_get() returns rtc_ticks, nrf_power_dcdcen_set() sets
+* dcdc_enabled.
+* Reset, DFU mode and application start jump back to the setjmp() of the test
+* through fake_boot_jmp.
+*/
+typedef struct {
+  uint32_t init_result;
+  bool dfu_enter;
+  void (*sched_handler)(void);
+  uint32_t rtc_ticks;
+  bool dcdc_enabled;
+} fake_boot_t;
+
+#define FAKE_BOOT_APP_STARTED 1
+#define FAKE_BOOT_RESET 2
+#define FAKE_BOOT_DFU_MODE 3
+
+extern fake_boot_t fake_boot;
+extern jmp_buf fake_boot_jmp;
+
+void fake_boot_dfu_evt(uint32_t evt_type);
+
+#endif
@@ -0,0 +1,13 @@
+#include <setjmp.h>
+#include "fake.h"
+#include "nrf_bootloader_app_start.h"
+
+/*
+* nrf_bootloader_app_start.c of the SDK, apart from nrf_bootloader_init() in
+* fake_boot.c so its call goes through -Wl,--wrap=nrf_bootloader_app_start
+* like on the target.
+*/
+void nrf_bootloader_app_start(void) {
+  fake_evt(FAKE_EVT_APP_START, 0);
+  longjmp(fake_boot_jmp, FAKE_BOOT_APP_STARTED);
+}
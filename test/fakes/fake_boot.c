@@ -0,0 +1,135 @@
+#include <stddef.h>
+#include "fake.h"
+#include "boards.h"
+#include "nrf_bootloader.h"
+#include "nrf_bootloader_app_start.h"
+#include "led_softblink.h"
+#include "app_timer.h"
+#include "nrf_clock.h"
+#include "nrf_power.h"
+#include "nrf_dfu_utils.h"
+
+/*
+* What main() calls besides the sources of src/.
+*/
+fake_boot_t fake_boot;
+jmp_buf fake_boot_jmp;
+
+static nrf_dfu_observer_t m_observer;
+static bool m_lfclk_running;
+
+/*
+* nrf_bootloader_init() of SDK 15.3 only returns on errors. Without a DFU to
+* do it starts the application itself, DFU mode does not return either.
+*/
+ret_code_t nrf_bootloader_init(nrf_dfu_observer_t observer) {
+  m_observer = observer;
+
+  if (fake_boot.init_result != NRF_SUCCESS) {
+    return fake_boot.init_result;
+  }
+
+  if (fake_boot.dfu_enter) {
+    observer(NRF_DFU_EVT_DFU_INITIALIZED);
+    longjmp(fake_boot_jmp, FAKE_BOOT_DFU_MODE);
+  }
+
+  nrf_bootloader_app_start();
+
+  return NRF_ERROR_INTERNAL;
+}
+
+//no SoftDevice, the application follows the MBR
+uint32_t nrf_dfu_bank0_start_addr(void) {
+  return MEMORY_MBR_SIZE;
+}
+
+void fake_boot_dfu_evt(uint32_t evt_type) {
+  if (m_observer != NULL) {
+    m_observer((nrf_dfu_evt_type_t)evt_type);
+  }
+}
+
+//wrapped by wdt_feed.c
+void app_sched_execute(void) {
+  if (fake_boot.sched_handler != NULL) {
+    fake_boot.sched_handler();
+  }
+}
+
+void bsp_board_init(uint32_t init_flags) {
+  (void)init_flags;
+}
+
+void bsp_board_led_invert(uint32_t led_idx) {
+  (void)led_idx;
+}
+
+bool nrf_clock_lf_is_running(void) {
+  return m_lfclk_running;
+}
+
+void nrf_clock_task_trigger(nrf_clock_task_t task) {
+  if (task == NRF_CLOCK_TASK_LFCLKSTART) {
+    m_lfclk_running = true;
+  }
+}
+
+ret_code_t app_timer_init(void) {
+  return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler) {
+  (void)mode;
+
+  return ((p_timer_id == NULL) || (timeout_handler == NULL)) ? NRF_ERROR_NULL : NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context) {
+  timer_id->ticks = timeout_ticks;
+  timer_id->p_context = p_context;
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id) {
+  timer_id->ticks = 0;
+
+  return NRF_SUCCESS;
+}
+
+//the RTC counter is 24 bits wide
+uint32_t app_timer_cnt_get(void) {
+  return fake_boot.rtc_ticks & 0xFFFFFF;
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from) {
+  return (ticks_to - ticks_from) & 0xFFFFFF;
+}
+
+void nrf_power_dcdcen_set(bool enable) {
+  fake_boot.dcdc_enabled = enable;
+}
+
+ret_code_t led_softblink_init(led_sb_init_params_t const * p_init_params) {
+  return (p_init_params == NULL) ? NRF_ERROR_NULL : NRF_SUCCESS;
+}
+
+ret_code_t led_softblink_start(uint32_t leds_pin_bit_mask) {
+  (void)leds_pin_bit_mask;
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t led_softblink_stop(void) {
+  return NRF_SUCCESS;
+}
+
+void led_softblink_off_time_set(uint32_t off_time_ticks) {
+  (void)off_time_ticks;
+}
+
+void led_softblink_on_time_set(uint32_t on_time_ticks) {
+  (void)on_time_ticks;
+}
@@ -0,0 +1,204 @@
+#include <string.h>
+#include "fake.h"
+#include "nrf_crypto.h"
+
+/*
+* nrf_crypto with the hash API only, SHA-256 of FIPS 180-4 in software like
+* the CC310 bl backend computes it, so tests can compare the measurements
+* with digests computed elsewhere.
+*/
+#define SHA256_BLOCK_SIZE 64
+#define CONTEXT_MAGIC 0x48415348
+
+fake_crypto_t fake_crypto;
+
+const nrf_crypto_hash_info_t g_nrf_crypto_hash_sha256_info = { NRF_CRYPTO_HASH_SIZE_SHA256 };
+
+static const uint32_t m_k[64] = {
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const uint32_t m_h0[8] = {
+  0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static uint32_t rotr(uint32_t value, uint32_t bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+static void sha256_block(uint32_t * p_state, uint8_t const * p_block) {
+  uint32_t w[64];
+  uint32_t v[8];
+
+  for (uint32_t i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)p_block[4 * i] << 24) | ((uint32_t)p_block[4 * i + 1] << 16) |
+           ((uint32_t)p_block[4 * i + 2] << 8) | p_block[4 * i + 3];
+  }
+
+  for (uint32_t i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  memcpy(v, p_state, sizeof(v));
+
+  for (uint32_t i = 0; i < 64; i++) {
+    uint32_t s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+    uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    uint32_t t1 = v[7] + s1 + ch + m_k[i] + w[i];
+    uint32_t s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+    uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+
+    memmove(&v[1], &v[0], 7 * sizeof(uint32_t));
+    v[4] += t1;
+    v[0] = t1 + s0 + maj;
+  }
+
+  for (uint32_t i = 0; i < 8; i++) {
+    p_state[i] += v[i];
+  }
+}
+
+//counts the call and tells whether it is the one to fail
+static bool hash_call_fails() {
+  fake_crypto.hash_calls++;
+
+  return fake_crypto.hash_calls == fake_crypto.fail_call;
+}
+
+ret_code_t nrf_crypto_init(void) {
+  fake_crypto.initialized = true;
+
+  return NRF_SUCCESS;
+}
+
+bool nrf_crypto_is_initialized(void) {
+  return fake_crypto.initialized;
+}
+
+ret_code_t nrf_crypto_hash_init(nrf_crypto_hash_context_t * const p_context, nrf_crypto_hash_info_t const * p_info) {
+  if ((p_context == NULL) || (p_info != &g_nrf_crypto_hash_sha256_info)) {
+    return NRF_ERROR_NULL;
+  }
+
+  if (hash_call_fails()) {
+    return NRF_ERROR_CRYPTO_INTERNAL;
+  }
+
+  memset(p_context, 0, sizeof(*p_context));
+  memcpy(p_context->state, m_h0, sizeof(m_h0));
+  p_context->initialized = CONTEXT_MAGIC;
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_crypto_hash_update(nrf_crypto_hash_context_t * const p_context, uint8_t const * p_data, size_t data_size) {
+  if ((p_context == NULL) || ((p_data == NULL) && (data_size > 0))) {
+    return NRF_ERROR_NULL;
+  }
+
+  if (p_context->initialized != CONTEXT_MAGIC) {
+    return NRF_ERROR_CRYPTO_CONTEXT_NOT_INITIALIZED;
+  }
+
+  if (hash_call_fails()) {
+    return NRF_ERROR_CRYPTO_INTERNAL;
+  }
+
+  p_context->length += data_size;
+
+  while (data_size > 0) {
+    uint32_t chunk = SHA256_BLOCK_SIZE - p_context->used;
+
+    if (chunk > data_size) {
+      chunk = data_size;
+    }
+
+    memcpy(p_context->block + p_context->used, p_data, chunk);
+    p_context->used += chunk;
+    p_data += chunk;
+    data_size -= chunk;
+
+    if (p_context->used == SHA256_BLOCK_SIZE) {
+      sha256_block(p_context->state, p_context->block);
+      p_context->used = 0;
+    }
+  }
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_crypto_hash_finalize(nrf_crypto_hash_context_t * const p_context, uint8_t * p_digest,
+                                    size_t * const p_digest_size) {
+  uint64_t bits;
+
+  if ((p_context == NULL) || (p_digest == NULL) || (p_digest_size == NULL)) {
+    return NRF_ERROR_NULL;
+  }
+
+  if (p_context->initialized != CONTEXT_MAGIC) {
+    return NRF_ERROR_CRYPTO_CONTEXT_NOT_INITIALIZED;
+  }
+
+  if (*p_digest_size < NRF_CRYPTO_HASH_SIZE_SHA256) {
+    return NRF_ERROR_DATA_SIZE;
+  }
+
+  if (hash_call_fails()) {
+    return NRF_ERROR_CRYPTO_INTERNAL;
+  }
+
+  bits = p_context->length * 8;
+  p_context->block[p_context->used++] = 0x80;
+
+  if (p_context->used > SHA256_BLOCK_SIZE - 8) {
+    memset(p_context->block + p_context->used, 0, SHA256_BLOCK_SIZE - p_context->used);
+    sha256_block(p_context->state, p_context->block);
+    p_context->used = 0;
+  }
+
+  memset(p_context->block + p_context->used, 0, SHA256_BLOCK_SIZE - 8 - p_context->used);
+
+  for (uint32_t i = 0; i < 8; i++) {
+    p_context->block[SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+  }
+
+  sha256_block(p_context->state, p_context->block);
+
+  for (uint32_t i = 0; i < NRF_CRYPTO_HASH_SIZE_SHA256; i++) {
+    p_digest[i] = (uint8_t)(p_context->state[i / 4] >> (24 - 8 * (i % 4)));
+  }
+
+  *p_digest_size = NRF_CRYPTO_HASH_SIZE_SHA256;
+  p_context->initialized = 0;
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_crypto_hash_calculate(nrf_crypto_hash_context_t * const p_context,
+                                     nrf_crypto_hash_info_t const * p_info,
+                                     uint8_t const * p_data,
+                                     size_t data_size,
+                                     uint8_t * p_digest,
+                                     size_t * const p_digest_size) {
+  ret_code_t ret = nrf_crypto_hash_init(p_context, p_info);
+
+  if (ret == NRF_SUCCESS) {
+    ret = nrf_crypto_hash_update(p_context, p_data, data_size);
+  }
+
+  if (ret == NRF_SUCCESS) {
+    ret = nrf_crypto_hash_finalize(p_context, p_digest, p_digest_size);
+  }
+
+  return ret;
+}
@@ -0,0 +1,278 @@
+#include <string.h>
+#include "fake.h"
+#include "nrf52840.h"
+#include "crys_rnd.h"
+#include "sns_silib.h"
+#include "sasi_util_key_derivation.h"
+
+/*
+* CryptoCell runtime. The RNG is a xorshift generator seeded from
+* fake_cc.rng_seed. The key derivation is that of the CC310 runtime, the
+* NIST SP 800-108 KDF in counter mode with AES-CMAC keyed by the KDR
+* registers, so tests can compare the derived keys with vectors computed
+* elsewhere.
+*/
+#define AES_BLOCK_SIZE 16
+#define AES_ROUNDS 10
+
+//limits of SaSi_UtilKeyDerivation()
+#define KDF_LABEL_MAX 64
+#define KDF_CONTEXT_MAX 64
+
+static const uint8_t m_sbox[256] = {
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static uint8_t xtime(uint8_t value) {
+  return (uint8_t)((value << 1) ^ ((value & 0x80) ? 0x1B : 0x00));
+}
+
+/*
+* AES-128 encryption of one block, FIPS 197.
+*/
+static void aes_encrypt(uint8_t const * p_key, uint8_t const * p_in, uint8_t * p_out) {
+  uint8_t round_keys[(AES_ROUNDS + 1) * AES_BLOCK_SIZE];
+  uint8_t state[AES_BLOCK_SIZE];
+  uint8_t rcon = 0x01;
+
+  memcpy(round_keys, p_key, AES_BLOCK_SIZE);
+
+  for (uint32_t i = AES_BLOCK_SIZE; i < sizeof(round_keys); i += 4) {
+    uint8_t word[4];
+
+    memcpy(word, &round_keys[i - 4], sizeof(word));
+
+    if (i % AES_BLOCK_SIZE == 0) {
+      uint8_t first = word[0];
+
+      word[0] = m_sbox[word[1]] ^ rcon;
+      word[1] = m_sbox[word[2]];
+      word[2] = m_sbox[word[3]];
+      word[3] = m_sbox[first];
+      rcon = xtime(rcon);
+    }
+
+    for (uint32_t j = 0; j < 4; j++) {
+      round_keys[i + j] = round_keys[i + j - AES_BLOCK_SIZE] ^ word[j];
+    }
+  }
+
+  for (uint32_t i = 0; i < AES_BLOCK_SIZE; i++) {
+    state[i] = p_in[i] ^ round_keys[i];
+  }
+
+  for (uint32_t round = 1; round <= AES_ROUNDS; round++) {
+    uint8_t shifted[AES_BLOCK_SIZE];
+
+    //SubBytes and ShiftRows, the state is stored column by column
+    for (uint32_t i = 0; i < AES_BLOCK_SIZE; i++) {
+      shifted[i] = m_sbox[state[(i + 4 * (i % 4)) % AES_BLOCK_SIZE]];
+    }
+
+    if (round < AES_ROUNDS) {
+      for (uint32_t c = 0; c < AES_BLOCK_SIZE; c += 4) {
+        uint8_t const * p_col = &shifted[c];
+        uint8_t all = p_col[0] ^ p_col[1] ^ p_col[2] ^ p_col[3];
+
+        for (uint32_t r = 0; r < 4; r++) {
+          state[c + r] = p_col[r] ^ all ^ xtime(p_col[r] ^ p_col[(r + 1) % 4]);
+        }
+      }
+    } else {
+      memcpy(state, shifted, sizeof(state));
+    }
+
+    for (uint32_t i = 0; i < AES_BLOCK_SIZE; i++) {
+      state[i] ^= round_keys[round * AES_BLOCK_SIZE + i];
+    }
+  }
+
+  memcpy(p_out, state, sizeof(state));
+}
+
+//doubling in GF(2^128) for the CMAC subkeys
+static void cmac_double(uint8_t * p_block) {
+  uint8_t carry = (p_block[0] & 0x80) ? 0x87 : 0x00;
+
+  for (uint32_t i = 0; i < AES_BLOCK_SIZE - 1; i++) {
+    p_block[i] = (uint8_t)((p_block[i] << 1) | (p_block[i + 1] >> 7));
+  }
+
+  p_block[AES_BLOCK_SIZE - 1] = (uint8_t)(p_block[AES_BLOCK_SIZE - 1] << 1) ^ carry;
+}
+
+/*
+* AES-CMAC, RFC 4493.
+*/
+void fake_aes_cmac(uint8_t const * p_key, uint8_t const * p_data, size_t size, uint8_t * p_mac) {
+  uint8_t subkey[AES_BLOCK_SIZE] = { 0 };
+  uint8_t last[AES_BLOCK_SIZE] = { 0 };
+  uint8_t mac[AES_BLOCK_SIZE] = { 0 };
+  size_t blocks = (size == 0) ? 1 : (size + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+  size_t tail = size - (blocks - 1) * AES_BLOCK_SIZE;
+
+  aes_encrypt(p_key, subkey, subkey);
+  cmac_double(subkey);
+
+  if (tail > 0) {
+    memcpy(last, &p_data[(blocks - 1) * AES_BLOCK_SIZE], tail);
+  }
+
+  if (tail < AES_BLOCK_SIZE) {
+    last[tail] = 0x80;
+    cmac_double(subkey);
+  }
+
+  for (size_t i = 0; i < blocks; i++) {
+    uint8_t const * p_block = (i == blocks - 1) ? last : &p_data[i * AES_BLOCK_SIZE];
+
+    for (uint32_t j = 0; j < AES_BLOCK_SIZE; j++) {
+      mac[j] ^= p_block[j] ^ ((i == blocks - 1) ? subkey[j] : 0);
+    }
+
+    aes_encrypt(p_key, mac, mac);
+  }
+
+  memcpy(p_mac, mac, sizeof(mac));
+}
+static bool cryptocell_enabled() {
+  return ((NRF_CRYPTOCELL_Type *)fake_periph_peek(FAKE_CRYPTOCELL))->ENABLE == 1;
+}
+
+SA_SilibRetCode_t SaSi_LibInit(void) {
+  if (!cryptocell_enabled()) {
+    return SA_SILIB_RET_HAL;
+  }
+
+  fake_cc.lib_init++;
+  fake_cc.lib_open++;
+
+  return SA_SILIB_RET_OK;
+}
+
+void SaSi_LibFini(void) {
+  if (fake_cc.lib_open > 0) {
+    fake_cc.lib_open--;
+  }
+}
+
+CRYSError_t CRYS_RndInit(void * rndState_ptr, CRYS_RND_WorkBuff_t * rndWorkBuff_ptr) {
+  (void)rndWorkBuff_ptr;
+
+  if ((fake_cc.lib_open == 0) || (rndState_ptr == NULL)) {
+    return CRYS_RND_INSTANTIATION_NOT_DONE_ERROR;
+  }
+
+  fake_cc.rnd_open++;
+
+  return CRYS_OK;
+}
+
+CRYSError_t CRYS_RND_UnInstantiation(void * rndState_ptr) {
+  if ((fake_cc.rnd_open == 0) || (rndState_ptr == NULL)) {
+    return CRYS_RND_INSTANTIATION_NOT_DONE_ERROR;
+  }
+
+  fake_cc.rnd_open--;
+
+  return CRYS_OK;
+}
+
+CRYSError_t CRYS_RND_GenerateVector(void * rndState_ptr, uint16_t outSizeBytes, uint8_t * out_ptr) {
+  fake_evt(FAKE_EVT_RNG, outSizeBytes);
+
+  if (fake_fault_hit(FAKE_FAULT_RNG, &fake_counters.rng_calls)) {
+    return CRYS_RND_TRNG_ERRORS_ERROR;
+  }
+
+  if ((fake_cc.rnd_open == 0) || (rndState_ptr == NULL)) {
+    return CRYS_RND_INSTANTIATION_NOT_DONE_ERROR;
+  }
+
+  for (uint32_t i = 0; i < outSizeBytes; i++) {
+    fake_cc.rng_seed ^= fake_cc.rng_seed << 13;
+    fake_cc.rng_seed ^= fake_cc.rng_seed >> 17;
+    fake_cc.rng_seed ^= fake_cc.rng_seed << 5;
+    out_ptr[i] = (uint8_t)fake_cc.rng_seed;
+  }
+
+  fake_cc.rng_bytes += outSizeBytes;
+
+  return CRYS_OK;
+}
+
+SaSiUtilError_t SaSi_UtilKeyDerivation(SaSiUtilKeyType_t keyType,
+                                       SASI_AES_USER_KEY_STRUCT * pUserKey,
+                                       const uint8_t * pLabel,
+                                       size_t labelSize,
+                                       const uint8_t * pContextData,
+                                       size_t contextSize,
+                                       uint8_t * pDerivedKey,
+                                       size_t derivedKeySize) {
+  uint8_t input[1 + KDF_LABEL_MAX + 1 + KDF_CONTEXT_MAX + 2];
+  size_t size;
+
+  (void)pUserKey;
+
+  if (keyType != SASI_UTIL_ROOT_KEY) {
+    return SASI_UTIL_INVALID_KEY_TYPE;
+  }
+
+  if ((pLabel == NULL) || (labelSize == 0) || (labelSize > KDF_LABEL_MAX) || (contextSize > KDF_CONTEXT_MAX) ||
+      ((pContextData == NULL) && (contextSize != 0)) || (pDerivedKey == NULL) || (derivedKeySize == 0) ||
+      !cryptocell_enabled() || (fake_cc.lib_open == 0)) {
+    return SASI_UTIL_ILLEGAL_PARAMS_ERROR;
+  }
+
+  fake_periph_peek(FAKE_CC_HOST_RGF);
+
+  if (fake_cc.lcs != 2) {
+    return SASI_UTIL_LCS_INVALID_ERROR;
+  }
+
+  if (fake_cc.kdr_loaded != 0xF) {
+    return SASI_UTIL_KDR_INVALID_ERROR;
+  }
+
+  //[i] || Label || 0x00 || Context || [L], L in bits on one byte or two big endian
+  input[0] = 0;
+  memcpy(&input[1], pLabel, labelSize);
+  size = 1 + labelSize;
+  input[size++] = 0x00;
+  if (contextSize > 0) {
+    memcpy(&input[size], pContextData, contextSize);
+    size += contextSize;
+  }
+
+  if (derivedKeySize * 8 > 0xFF) {
+    input[size++] = (uint8_t)((derivedKeySize * 8) >> 8);
+  }
+
+  input[size++] = (uint8_t)(derivedKeySize * 8);
+
+  for (uint32_t i = 0; i < derivedKeySize; i += AES_BLOCK_SIZE) {
+    uint8_t block[AES_BLOCK_SIZE];
+    uint32_t length = ((derivedKeySize - i) < AES_BLOCK_SIZE) ? (derivedKeySize - i) : AES_BLOCK_SIZE;
+
+    input[0]++;
+    fake_aes_cmac((uint8_t const *)fake_cc.kdr, input, size, block);
+    memcpy(&pDerivedKey[i], block, length);
+  }
+
+  return SASI_UTIL_OK;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "fake.h"
+#include "nrf.h"
+#include "nrf_nvmc.h"
+#include "nrf_dfu_flash.h"
+
+/*
+* Flash is mapped at its device address, the first page excepted, which is
+* below the lowest address the host maps (vm.mmap_min_addr). The ACL regions
+* the code configures are kept here and applied to every store and erase:
+* writes to a write protected region are dropped like on the device, a read
+* protected region is unmapped.
+*/
+#define ACL_PERM_WRITE (ACL_ACL_PERM_WRITE_Disable << ACL_ACL_PERM_WRITE_Pos)
+#define ACL_PERM_READ (ACL_ACL_PERM_READ_Disable << ACL_ACL_PERM_READ_Pos)
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  uint32_t perm;
+} protected_region_t;
+
+fake_flash_t fake_flash;
+
+static protected_region_t m_protected[ACL_REGIONS_COUNT];
+static uint32_t m_protected_count;
+
+static bool range_valid(uint32_t address, uint32_t length) {
+  return (address >= FAKE_FLASH_START) && (address <= FAKE_FLASH_END) && (length <= FAKE_FLASH_END - address);
+}
+
+static bool write_denied(uint32_t address, uint32_t length) {
+  for (uint32_t i = 0; i < m_protected_count; i++) {
+    if ((m_protected[i].perm & ACL_PERM_WRITE) && (address < m_protected[i].address + m_protected[i].size) &&
+        (m_protected[i].address < address + length)) {
+      fake_evt(FAKE_EVT_ACL_VIOLATION, address);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void fake_flash_program(uint32_t address, void const * p_data, uint32_t length) {
+  if (!range_valid(address, length)) {
+    fprintf(stderr, "fake_flash_program: 0x%08x+%u is outside the flash\n", address, length);
+    abort();
+  }
+
+  memcpy((void *)(uintptr_t)address, p_data, length);
+}
+
+void fake_flash_fill(uint32_t address, uint8_t value, uint32_t length) {
+  if (!range_valid(address, length)) {
+    fprintf(stderr, "fake_flash_fill: 0x%08x+%u is outside the flash\n", address, length);
+    abort();
+  }
+
+  memset((void *)(uintptr_t)address, value, length);
+}
+
+void fake_flash_page_erase(uint32_t address) {
+  uint32_t page = address & ~(FAKE_FLASH_PAGE_SIZE - 1);
+
+  if (!range_valid(page, FAKE_FLASH_PAGE_SIZE) || write_denied(page, FAKE_FLASH_PAGE_SIZE)) {
+    return;
+  }
+
+  fake_flash.erase_progress_ms[page / FAKE_FLASH_PAGE_SIZE] = 0;
+  memset((void *)(uintptr_t)page, 0xFF, FAKE_FLASH_PAGE_SIZE);
+}
+
+void fake_flash_protect(uint32_t address, uint32_t size, uint32_t perm) {
+  if (m_protected_count < ACL_REGIONS_COUNT) {
+    m_protected[m_protected_count].address = address;
+    m_protected[m_protected_count].size = size;
+    m_protected[m_protected_count].perm = perm;
+    m_protected_count++;
+  }
+
+  if ((perm & ACL_PERM_READ) && range_valid(address, size)) {
+    mprotect((void *)(uintptr_t)address, size, PROT_NONE);
+  }
+}
+
+bool fake_flash_protected(uint32_t address, uint32_t size, uint32_t perm) {
+  for (uint32_t i = 0; i < m_protected_count; i++) {
+    if ((m_protected[i].address <= address) && (address + size <= m_protected[i].address + m_protected[i].size) &&
+        ((m_protected[i].perm & perm) == perm)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+* Lifts the read protection for the copy, like a debugger before APPROTECT.
+*/
+void fake_flash_read(uint32_t address, void * p_data, uint32_t length) {
+  if (!range_valid(address, length)) {
+    fprintf(stderr, "fake_flash_read: 0x%08x+%u is outside the flash\n", address, length);
+    abort();
+  }
+
+  mprotect((void *)FAKE_FLASH_START, FAKE_FLASH_END - FAKE_FLASH_START, PROT_READ | PROT_WRITE);
+  memcpy(p_data, (void const *)(uintptr_t)address, length);
+
+  for (uint32_t i = 0; i < m_protected_count; i++) {
+    if ((m_protected[i].perm & ACL_PERM_READ) && range_valid(m_protected[i].address, m_protected[i].size)) {
+      mprotect((void *)(uintptr_t)m_protected[i].address, m_protected[i].size, PROT_NONE);
+    }
+  }
+}
+
+ret_code_t nrf_dfu_flash_init(bool sd_irq_initialized) {
+  (void)sd_irq_initialized;
+
+  return NRF_SUCCESS;
+}
+
+/*
+* Programming only clears bits. A store cut by fake_flash.cut_after writes
+* that many bytes and resets the device.
+*/
+ret_code_t nrf_dfu_flash_store(uint32_t dest, void const * p_src, uint32_t len, nrf_dfu_flash_callback_t callback) {
+  uint8_t const * p_data = p_src;
+  uint8_t * p_flash = (uint8_t *)(uintptr_t)dest;
+  uint32_t written;
+
+  if (fake_fault_hit(FAKE_FAULT_FLASH_STORE, &fake_counters.flash_stores)) {
+    return NRF_ERROR_INTERNAL;
+  }
+
+  if ((dest % sizeof(uint32_t) != 0) || !range_valid(dest, len)) {
+    return NRF_ERROR_INVALID_ADDR;
+  }
+
+  if ((len == 0) || (len % sizeof(uint32_t) != 0)) {
+    return NRF_ERROR_INVALID_LENGTH;
+  }
+
+  fake_evt(FAKE_EVT_FLASH_STORE, dest);
+  fake_flash.stores++;
+
+  if (!write_denied(dest, len)) {
+    written = (len < fake_flash.cut_after) ? len : fake_flash.cut_after;
+
+    for (uint32_t i = 0; i < written; i++) {
+      p_flash[i] &= p_data[i];
+    }
+
+    fake_flash.bytes_stored += written;
+
+    if (written < len) {
+      fake_flash.cut_after = UINT32_MAX;
+      fake_evt(FAKE_EVT_RESET, dest + written);
+      longjmp(fake_boot_jmp, FAKE_BOOT_RESET);
+    }
+  }
+
+  if (callback != NULL) {
+    callback((void *)p_src);
+  }
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_dfu_flash_erase(uint32_t page_addr, uint32_t num_pages, nrf_dfu_flash_callback_t callback) {
+  if ((page_addr % FAKE_FLASH_PAGE_SIZE != 0) || !range_valid(page_addr, num_pages * FAKE_FLASH_PAGE_SIZE)) {
+    return NRF_ERROR_INVALID_ADDR;
+  }
+
+  for (uint32_t i = 0; i < num_pages; i++) {
+    fake_evt(FAKE_EVT_FLASH_ERASE, page_addr + i * FAKE_FLASH_PAGE_SIZE);
+    nrf_nvmc_page_erase(page_addr + i * FAKE_FLASH_PAGE_SIZE);
+  }
+
+  if (callback != NULL) {
+    callback(NULL);
+  }
+
+  return NRF_SUCCESS;
+}
+
+__attribute__((constructor(101))) static void flash_map() {
+  void * p_flash = mmap((void *)FAKE_FLASH_START, FAKE_FLASH_END - FAKE_FLASH_START, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+  if (p_flash != (void *)FAKE_FLASH_START) {
+    perror("fake flash: mmap at 0x1000");
+    exit(2);
+  }
+
+  memset(p_flash, 0xFF, FAKE_FLASH_END - FAKE_FLASH_START);
+}
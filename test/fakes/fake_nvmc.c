@@ -0,0 +1,17 @@
+#include "nrf.h"
+#include "nrf_nvmc.h"
+
+/*
+* nrf_nvmc_page_erase() of the SDK, wrapped by nvmc_erase.c like on the
+* target and called there as the fallback full erase.
+*/
+void nrf_nvmc_page_erase(uint32_t address) {
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een;
+
+  NRF_NVMC->ERASEPAGE = address;
+
+  while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+  }
+
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren;
+}
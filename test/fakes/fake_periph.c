@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fake.h"
+#include "nrf52840.h"
+
+/*
+* Register side effects. A write to a fake register only changes memory, so
+* every peripheral keeps a copy of its registers as of the last access and
+* applies what changed since then when it is accessed again: the KDR
+* registers take the key and read back 1 once all four are written, an ACL
+* register keeps its first value, an NVMC erase register erases flash. The
+* erase registers are reset to a marker after every erase so a second erase
+* of the same page is seen as well. A KDR write of the value the register
+* reads back (0, or 1 for KDR0) is not seen, a generated key word has that
+* value with a probability of 2^-31.
+*/
+#define NVMC_IDLE 0xFFFFFFFF
+#define WDT_RELOAD 0x6E524635UL
+
+#define PERIPH_WORDS_MAX 32
+
+//sets a register that is read only to the code
+#define REG_SET(reg, value) (*(uint32_t volatile *)&(reg) = (value))
+
+typedef struct {
+  void * p_regs;
+  uint32_t size;
+  void (*settle)(uint32_t const * p_before);
+} periph_t;
+
+static NRF_CRYPTOCELL_Type m_cryptocell;
+static NRF_CC_HOST_RGF_Type m_cc_host_rgf;
+static NRF_FICR_Type m_ficr;
+static NRF_POWER_Type m_power;
+static NRF_NVMC_Type m_nvmc;
+static NRF_ACL_Type m_acl;
+static NRF_WDT_Type m_wdt;
+
+DWT_Type fake_dwt;
+CoreDebug_Type fake_core_debug;
+uint32_t SystemCoreClock = FAKE_CPU_HZ;
+
+fake_evt_t fake_evts[FAKE_EVT_MAX];
+uint32_t fake_evt_count;
+fake_fault_t fake_fault;
+fake_counters_t fake_counters;
+fake_cc_t fake_cc;
+fake_wdt_t fake_wdt;
+
+static uint32_t m_before[FAKE_PERIPH_COUNT][PERIPH_WORDS_MAX];
+static uint32_t m_glitched[PERIPH_WORDS_MAX];
+static uint32_t m_acl_locked[ACL_REGIONS_COUNT];
+
+static void periph_settle(fake_periph_t periph);
+
+void fake_evt(fake_evt_type_t type, uint32_t arg) {
+  if (fake_evt_count < FAKE_EVT_MAX) {
+    fake_evts[fake_evt_count].type = type;
+    fake_evts[fake_evt_count].arg = arg;
+    fake_evt_count++;
+  }
+}
+
+int fake_evt_find(fake_evt_type_t type, uint32_t arg) {
+  for (uint32_t i = 0; i < fake_evt_count; i++) {
+    if ((fake_evts[i].type == type) && (fake_evts[i].arg == arg)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+int fake_evt_find_any(fake_evt_type_t type) {
+  for (uint32_t i = 0; i < fake_evt_count; i++) {
+    if (fake_evts[i].type == type) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/*
+* Counts an event of the given kind and tells whether the armed fault hits it.
+*/
+bool fake_fault_hit(fake_fault_type_t type, uint32_t * p_counter) {
+  uint32_t index = (*p_counter)++;
+
+  if ((fake_fault.type != type) || (index != fake_fault.at)) {
+    return false;
+  }
+
+  fake_fault.injected = true;
+  return true;
+}
+
+/*
+* Branch hook of the fault campaigns, inverts the branch the fault is armed for.
+*/
+bool fake_branch(bool taken, char const * p_file, uint32_t line) {
+  if (!fake_fault_hit(FAKE_FAULT_BRANCH, &fake_counters.branches)) {
+    return taken;
+  }
+
+  fake_fault.p_file = p_file;
+  fake_fault.line = line;
+  return !taken;
+}
+
+/*
+* A running watchdog times out as soon as the time passes its period without
+* a feed. The device would reset, the fake counts it and starts a new period.
+* A feed written before the time moves takes effect first.
+*/
+void fake_cycles_advance(uint32_t cycles) {
+  periph_settle(FAKE_WDT);
+  fake_dwt.CYCCNT += cycles;
+
+  if ((m_wdt.RUNSTATUS != 0) && (fake_dwt.CYCCNT - fake_wdt.last_feed > fake_wdt.crv_ms * FAKE_CYCLES_PER_MS)) {
+    fake_wdt.timeouts++;
+    fake_evt(FAKE_EVT_WDT_TIMEOUT, fake_dwt.CYCCNT - fake_wdt.last_feed);
+    fake_wdt.last_feed = fake_dwt.CYCCNT;
+  }
+}
+
+static void cc_host_rgf_settle(uint32_t const * p_before) {
+  NRF_CC_HOST_RGF_Type const * p_old = (NRF_CC_HOST_RGF_Type const *)p_before;
+  uint32_t volatile * p_kdr = &m_cc_host_rgf.HOST_IOT_KDR0;
+  uint32_t loaded = fake_cc.kdr_loaded;
+
+  if (m_cc_host_rgf.HOST_IOT_LCS != p_old->HOST_IOT_LCS) {
+    fake_cc.lcs = m_cc_host_rgf.HOST_IOT_LCS & 0x7;
+    m_cc_host_rgf.HOST_IOT_LCS = fake_cc.lcs | CC_HOST_RGF_HOST_IOT_LCS_LCS_IS_VALID_Msk;
+  }
+
+  for (uint32_t i = 0; i < 4; i++) {
+    if (p_kdr[i] == (&p_old->HOST_IOT_KDR0)[i]) {
+      continue;
+    }
+
+    fake_cc.kdr_writes++;
+
+    //write once, and only in the secure life cycle state
+    if ((fake_cc.lcs == 2) && !(fake_cc.kdr_loaded & (1UL << i))) {
+      fake_cc.kdr[i] = p_kdr[i];
+      fake_cc.kdr_loaded |= 1UL << i;
+    }
+  }
+
+  if ((fake_cc.kdr_loaded == 0xF) && (loaded != 0xF)) {
+    fake_evt(FAKE_EVT_KDR_LOADED, 0);
+  }
+
+  //KDR0 reads 1 once the key is retained, the others read 0
+  m_cc_host_rgf.HOST_IOT_KDR0 = (fake_cc.kdr_loaded == 0xF) ? 1 : 0;
+  m_cc_host_rgf.HOST_IOT_KDR1 = 0;
+  m_cc_host_rgf.HOST_IOT_KDR2 = 0;
+  m_cc_host_rgf.HOST_IOT_KDR3 = 0;
+}
+
+static void nvmc_settle(uint32_t const * p_before) {
+  (void)p_before;
+
+  if (m_nvmc.ERASEPAGE != NVMC_IDLE) {
+    if (m_nvmc.CONFIG == NVMC_CONFIG_WEN_Een) {
+      fake_flash.full_erases++;
+      fake_cycles_advance(fake_flash.erase_time_ms * FAKE_CYCLES_PER_MS);
+      fake_flash_page_erase(m_nvmc.ERASEPAGE);
+    }
+
+    m_nvmc.ERASEPAGE = NVMC_IDLE;
+  }
+
+  if (m_nvmc.ERASEPAGEPARTIAL != NVMC_IDLE) {
+    if (m_nvmc.CONFIG == NVMC_CONFIG_WEN_Een) {
+      uint32_t page = m_nvmc.ERASEPAGEPARTIAL / FAKE_FLASH_PAGE_SIZE;
+
+      fake_flash.partial_erases++;
+      fake_cycles_advance(m_nvmc.ERASEPAGEPARTIALCFG * FAKE_CYCLES_PER_MS);
+      fake_flash.erase_progress_ms[page] += m_nvmc.ERASEPAGEPARTIALCFG;
+
+      if (fake_flash.erase_progress_ms[page] >= fake_flash.erase_time_ms) {
+        fake_flash_page_erase(m_nvmc.ERASEPAGEPARTIAL);
+      }
+    }
+
+    m_nvmc.ERASEPAGEPARTIAL = NVMC_IDLE;
+  }
+}
+
+/*
+* ADDR, SIZE and PERM are each write once until reset. A region only counts
+* once it has a size, which also fixes its address as it may well be 0.
+*/
+#define ACL_ADDR 0x1
+#define ACL_SIZE 0x2
+#define ACL_PERM 0x4
+
+static void acl_settle(uint32_t const * p_before) {
+  uint32_t const * p_old = p_before;
+  uint32_t * p_new = (uint32_t *)&m_acl;
+
+  for (uint32_t i = 0; i < ACL_REGIONS_COUNT; i++) {
+    uint32_t locked = m_acl_locked[i];
+
+    for (uint32_t reg = 0; reg < 3; reg++) {
+      uint32_t word = i * 4 + reg;
+
+      if (p_new[word] == p_old[word]) {
+        continue;
+      }
+
+      if (locked & (1UL << reg)) {
+        p_new[word] = p_old[word];
+      } else {
+        m_acl_locked[i] |= 1UL << reg;
+      }
+    }
+
+    if (m_acl_locked[i] & ACL_SIZE) {
+      m_acl_locked[i] |= ACL_ADDR;
+    }
+
+    if ((locked != m_acl_locked[i]) && ((m_acl_locked[i] & (ACL_SIZE | ACL_PERM)) == (ACL_SIZE | ACL_PERM))) {
+      fake_evt(FAKE_EVT_ACL_REGION, m_acl.ACL[i].ADDR);
+      fake_flash_protect(m_acl.ACL[i].ADDR, m_acl.ACL[i].SIZE, m_acl.ACL[i].PERM);
+    }
+  }
+}
+
+static void wdt_settle(uint32_t const * p_before) {
+  (void)p_before;
+
+  for (uint32_t i = 0; i < 8; i++) {
+    if (m_wdt.RR[i] != WDT_RELOAD) {
+      continue;
+    }
+
+    m_wdt.RR[i] = 0;
+
+    if (!(m_wdt.RREN & (1UL << i)) || (m_wdt.RUNSTATUS == 0)) {
+      continue;
+    }
+
+    //the counter restarts once every enabled channel was reloaded, count the first one
+    fake_wdt.last_feed = fake_dwt.CYCCNT;
+    fake_wdt.feeds++;
+  }
+}
+
+static const periph_t m_periphs[FAKE_PERIPH_COUNT] = {
+  [FAKE_CRYPTOCELL] = { &m_cryptocell, sizeof(m_cryptocell), NULL },
+  [FAKE_CC_HOST_RGF] = { &m_cc_host_rgf, sizeof(m_cc_host_rgf), cc_host_rgf_settle },
+  [FAKE_FICR] = { &m_ficr, sizeof(m_ficr), NULL },
+  [FAKE_POWER] = { &m_power, sizeof(m_power), NULL },
+  [FAKE_NVMC] = { &m_nvmc, sizeof(m_nvmc), nvmc_settle },
+  [FAKE_ACL] = { &m_acl, sizeof(m_acl), acl_settle },
+  [FAKE_WDT] = { &m_wdt, sizeof(m_wdt), wdt_settle },
+};
+
+static void periph_settle(fake_periph_t periph) {
+  periph_t const * p_periph = &m_periphs[periph];
+
+  if (p_periph->settle != NULL) {
+    p_periph->settle(m_before[periph]);
+  }
+
+  memcpy(m_before[periph], p_periph->p_regs, p_periph->size);
+}
+
+/*
+* Every register access of src/ goes through here. An armed register fault
+* hands out a copy of the registers with every word replaced, so the access
+* reads the fault value and a write is lost.
+*/
+void * fake_periph(fake_periph_t periph) {
+  periph_t const * p_periph = &m_periphs[periph];
+
+  periph_settle(periph);
+
+  if (fake_fault_hit(FAKE_FAULT_REGISTER, &fake_counters.registers)) {
+    for (uint32_t i = 0; i < p_periph->size / sizeof(uint32_t); i++) {
+      m_glitched[i] = fake_fault.value;
+    }
+
+    return m_glitched;
+  }
+
+  return p_periph->p_regs;
+}
+
+void * fake_periph_peek(fake_periph_t periph) {
+  periph_settle(periph);
+  return m_periphs[periph].p_regs;
+}
+
+void fake_periph_sync() {
+  for (uint32_t i = 0; i < FAKE_PERIPH_COUNT; i++) {
+    periph_settle((fake_periph_t)i);
+  }
+}
+
+void fake_wdt_start(uint32_t crv_ms, uint32_t channels) {
+  fake_wdt.crv_ms = crv_ms;
+  fake_wdt.last_feed = fake_dwt.CYCCNT;
+  m_wdt.CRV = crv_ms * 32768 / 1000;
+  m_wdt.RREN = channels;
+  REG_SET(m_wdt.RUNSTATUS, 1);
+  memcpy(m_before[FAKE_WDT], &m_wdt, sizeof(m_wdt));
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+  (void)irq;
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+  (void)irq;
+}
+
+void NVIC_SystemReset(void) {
+  fake_evt(FAKE_EVT_RESET, 0);
+  longjmp(fake_boot_jmp, FAKE_BOOT_RESET);
+}
+
+/*
+* Reset state, set up before the tests are registered.
+*/
+__attribute__((constructor(101))) static void periph_reset() {
+  REG_SET(m_ficr.CODEPAGESIZE, FAKE_FLASH_PAGE_SIZE);
+  REG_SET(m_ficr.CODESIZE, FAKE_FLASH_END / FAKE_FLASH_PAGE_SIZE);
+  REG_SET(m_ficr.DEVICEID[0], 0x12345678);
+  REG_SET(m_ficr.DEVICEID[1], 0x9ABCDEF0);
+
+  REG_SET(m_nvmc.READY, NVMC_READY_READY_Ready);
+  m_nvmc.ERASEPAGE = NVMC_IDLE;
+  m_nvmc.ERASEPAGEPARTIAL = NVMC_IDLE;
+  m_nvmc.ERASEPAGEPARTIALCFG = 10;
+
+  fake_flash.erase_time_ms = 85;
+  fake_flash.cut_after = UINT32_MAX;
+  fake_cc.rng_seed = 0x2545F491;
+
+  for (uint32_t i = 0; i < FAKE_PERIPH_COUNT; i++) {
+    memcpy(m_before[i], m_periphs[i].p_regs, m_periphs[i].size);
+  }
+}
@@ -0,0 +1,67 @@
+#include <string.h>
+#include "fake.h"
+#include "SEGGER_RTT.h"
+
+/*
+* The up buffers of SEGGER RTT. Like on the target a buffer is a ring in the
+* memory the caller configured, one byte is always left free and the
+* debugger side (fake_rtt_read()) moves the read offset.
+*/
+fake_rtt_t fake_rtt;
+
+void SEGGER_RTT_Init(void) {
+  fake_rtt.initialized = true;
+}
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char * sName, void * pBuffer, unsigned BufferSize,
+                              unsigned Flags) {
+  (void)sName;
+
+  if (!fake_rtt.initialized || (BufferIndex >= FAKE_RTT_CHANNELS)) {
+    return -1;
+  }
+
+  fake_rtt.up[BufferIndex] = (fake_rtt_up_t){ .p_buffer = pBuffer, .size = BufferSize, .flags = Flags };
+
+  return 0;
+}
+
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void * pBuffer, unsigned NumBytes) {
+  fake_rtt_up_t * p_up = &fake_rtt.up[BufferIndex];
+  uint8_t const * p_bytes = pBuffer;
+  uint32_t free;
+
+  if ((BufferIndex >= FAKE_RTT_CHANNELS) || (p_up->p_buffer == NULL)) {
+    return 0;
+  }
+
+  free = (p_up->rd + p_up->size - p_up->wr - 1) % p_up->size;
+
+  //only the skip mode is used, a write that does not fit is dropped as a whole
+  if ((p_up->flags != SEGGER_RTT_MODE_NO_BLOCK_SKIP) || (NumBytes > free)) {
+    p_up->dropped++;
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < NumBytes; i++) {
+    p_up->p_buffer[p_up->wr] = p_bytes[i];
+    p_up->wr = (p_up->wr + 1) % p_up->size;
+  }
+
+  p_up->written += NumBytes;
+
+  return NumBytes;
+}
+
+uint32_t fake_rtt_read(uint32_t channel, void * p_data, uint32_t size) {
+  fake_rtt_up_t * p_up = &fake_rtt.up[channel];
+  uint8_t * p_bytes = p_data;
+  uint32_t read = 0;
+
+  while ((read < size) && (p_up->rd != p_up->wr)) {
+    p_bytes[read++] = p_up->p_buffer[p_up->rd];
+    p_up->rd = (p_up->rd + 1) % p_up->size;
+  }
+
+  return read;
+}
@@ -0,0 +1,92 @@
+#include <string.h>
+#include "fake.h"
+#include "crc32.h"
+#include "nrf_dfu_settings.h"
+
+/*
+* Condensed nrf_dfu_settings.c of SDK 15.3: the settings page with the MBR
+* parameters page as backup, the write skipped when the page already holds
+* the settings. The functions are wrapped by settings_log.c through the same
+* -Wl,--wrap options as on the target.
+*/
+#define SETTINGS ((nrf_dfu_settings_t const *)BOOTLOADER_SETTINGS_ADDRESS)
+#define SETTINGS_BACKUP ((nrf_dfu_settings_t const *)NRF_MBR_PARAMS_PAGE_ADDRESS)
+
+nrf_dfu_settings_t s_dfu_settings;
+
+uint32_t nrf_dfu_settings_crc_get(nrf_dfu_settings_t const * p_settings) {
+  return crc32_compute((uint8_t const *)p_settings + sizeof(uint32_t),
+                       offsetof(nrf_dfu_settings_t, init_command) - sizeof(uint32_t), NULL);
+}
+
+static uint32_t boot_validation_crc(nrf_dfu_settings_t const * p_settings) {
+  return crc32_compute((uint8_t const *)&p_settings->boot_validation_softdevice, 3 * sizeof(boot_validation_t), NULL);
+}
+
+static ret_code_t settings_write(nrf_dfu_settings_t const * p_dst, nrf_dfu_flash_callback_t callback) {
+  static nrf_dfu_settings_t buffer;
+  ret_code_t ret_code;
+
+  if (memcmp(p_dst, &s_dfu_settings, sizeof(nrf_dfu_settings_t)) == 0) {
+    if (callback != NULL) {
+      callback(NULL);
+    }
+
+    return NRF_SUCCESS;
+  }
+
+  ret_code = nrf_dfu_flash_erase((uint32_t)(uintptr_t)p_dst, 1, NULL);
+
+  if (ret_code != NRF_SUCCESS) {
+    return ret_code;
+  }
+
+  memcpy(&buffer, &s_dfu_settings, sizeof(nrf_dfu_settings_t));
+
+  return nrf_dfu_flash_store((uint32_t)(uintptr_t)p_dst, &buffer, sizeof(nrf_dfu_settings_t), callback);
+}
+
+ret_code_t nrf_dfu_settings_init(bool sd_irq_initialized) {
+  ret_code_t ret_code = nrf_dfu_flash_init(sd_irq_initialized);
+
+  if (ret_code != NRF_SUCCESS) {
+    return NRF_ERROR_INTERNAL;
+  }
+
+  memcpy(&s_dfu_settings, SETTINGS, sizeof(nrf_dfu_settings_t));
+
+  if (s_dfu_settings.crc == nrf_dfu_settings_crc_get(&s_dfu_settings)) {
+    return NRF_SUCCESS;
+  }
+
+  if (SETTINGS_BACKUP->crc == nrf_dfu_settings_crc_get(SETTINGS_BACKUP)) {
+    memcpy(&s_dfu_settings, SETTINGS_BACKUP, sizeof(nrf_dfu_settings_t));
+    return nrf_dfu_settings_write(NULL);
+  }
+
+  memset(&s_dfu_settings, 0, sizeof(nrf_dfu_settings_t));
+  s_dfu_settings.settings_version = NRF_DFU_SETTINGS_VERSION;
+
+  return nrf_dfu_settings_write(NULL);
+}
+
+ret_code_t nrf_dfu_settings_write(nrf_dfu_flash_callback_t callback) {
+  s_dfu_settings.crc = nrf_dfu_settings_crc_get(&s_dfu_settings);
+  s_dfu_settings.boot_validation_crc = boot_validation_crc(&s_dfu_settings);
+
+  return settings_write(SETTINGS, callback);
+}
+
+void nrf_dfu_settings_backup(nrf_dfu_flash_callback_t callback) {
+  (void)settings_write(SETTINGS_BACKUP, callback);
+}
+
+ret_code_t nrf_dfu_settings_write_and_backup(nrf_dfu_flash_callback_t callback) {
+  ret_code_t ret_code = nrf_dfu_settings_write(NULL);
+
+  if (ret_code == NRF_SUCCESS) {
+    nrf_dfu_settings_backup(callback);
+  }
+
+  return ret_code;
+}
@@ -0,0 +1,483 @@
+#include <string.h>
+#include "fake.h"
+#include "nrf52840.h"
+#include "sdk_config.h"
+#include "app_util.h"
+#include "app_usbd.h"
+#include "app_usbd_core.h"
+#include "app_scheduler.h"
+#include "nrf_atfifo.h"
+#include "usb_event_queue.h"
+#include "usb_dfu_transport.h"
+
+/*
+* The event queue and the class endpoints of app_usbd, the scheduler queue,
+* nrf_atfifo and the load of the USB transport. Events are
+* raised and processed on the same thread, the interrupt is a plain call.
+*/
+#define SCHED_QUEUE_SIZE 8
+
+fake_usbd_t fake_usbd = { .dma_mode = NRFX_USBD_CONFIG_DMASCHEDULER_MODE };
+
+static app_usbd_internal_evt_t m_events[APP_USBD_CONFIG_EVENT_QUEUE_SIZE];
+static uint32_t m_event_head;
+static uint32_t m_event_count;
+
+#define EP_COUNT 8
+
+typedef struct {
+  nrf_drv_usbd_transfer_t transfer;
+  size_t done;
+  bool busy;
+  bool waiting; // an OUT packet was NAKed, reported once
+  bool dma;     // requests the EasyDMA channel since dma_since
+  uint32_t dma_since;
+  uint8_t packet[NRF_DRV_USBD_EPSIZE]; // OUT packet received or IN packet loaded, while dma_deferred
+  uint32_t packet_size;
+  bool packet_full;
+} endpoint_t;
+
+static endpoint_t m_ep_out[EP_COUNT];
+static endpoint_t m_ep_in[EP_COUNT];
+static app_usbd_class_inst_t const * mp_class;
+static app_usbd_state_t m_state;
+static uint32_t m_dma_last = FAKE_USBD_DMA_BITS - 1;
+
+static app_sched_event_handler_t m_sched[SCHED_QUEUE_SIZE];
+static uint32_t m_sched_head;
+static uint32_t m_sched_count;
+
+void fake_usbd_event(uint32_t type) {
+  app_usbd_internal_evt_t event = { .app_evt = { .type = (app_usbd_event_type_t)type } };
+  bool queued = m_event_count < APP_USBD_CONFIG_EVENT_QUEUE_SIZE;
+
+  if (queued) {
+    m_events[(m_event_head + m_event_count) % APP_USBD_CONFIG_EVENT_QUEUE_SIZE] = event;
+    m_event_count++;
+    fake_usbd.queued++;
+  } else {
+    fake_usbd.dropped++;
+  }
+
+  usb_event_queue_isr_handler(&event, queued);
+}
+
+bool app_usbd_event_queue_process(void) {
+  if (m_event_count == 0) {
+    return false;
+  }
+
+  m_event_head = (m_event_head + 1) % APP_USBD_CONFIG_EVENT_QUEUE_SIZE;
+  m_event_count--;
+  fake_usbd.processed++;
+  fake_cycles_advance(fake_usbd.process_cycles);
+
+  if (fake_usbd.process_handler != NULL) {
+    fake_usbd.process_handler();
+  }
+
+  return true;
+}
+
+ret_code_t app_sched_event_put(void const * p_event_data, uint16_t event_size, app_sched_event_handler_t handler) {
+  (void)p_event_data;
+  (void)event_size;
+
+  if (fake_usbd.sched_full || (m_sched_count == SCHED_QUEUE_SIZE)) {
+    return NRF_ERROR_NO_MEM;
+  }
+
+  m_sched[(m_sched_head + m_sched_count) % SCHED_QUEUE_SIZE] = handler;
+  m_sched_count++;
+  fake_usbd.sched_puts++;
+
+  return NRF_SUCCESS;
+}
+
+uint32_t fake_usbd_sched_run() {
+  uint32_t ran = 0;
+
+  while (m_sched_count > 0) {
+    app_sched_event_handler_t handler = m_sched[m_sched_head];
+
+    m_sched_head = (m_sched_head + 1) % SCHED_QUEUE_SIZE;
+    m_sched_count--;
+    handler(NULL, 0);
+    ran++;
+  }
+
+  return ran;
+}
+
+ret_code_t nrf_atfifo_init(nrf_atfifo_t * const p_fifo, void * p_buf, uint16_t buf_size, uint16_t item_size) {
+  p_fifo->p_buf = p_buf;
+  p_fifo->buf_size = buf_size;
+  p_fifo->item_size = item_size;
+  p_fifo->head = 0;
+  p_fifo->count = 0;
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_atfifo_alloc_put(nrf_atfifo_t * const p_fifo, void const * p_var, size_t size, bool * const p_visible) {
+  uint16_t items = p_fifo->buf_size / p_fifo->item_size;
+
+  if ((size != p_fifo->item_size) || (p_fifo->count == items)) {
+    return NRF_ERROR_NO_MEM;
+  }
+
+  memcpy(&p_fifo->p_buf[((p_fifo->head + p_fifo->count) % items) * p_fifo->item_size], p_var, size);
+  p_fifo->count++;
+
+  if (p_visible != NULL) {
+    *p_visible = true;
+  }
+
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_atfifo_get_free(nrf_atfifo_t * const p_fifo, void * const p_var, size_t size, bool * p_released) {
+  uint16_t items = p_fifo->buf_size / p_fifo->item_size;
+
+  if ((size != p_fifo->item_size) || (p_fifo->count == 0)) {
+    return NRF_ERROR_NOT_FOUND;
+  }
+
+  memcpy(p_var, &p_fifo->p_buf[p_fifo->head * p_fifo->item_size], size);
+  p_fifo->head = (p_fifo->head + 1) % items;
+  p_fifo->count--;
+
+  if (p_released != NULL) {
+    *p_released = true;
+  }
+
+  return NRF_SUCCESS;
+}
+
+void usb_dfu_transport_load_get(usb_dfu_transport_load_t * p_load) {
+  p_load->rx_buffers_used = fake_usbd.rx_buffers_used;
+  p_load->flash_backlog = fake_usbd.flash_backlog;
+  p_load->rx_held = fake_usbd.rx_held;
+}
+
+static endpoint_t * endpoint(nrf_drv_usbd_ep_t ep) {
+  return NRF_USBD_EPIN_CHECK(ep) ? &m_ep_in[NRF_USBD_EP_NR_GET(ep)] : &m_ep_out[NRF_USBD_EP_NR_GET(ep)];
+}
+
+static bool class_endpoint(nrf_drv_usbd_ep_t ep) {
+  app_usbd_class_iface_conf_t const * p_iface;
+
+  if (mp_class == NULL) {
+    return false;
+  }
+
+  p_iface = app_usbd_class_iface_get(mp_class, 0);
+
+  for (uint8_t i = 0; i < app_usbd_class_iface_ep_count_get(p_iface); i++) {
+    if (app_usbd_class_ep_address_get(app_usbd_class_iface_ep_get(p_iface, i)) == ep) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void class_event(app_usbd_complex_evt_t const * p_event) {
+  if (mp_class != NULL) {
+    (void)mp_class->p_class_methods->event_handler(mp_class, p_event);
+  }
+}
+
+static void app_event(app_usbd_event_type_t type) {
+  app_usbd_complex_evt_t event = { .app_evt = { .type = type } };
+
+  class_event(&event);
+}
+
+static void transfer_event(nrf_drv_usbd_ep_t ep, nrf_drv_usbd_ep_status_t status) {
+  app_usbd_complex_evt_t event = {
+    .drv_evt = { .type = APP_USBD_EVT_DRV_EPTRANSFER, .data = { .eptransfer = { .ep = ep, .status = status } } }
+  };
+
+  if (class_endpoint(ep)) {
+    class_event(&event);
+  }
+}
+
+static void dma_request(endpoint_t * p_ep) {
+  p_ep->dma = true;
+  p_ep->dma_since = fake_dwt.CYCCNT;
+}
+
+static void transaction(fake_usbd_bus_t * p_bus, uint32_t size, bool acked) {
+  p_bus->transactions++;
+  p_bus->wire += size + FAKE_USBD_PACKET_OVERHEAD;
+
+  if (!acked) {
+    p_bus->naks++;
+  } else {
+    p_bus->payload += size;
+    p_bus->zlps += (size == 0);
+  }
+}
+
+ret_code_t app_usbd_class_append(app_usbd_class_inst_t const * p_cinst) {
+  mp_class = p_cinst;
+  app_event(APP_USBD_EVT_INST_APPEND);
+
+  return NRF_SUCCESS;
+}
+
+app_usbd_state_t app_usbd_core_state_get(void) {
+  return m_state;
+}
+
+ret_code_t app_usbd_ep_transfer(nrf_drv_usbd_ep_t ep, nrf_drv_usbd_transfer_t const * p_transfer) {
+  endpoint_t * p_ep = endpoint(ep);
+
+  if (m_state != APP_USBD_STATE_Configured) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+
+  if (p_ep->busy) {
+    return NRF_ERROR_BUSY;
+  }
+
+  p_ep->transfer = *p_transfer;
+  p_ep->done = 0;
+  p_ep->busy = true;
+
+  if (fake_usbd.dma_deferred && NRF_USBD_EPIN_CHECK(ep)) {
+    dma_request(p_ep);
+  }
+
+  return NRF_SUCCESS;
+}
+
+nrf_drv_usbd_ep_status_t nrf_drv_usbd_ep_status_get(nrf_drv_usbd_ep_t ep, size_t * p_size) {
+  endpoint_t * p_ep = endpoint(ep);
+
+  *p_size = p_ep->done;
+  return p_ep->busy ? NRF_USBD_EP_BUSY : NRF_USBD_EP_OK;
+}
+
+void fake_usbd_configure() {
+  m_state = APP_USBD_STATE_Configured;
+  app_event(APP_USBD_EVT_STATE_CHANGED);
+}
+
+void fake_usbd_bus_reset() {
+  memset(m_ep_out, 0, sizeof(m_ep_out));
+  memset(m_ep_in, 0, sizeof(m_ep_in));
+  m_state = APP_USBD_STATE_Default;
+  app_event(APP_USBD_EVT_DRV_RESET);
+}
+
+/*
+* One OUT packet in RAM. A transfer ends with a short packet or when its
+* buffer is full, more data than the buffer holds ends it with an overload.
+*/
+static void receive(nrf_drv_usbd_ep_t ep, uint8_t const * p_data, uint32_t size) {
+  endpoint_t * p_ep = endpoint(ep);
+
+  if (p_ep->done + size > p_ep->transfer.size) {
+    p_ep->busy = false;
+    transfer_event(ep, NRF_USBD_EP_OVERLOAD);
+    return;
+  }
+
+  if (size > 0) {
+    memcpy((uint8_t *)p_ep->transfer.p_data.rx + p_ep->done, p_data, size);
+    p_ep->done += size;
+  }
+
+  if ((size < NRF_DRV_USBD_EPSIZE) || (p_ep->done == p_ep->transfer.size)) {
+    p_ep->busy = false;
+    transfer_event(ep, NRF_USBD_EP_OK);
+  }
+}
+
+static bool packet_out(nrf_drv_usbd_ep_t ep, uint8_t const * p_data, uint32_t size) {
+  endpoint_t * p_ep = endpoint(ep);
+
+  //the previous packet still waits for the DMA
+  if (p_ep->packet_full) {
+    transaction(&fake_usbd.out, size, false);
+    return false;
+  }
+
+  if (!p_ep->busy) {
+    transaction(&fake_usbd.out, size, false);
+
+    if (!p_ep->waiting) {
+      p_ep->waiting = true;
+      transfer_event(ep, NRF_USBD_EP_WAITING);
+    }
+
+    return false;
+  }
+
+  transaction(&fake_usbd.out, size, true);
+  p_ep->waiting = false;
+
+  if (!fake_usbd.dma_deferred) {
+    receive(ep, p_data, size);
+    return true;
+  }
+
+  if (size > 0) {
+    memcpy(p_ep->packet, p_data, size);
+  }
+
+  p_ep->packet_size = size;
+  p_ep->packet_full = true;
+  dma_request(p_ep);
+
+  return true;
+}
+
+uint32_t fake_usbd_host_out(uint32_t ep, void const * p_data, uint32_t size) {
+  uint8_t const * p_bytes = p_data;
+  uint32_t sent = 0;
+
+  do {
+    uint32_t packet = MIN(size - sent, NRF_DRV_USBD_EPSIZE);
+
+    if (!packet_out((nrf_drv_usbd_ep_t)ep, &p_bytes[sent], packet)) {
+      break;
+    }
+
+    sent += packet;
+
+    //a full last packet is followed by a ZLP, while the DMA is deferred it would only be NAKed
+    if ((sent == size) && (packet == NRF_DRV_USBD_EPSIZE) && !fake_usbd.dma_deferred) {
+      (void)packet_out((nrf_drv_usbd_ep_t)ep, NULL, 0);
+    }
+  } while (sent < size);
+
+  return sent;
+}
+
+//the IN packet the DMA loaded, and the ZLP if it is the full last packet of a transfer that asks for one
+static uint32_t packet_in(nrf_drv_usbd_ep_t ep, void * p_data, uint32_t size) {
+  endpoint_t * p_ep = endpoint(ep);
+  uint32_t packet = p_ep->packet_size;
+
+  if (!p_ep->packet_full) {
+    transaction(&fake_usbd.in, 0, false);
+    return 0;
+  }
+
+  transaction(&fake_usbd.in, packet, true);
+  p_ep->packet_full = false;
+
+  if (packet > 0) {
+    memcpy(p_data, p_ep->packet, MIN(packet, size));
+  }
+
+  if (p_ep->done < p_ep->transfer.size) {
+    dma_request(p_ep);
+    return packet;
+  }
+
+  if ((packet == NRF_DRV_USBD_EPSIZE) && (p_ep->transfer.flags & NRF_DRV_USBD_TRANSFER_ZLP_FLAG)) {
+    transaction(&fake_usbd.in, 0, true);
+  }
+
+  p_ep->busy = false;
+  transfer_event(ep, NRF_USBD_EP_OK);
+
+  return packet;
+}
+
+uint32_t fake_usbd_host_in(uint32_t ep, void * p_data, uint32_t size) {
+  endpoint_t * p_ep = endpoint((nrf_drv_usbd_ep_t)ep);
+  size_t length = p_ep->transfer.size;
+  uint32_t sent = 0;
+
+  if (fake_usbd.dma_deferred) {
+    return packet_in((nrf_drv_usbd_ep_t)ep, p_data, size);
+  }
+
+  if (!p_ep->busy) {
+    transaction(&fake_usbd.in, 0, false);
+    return 0;
+  }
+
+  do {
+    uint32_t packet = MIN(length - sent, NRF_DRV_USBD_EPSIZE);
+
+    transaction(&fake_usbd.in, packet, true);
+    sent += packet;
+  } while (sent < length);
+
+  //a transfer of zero length is a ZLP already
+  if ((length > 0) && (length % NRF_DRV_USBD_EPSIZE == 0) && (p_ep->transfer.flags & NRF_DRV_USBD_TRANSFER_ZLP_FLAG)) {
+    transaction(&fake_usbd.in, 0, true);
+  }
+
+  if (length > 0) {
+    memcpy(p_data, p_ep->transfer.p_data.tx, MIN(length, size));
+  }
+
+  p_ep->done = length;
+  p_ep->busy = false;
+  transfer_event((nrf_drv_usbd_ep_t)ep, NRF_USBD_EP_OK);
+
+  return length;
+}
+
+uint32_t fake_usbd_dma_run() {
+  uint32_t requests = 0;
+  uint32_t later;
+  uint32_t bit;
+  uint32_t wait;
+  nrf_drv_usbd_ep_t ep;
+  endpoint_t * p_ep;
+
+  for (uint32_t nr = 0; nr < EP_COUNT; nr++) {
+    requests |= (uint32_t)m_ep_in[nr].dma << FAKE_USBD_DMA_BIT(NRF_DRV_USBD_EPIN0 + nr);
+    requests |= (uint32_t)m_ep_out[nr].dma << FAKE_USBD_DMA_BIT(NRF_DRV_USBD_EPOUT0 + nr);
+  }
+
+  if (requests == 0) {
+    return FAKE_USBD_DMA_IDLE;
+  }
+
+  //round robin continues after the last endpoint served, both start from the lowest bit
+  later = requests & ~((2u << m_dma_last) - 1);
+
+  if ((fake_usbd.dma_mode == FAKE_USBD_DMA_MODE_ROUND_ROBIN) && (later != 0)) {
+    bit = __builtin_ctz(later);
+  } else {
+    bit = __builtin_ctz(requests);
+  }
+
+  m_dma_last = bit;
+  ep = (nrf_drv_usbd_ep_t)((bit < 16) ? (NRF_DRV_USBD_EPIN0 + bit) : (NRF_DRV_USBD_EPOUT0 + bit - 16));
+  p_ep = endpoint(ep);
+
+  wait = fake_dwt.CYCCNT - p_ep->dma_since;
+  fake_usbd.dma_packets[bit]++;
+  fake_usbd.dma_wait_total[bit] += wait;
+  fake_usbd.dma_wait_max[bit] = MAX(fake_usbd.dma_wait_max[bit], wait);
+
+  p_ep->dma = false;
+  fake_cycles_advance(FAKE_USBD_DMA_CYCLES);
+
+  if (NRF_USBD_EPIN_CHECK(ep)) {
+    p_ep->packet_size = MIN(p_ep->transfer.size - p_ep->done, NRF_DRV_USBD_EPSIZE);
+
+    if (p_ep->packet_size > 0) {
+      memcpy(p_ep->packet, (uint8_t const *)p_ep->transfer.p_data.tx + p_ep->done, p_ep->packet_size);
+    }
+
+    p_ep->done += p_ep->packet_size;
+    p_ep->packet_full = true;
+  } else {
+    p_ep->packet_full = false;
+    receive(ep, p_ep->packet, p_ep->packet_size);
+  }
+
+  return ep;
+}
@@ -0,0 +1,38 @@
+#ifndef __FAKE_LED_SOFTBLINK_H__
+#define __FAKE_LED_SOFTBLINK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdk_errors.h"
+
+typedef struct {
+  bool active_high;
+  uint8_t duty_cycle_max;
+  uint8_t duty_cycle_min;
+  uint8_t duty_cycle_step;
+  uint32_t off_time_ticks;
+  uint32_t on_time_ticks;
+  uint32_t leds_pin_bm;
+  void * p_leds_port;
+} led_sb_init_params_t;
+
+#define LED_SB_INIT_DEFAULT_PARAMS(mask)                                              \
+  {                                                                                   \
+    .active_high = false,                                                             \
+    .duty_cycle_max = 220,                                                            \
+    .duty_cycle_min = 0,                                                              \
+    .duty_cycle_step = 5,                                                             \
+    .off_time_ticks = 65536,                                                          \
+    .on_time_ticks = 0,                                                               \
+    .leds_pin_bm = (mask),                                                            \
+    .p_leds_port = NULL                                                               \
+  }
+
+ret_code_t led_softblink_init(led_sb_init_params_t const * p_init_params);
+ret_code_t led_softblink_start(uint32_t leds_pin_bit_mask);
+ret_code_t led_softblink_stop(void);
+void led_softblink_off_time_set(uint32_t off_time_ticks);
+void led_softblink_on_time_set(uint32_t on_time_ticks);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __FAKE_NORDIC_COMMON_H__
+#define __FAKE_NORDIC_COMMON_H__
+
+#define NRF_MODULE_ENABLED(module) ((defined(module ## _ENABLED) && (module ## _ENABLED)) ? 1 : 0)
+
+#define UNUSED_PARAMETER(x) (void)(x)
+#define UNUSED_VARIABLE(x) (void)(x)
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FAKE_NRF_H__
+#define __FAKE_NRF_H__
+
+#include "nrf52840.h"
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef __FAKE_NRF52840_H__
+#define __FAKE_NRF52840_H__
+
+#include <stdint.h>
+#include "fake.h"
+
+/*
+* Host replacement of the device header. Only the registers used by src/ are
+* declared, at their offsets within the peripheral where it matters to the
+* fake. Peripherals with side effects are reached through fake_periph(),
+* which applies the writes since the previous access, see fake_periph.c.
+*/
+#define __IM volatile const
+#define __OM volatile
+#define __IOM volatile
+
+typedef struct {
+  __IOM uint32_t ENABLE;
+} NRF_CRYPTOCELL_Type;
+
+typedef struct {
+  __OM uint32_t HOST_IOT_KDR0;
+  __OM uint32_t HOST_IOT_KDR1;
+  __OM uint32_t HOST_IOT_KDR2;
+  __OM uint32_t HOST_IOT_KDR3;
+  __IOM uint32_t HOST_IOT_LCS;
+} NRF_CC_HOST_RGF_Type;
+
+typedef struct {
+  __IM uint32_t CODEPAGESIZE;
+  __IM uint32_t CODESIZE;
+  __IM uint32_t DEVICEID[2];
+} NRF_FICR_Type;
+
+typedef struct {
+  __IOM uint32_t RESETREAS;
+  __IOM uint32_t DCDCEN;
+} NRF_POWER_Type;
+
+typedef struct {
+  __IM uint32_t READY;
+  __IOM uint32_t CONFIG;
+  __IOM uint32_t ERASEPAGE;
+  __IOM uint32_t ERASEPAGEPARTIAL;
+  __IOM uint32_t ERASEPAGEPARTIALCFG;
+} NRF_NVMC_Type;
+
+typedef struct {
+  __IOM uint32_t ADDR;
+  __IOM uint32_t SIZE;
+  __IOM uint32_t PERM;
+  __IM uint32_t UNUSED;
+} ACL_ACL_Type;
+
+typedef struct {
+  ACL_ACL_Type ACL[8];
+} NRF_ACL_Type;
+
+typedef struct {
+  __IM uint32_t RUNSTATUS;
+  __IOM uint32_t CRV;
+  __IOM uint32_t RREN;
+  __OM uint32_t RR[8];
+} NRF_WDT_Type;
+
+typedef struct {
+  __IOM uint32_t CTRL;
+  __IOM uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define NRF_CRYPTOCELL ((NRF_CRYPTOCELL_Type *)fake_periph(FAKE_CRYPTOCELL))
+#define NRF_CC_HOST_RGF ((NRF_CC_HOST_RGF_Type *)fake_periph(FAKE_CC_HOST_RGF))
+#define NRF_FICR ((NRF_FICR_Type *)fake_periph(FAKE_FICR))
+#define NRF_POWER ((NRF_POWER_Type *)fake_periph(FAKE_POWER))
+#define NRF_NVMC ((NRF_NVMC_Type *)fake_periph(FAKE_NVMC))
+#define NRF_ACL ((NRF_ACL_Type *)fake_periph(FAKE_ACL))
+#define NRF_WDT ((NRF_WDT_Type *)fake_periph(FAKE_WDT))
+
+extern DWT_Type fake_dwt;
+extern CoreDebug_Type fake_core_debug;
+
+#define DWT (&fake_dwt)
+#define CoreDebug (&fake_core_debug)
+
+extern uint32_t SystemCoreClock;
+
+//the ARM instruction gives 32 for zero
+#define __CLZ(value) (((value) == 0) ? 32 : __builtin_clz(value))
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+
+#define NVMC_READY_READY_Busy 0UL
+#define NVMC_READY_READY_Ready 1UL
+#define NVMC_CONFIG_WEN_Ren 0UL
+#define NVMC_CONFIG_WEN_Wen 1UL
+#define NVMC_CONFIG_WEN_Een 2UL
+
+#define ACL_PRESENT
+#define ACL_REGIONS_COUNT 8
+#define ACL_ACL_PERM_WRITE_Pos 1UL
+#define ACL_ACL_PERM_WRITE_Disable 1UL
+#define ACL_ACL_PERM_READ_Pos 2UL
+#define ACL_ACL_PERM_READ_Disable 1UL
+
+#define CC_HOST_RGF_HOST_IOT_LCS_LCS_IS_VALID_Msk (1UL << 8)
+
+typedef enum {
+  POWER_CLOCK_IRQn = 0,
+  USBD_IRQn = 39,
+  CRYPTOCELL_IRQn = 42
+} IRQn_Type;
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SystemReset(void) __attribute__((noreturn));
+
+#define __ISB()
+#define __DSB()
+#define __NOP()
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef __FAKE_NRF_ATOMIC_H__
+#define __FAKE_NRF_ATOMIC_H__
+
+#include <stdint.h>
+
+typedef volatile uint32_t nrf_atomic_flag_t;
+
+static inline uint32_t nrf_atomic_flag_set_fetch(nrf_atomic_flag_t * p_data) {
+  return __atomic_exchange_n(p_data, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t nrf_atomic_flag_clear(nrf_atomic_flag_t * p_data) {
+  return __atomic_exchange_n(p_data, 0, __ATOMIC_SEQ_CST);
+}
+
+#endif
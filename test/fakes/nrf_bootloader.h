@@ -0,0 +1,9 @@
+#ifndef __FAKE_NRF_BOOTLOADER_H__
+#define __FAKE_NRF_BOOTLOADER_H__
+
+#include "nrf_dfu_types.h"
+#include "sdk_errors.h"
+
+ret_code_t nrf_bootloader_init(nrf_dfu_observer_t observer);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FAKE_NRF_BOOTLOADER_APP_START_H__
+#define __FAKE_NRF_BOOTLOADER_APP_START_H__
+
+void nrf_bootloader_app_start(void);
+
+#endif
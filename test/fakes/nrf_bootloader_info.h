@@ -0,0 +1,15 @@
+#ifndef __FAKE_NRF_BOOTLOADER_INFO_H__
+#define __FAKE_NRF_BOOTLOADER_INFO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf_dfu_types.h"
+#include "sdk_errors.h"
+
+//the bootloader as linked, see memory_layout.h
+#define BOOTLOADER_START_ADDR MEMORY_BOOTLOADER_ADDRESS
+#define BOOTLOADER_SIZE MEMORY_BOOTLOADER_SIZE
+
+ret_code_t nrf_bootloader_flash_protect(uint32_t address, uint32_t size, bool read_protect);
+
+#endif
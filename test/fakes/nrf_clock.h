@@ -0,0 +1,16 @@
+#ifndef __FAKE_NRF_CLOCK_H__
+#define __FAKE_NRF_CLOCK_H__
+
+#include <stdbool.h>
+
+typedef enum {
+  NRF_CLOCK_TASK_HFCLKSTART,
+  NRF_CLOCK_TASK_HFCLKSTOP,
+  NRF_CLOCK_TASK_LFCLKSTART,
+  NRF_CLOCK_TASK_LFCLKSTOP
+} nrf_clock_task_t;
+
+bool nrf_clock_lf_is_running(void);
+void nrf_clock_task_trigger(nrf_clock_task_t task);
+
+#endif
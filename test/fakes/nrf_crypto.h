@@ -0,0 +1,47 @@
+#ifndef __FAKE_NRF_CRYPTO_H__
+#define __FAKE_NRF_CRYPTO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdk_errors.h"
+
+/*
+* The nrf_crypto hash API used by measured_boot.c, SHA-256 only, see
+* fake_crypto.c.
+*/
+#define NRF_CRYPTO_HASH_SIZE_SHA256 32
+
+//same values as in nrf_crypto_error.h
+#define NRF_ERROR_CRYPTO_CONTEXT_NOT_INITIALIZED 0x8503
+#define NRF_ERROR_CRYPTO_INTERNAL 0x8580
+
+typedef struct {
+  uint32_t digest_size;
+} nrf_crypto_hash_info_t;
+
+typedef struct {
+  uint32_t initialized;
+  uint32_t state[8];
+  uint64_t length;
+  uint8_t block[64];
+  uint32_t used;
+} nrf_crypto_hash_context_t;
+
+extern const nrf_crypto_hash_info_t g_nrf_crypto_hash_sha256_info;
+
+ret_code_t nrf_crypto_init(void);
+bool nrf_crypto_is_initialized(void);
+
+ret_code_t nrf_crypto_hash_init(nrf_crypto_hash_context_t * const p_context, nrf_crypto_hash_info_t const * p_info);
+ret_code_t nrf_crypto_hash_update(nrf_crypto_hash_context_t * const p_context, uint8_t const * p_data, size_t data_size);
+ret_code_t nrf_crypto_hash_finalize(nrf_crypto_hash_context_t * const p_context, uint8_t * p_digest,
+                                    size_t * const p_digest_size);
+ret_code_t nrf_crypto_hash_calculate(nrf_crypto_hash_context_t * const p_context,
+                                     nrf_crypto_hash_info_t const * p_info,
+                                     uint8_t const * p_data,
+                                     size_t data_size,
+                                     uint8_t * p_digest,
+                                     size_t * const p_digest_size);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef __FAKE_NRF_DELAY_H__
+#define __FAKE_NRF_DELAY_H__
+
+#include <stdint.h>
+#include "fake.h"
+
+static inline void nrf_delay_ms(uint32_t ms_time) {
+  fake_cycles_advance(ms_time * FAKE_CYCLES_PER_MS);
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FAKE_NRF_DFU_H__
+#define __FAKE_NRF_DFU_H__
+
+#include "nrf_dfu_types.h"
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __FAKE_NRF_DFU_FLASH_H__
+#define __FAKE_NRF_DFU_FLASH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+typedef void (*nrf_dfu_flash_callback_t)(void * p_buf);
+
+ret_code_t nrf_dfu_flash_init(bool sd_irq_initialized);
+ret_code_t nrf_dfu_flash_store(uint32_t dest, void const * p_src, uint32_t len, nrf_dfu_flash_callback_t callback);
+ret_code_t nrf_dfu_flash_erase(uint32_t page_addr, uint32_t num_pages, nrf_dfu_flash_callback_t callback);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __FAKE_NRF_DFU_SETTINGS_H__
+#define __FAKE_NRF_DFU_SETTINGS_H__
+
+#include <stdbool.h>
+#include "nrf_dfu_types.h"
+#include "nrf_dfu_flash.h"
+#include "sdk_errors.h"
+
+extern nrf_dfu_settings_t s_dfu_settings;
+
+ret_code_t nrf_dfu_settings_init(bool sd_irq_initialized);
+ret_code_t nrf_dfu_settings_write(nrf_dfu_flash_callback_t callback);
+void nrf_dfu_settings_backup(nrf_dfu_flash_callback_t callback);
+ret_code_t nrf_dfu_settings_write_and_backup(nrf_dfu_flash_callback_t callback);
+uint32_t nrf_dfu_settings_crc_get(nrf_dfu_settings_t const * p_settings);
+
+#endif
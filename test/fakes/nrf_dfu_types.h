@@ -0,0 +1,109 @@
+#ifndef __FAKE_NRF_DFU_TYPES_H__
+#define __FAKE_NRF_DFU_TYPES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "memory_layout.h"
+
+/*
+* nrf_dfu_settings_t of SDK 15.3 as laid out with NRF_DFU_SETTINGS_VERSION 2
+* and -fshort-enums, the same offsets as tools/settings_page.py. The peer
+* data and advertising name of the BLE transports are reduced to their size.
+*/
+#define CODE_PAGE_SIZE 0x1000
+#define BOOTLOADER_SETTINGS_ADDRESS MEMORY_SETTINGS_ADDRESS
+#define NRF_MBR_PARAMS_PAGE_ADDRESS MEMORY_MBR_PARAMS_ADDRESS
+#define INIT_COMMAND_MAX_SIZE 512
+#define BOOT_VALIDATION_MAX_SIZE 64
+
+#define NRF_DFU_BANK_INVALID 0x00
+#define NRF_DFU_BANK_VALID_APP 0x01
+
+typedef enum {
+  NRF_DFU_EVT_DFU_INITIALIZED,
+  NRF_DFU_EVT_TRANSPORT_ACTIVATED,
+  NRF_DFU_EVT_TRANSPORT_DEACTIVATED,
+  NRF_DFU_EVT_DFU_STARTED,
+  NRF_DFU_EVT_OBJECT_RECEIVED,
+  NRF_DFU_EVT_DFU_FAILED,
+  NRF_DFU_EVT_DFU_COMPLETED,
+  NRF_DFU_EVT_DFU_ABORTED
+} nrf_dfu_evt_type_t;
+
+typedef void (*nrf_dfu_observer_t)(nrf_dfu_evt_type_t notification);
+
+typedef struct {
+  uint32_t image_size;
+  uint32_t image_crc;
+  uint32_t bank_code;
+} nrf_dfu_bank_t;
+
+typedef struct {
+  uint32_t command_size;
+  uint32_t command_offset;
+  uint32_t command_crc;
+  uint32_t data_object_size;
+  union {
+    struct {
+      uint32_t firmware_image_crc;
+      uint32_t firmware_image_crc_last;
+      uint32_t firmware_image_offset;
+      uint32_t firmware_image_offset_last;
+    };
+    struct {
+      uint32_t update_start_address;
+    };
+  };
+} dfu_progress_t;
+
+typedef enum {
+  NO_VALIDATION,
+  VALIDATE_CRC,
+  VALIDATE_SHA256,
+  VALIDATE_ECDSA_P256_SHA256
+} boot_validation_type_t;
+
+typedef struct {
+  boot_validation_type_t type;
+  uint8_t bytes[BOOT_VALIDATION_MAX_SIZE];
+} boot_validation_t;
+
+typedef struct {
+  uint32_t crc;
+  uint8_t data[80];
+} nrf_dfu_peer_data_t;
+
+typedef struct {
+  uint32_t crc;
+  uint32_t len;
+  uint8_t name[20];
+} nrf_dfu_adv_name_t;
+
+typedef struct {
+  uint32_t crc;
+  uint32_t settings_version;
+  uint32_t app_version;
+  uint32_t bootloader_version;
+  uint32_t bank_layout;
+  uint32_t bank_current;
+  nrf_dfu_bank_t bank_0;
+  nrf_dfu_bank_t bank_1;
+  uint32_t write_offset;
+  uint32_t sd_size;
+  dfu_progress_t progress;
+  uint32_t enter_buttonless_dfu;
+  uint8_t init_command[INIT_COMMAND_MAX_SIZE];
+  uint32_t boot_validation_crc;
+  boot_validation_t boot_validation_softdevice;
+  boot_validation_t boot_validation_app;
+  boot_validation_t boot_validation_bootloader;
+  nrf_dfu_peer_data_t peer_data;
+  nrf_dfu_adv_name_t adv_name;
+} nrf_dfu_settings_t;
+
+_Static_assert(offsetof(nrf_dfu_settings_t, init_command) == 0x5C, "layout of SDK 15.3");
+_Static_assert(offsetof(nrf_dfu_settings_t, boot_validation_crc) == 0x25C, "layout of SDK 15.3");
+_Static_assert(offsetof(nrf_dfu_settings_t, boot_validation_softdevice) == 0x260, "layout of SDK 15.3");
+_Static_assert(sizeof(boot_validation_t) == 65, "layout of SDK 15.3");
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef __FAKE_NRF_DFU_UTILS_H__
+#define __FAKE_NRF_DFU_UTILS_H__
+
+#include "nrf_dfu_types.h"
+
+uint32_t nrf_dfu_bank0_start_addr(void);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __FAKE_NRF_DRV_USBD_H__
+#define __FAKE_NRF_DRV_USBD_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+* The endpoint side of nrfx_usbd behind app_usbd, see fake_usbd.c.
+*/
+#define NRF_DRV_USBD_EPSIZE 64
+
+#define NRF_USBD_EPIN_CHECK(ep) (((ep) & 0x80) != 0)
+#define NRF_USBD_EP_NR_GET(ep) ((ep) & 0x0F)
+
+typedef enum {
+  NRF_DRV_USBD_EPOUT0 = 0x00,
+  NRF_DRV_USBD_EPOUT1 = 0x01,
+  NRF_DRV_USBD_EPOUT2 = 0x02,
+  NRF_DRV_USBD_EPOUT3 = 0x03,
+  NRF_DRV_USBD_EPOUT4 = 0x04,
+  NRF_DRV_USBD_EPOUT5 = 0x05,
+  NRF_DRV_USBD_EPOUT6 = 0x06,
+  NRF_DRV_USBD_EPOUT7 = 0x07,
+  NRF_DRV_USBD_EPIN0 = 0x80,
+  NRF_DRV_USBD_EPIN1 = 0x81,
+  NRF_DRV_USBD_EPIN2 = 0x82,
+  NRF_DRV_USBD_EPIN3 = 0x83,
+  NRF_DRV_USBD_EPIN4 = 0x84,
+  NRF_DRV_USBD_EPIN5 = 0x85,
+  NRF_DRV_USBD_EPIN6 = 0x86,
+  NRF_DRV_USBD_EPIN7 = 0x87
+} nrf_drv_usbd_ep_t;
+
+typedef enum {
+  NRF_USBD_EP_OK,
+  NRF_USBD_EP_WAITING,
+  NRF_USBD_EP_OVERLOAD,
+  NRF_USBD_EP_ABORTED,
+  NRF_USBD_EP_BUSY
+} nrf_drv_usbd_ep_status_t;
+
+#define NRF_DRV_USBD_TRANSFER_ZLP_FLAG 1
+
+typedef struct {
+  union {
+    void const * tx;
+    void * rx;
+  } p_data;
+  size_t size;
+  uint32_t flags;
+} nrf_drv_usbd_transfer_t;
+
+//type has the values of app_usbd_event_type_t
+typedef struct {
+  uint8_t type;
+  union {
+    struct {
+      nrf_drv_usbd_ep_t ep;
+      nrf_drv_usbd_ep_status_t status;
+    } eptransfer;
+  } data;
+} nrf_drv_usbd_evt_t;
+
+nrf_drv_usbd_ep_status_t nrf_drv_usbd_ep_status_get(nrf_drv_usbd_ep_t ep, size_t * p_size);
+
+#endif
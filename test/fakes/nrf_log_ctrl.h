@@ -0,0 +1,10 @@
+#ifndef __FAKE_NRF_LOG_CTRL_H__
+#define __FAKE_NRF_LOG_CTRL_H__
+
+#include "nrf_log.h"
+
+#define NRF_LOG_INIT(timestamp_func) ((void)(timestamp_func), NRF_SUCCESS)
+#define NRF_LOG_FLUSH()
+#define NRF_LOG_FINAL_FLUSH()
+
+#endif
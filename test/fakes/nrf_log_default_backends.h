@@ -0,0 +1,6 @@
+#ifndef __FAKE_NRF_LOG_DEFAULT_BACKENDS_H__
+#define __FAKE_NRF_LOG_DEFAULT_BACKENDS_H__
+
+#define NRF_LOG_DEFAULT_BACKENDS_INIT()
+
+#endif
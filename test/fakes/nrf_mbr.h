@@ -0,0 +1,4 @@
+#ifndef __FAKE_NRF_MBR_H__
+#define __FAKE_NRF_MBR_H__
+
+#endif
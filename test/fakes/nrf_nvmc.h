@@ -0,0 +1,8 @@
+#ifndef __FAKE_NRF_NVMC_H__
+#define __FAKE_NRF_NVMC_H__
+
+#include <stdint.h>
+
+void nrf_nvmc_page_erase(uint32_t address);
+
+#endif
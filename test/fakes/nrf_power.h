@@ -0,0 +1,9 @@
+#ifndef __FAKE_NRF_POWER_H__
+#define __FAKE_NRF_POWER_H__
+
+#include <stdbool.h>
+
+//sets fake_boot.dcdc_enabled
+void nrf_power_dcdcen_set(bool enable);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __FAKE_NRF_WDT_H__
+#define __FAKE_NRF_WDT_H__
+
+#include <stdbool.h>
+#include "nrf.h"
+
+/*
+* The part of the nrfx WDT HAL used by wdt_feed.c, on the fake registers.
+*/
+#define NRF_WDT_CHANNEL_NUMBER 8
+#define NRF_WDT_RR_VALUE 0x6E524635UL
+
+typedef enum {
+  NRF_WDT_RR0 = 0,
+  NRF_WDT_RR1,
+  NRF_WDT_RR2,
+  NRF_WDT_RR3,
+  NRF_WDT_RR4,
+  NRF_WDT_RR5,
+  NRF_WDT_RR6,
+  NRF_WDT_RR7
+} nrf_wdt_rr_register_t;
+
+static inline bool nrf_wdt_started(void) {
+  return NRF_WDT->RUNSTATUS != 0;
+}
+
+static inline bool nrf_wdt_reload_request_is_enabled(nrf_wdt_rr_register_t rr_register) {
+  return (NRF_WDT->RREN & (1UL << rr_register)) != 0;
+}
+
+static inline void nrf_wdt_reload_request_set(nrf_wdt_rr_register_t rr_register) {
+  NRF_WDT->RR[rr_register] = NRF_WDT_RR_VALUE;
+}
+
+#endif
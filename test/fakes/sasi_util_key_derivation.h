@@ -0,0 +1,39 @@
+#ifndef __FAKE_SASI_UTIL_KEY_DERIVATION_H__
+#define __FAKE_SASI_UTIL_KEY_DERIVATION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t SaSiUtilError_t;
+
+#define SASI_UTIL_OK 0
+#define SASI_UTIL_ERROR_BASE 0x80000000
+#define SASI_UTIL_INVALID_KEY_TYPE (SASI_UTIL_ERROR_BASE + 0x00000001)
+#define SASI_UTIL_ILLEGAL_PARAMS_ERROR (SASI_UTIL_ERROR_BASE + 0x00000002)
+#define SASI_UTIL_LCS_INVALID_ERROR (SASI_UTIL_ERROR_BASE + 0x00000004)
+#define SASI_UTIL_KDR_INVALID_ERROR (SASI_UTIL_ERROR_BASE + 0x00000009)
+
+typedef enum {
+  SASI_UTIL_USER_KEY = 0,
+  SASI_UTIL_ROOT_KEY = 1,
+  SASI_UTIL_END_OF_KEY_TYPE = 0x7FFFFFFF
+} SaSiUtilKeyType_t;
+
+typedef struct {
+  uint8_t * pKey;
+  size_t keySize;
+} SASI_AES_USER_KEY_STRUCT;
+
+SaSiUtilError_t SaSi_UtilKeyDerivation(SaSiUtilKeyType_t keyType,
+                                       SASI_AES_USER_KEY_STRUCT * pUserKey,
+                                       const uint8_t * pLabel,
+                                       size_t labelSize,
+                                       const uint8_t * pContextData,
+                                       size_t contextSize,
+                                       uint8_t * pDerivedKey,
+                                       size_t derivedKeySize);
+
+#define SaSi_UtilDeviceRootKeyDerivation(pLabel, labelSize, pContextData, contextSize, pDerivedKey, derivedKeySize) \
+  SaSi_UtilKeyDerivation(SASI_UTIL_ROOT_KEY, NULL, pLabel, labelSize, pContextData, contextSize, pDerivedKey, derivedKeySize)
+
+#endif
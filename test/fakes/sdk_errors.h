@@ -0,0 +1,9 @@
+#ifndef __FAKE_SDK_ERRORS_H__
+#define __FAKE_SDK_ERRORS_H__
+
+#include <stdint.h>
+#include "nrf_error.h"
+
+typedef uint32_t ret_code_t;
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __FAKE_SNS_SILIB_H__
+#define __FAKE_SNS_SILIB_H__
+
+typedef enum {
+  SA_SILIB_RET_OK = 0,
+  SA_SILIB_RET_EINVAL_CTX_PTR,
+  SA_SILIB_RET_EINVAL_WORK_BUF_PTR,
+  SA_SILIB_RET_HAL,
+  SA_SILIB_RET_PAL,
+  SA_SILIB_RET_EINVAL_HW_VERSION,
+  SA_SILIB_RET_EINVAL_HW_SIGNATURE,
+  SA_SILIB_RESERVE32B = 0x7FFFFFFFL
+} SA_SilibRetCode_t;
+
+SA_SilibRetCode_t SaSi_LibInit(void);
+void SaSi_LibFini(void);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __FAKE_SSI_PAL_MEM_H__
+#define __FAKE_SSI_PAL_MEM_H__
+
+#include <string.h>
+
+#define SaSi_PalMemCopy(p_dst, p_src, size) memmove((p_dst), (p_src), (size))
+#define SaSi_PalMemSetZero(p_buf, size) memset((p_buf), 0, (size))
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __BRANCH_HOOK_H__
+#define __BRANCH_HOOK_H__
+
+#include "fake.h"
+
+/*
+* Puts every if statement of the source included after this header behind
+* fake_branch(), so a campaign can invert any one of them. The headers of
+* the source must be included before, their inline code stays unhooked.
+* Loops and the conditional operator are not hooked.
+*/
+#define if(cond) if (fake_branch(!!(cond), __FILE__, __LINE__))
+
+#endif
@@ -0,0 +1,512 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "fake.h"
+#include "fixtures.h"
+#include "secure.h"
+#include "device_secrets.h"
+#include "memory_layout.h"
+#include "app_util.h"
+#include "nrf_error.h"
+#include "nrf.h"
+
+/*
+* Fault injection campaigns against the boot of main(). Every campaign boots
+* a fresh copy of the process (fork) with exactly one fault armed:
+*
+*   branch       one if statement of secure.c, device_secrets.c,
+*                flash_protect.c or main.c is inverted (see branch_hook.h)
+*   register     one peripheral access reads each of m_register_values in every
+*                register, a write done through it is lost
+*   rng          one CRYS_RND_GenerateVector() call fails
+*   flash store  one nrf_dfu_flash_store() call fails
+*
+* A clean boot of every scenario first counts the candidates of each kind,
+* then every candidate is faulted once. The campaigns run in parallel, -j
+* sets how many (default: one per online CPU). The outcome of a campaign is
+*
+*   started      the application was started with the code write protected,
+*                the secrets read protected and the key of the secrets page
+*                in the KDR registers
+*   reset        the bootloader reset, the secrets page allows the next boot
+*                to succeed
+*   stuck        the bootloader reset and left a secrets page no later boot
+*                can load a key from
+*   hang         no start or reset within CAMPAIGN_TIMEOUT_MS
+*   crash        the boot died on a signal or a sanitizer report
+*   unsafe       the application was started without the protection or the
+*                key above, or a provisioned key was changed
+*
+* The summary lists the campaigns per scenario and fault kind and the unsafe
+* ones. The exit code is 1 if any campaign was unsafe. -c n runs campaign
+* number n of the list alone, with the output of the boot and its sanitizers. Stuck, hang and crash
+* are reported, not failed: on the device the watchdog or the fault handler
+* resets, and a stuck device does not leak its key.
+*/
+#define CAMPAIGN_TIMEOUT_MS 500
+#define LISTED_MAX 20
+
+static const uint32_t m_register_values[] = { 0x00000000, 0xFFFFFFFF };
+
+typedef enum {
+  SCENARIO_PROVISIONED, // table with fixture_root_key
+  SCENARIO_LEGACY,      // flat layout with fixture_root_key
+  SCENARIO_FIRST_BOOT,  // GENERATE_AND_WRITE
+  SCENARIO_COUNT
+} scenario_t;
+
+static char const * const m_scenario_names[SCENARIO_COUNT] = { "provisioned", "legacy", "first boot" };
+static char const * const m_fault_names[FAKE_FAULT_TYPE_COUNT] = { "none", "branch", "register", "rng", "flash store" };
+
+typedef enum {
+  OUTCOME_NONE, // the child did not report, it crashed
+  OUTCOME_STARTED,
+  OUTCOME_RESET,
+  OUTCOME_STUCK,
+  OUTCOME_HANG,
+  OUTCOME_CRASH,
+  OUTCOME_UNSAFE,
+  OUTCOME_COUNT
+} outcome_t;
+
+static char const * const m_outcome_names[OUTCOME_COUNT] = {
+  "", "started", "reset", "stuck", "hang", "crash", "unsafe"
+};
+
+//why a campaign is unsafe
+#define UNSAFE_CODE_WRITABLE    0x1
+#define UNSAFE_SECRETS_READABLE 0x2
+#define UNSAFE_KEY_NOT_LOADED   0x4
+#define UNSAFE_KEY_CHANGED      0x8
+
+typedef struct {
+  scenario_t scenario;
+  fake_fault_t fault;
+} campaign_t;
+
+typedef struct {
+  uint8_t outcome;
+  uint8_t unsafe;
+  fake_fault_t fault; // as the boot ended, whether and where it was injected
+  fake_counters_t counters;
+} result_t;
+
+static campaign_t * m_campaigns;
+static uint32_t m_campaign_count;
+
+//written by the children
+static result_t * m_results;
+
+//state of the child
+static bool m_quiet = true;
+static result_t * m_result;
+static scenario_t m_scenario;
+static uint8_t m_page_before[DEVICE_SECRETS_PAGE_SIZE];
+
+static void scenario_setup(scenario_t scenario) {
+  switch (scenario) {
+    case SCENARIO_PROVISIONED:
+      fixture_secrets_provisioned();
+      break;
+    case SCENARIO_LEGACY:
+      fixture_secrets_legacy();
+      break;
+    default:
+      fixture_secrets_unprovisioned();
+      break;
+  }
+}
+
+/*
+* Key the page provides to the next boot, false if it provides none.
+*/
+static bool page_key(uint8_t const * p_page, uint8_t * p_key) {
+  device_secrets_t secrets;
+  uint8_t const * p_key_data;
+  uint16_t length;
+
+  if (*(uint32_t const *)p_page != ALREADY_WRITTEN) {
+    return false;
+  }
+
+  if ((device_secrets_open(&secrets, p_page) != NRF_SUCCESS) ||
+      (device_secrets_find(&secrets, SECRET_ROOT_KEY, &p_key_data, &length) != NRF_SUCCESS) ||
+      (length != DEVICE_ROOT_KEY_SIZE)) {
+    return false;
+  }
+
+  memcpy(p_key, p_key_data, DEVICE_ROOT_KEY_SIZE);
+  return true;
+}
+
+/*
+* Classifies the state the boot ended in and reports it to the parent.
+*/
+static void __attribute__((noreturn)) child_report(outcome_t ended) {
+  uint8_t page[DEVICE_SECRETS_PAGE_SIZE];
+  uint8_t key[DEVICE_ROOT_KEY_SIZE];
+  bool key_valid;
+  uint32_t unsafe = 0;
+  outcome_t outcome = ended;
+
+  //the checks below run hooked code as well
+  m_result->fault = fake_fault;
+  m_result->counters = fake_counters;
+  fake_fault.type = FAKE_FAULT_NONE;
+
+  fake_flash_read(DEVICE_SECRET_ADDRESS, page, sizeof(page));
+  key_valid = page_key(page, key);
+
+  if ((m_scenario != SCENARIO_FIRST_BOOT) && (memcmp(page, m_page_before, sizeof(page)) != 0)) {
+    unsafe |= UNSAFE_KEY_CHANGED;
+  }
+
+  if (ended == OUTCOME_STARTED) {
+    uint32_t const write = ACL_ACL_PERM_WRITE_Disable << ACL_ACL_PERM_WRITE_Pos;
+    uint32_t const read = ACL_ACL_PERM_READ_Disable << ACL_ACL_PERM_READ_Pos;
+
+    if (!fake_flash_protected(MEMORY_MBR_ADDRESS, MEMORY_MBR_SIZE, write) ||
+        !fake_flash_protected(MEMORY_BOOTLOADER_ADDRESS, MEMORY_BOOTLOADER_SIZE, write)) {
+      unsafe |= UNSAFE_CODE_WRITABLE;
+    }
+
+    if (!fake_flash_protected(MEMORY_DEVICE_SECRETS_ADDRESS, MEMORY_DEVICE_SECRETS_SIZE, write | read)) {
+      unsafe |= UNSAFE_SECRETS_READABLE;
+    }
+
+    if (!key_valid || (fake_cc.kdr_loaded != 0xF) || (memcmp(fake_cc.kdr, key, sizeof(key)) != 0)) {
+      unsafe |= UNSAFE_KEY_NOT_LOADED;
+    }
+  } else if ((m_scenario == SCENARIO_FIRST_BOOT) && !key_valid && (*(uint32_t const *)page != GENERATE_AND_WRITE)) {
+    outcome = OUTCOME_STUCK;
+  }
+
+  m_result->outcome = (unsafe != 0) ? OUTCOME_UNSAFE : outcome;
+  m_result->unsafe = unsafe;
+
+  _exit(0);
+}
+
+static void child_timeout(int signal) {
+  (void)signal;
+  child_report(OUTCOME_HANG);
+}
+
+int bootloader_main(void);
+
+static void __attribute__((noreturn)) child_run(campaign_t const * p_campaign, result_t * p_result) {
+  struct itimerval timeout = { { 0, 0 }, { CAMPAIGN_TIMEOUT_MS / 1000, (CAMPAIGN_TIMEOUT_MS % 1000) * 1000 } };
+  int null = open("/dev/null", O_WRONLY);
+  int result;
+
+  //the sanitizer reports of crashed campaigns are not of interest, their count is
+  if (m_quiet && (null >= 0)) {
+    dup2(null, STDERR_FILENO);
+    dup2(null, STDOUT_FILENO);
+  }
+
+  m_result = p_result;
+  m_scenario = p_campaign->scenario;
+
+  scenario_setup(m_scenario);
+  memcpy(m_page_before, (void const *)DEVICE_SECRET_ADDRESS, sizeof(m_page_before));
+
+  fake_fault = p_campaign->fault;
+  signal(SIGALRM, child_timeout);
+  setitimer(ITIMER_REAL, &timeout, NULL);
+
+  result = setjmp(fake_boot_jmp);
+
+  if (result == 0) {
+    bootloader_main();
+    child_report(OUTCOME_CRASH);
+  }
+
+  child_report((result == FAKE_BOOT_APP_STARTED) ? OUTCOME_STARTED : OUTCOME_RESET);
+}
+
+/*
+* Runs the campaigns with at most jobs children at a time.
+*/
+static void campaigns_run(campaign_t const * p_campaigns, result_t * p_results, uint32_t count, uint32_t jobs) {
+  pid_t * p_pids = calloc(jobs, sizeof(pid_t));
+  uint32_t * p_slots = calloc(jobs, sizeof(uint32_t));
+  uint32_t next = 0;
+  uint32_t running = 0;
+
+  while ((next < count) || (running > 0)) {
+    int status;
+    pid_t pid;
+
+    while ((next < count) && (running < jobs)) {
+      uint32_t job;
+
+      for (job = 0; p_pids[job] != 0; job++) {
+      }
+
+      fflush(stdout);
+      fflush(stderr);
+      pid = fork();
+
+      if (pid < 0) {
+        perror("fork");
+        exit(2);
+      }
+
+      if (pid == 0) {
+        child_run(&p_campaigns[next], &p_results[next]);
+      }
+
+      p_pids[job] = pid;
+      p_slots[job] = next;
+      next++;
+      running++;
+    }
+
+    pid = wait(&status);
+
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      perror("wait");
+      exit(2);
+    }
+
+    for (uint32_t job = 0; job < jobs; job++) {
+      if (p_pids[job] == pid) {
+        if (p_results[p_slots[job]].outcome == OUTCOME_NONE) {
+          p_results[p_slots[job]].outcome = OUTCOME_CRASH;
+        }
+
+        p_pids[job] = 0;
+        running--;
+      }
+    }
+  }
+
+  free(p_pids);
+  free(p_slots);
+}
+
+static void campaign_add(scenario_t scenario, fake_fault_type_t type, uint32_t at, uint32_t value) {
+  campaign_t * p_campaign = &m_campaigns[m_campaign_count++];
+
+  p_campaign->scenario = scenario;
+  p_campaign->fault.type = type;
+  p_campaign->fault.at = at;
+  p_campaign->fault.value = value;
+  p_campaign->fault.injected = false;
+}
+
+/*
+* Counts the candidates of every scenario in a clean boot and lists one
+* campaign per candidate. Returns false if a clean boot does not start the
+* application safely.
+*/
+static bool campaigns_list(uint32_t jobs) {
+  campaign_t golden[SCENARIO_COUNT];
+  result_t * p_golden = mmap(NULL, sizeof(result_t) * SCENARIO_COUNT, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  uint32_t count = 0;
+
+  for (uint32_t s = 0; s < SCENARIO_COUNT; s++) {
+    golden[s].scenario = (scenario_t)s;
+    memset(&golden[s].fault, 0, sizeof(golden[s].fault));
+  }
+
+  campaigns_run(golden, p_golden, SCENARIO_COUNT, jobs);
+
+  for (uint32_t s = 0; s < SCENARIO_COUNT; s++) {
+    fake_counters_t const * p_counters = &p_golden[s].counters;
+
+    printf("%-12s clean boot %s, %u branches, %u register accesses, %u rng calls, %u flash stores\n",
+           m_scenario_names[s], m_outcome_names[p_golden[s].outcome], p_counters->branches,
+           p_counters->registers, p_counters->rng_calls, p_counters->flash_stores);
+
+    if (p_golden[s].outcome != OUTCOME_STARTED) {
+      return false;
+    }
+
+    count += p_counters->branches + p_counters->registers * ARRAY_SIZE(m_register_values) +
+             p_counters->rng_calls + p_counters->flash_stores;
+  }
+
+  m_campaigns = calloc(count, sizeof(campaign_t));
+
+  for (uint32_t s = 0; s < SCENARIO_COUNT; s++) {
+    fake_counters_t const * p_counters = &p_golden[s].counters;
+
+    for (uint32_t i = 0; i < p_counters->branches; i++) {
+      campaign_add((scenario_t)s, FAKE_FAULT_BRANCH, i, 0);
+    }
+
+    for (uint32_t i = 0; i < p_counters->registers; i++) {
+      for (uint32_t v = 0; v < ARRAY_SIZE(m_register_values); v++) {
+        campaign_add((scenario_t)s, FAKE_FAULT_REGISTER, i, m_register_values[v]);
+      }
+    }
+
+    for (uint32_t i = 0; i < p_counters->rng_calls; i++) {
+      campaign_add((scenario_t)s, FAKE_FAULT_RNG, i, 0);
+    }
+
+    for (uint32_t i = 0; i < p_counters->flash_stores; i++) {
+      campaign_add((scenario_t)s, FAKE_FAULT_FLASH_STORE, i, 0);
+    }
+  }
+
+  munmap(p_golden, sizeof(result_t) * SCENARIO_COUNT);
+
+  return true;
+}
+
+static void campaign_print(uint32_t index) {
+  campaign_t const * p_campaign = &m_campaigns[index];
+  result_t const * p_result = &m_results[index];
+  char where[64] = "";
+
+  //the file names point into the image, which the children share with the parent
+  if (p_result->fault.p_file != NULL) {
+    snprintf(where, sizeof(where), " at %s:%u", strrchr(p_result->fault.p_file, '/') + 1, p_result->fault.line);
+  }
+
+  printf("#%-5u %-7s %s, %s %u value 0x%08x%s%s%s%s%s\n", index, m_outcome_names[p_result->outcome],
+         m_scenario_names[p_campaign->scenario], m_fault_names[p_campaign->fault.type], p_campaign->fault.at,
+         p_campaign->fault.value, where,
+         (p_result->unsafe & UNSAFE_CODE_WRITABLE) ? ", code writable" : "",
+         (p_result->unsafe & UNSAFE_SECRETS_READABLE) ? ", secrets readable" : "",
+         (p_result->unsafe & UNSAFE_KEY_NOT_LOADED) ? ", key not loaded" : "",
+         (p_result->unsafe & UNSAFE_KEY_CHANGED) ? ", key changed" : "");
+}
+
+/*
+* Prints the outcomes and lists the unsafe campaigns, then those that hung
+* or crashed. Returns the number of unsafe campaigns.
+*/
+static uint32_t summary_print() {
+  uint32_t unsafe = 0;
+  uint32_t failed = 0;
+
+  printf("\n%-12s %-12s %9s %9s", "scenario", "fault", "campaigns", "injected");
+
+  for (uint32_t o = OUTCOME_STARTED; o < OUTCOME_COUNT; o++) {
+    printf(" %8s", m_outcome_names[o]);
+  }
+
+  printf("\n");
+
+  for (uint32_t s = 0; s < SCENARIO_COUNT; s++) {
+    for (uint32_t t = FAKE_FAULT_BRANCH; t < FAKE_FAULT_TYPE_COUNT; t++) {
+      uint32_t outcomes[OUTCOME_COUNT] = { 0 };
+      uint32_t campaigns = 0;
+      uint32_t injected = 0;
+
+      for (uint32_t i = 0; i < m_campaign_count; i++) {
+        if ((m_campaigns[i].scenario == s) && (m_campaigns[i].fault.type == t)) {
+          campaigns++;
+          injected += m_results[i].fault.injected;
+          outcomes[m_results[i].outcome]++;
+        }
+      }
+
+      if (campaigns == 0) {
+        continue;
+      }
+
+      printf("%-12s %-12s %9u %9u", m_scenario_names[s], m_fault_names[t], campaigns, injected);
+
+      for (uint32_t o = OUTCOME_STARTED; o < OUTCOME_COUNT; o++) {
+        printf(" %8u", outcomes[o]);
+      }
+
+      printf("\n");
+    }
+  }
+
+  for (uint32_t i = 0; i < m_campaign_count; i++) {
+    if (m_results[i].outcome == OUTCOME_UNSAFE) {
+      if (unsafe++ < LISTED_MAX) {
+        campaign_print(i);
+      }
+    } else if ((m_results[i].outcome == OUTCOME_HANG) || (m_results[i].outcome == OUTCOME_CRASH)) {
+      if (failed++ < LISTED_MAX) {
+        campaign_print(i);
+      }
+    }
+  }
+
+  return unsafe;
+}
+
+static double now_ms() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char ** argv) {
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  long single = -1;
+  double start = now_ms();
+  uint32_t unsafe;
+  int option;
+
+  while ((option = getopt(argc, argv, "j:c:")) != -1) {
+    if (option == 'j') {
+      jobs = strtol(optarg, NULL, 0);
+    } else if (option == 'c') {
+      single = strtol(optarg, NULL, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-j jobs] [-c campaign]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (jobs < 1) {
+    jobs = 1;
+  }
+
+  if (!campaigns_list(jobs)) {
+    fprintf(stderr, "a boot without faults does not start the application safely\n");
+    return 1;
+  }
+
+  m_results = mmap(NULL, sizeof(result_t) * m_campaign_count, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  if (m_results == MAP_FAILED) {
+    perror("mmap");
+    return 2;
+  }
+
+  if (single >= 0) {
+    if (single >= m_campaign_count) {
+      fprintf(stderr, "there are %u campaigns\n", m_campaign_count);
+      return 2;
+    }
+
+    m_quiet = false;
+    campaigns_run(&m_campaigns[single], &m_results[single], 1, 1);
+    campaign_print(single);
+
+    return (m_results[single].outcome == OUTCOME_UNSAFE) ? 1 : 0;
+  }
+
+  campaigns_run(m_campaigns, m_results, m_campaign_count, jobs);
+  unsafe = summary_print();
+
+  printf("%u campaigns on %ld jobs in %.0f ms, %u unsafe\n", m_campaign_count, jobs, now_ms() - start, unsafe);
+
+  return (unsafe == 0) ? 0 : 1;
+}
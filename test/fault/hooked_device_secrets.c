@@ -0,0 +1,8 @@
+#include <stddef.h>
+#include <string.h>
+#include "device_secrets.h"
+#include "nrf_error.h"
+#include "crc32.h"
+
+#include "branch_hook.h"
+#include "../../src/device_secrets.c"
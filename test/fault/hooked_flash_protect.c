@@ -0,0 +1,10 @@
+#include "flash_protect.h"
+#include "memory_layout.h"
+#include "nrf.h"
+#include "nrf_error.h"
+#include "nrf_bootloader_info.h"
+#include "app_util.h"
+#include "nrf_log.h"
+
+#include "branch_hook.h"
+#include "../../src/flash_protect.c"
@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include "boards.h"
+#include "nrf_mbr.h"
+#include "nrf_bootloader.h"
+#include "nrf_bootloader_app_start.h"
+#include "nrf_dfu.h"
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_log_default_backends.h"
+#include "app_error.h"
+#include "app_error_weak.h"
+#include "nrf_bootloader_info.h"
+#include "nrf_dfu_utils.h"
+#include "led_softblink.h"
+#include "app_timer.h"
+#include "nrf_delay.h"
+#include "nrf_clock.h"
+#include "secure.h"
+#include "measured_boot.h"
+#include "dfu_power.h"
+#include "trace.h"
+#include "boot_probe.h"
+#include "dfu_telemetry.h"
+#include "settings_log.h"
+#include "ramfunc.h"
+#include "nvmc_erase.h"
+#include "flash_protect.h"
+#include "wdt_feed.h"
+
+#include "branch_hook.h"
+#include "../../src/main.c"
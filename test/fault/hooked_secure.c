@@ -0,0 +1,14 @@
+#include "nrf52840.h"
+#include <string.h>
+#include "secure.h"
+#include "nrf_error.h"
+#include "crys_rnd.h"
+#include "ssi_pal_mem.h"
+#include "sns_silib.h"
+#include "nrf_dfu_flash.h"
+#include "sdk_config.h"
+#include "key_derivation.h"
+#include "device_secrets.h"
+
+#include "branch_hook.h"
+#include "../../src/secure.c"
@@ -0,0 +1,48 @@
+#include <string.h>
+#include "fixtures.h"
+#include "fake.h"
+#include "secure.h"
+#include "device_secrets.h"
+
+const uint8_t fixture_root_key[16] = {
+  0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF
+};
+
+/*
+* Only the flag, the bootloader generates the rest.
+*/
+void fixture_secrets_unprovisioned() {
+  uint32_t flag = GENERATE_AND_WRITE;
+
+  fake_flash_program(DEVICE_SECRET_ADDRESS, &flag, sizeof(flag));
+}
+
+/*
+* Default slot table holding fixture_root_key.
+*/
+void fixture_secrets_provisioned() {
+  static uint8_t page[DEVICE_SECRETS_PAGE_SIZE];
+  device_secrets_default_t * p_default = (device_secrets_default_t *)page;
+
+  device_secrets_default_init(page);
+  memcpy(p_default->root_key, fixture_root_key, sizeof(fixture_root_key));
+  memset(p_default->device_id, 0x11, sizeof(p_default->device_id));
+  memset(p_default->attestation_seed, 0x22, sizeof(p_default->attestation_seed));
+  p_default->header.flag = ALREADY_WRITTEN;
+  device_secrets_seal(page);
+
+  fake_flash_program(DEVICE_SECRET_ADDRESS, page, sizeof(device_secrets_default_t));
+}
+
+/*
+* Flat layout of the pages burned before the slot table.
+*/
+void fixture_secrets_legacy() {
+  device_secrets_legacy_t legacy;
+
+  memset(&legacy, 0xFF, sizeof(legacy));
+  legacy.flag = ALREADY_WRITTEN;
+  memcpy(legacy.root_key, fixture_root_key, sizeof(fixture_root_key));
+
+  fake_flash_program(DEVICE_SECRET_ADDRESS, &legacy, sizeof(legacy));
+}
@@ -0,0 +1,16 @@
+#ifndef __FIXTURES_H__
+#define __FIXTURES_H__
+
+#include <stdint.h>
+
+/*
+* Device secrets pages for the tests, programmed into the fake flash like
+* the production line does.
+*/
+extern const uint8_t fixture_root_key[16];
+
+void fixture_secrets_unprovisioned();
+void fixture_secrets_provisioned();
+void fixture_secrets_legacy();
+
+#endif
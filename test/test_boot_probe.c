@@ -0,0 +1,64 @@
+#include <time.h>
+#include "unit.h"
+#include "boot_probe.h"
+
+#define NS_PER_MS 1000000
+
+static void sleep_ms(uint32_t ms) {
+  struct timespec delay = { 0, ms * NS_PER_MS };
+
+  nanosleep(&delay, NULL);
+}
+
+static boot_probe_stats_t stats(boot_probe_id_t id) {
+  boot_probe_stats_t stats;
+
+  boot_probe_get(id, &stats);
+  return stats;
+}
+
+TEST(host_probes_are_active) {
+  CHECK_EQ(BOOT_PROBES_ACTIVE, 1);
+}
+
+TEST(host_probe_time_is_monotonic_nanoseconds) {
+  uint32_t start = boot_probe_now();
+  uint32_t elapsed;
+
+  sleep_ms(5);
+  elapsed = boot_probe_now() - start;
+
+  CHECK(elapsed >= 5 * NS_PER_MS);
+  CHECK(elapsed < 1000 * NS_PER_MS);
+}
+
+TEST(scoped_probe_records_the_block) {
+  boot_probe_init();
+
+  for (uint32_t i = 0; i < 2; i++) {
+    BOOT_PROBE_BEGIN(BOOT_PROBE_COPY_KDR);
+    sleep_ms(2);
+    BOOT_PROBE_END(BOOT_PROBE_COPY_KDR);
+  }
+
+  CHECK_EQ(stats(BOOT_PROBE_COPY_KDR).count, 2);
+  CHECK(stats(BOOT_PROBE_COPY_KDR).min >= 2 * NS_PER_MS);
+  CHECK(stats(BOOT_PROBE_COPY_KDR).total >= 4 * NS_PER_MS);
+  CHECK_EQ(stats(BOOT_PROBE_MEASURED_BOOT).count, 0);
+}
+
+TEST(record_keeps_the_minimum_maximum_and_total) {
+  boot_probe_init();
+
+  boot_probe_record(BOOT_PROBE_DFU_REQUEST, 30);
+  boot_probe_record(BOOT_PROBE_DFU_REQUEST, 10);
+  boot_probe_record(BOOT_PROBE_DFU_REQUEST, 20);
+
+  CHECK_EQ(stats(BOOT_PROBE_DFU_REQUEST).count, 3);
+  CHECK_EQ(stats(BOOT_PROBE_DFU_REQUEST).min, 10);
+  CHECK_EQ(stats(BOOT_PROBE_DFU_REQUEST).max, 30);
+  CHECK_EQ(stats(BOOT_PROBE_DFU_REQUEST).total, 60);
+
+  boot_probe_init();
+  CHECK_EQ(stats(BOOT_PROBE_DFU_REQUEST).count, 0);
+}
@@ -0,0 +1,186 @@
+#include <stddef.h>
+#include "unit.h"
+#include "fake.h"
+#include "fixtures.h"
+#include "nrf_error.h"
+#include "secure.h"
+#include "device_secrets.h"
+
+static uint8_t m_page[DEVICE_SECRETS_PAGE_SIZE] __attribute__((aligned(4)));
+
+static device_secrets_header_t * const p_header = (device_secrets_header_t *)m_page;
+
+/*
+* Default table in RAM with its crc, as the bootloader writes it.
+*/
+static void page_default() {
+  device_secrets_default_init(m_page);
+  p_header->flag = ALREADY_WRITTEN;
+  device_secrets_seal(m_page);
+}
+
+TEST(table_valid_accepts_the_default_table) {
+  page_default();
+
+  CHECK(device_secrets_table_present(m_page));
+  CHECK(device_secrets_table_valid(m_page));
+}
+
+TEST(table_valid_rejects_a_wrong_crc) {
+  page_default();
+  m_page[offsetof(device_secrets_default_t, root_key)] ^= 1;
+
+  CHECK(device_secrets_table_present(m_page));
+  CHECK(!device_secrets_table_valid(m_page));
+}
+
+TEST(table_valid_rejects_a_wrong_version) {
+  page_default();
+  p_header->version = DEVICE_SECRETS_VERSION + 1;
+  device_secrets_seal(m_page);
+
+  CHECK(!device_secrets_table_valid(m_page));
+}
+
+TEST(table_valid_rejects_sizes_outside_the_page) {
+  page_default();
+  p_header->size = sizeof(device_secrets_header_t) - 4;
+  device_secrets_seal(m_page);
+  CHECK(!device_secrets_table_valid(m_page));
+
+  page_default();
+  p_header->size = sizeof(device_secrets_default_t) + 2;
+  device_secrets_seal(m_page);
+  CHECK(!device_secrets_table_valid(m_page));
+}
+
+TEST(table_valid_rejects_slots_outside_the_table) {
+  page_default();
+  p_header->slots[SECRET_CERTIFICATE].offset = p_header->size - 4;
+  p_header->slots[SECRET_CERTIFICATE].length = 8;
+  device_secrets_seal(m_page);
+  CHECK(!device_secrets_table_valid(m_page));
+
+  //slots may not overlap the header
+  page_default();
+  p_header->slots[SECRET_CERTIFICATE].offset = offsetof(device_secrets_header_t, slots);
+  p_header->slots[SECRET_CERTIFICATE].length = 4;
+  device_secrets_seal(m_page);
+  CHECK(!device_secrets_table_valid(m_page));
+
+  page_default();
+  p_header->slots[SECRET_CERTIFICATE].offset = offsetof(device_secrets_default_t, root_key) + 2;
+  p_header->slots[SECRET_CERTIFICATE].length = 4;
+  device_secrets_seal(m_page);
+  CHECK(!device_secrets_table_valid(m_page));
+}
+
+TEST(find_returns_the_slots_of_the_table) {
+  device_secrets_t secrets;
+  uint8_t const * p_data;
+  uint16_t length;
+
+  page_default();
+
+  CHECK_EQ(device_secrets_open(&secrets, m_page), NRF_SUCCESS);
+  CHECK(!secrets.legacy);
+
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_ROOT_KEY, &p_data, &length), NRF_SUCCESS);
+  CHECK(p_data == &m_page[offsetof(device_secrets_default_t, root_key)]);
+  CHECK_EQ(length, DEVICE_ROOT_KEY_SIZE);
+
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_ATTESTATION_SEED, &p_data, &length), NRF_SUCCESS);
+  CHECK(p_data == &m_page[offsetof(device_secrets_default_t, attestation_seed)]);
+  CHECK_EQ(length, ATTESTATION_SEED_SIZE);
+
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_CERTIFICATE, &p_data, &length), NRF_ERROR_NOT_FOUND);
+  CHECK_EQ(device_secrets_find(&secrets, DEVICE_SECRETS_MAX_SLOTS, &p_data, &length), NRF_ERROR_INVALID_PARAM);
+}
+
+TEST(find_reads_a_page_without_table_as_legacy) {
+  device_secrets_legacy_t * p_legacy = (device_secrets_legacy_t *)m_page;
+  device_secrets_t secrets;
+  uint8_t const * p_data;
+  uint16_t length;
+
+  memset(m_page, 0xFF, sizeof(m_page));
+  p_legacy->flag = ALREADY_WRITTEN;
+  memcpy(p_legacy->root_key, fixture_root_key, sizeof(fixture_root_key));
+
+  CHECK_EQ(device_secrets_open(&secrets, m_page), NRF_SUCCESS);
+  CHECK(secrets.legacy);
+
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_ROOT_KEY, &p_data, &length), NRF_SUCCESS);
+  CHECK_MEM(p_data, fixture_root_key, sizeof(fixture_root_key));
+
+  //never written, still erased
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_DEVICE_ID, &p_data, &length), NRF_ERROR_NOT_FOUND);
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_CERTIFICATE, &p_data, &length), NRF_ERROR_NOT_FOUND);
+}
+
+TEST(open_rejects_a_damaged_table_instead_of_reading_it_as_legacy) {
+  device_secrets_t secrets;
+
+  page_default();
+  p_header->crc ^= 1;
+
+  CHECK_EQ(device_secrets_open(&secrets, m_page), NRF_ERROR_INVALID_DATA);
+}
+
+TEST(generate_fills_all_slots_from_one_rng_request) {
+  device_secrets_header_t const * p_flash = (device_secrets_header_t const *)DEVICE_SECRET_ADDRESS;
+  uint32_t random_size = DEVICE_ROOT_KEY_SIZE + DEVICE_ID_SIZE + ATTESTATION_SEED_SIZE;
+
+  fixture_secrets_unprovisioned();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  CHECK_EQ(fake_counters.rng_calls, 1);
+  CHECK(fake_evt_find(FAKE_EVT_RNG, random_size) >= 0);
+  CHECK_EQ(p_flash->size, sizeof(device_secrets_default_t));
+
+  //the bytes past the table are not written
+  for (uint32_t i = p_flash->size; i < DEVICE_SECRETS_PAGE_SIZE; i++) {
+    CHECK_EQ(((uint8_t const *)p_flash)[i], 0xFF);
+  }
+}
+
+TEST(generate_keeps_a_production_table_and_its_certificate) {
+  static const uint8_t certificate[8] = { 'c', 'e', 'r', 't', 0, 1, 2, 3 };
+  uint32_t certificate_offset = sizeof(device_secrets_default_t);
+  device_secrets_t secrets;
+  uint8_t const * p_data;
+  uint16_t length;
+
+  device_secrets_default_init(m_page);
+  p_header->flag = GENERATE_AND_WRITE;
+  p_header->size = certificate_offset + sizeof(certificate);
+  p_header->slots[SECRET_CERTIFICATE].offset = certificate_offset;
+  p_header->slots[SECRET_CERTIFICATE].length = sizeof(certificate);
+  memcpy(&m_page[certificate_offset], certificate, sizeof(certificate));
+  device_secrets_seal(m_page);
+  fake_flash_program(DEVICE_SECRET_ADDRESS, m_page, p_header->size);
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  CHECK_EQ(device_secrets_open(&secrets, (uint8_t const *)DEVICE_SECRET_ADDRESS), NRF_SUCCESS);
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_CERTIFICATE, &p_data, &length), NRF_SUCCESS);
+  CHECK_EQ(length, sizeof(certificate));
+  CHECK_MEM(p_data, certificate, sizeof(certificate));
+  CHECK_EQ(fake_counters.rng_calls, 1);
+}
+
+TEST(generate_rejects_a_damaged_table) {
+  device_secrets_default_init(m_page);
+  p_header->flag = GENERATE_AND_WRITE;
+  device_secrets_seal(m_page);
+  p_header->crc ^= 1;
+  fake_flash_program(DEVICE_SECRET_ADDRESS, m_page, sizeof(device_secrets_default_t));
+
+  CHECK_EQ(copy_kdr(), NRF_ERROR_INVALID_DATA);
+
+  CHECK_EQ(fake_counters.rng_calls, 0);
+  CHECK_EQ(fake_flash.stores, 0);
+  CHECK_MEM((uint8_t const *)DEVICE_SECRET_ADDRESS, m_page, sizeof(device_secrets_default_t));
+  CHECK_EQ(fake_cc.kdr_loaded, 0);
+}
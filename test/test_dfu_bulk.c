@@ -0,0 +1,515 @@
+#include <stdio.h>
+#include "unit.h"
+#include "fake.h"
+#include "nrf52840.h"
+#include "sdk_config.h"
+#include "app_util.h"
+#include "app_usbd_core.h"
+#include "app_usbd_dfu_bulk.h"
+#include "usb_dfu_transport.h"
+
+/*
+* The bulk DFU class over the endpoints of the fakes, on the interface and
+* endpoints the USB transport gives it. The user handler stands in for the
+* transport: it keeps a read of NRF_DFU_USB_BULK_MTU bytes queued and
+* answers requests with responses of the sizes the transport sends (header,
+* parameters and the flow status).
+*/
+#define BULK_EPIN DFU_BULK_EPIN
+#define BULK_EPOUT DFU_BULK_EPOUT
+
+#define OP_OBJECT_CREATE 0x01
+#define OP_CRC_GET 0x03
+#define OP_OBJECT_EXECUTE 0x04
+#define OP_OBJECT_WRITE 0x08
+
+#define FLOW_STATUS_SIZE 6
+#define RSP_HEADER_SIZE 3
+
+//firmware of the overhead measurement, data objects as tools/usb_dfu.py sends them
+#define IMAGE_SIZE 0x10000
+#define OBJECT_SIZE 0x1000
+#define CHUNK_SIZE (NRF_DFU_USB_BULK_MTU / 2)
+
+//cycles of a byte on the bus at full speed, 12 Mbit/s at 64 MHz
+#define BUS_CYCLES_PER_BYTE 43
+
+static void bulk_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_dfu_bulk_user_event_t event);
+
+APP_USBD_DFU_BULK_GLOBAL_DEF(m_bulk, bulk_ev_handler, DFU_BULK_INTERFACE, BULK_EPIN, BULK_EPOUT);
+
+static uint8_t m_rx_buf[NRF_DFU_USB_BULK_MTU];
+static uint8_t m_request[NRF_DFU_USB_BULK_MTU];
+static size_t m_request_size;
+static uint8_t m_response[64];
+static bool m_requeue = true;
+static uint32_t m_events[4];
+
+static void rx_start() {
+  if (m_requeue) {
+    CHECK_EQ(app_usbd_dfu_bulk_read(&m_bulk, m_rx_buf, sizeof(m_rx_buf)), NRF_SUCCESS);
+  }
+}
+
+static uint32_t response_size(uint8_t opcode) {
+  switch (opcode) {
+    case OP_OBJECT_WRITE:
+      return 0;
+    case OP_CRC_GET:
+      return RSP_HEADER_SIZE + 8 + FLOW_STATUS_SIZE;
+    default:
+      return RSP_HEADER_SIZE + FLOW_STATUS_SIZE;
+  }
+}
+
+static void bulk_ev_handler(app_usbd_class_inst_t const * p_inst, app_usbd_dfu_bulk_user_event_t event) {
+  uint32_t size;
+
+  CHECK(p_inst == app_usbd_dfu_bulk_class_inst_get(&m_bulk));
+  m_events[event]++;
+
+  switch (event) {
+    case APP_USBD_DFU_BULK_USER_EVT_READY:
+      rx_start();
+      break;
+
+    case APP_USBD_DFU_BULK_USER_EVT_RX_DONE:
+      m_request_size = app_usbd_dfu_bulk_rx_size(&m_bulk);
+      memcpy(m_request, m_rx_buf, m_request_size);
+      rx_start();
+
+      size = (m_request_size > 0) ? response_size(m_request[0]) : 0;
+
+      if (size > 0) {
+        m_response[0] = 0x60;
+        m_response[1] = m_request[0];
+        m_response[2] = 0x01;
+        CHECK_EQ(app_usbd_dfu_bulk_write(&m_bulk, m_response, size), NRF_SUCCESS);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void connect() {
+  CHECK_EQ(app_usbd_class_append(app_usbd_dfu_bulk_class_inst_get(&m_bulk)), NRF_SUCCESS);
+  fake_usbd_configure();
+}
+
+static void pattern(uint8_t * p_data, uint32_t size, uint32_t seed) {
+  for (uint32_t i = 0; i < size; i++) {
+    p_data[i] = (uint8_t)(((seed + i) * 0x9E3779B1) >> 24);
+  }
+}
+
+//bytes on the bus for one transfer, with the ZLP of a transfer that fills its last packet
+static uint32_t transfer_wire(uint32_t size) {
+  uint32_t packets = size / NRF_DRV_USBD_EPSIZE + 1;
+
+  return size + packets * FAKE_USBD_PACKET_OVERHEAD;
+}
+
+//the SLIP encoding of the CDC ACM interface, escaped END and ESC bytes and an END at the end
+static uint32_t slip_size(uint8_t const * p_data, uint32_t size) {
+  uint32_t encoded = size + 1;
+
+  for (uint32_t i = 0; i < size; i++) {
+    encoded += (p_data[i] == 0xC0) || (p_data[i] == 0xDB);
+  }
+
+  return encoded;
+}
+
+TEST(dfu_bulk_describes_a_vendor_interface_with_two_bulk_endpoints) {
+  static const uint8_t expected[] = {
+    0x09, 0x04, 0x02, 0x00, 0x02, 0xFF, 0x44, 0x01, 0x00,
+    0x07, 0x05, 0x81, 0x02, 0x40, 0x00, 0x00,
+    0x07, 0x05, 0x01, 0x02, 0x40, 0x00, 0x00
+  };
+  app_usbd_class_descriptor_ctx_t ctx;
+  uint8_t descriptor[64];
+
+  CHECK(!app_usbd_dfu_bulk_class_methods.feed_descriptors(&ctx, app_usbd_dfu_bulk_class_inst_get(&m_bulk),
+                                                          descriptor, sizeof(descriptor)));
+
+  CHECK_EQ(ctx.size, sizeof(expected));
+  CHECK_MEM(descriptor, expected, sizeof(expected));
+}
+
+TEST(dfu_bulk_receives_a_request_of_many_packets_in_one_transfer) {
+  uint8_t request[1000];
+
+  connect();
+  pattern(request, sizeof(request), 1);
+
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizeof(request)), sizeof(request));
+
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE], 1);
+  CHECK_EQ(m_request_size, sizeof(request));
+  CHECK_MEM(m_request, request, sizeof(request));
+  CHECK_EQ(fake_usbd.out.transactions, 16);
+}
+
+TEST(dfu_bulk_ends_a_request_of_full_packets_at_the_zlp) {
+  uint8_t request[128];
+
+  connect();
+  pattern(request, sizeof(request), 2);
+
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizeof(request)), sizeof(request));
+
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE], 1);
+  CHECK_EQ(m_request_size, sizeof(request));
+  CHECK_EQ(fake_usbd.out.zlps, 1);
+}
+
+TEST(dfu_bulk_naks_until_a_read_is_queued) {
+  uint8_t request[100];
+
+  m_requeue = false;
+  connect();
+  pattern(request, sizeof(request), 3);
+
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizeof(request)), 0);
+  CHECK_EQ(fake_usbd.out.naks, 1);
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE], 0);
+
+  //the host retries the transfer
+  CHECK_EQ(app_usbd_dfu_bulk_read(&m_bulk, m_rx_buf, sizeof(m_rx_buf)), NRF_SUCCESS);
+  CHECK_EQ(app_usbd_dfu_bulk_read(&m_bulk, m_rx_buf, sizeof(m_rx_buf)), NRF_ERROR_BUSY);
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizeof(request)), sizeof(request));
+
+  CHECK_EQ(m_request_size, sizeof(request));
+  CHECK_MEM(m_request, request, sizeof(request));
+}
+
+TEST(dfu_bulk_drops_an_overlong_request_and_keeps_receiving) {
+  uint8_t request[128];
+
+  m_requeue = false;
+  connect();
+  CHECK_EQ(app_usbd_dfu_bulk_read(&m_bulk, m_rx_buf, 100), NRF_SUCCESS);
+  m_requeue = true;
+  pattern(request, sizeof(request), 4);
+
+  fake_usbd_host_out(BULK_EPOUT, request, sizeof(request));
+
+  //the overload and then the ZLP, both as empty transfers
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE], 2);
+  CHECK_EQ(m_request_size, 0);
+  CHECK(app_usbd_dfu_bulk_rx_busy(&m_bulk));
+
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, 99), 99);
+  CHECK_EQ(m_request_size, 99);
+  CHECK_MEM(m_request, request, 99);
+}
+
+TEST(dfu_bulk_ends_a_response_of_full_packets_with_a_zlp) {
+  uint8_t response[128];
+  uint8_t received[128];
+
+  connect();
+  pattern(response, sizeof(response), 5);
+
+  CHECK_EQ(app_usbd_dfu_bulk_write(&m_bulk, response, sizeof(response)), NRF_SUCCESS);
+  CHECK_EQ(app_usbd_dfu_bulk_write(&m_bulk, response, sizeof(response)), NRF_ERROR_BUSY);
+  CHECK(app_usbd_dfu_bulk_tx_busy(&m_bulk));
+
+  CHECK_EQ(fake_usbd_host_in(BULK_EPIN, received, sizeof(received)), sizeof(response));
+
+  CHECK_MEM(received, response, sizeof(response));
+  CHECK_EQ(fake_usbd.in.transactions, 3);
+  CHECK_EQ(fake_usbd.in.zlps, 1);
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_TX_DONE], 1);
+  CHECK(!app_usbd_dfu_bulk_tx_busy(&m_bulk));
+}
+
+TEST(dfu_bulk_closes_on_a_bus_reset) {
+  connect();
+  CHECK_EQ(app_usbd_dfu_bulk_write(&m_bulk, m_response, 9), NRF_SUCCESS);
+
+  fake_usbd_bus_reset();
+
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_CLOSED], 1);
+  CHECK(!app_usbd_dfu_bulk_rx_busy(&m_bulk));
+  CHECK(!app_usbd_dfu_bulk_tx_busy(&m_bulk));
+}
+
+TEST(dfu_bulk_counts_transfers_and_cycles) {
+  app_usbd_dfu_bulk_ep_stats_t rx_stats;
+  app_usbd_dfu_bulk_ep_stats_t tx_stats;
+  uint8_t request[] = { OP_CRC_GET };
+  uint8_t response[64];
+
+  connect();
+  fake_cycles_advance(5000);
+  fake_usbd_host_out(BULK_EPOUT, request, sizeof(request));
+  fake_cycles_advance(700);
+  fake_usbd_host_in(BULK_EPIN, response, sizeof(response));
+
+  app_usbd_dfu_bulk_stats_get(&m_bulk, &rx_stats, &tx_stats);
+
+  CHECK_EQ(rx_stats.transfers, 1);
+  CHECK_EQ(rx_stats.bytes, 1);
+  CHECK_EQ(rx_stats.cycles_max, 5000);
+  CHECK_EQ(tx_stats.transfers, 1);
+  CHECK_EQ(tx_stats.bytes, RSP_HEADER_SIZE + 8 + FLOW_STATUS_SIZE);
+  CHECK_EQ(tx_stats.cycles_max, 700);
+}
+
+/*
+* Sends an image in data objects like tools/usb_dfu.py without PRN: create,
+* writes of half the MTU, CRC and execute. The same requests and responses
+* SLIP encoded over the CDC ACM interface cost the bytes of slip_size() in
+* transfers of the same packet size.
+*/
+TEST(dfu_bulk_protocol_overhead_per_byte) {
+  static uint8_t image[IMAGE_SIZE];
+  uint8_t request[1 + CHUNK_SIZE];
+  uint8_t response[64];
+  uint32_t requests = 0;
+  uint32_t cdc_payload = 0;
+  uint32_t cdc_wire = 0;
+  uint32_t bulk_payload;
+  uint32_t bulk_wire;
+
+  connect();
+  pattern(image, sizeof(image), 6);
+
+  for (uint32_t object = 0; object < IMAGE_SIZE; object += OBJECT_SIZE) {
+    uint32_t sizes[OBJECT_SIZE / CHUNK_SIZE + 3];
+    uint32_t count = 0;
+
+    request[0] = OP_OBJECT_CREATE;
+    request[1] = 0x02;
+    memcpy(&request[2], &(uint32_t){ OBJECT_SIZE }, 4);
+    sizes[count++] = 6;
+
+    for (uint32_t offset = 0; offset < OBJECT_SIZE; offset += CHUNK_SIZE) {
+      sizes[count++] = 1 + CHUNK_SIZE;
+    }
+
+    sizes[count++] = 1;
+    sizes[count++] = 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t offset = object + (i - 1) * CHUNK_SIZE;
+      uint32_t rsp_size;
+
+      if ((i > 0) && (i < count - 2)) {
+        request[0] = OP_OBJECT_WRITE;
+        memcpy(&request[1], &image[offset], CHUNK_SIZE);
+      } else if (i == count - 2) {
+        request[0] = OP_CRC_GET;
+      } else if (i == count - 1) {
+        request[0] = OP_OBJECT_EXECUTE;
+      }
+
+      CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizes[i]), sizes[i]);
+      CHECK_EQ(m_request_size, sizes[i]);
+      CHECK_MEM(m_request, request, sizes[i]);
+      requests++;
+
+      cdc_payload += slip_size(request, sizes[i]);
+      cdc_wire += transfer_wire(slip_size(request, sizes[i]));
+
+      rsp_size = response_size(request[0]);
+
+      if (rsp_size > 0) {
+        CHECK_EQ(fake_usbd_host_in(BULK_EPIN, response, sizeof(response)), rsp_size);
+        //the flow status is only sent on the bulk interface
+        cdc_payload += slip_size(response, rsp_size - FLOW_STATUS_SIZE);
+        cdc_wire += transfer_wire(slip_size(response, rsp_size - FLOW_STATUS_SIZE));
+      }
+    }
+  }
+
+  bulk_payload = fake_usbd.out.payload + fake_usbd.in.payload;
+  bulk_wire = fake_usbd.out.wire + fake_usbd.in.wire;
+
+  printf("bulk %u requests: %u bytes in transfers, %.4f protocol bytes per image byte, %.4f on the bus\n",
+         requests, bulk_payload, (double)(bulk_payload - IMAGE_SIZE) / IMAGE_SIZE,
+         (double)(bulk_wire - IMAGE_SIZE) / IMAGE_SIZE);
+  printf("cdc acm with slip: %u bytes in transfers, %.4f protocol bytes per image byte, %.4f on the bus\n",
+         cdc_payload, (double)(cdc_payload - IMAGE_SIZE) / IMAGE_SIZE, (double)(cdc_wire - IMAGE_SIZE) / IMAGE_SIZE);
+
+  CHECK_EQ(m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE], requests);
+  CHECK_EQ(fake_usbd.out.naks, 0);
+  CHECK(bulk_payload < cdc_payload);
+  CHECK(bulk_wire < cdc_wire);
+
+  //a request byte and a share of the create, CRC and execute requests per chunk
+  CHECK(bulk_payload - IMAGE_SIZE < IMAGE_SIZE / 64);
+}
+
+//a transfer on a CDC ACM endpoint, the class is not appended so it completes without events
+static void cdc_transfer(nrf_drv_usbd_ep_t ep, void * p_buf, size_t size) {
+  nrf_drv_usbd_transfer_t transfer = { .p_data = { .rx = p_buf }, .size = size };
+
+  CHECK_EQ(app_usbd_ep_transfer(ep, &transfer), NRF_SUCCESS);
+}
+
+static bool cdc_busy(nrf_drv_usbd_ep_t ep) {
+  size_t size;
+
+  return nrf_drv_usbd_ep_status_get(ep, &size) == NRF_USBD_EP_BUSY;
+}
+
+/*
+* One packet waiting on every endpoint of both interfaces, raised from the
+* CDC ACM OUT endpoint to the bulk IN endpoint. The scheduler does not serve
+* them in that order but by their bit: IN endpoints by number, then bulk
+* OUT before CDC ACM OUT.
+*/
+TEST(dfu_bulk_dma_serves_bulk_out_before_cdc_acm_out) {
+  static const nrf_drv_usbd_ep_t expected[] = {
+    BULK_EPIN, CDC_ACM_COMM_EPIN, CDC_ACM_DATA_EPIN, BULK_EPOUT, CDC_ACM_DATA_EPOUT
+  };
+  uint8_t request[10] = { OP_OBJECT_WRITE };
+  uint8_t cdc_rx[64];
+  uint8_t cdc_tx[16];
+
+  CHECK_EQ(NRFX_USBD_CONFIG_DMASCHEDULER_MODE, FAKE_USBD_DMA_MODE_PRIORITIZED);
+  fake_usbd.dma_deferred = true;
+  connect();
+
+  cdc_transfer(CDC_ACM_DATA_EPOUT, cdc_rx, sizeof(cdc_rx));
+  CHECK_EQ(fake_usbd_host_out(CDC_ACM_DATA_EPOUT, cdc_tx, sizeof(cdc_tx)), sizeof(cdc_tx));
+  CHECK_EQ(fake_usbd_host_out(BULK_EPOUT, request, sizeof(request)), sizeof(request));
+  cdc_transfer(CDC_ACM_DATA_EPIN, cdc_tx, sizeof(cdc_tx));
+  cdc_transfer(CDC_ACM_COMM_EPIN, cdc_tx, 10);
+  CHECK_EQ(app_usbd_dfu_bulk_write(&m_bulk, m_response, RSP_HEADER_SIZE + FLOW_STATUS_SIZE), NRF_SUCCESS);
+
+  for (uint32_t i = 0; i < ARRAY_SIZE(expected); i++) {
+    CHECK_EQ(fake_usbd_dma_run(), expected[i]);
+  }
+
+  CHECK_EQ(fake_usbd_dma_run(), FAKE_USBD_DMA_IDLE);
+  CHECK_EQ(m_request_size, sizeof(request));
+  CHECK(!cdc_busy(CDC_ACM_DATA_EPOUT));
+
+  //the bulk OUT packet waited for the three IN packets before it
+  CHECK_EQ(fake_usbd.dma_wait_max[FAKE_USBD_DMA_BIT(BULK_EPOUT)], 3 * FAKE_USBD_DMA_CYCLES);
+}
+
+/*
+* A write request of CHUNK_SIZE bytes on bulk OUT while the host also streams
+* to CDC ACM OUT and, if cdc_in is set, from CDC ACM IN. The host serves the
+* endpoints in turn, one transaction at a time. The driver starts the DMA of
+* the waiting packets from the USBD interrupt, which runs after every
+* isr_every transactions: every one while the CPU is free, less often while
+* it waits for flash writes. Returns the cycles from the first packet to
+* the completion of the read.
+*/
+static uint32_t bulk_out_with_cdc_traffic(bool cdc_in, uint32_t isr_every, uint32_t * p_wait_avg,
+                                          uint32_t * p_wait_max) {
+  static uint8_t request[1 + CHUNK_SIZE];
+  static uint8_t cdc_rx[1024];
+  static uint8_t cdc_tx[1024];
+  uint32_t endpoints = cdc_in ? 3 : 2;
+  uint32_t bit = FAKE_USBD_DMA_BIT(BULK_EPOUT);
+  uint32_t received = m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE];
+  uint32_t sent = 0;
+  uint32_t started;
+
+  memset(fake_usbd.dma_packets, 0, sizeof(fake_usbd.dma_packets));
+  memset(fake_usbd.dma_wait_total, 0, sizeof(fake_usbd.dma_wait_total));
+  memset(fake_usbd.dma_wait_max, 0, sizeof(fake_usbd.dma_wait_max));
+  fake_usbd_bus_reset();
+  fake_usbd.dma_deferred = true;
+  connect();
+  pattern(request, sizeof(request), 7);
+  request[0] = OP_OBJECT_WRITE;
+  started = fake_dwt.CYCCNT;
+
+  for (uint32_t turn = 0; m_events[APP_USBD_DFU_BULK_USER_EVT_RX_DONE] == received; turn++) {
+    uint32_t wire = fake_usbd.out.wire + fake_usbd.in.wire;
+    uint32_t start = fake_dwt.CYCCNT;
+    uint32_t bus_cycles;
+    uint8_t packet[NRF_DRV_USBD_EPSIZE];
+
+    CHECK(turn < 1000);
+
+    switch (turn % endpoints) {
+      case 0:
+        sent += fake_usbd_host_out(BULK_EPOUT, &request[sent], MIN(sizeof(request) - sent, NRF_DRV_USBD_EPSIZE));
+        break;
+      case 1:
+        if (!cdc_busy(CDC_ACM_DATA_EPOUT)) {
+          cdc_transfer(CDC_ACM_DATA_EPOUT, cdc_rx, sizeof(cdc_rx));
+        }
+        fake_usbd_host_out(CDC_ACM_DATA_EPOUT, cdc_tx, NRF_DRV_USBD_EPSIZE);
+        break;
+      default:
+        if (!cdc_busy(CDC_ACM_DATA_EPIN)) {
+          cdc_transfer(CDC_ACM_DATA_EPIN, cdc_tx, sizeof(cdc_tx));
+        }
+        fake_usbd_host_in(CDC_ACM_DATA_EPIN, packet, sizeof(packet));
+        break;
+    }
+
+    //the DMA of the waiting packets runs while the next transaction is on the bus
+    bus_cycles = (fake_usbd.out.wire + fake_usbd.in.wire - wire) * BUS_CYCLES_PER_BYTE;
+
+    if (turn % isr_every == isr_every - 1) {
+      while ((fake_dwt.CYCCNT - start + FAKE_USBD_DMA_CYCLES <= bus_cycles) &&
+             (fake_usbd_dma_run() != FAKE_USBD_DMA_IDLE)) {
+      }
+    }
+
+    if (fake_dwt.CYCCNT - start < bus_cycles) {
+      fake_cycles_advance(bus_cycles - (fake_dwt.CYCCNT - start));
+    }
+  }
+
+  CHECK_EQ(m_request_size, sizeof(request));
+  CHECK_MEM(m_request, request, sizeof(request));
+
+  *p_wait_avg = fake_usbd.dma_wait_total[bit] / fake_usbd.dma_packets[bit];
+  *p_wait_max = fake_usbd.dma_wait_max[bit];
+
+  return fake_dwt.CYCCNT - started;
+}
+
+TEST(dfu_bulk_dma_wait_of_image_data_next_to_cdc_acm_traffic) {
+  static const char * const modes[] = { "prioritized", "round robin" };
+  uint32_t wait_avg[2][2][2];
+  uint32_t wait_max[2][2][2];
+  uint32_t cycles[2][2][2];
+
+  for (uint32_t mode = 0; mode < 2; mode++) {
+    for (uint32_t cdc_in = 0; cdc_in < 2; cdc_in++) {
+      for (uint32_t late = 0; late < 2; late++) {
+        fake_usbd.dma_mode = mode;
+        cycles[mode][cdc_in][late] = bulk_out_with_cdc_traffic(cdc_in, late ? 3 : 1, &wait_avg[mode][cdc_in][late],
+                                                               &wait_max[mode][cdc_in][late]);
+
+        printf("dma %-11s cdc acm %-6s interrupt every %u transactions: %6u cycles for %u bytes, "
+               "bulk out waited %4u cycles on average, %4u at most\n",
+               modes[mode], cdc_in ? "out+in" : "out", late ? 3 : 1, cycles[mode][cdc_in][late], 1 + CHUNK_SIZE,
+               wait_avg[mode][cdc_in][late], wait_max[mode][cdc_in][late]);
+      }
+    }
+  }
+
+  //an interrupt per transaction leaves a single packet waiting, the order does not matter
+  for (uint32_t mode = 0; mode < 2; mode++) {
+    CHECK_EQ(wait_max[mode][0][0], 0);
+    CHECK_EQ(wait_max[mode][1][0], 0);
+  }
+
+  //packets piling up behind a late interrupt: bulk OUT goes before CDC ACM OUT, after CDC ACM IN
+  CHECK(wait_avg[FAKE_USBD_DMA_MODE_PRIORITIZED][0][1] < wait_avg[FAKE_USBD_DMA_MODE_ROUND_ROBIN][0][1]);
+  CHECK(wait_avg[FAKE_USBD_DMA_MODE_PRIORITIZED][1][1] > wait_avg[FAKE_USBD_DMA_MODE_PRIORITIZED][0][1]);
+
+  //the bus and the interrupt latency dominate, a DMA packet takes a tenth of a transaction
+  for (uint32_t cdc_in = 0; cdc_in < 2; cdc_in++) {
+    for (uint32_t late = 0; late < 2; late++) {
+      CHECK(cycles[FAKE_USBD_DMA_MODE_PRIORITIZED][cdc_in][late] <= cycles[FAKE_USBD_DMA_MODE_ROUND_ROBIN][cdc_in][late]);
+      CHECK(cycles[FAKE_USBD_DMA_MODE_ROUND_ROBIN][cdc_in][late] <
+            cycles[FAKE_USBD_DMA_MODE_PRIORITIZED][cdc_in][late] * 21 / 20);
+    }
+  }
+}
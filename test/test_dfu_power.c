@@ -0,0 +1,117 @@
+#include "unit.h"
+#include "fake.h"
+#include "fixtures.h"
+#include "nrf_dfu_types.h"
+#include "dfu_power.h"
+
+int bootloader_main(void);
+
+/*
+* The power states of dfu_power.c as the DFU observer of main() drives them.
+* The tests enter DFU mode through main() and then raise DFU events the way
+* nrf_dfu and the transport do.
+*/
+static void enter_dfu_mode() {
+  fixture_secrets_provisioned();
+  fake_boot.dfu_enter = true;
+
+  if (setjmp(fake_boot_jmp) == 0) {
+    bootloader_main();
+    unit_fail(__FILE__, __LINE__, "main() returned");
+  }
+}
+
+TEST(dfu_power_starts_detached_with_the_dcdc_enabled) {
+  enter_dfu_mode();
+
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_DETACHED);
+  CHECK(fake_boot.dcdc_enabled);
+}
+
+TEST(dfu_power_is_idle_while_the_transport_waits) {
+  enter_dfu_mode();
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_IDLE);
+}
+
+TEST(dfu_power_is_active_during_a_transfer) {
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_ACTIVE);
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_ACTIVE);
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_COMPLETED);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_IDLE);
+}
+
+TEST(dfu_power_returns_to_idle_after_a_failed_or_aborted_transfer) {
+  nrf_dfu_evt_type_t const ends[] = { NRF_DFU_EVT_DFU_FAILED, NRF_DFU_EVT_DFU_ABORTED };
+
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  for (uint32_t i = 0; i < 2; i++) {
+    fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+    fake_boot_dfu_evt(ends[i]);
+
+    CHECK_EQ(dfu_power_state_get(), DFU_POWER_IDLE);
+  }
+}
+
+TEST(dfu_power_follows_usb_suspend_and_resume) {
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  dfu_power_on_usb_suspend(true);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_SUSPENDED);
+
+  dfu_power_on_usb_suspend(false);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_IDLE);
+}
+
+TEST(dfu_power_stays_detached_without_a_transport) {
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_DEACTIVATED);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_DETACHED);
+
+  //late events of the transfer and bus events do not wake it up
+  fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  dfu_power_on_usb_suspend(false);
+  CHECK_EQ(dfu_power_state_get(), DFU_POWER_DETACHED);
+}
+
+TEST(dfu_power_accounts_the_time_in_each_state) {
+  enter_dfu_mode();
+  fake_boot.rtc_ticks = 1000;
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  fake_boot.rtc_ticks = 3000;
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+
+  fake_boot.rtc_ticks = 3500;
+  dfu_power_log();
+
+  CHECK_EQ(dfu_power_ticks_get(DFU_POWER_DETACHED), 1000);
+  CHECK_EQ(dfu_power_ticks_get(DFU_POWER_IDLE), 2000);
+  CHECK_EQ(dfu_power_ticks_get(DFU_POWER_ACTIVE), 500);
+}
+
+TEST(dfu_power_accounts_across_the_rtc_overflow) {
+  enter_dfu_mode();
+  fake_boot.rtc_ticks = 0xFFFF00;
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+
+  fake_boot.rtc_ticks = 0x1000000 + 0x100;
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+
+  CHECK_EQ(dfu_power_ticks_get(DFU_POWER_IDLE), 0x200);
+}
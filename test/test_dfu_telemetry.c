@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include "unit.h"
+#include "fake.h"
+#include "fixtures.h"
+#include "nrf_dfu_types.h"
+#include "nrf_dfu_settings.h"
+#include "SEGGER_RTT.h"
+#include "dfu_telemetry.h"
+
+int bootloader_main(void);
+
+/*
+* The records of dfu_telemetry.c as the DFU observer of main() sends them.
+* telemetry_stream_dump writes what tools/dfu_telemetry.py needs for the
+* round trip of test_dfu_telemetry.py to build/: the RTT channel as a
+* debugger read it, in chunks that split records and with records dropped
+* while the buffer was full, and the fields of every record that made it, one
+* record per line.
+*/
+#define DUMP_STREAM "build/telemetry.bin"
+#define DUMP_EXPECTED "build/telemetry_expected.txt"
+
+#define DUMP_STEPS 2000
+#define DUMP_SEED 0x9E3779B9
+
+#define RECORD_SIZE sizeof(dfu_telemetry_record_t)
+
+static void enter_dfu_mode() {
+  fixture_secrets_provisioned();
+  fake_boot.dfu_enter = true;
+
+  if (setjmp(fake_boot_jmp) == 0) {
+    bootloader_main();
+    unit_fail(__FILE__, __LINE__, "main() returned");
+  }
+}
+
+static dfu_telemetry_record_t record_read() {
+  dfu_telemetry_record_t record;
+
+  CHECK_EQ(fake_rtt_read(DFU_TELEMETRY_RTT_CHANNEL, &record, sizeof(record)), sizeof(record));
+  return record;
+}
+
+static uint8_t record_sum(dfu_telemetry_record_t const * p_record) {
+  uint8_t const * p_bytes = (uint8_t const *)p_record;
+  uint8_t sum = 0;
+
+  for (uint32_t i = 0; i < sizeof(*p_record); i++) {
+    sum += p_bytes[i];
+  }
+
+  return sum;
+}
+
+TEST(dfu_telemetry_configures_a_skipping_channel) {
+  enter_dfu_mode();
+
+  CHECK_EQ(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].size, DFU_TELEMETRY_BUFFER_SIZE);
+  CHECK_EQ(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].flags, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+  CHECK_EQ(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].written, 0);
+}
+
+TEST(dfu_telemetry_record_carries_the_progress_and_the_load) {
+  dfu_telemetry_record_t record;
+
+  fake_boot.rtc_ticks = 5000;
+  enter_dfu_mode();
+  s_dfu_settings.progress.firmware_image_offset = 0x12345;
+  s_dfu_settings.progress.firmware_image_offset_last = 0x11000;
+  fake_usbd.rx_buffers_used = 3;
+  fake_usbd.flash_backlog = 0x800;
+  fake_usbd.rx_held = 7;
+  fake_boot.rtc_ticks = 5000 + 3 * 32768;
+
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+  record = record_read();
+
+  CHECK_EQ(record.sync, DFU_TELEMETRY_SYNC);
+  CHECK_EQ(record.length, RECORD_SIZE);
+  CHECK_EQ(record.version, DFU_TELEMETRY_VERSION);
+  CHECK_EQ(record.flags, DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE);
+  CHECK_EQ(record.sequence, 0);
+  CHECK_EQ(record.time_ms, 3000);
+  CHECK_EQ(record.bytes_received, 0x12345);
+  CHECK_EQ(record.bytes_committed, 0x11000);
+  CHECK_EQ(record.flash_backlog, 0x800);
+  CHECK_EQ(record.rx_held, 7);
+  CHECK_EQ(record.rx_buffers_used, 3);
+  CHECK_EQ(record_sum(&record), 0);
+}
+
+TEST(dfu_telemetry_flags_and_objects_follow_the_transfer) {
+  dfu_telemetry_record_t record;
+
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_DFU_COMPLETED);
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_DEACTIVATED);
+
+  record_read();
+  record = record_read();
+  CHECK_EQ(record.flags, DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE | DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS);
+  CHECK_EQ(record.objects_committed, 0);
+
+  record_read();
+  record = record_read();
+  CHECK_EQ(record.objects_committed, 2);
+
+  record = record_read();
+  CHECK_EQ(record.flags, DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE);
+  CHECK_EQ(record.objects_committed, 2);
+
+  record = record_read();
+  CHECK_EQ(record.flags, 0);
+  CHECK_EQ(record.sequence, 5);
+}
+
+TEST(dfu_telemetry_drops_records_while_the_channel_is_full) {
+  uint32_t fit = (DFU_TELEMETRY_BUFFER_SIZE - 1) / RECORD_SIZE;
+  dfu_telemetry_record_t record;
+
+  enter_dfu_mode();
+
+  for (uint32_t i = 0; i < fit + 2; i++) {
+    fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  }
+
+  CHECK_EQ(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].dropped, 2);
+
+  for (uint32_t i = 0; i < fit; i++) {
+    CHECK_EQ(record_read().sequence, i);
+  }
+
+  //the gap shows in the sequence number
+  fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+  record = record_read();
+  CHECK_EQ(record.sequence, fit + 2);
+  CHECK_EQ(record.objects_committed, fit + 3);
+}
+
+TEST(dfu_telemetry_ignores_other_events) {
+  enter_dfu_mode();
+
+  //main() does not pass it on, the telemetry would not send a record either
+  dfu_telemetry_on_dfu_evt(NRF_DFU_EVT_DFU_INITIALIZED);
+
+  CHECK_EQ(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].written, 0);
+}
+
+TEST(telemetry_stream_dump) {
+  FILE * p_stream = fopen(DUMP_STREAM, "wb");
+  FILE * p_expected = fopen(DUMP_EXPECTED, "w");
+  uint8_t chunk[DFU_TELEMETRY_BUFFER_SIZE];
+  uint32_t state = DUMP_SEED;
+  uint64_t ticks = 0;
+  uint16_t sequence = 0;
+  uint16_t objects = 0;
+  uint8_t flags = DFU_TELEMETRY_FLAG_TRANSPORT_ACTIVE;
+  uint32_t read;
+
+  CHECK(p_stream != NULL);
+  CHECK(p_expected != NULL);
+
+  //the RTC counter wraps during the transfer
+  fake_boot.rtc_ticks = 0xFF0000;
+  enter_dfu_mode();
+  fake_boot_dfu_evt(NRF_DFU_EVT_TRANSPORT_ACTIVATED);
+  fake_rtt_read(DFU_TELEMETRY_RTT_CHANNEL, chunk, sizeof(chunk));
+  sequence++;
+
+  for (uint32_t step = 0; step < DUMP_STEPS; step++) {
+    uint32_t dropped = fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].dropped;
+    uint32_t advance;
+    uint32_t pick;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    pick = state % 16;
+
+    if (pick < 4) {
+      //the debugger polls, mostly in the middle of a record
+      read = fake_rtt_read(DFU_TELEMETRY_RTT_CHANNEL, chunk, (state >> 8) % sizeof(chunk));
+      CHECK_EQ(fwrite(chunk, 1, read, p_stream), read);
+      continue;
+    }
+
+    advance = (state >> 4) % 3000;
+    ticks += advance;
+    fake_boot.rtc_ticks += advance;
+    s_dfu_settings.progress.firmware_image_offset += (state >> 12) % 4096;
+    s_dfu_settings.progress.firmware_image_offset_last = s_dfu_settings.progress.firmware_image_offset & ~0xFFF;
+    fake_usbd.rx_buffers_used = (state >> 20) % 5;
+    fake_usbd.flash_backlog = fake_usbd.rx_buffers_used * 64;
+    fake_usbd.rx_held += (pick == 15);
+
+    if (pick == 4) {
+      flags |= DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS;
+      objects = 0;
+      fake_boot_dfu_evt(NRF_DFU_EVT_DFU_STARTED);
+    } else if (pick == 5) {
+      flags &= ~DFU_TELEMETRY_FLAG_DFU_IN_PROGRESS;
+      fake_boot_dfu_evt(NRF_DFU_EVT_DFU_COMPLETED);
+    } else {
+      objects++;
+      fake_boot_dfu_evt(NRF_DFU_EVT_OBJECT_RECEIVED);
+    }
+
+    if (fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].dropped == dropped) {
+      fprintf(p_expected, "%u %u %u %u %u %u %u %u %u\n", flags, sequence, objects,
+              (uint32_t)(ticks * 1000 / 32768), s_dfu_settings.progress.firmware_image_offset,
+              s_dfu_settings.progress.firmware_image_offset_last, fake_usbd.flash_backlog, fake_usbd.rx_held,
+              fake_usbd.rx_buffers_used);
+    }
+
+    sequence++;
+  }
+
+  while ((read = fake_rtt_read(DFU_TELEMETRY_RTT_CHANNEL, chunk, sizeof(chunk))) > 0) {
+    CHECK_EQ(fwrite(chunk, 1, read, p_stream), read);
+  }
+
+  fclose(p_stream);
+  fclose(p_expected);
+
+  CHECK(fake_rtt.up[DFU_TELEMETRY_RTT_CHANNEL].dropped > 0);
+  CHECK(ticks > 0x10000);
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""tools/dfu_telemetry.py against the records dfu_telemetry.c sends on the host.
+
+test_dfu_telemetry.c (case telemetry_stream_dump) sends records from the DFU
+observer of main() and reads the RTT channel in chunks the way a debugger
+does, with records dropped while the channel was full. It writes the stream
+and the fields of every record that made it to build/. Run by make from
+test/.
+"""
+
+import contextlib
+import io
+import os
+import subprocess
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BUILD = os.path.join(HERE, 'build')
+
+sys.path.insert(0, os.path.join(HERE, '..', 'tools'))
+import dfu_telemetry  # noqa: E402
+
+
+class DfuTelemetryTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        subprocess.run([os.path.join(BUILD, 'test_dfu_telemetry'), 'telemetry_stream_dump'], cwd=HERE,
+                       check=True, stdout=subprocess.DEVNULL)
+        with open(os.path.join(BUILD, 'telemetry.bin'), 'rb') as f:
+            cls.stream = f.read()
+        with open(os.path.join(BUILD, 'telemetry_expected.txt')) as f:
+            cls.expected = [dfu_telemetry.Record(*map(int, line.split())) for line in f.read().splitlines()]
+
+    def test_decodes_every_record_sent(self):
+        records, skipped = dfu_telemetry.decode(self.stream)
+
+        self.assertGreater(len(records), 100)
+        self.assertEqual(records, self.expected)
+        self.assertEqual(skipped, 0)
+
+    def test_encode_matches_the_device(self):
+        self.assertEqual(dfu_telemetry.RECORD_SIZE, 30)
+        self.assertEqual(b''.join(dfu_telemetry.encode(r) for r in self.expected), self.stream)
+
+    def test_render_counts_the_dropped_records(self):
+        gaps = sum(b.sequence - a.sequence - 1 for a, b in zip(self.expected, self.expected[1:]))
+        out = io.StringIO()
+
+        with contextlib.redirect_stdout(out):
+            dfu_telemetry.render(self.expected, 40)
+
+        self.assertGreater(gaps, 0)
+        self.assertIn('%d records dropped by the device' % gaps, out.getvalue())
+
+    def test_resyncs_after_garbage_and_cut_records(self):
+        size = dfu_telemetry.RECORD_SIZE
+        # a capture started in the middle of a record, garbage with sync bytes and a record cut short
+        damaged = self.stream[7:5 * size] + b'\xa5\x1e\x01\x00\xa5' + self.stream[5 * size:20 * size - 3]
+        damaged += self.stream[20 * size:]
+
+        records, skipped = dfu_telemetry.decode(damaged)
+
+        self.assertEqual(records, self.expected[1:19] + self.expected[20:])
+        self.assertEqual(skipped, size - 7 + 5 + size - 3)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+#include "unit.h"
+#include "fake.h"
+#include "nrf.h"
+#include "nrf_error.h"
+#include "nrf_dfu_flash.h"
+#include "flash_protect.h"
+#include "memory_layout.h"
+
+#define PERM_WRITE (ACL_ACL_PERM_WRITE_Disable << ACL_ACL_PERM_WRITE_Pos)
+#define PERM_READ (ACL_ACL_PERM_READ_Disable << ACL_ACL_PERM_READ_Pos)
+
+static uint32_t regions() {
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < fake_evt_count; i++) {
+    count += (fake_evts[i].type == FAKE_EVT_ACL_REGION);
+  }
+
+  return count;
+}
+
+/*
+* Configures ACL region slot the way other code before the bootloader could.
+*/
+static void acl_set(uint32_t slot, uint32_t address, uint32_t size, uint32_t perm) {
+  NRF_ACL->ACL[slot].ADDR = address;
+  NRF_ACL->ACL[slot].SIZE = size;
+  NRF_ACL->ACL[slot].PERM = perm;
+  fake_periph_sync();
+}
+
+TEST(code_pass_write_protects_the_mbr_and_the_bootloader) {
+  uint32_t word = 0;
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+
+  CHECK_EQ(regions(), 2);
+  CHECK(fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_MBR_ADDRESS) >= 0);
+  CHECK(fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_BOOTLOADER_ADDRESS) >= 0);
+  CHECK_EQ(NRF_ACL->ACL[1].SIZE, MEMORY_BOOTLOADER_SIZE);
+  CHECK_EQ(NRF_ACL->ACL[1].PERM, PERM_WRITE);
+
+  (void)nrf_dfu_flash_store(MEMORY_BOOTLOADER_ADDRESS, &word, sizeof(word), NULL);
+  CHECK(fake_evt_find(FAKE_EVT_ACL_VIOLATION, MEMORY_BOOTLOADER_ADDRESS) >= 0);
+}
+
+TEST(secrets_pass_read_protects_the_device_secrets) {
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+  CHECK_EQ(fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_DEVICE_SECRETS_ADDRESS), -1);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_SECRETS), NRF_SUCCESS);
+
+  CHECK_EQ(regions(), 3);
+  CHECK_EQ(NRF_ACL->ACL[2].ADDR, MEMORY_DEVICE_SECRETS_ADDRESS);
+  CHECK_EQ(NRF_ACL->ACL[2].PERM, PERM_WRITE | PERM_READ);
+}
+
+TEST(verify_needs_both_passes) {
+  CHECK_EQ(flash_protect_verify(), NRF_ERROR_INTERNAL);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+  CHECK_EQ(flash_protect_verify(), NRF_ERROR_INTERNAL);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_SECRETS), NRF_SUCCESS);
+  CHECK_EQ(flash_protect_verify(), NRF_SUCCESS);
+}
+
+TEST(applying_again_writes_no_region) {
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_SECRETS), NRF_SUCCESS);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_SECRETS), NRF_SUCCESS);
+
+  CHECK_EQ(regions(), 3);
+  CHECK_EQ(NRF_ACL->ACL[3].SIZE, 0);
+}
+
+TEST(region_already_covered_is_skipped) {
+  //write protection of the whole flash does not cover the read protection
+  acl_set(0, 0, MEMORY_FLASH_END, PERM_WRITE);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_SUCCESS);
+  CHECK_EQ(regions(), 1);
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_SECRETS), NRF_SUCCESS);
+  CHECK_EQ(regions(), 2);
+  CHECK_EQ(NRF_ACL->ACL[1].ADDR, MEMORY_DEVICE_SECRETS_ADDRESS);
+  CHECK_EQ(flash_protect_verify(), NRF_SUCCESS);
+}
+
+TEST(used_regions_run_out) {
+  for (uint32_t i = 0; i < ACL_REGIONS_COUNT; i++) {
+    acl_set(i, 0x80000 + i * 0x1000, 0x1000, PERM_WRITE);
+  }
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_ERROR_NO_MEM);
+  CHECK_EQ(flash_protect_verify(), NRF_ERROR_INTERNAL);
+}
+
+TEST(region_that_does_not_read_back_fails) {
+  //the address of the first region was locked before its size was written
+  NRF_ACL->ACL[0].ADDR = 0x80000;
+  fake_periph_sync();
+
+  CHECK_EQ(flash_protect_apply(FLASH_PROTECT_CODE), NRF_ERROR_INTERNAL);
+}
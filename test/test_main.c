@@ -0,0 +1,102 @@
+#include "unit.h"
+#include "fake.h"
+#include "fixtures.h"
+#include "nrf_error.h"
+#include "secure.h"
+#include "memory_layout.h"
+#include "boot_probe.h"
+#include "measured_boot.h"
+
+int bootloader_main(void);
+
+/*
+* Runs main() until it starts the application, enters DFU mode or resets.
+*/
+static int boot() {
+  int result = setjmp(fake_boot_jmp);
+
+  if (result == 0) {
+    bootloader_main();
+    unit_fail(__FILE__, __LINE__, "main() returned");
+  }
+
+  return result;
+}
+
+TEST(boot_protects_the_code_before_copy_kdr_and_the_secrets_after) {
+  int mbr;
+  int bootloader;
+  int kdr;
+  int secrets;
+
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(boot(), FAKE_BOOT_APP_STARTED);
+
+  mbr = fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_MBR_ADDRESS);
+  bootloader = fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_BOOTLOADER_ADDRESS);
+  kdr = fake_evt_find_any(FAKE_EVT_KDR_LOADED);
+  secrets = fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_DEVICE_SECRETS_ADDRESS);
+
+  CHECK((mbr >= 0) && (bootloader >= 0) && (kdr >= 0) && (secrets >= 0));
+  CHECK((mbr < kdr) && (bootloader < kdr));
+  CHECK(kdr < secrets);
+  CHECK(secrets < fake_evt_find_any(FAKE_EVT_APP_START));
+}
+
+TEST(boot_provisions_a_new_device_and_starts_the_application) {
+  fixture_secrets_unprovisioned();
+
+  CHECK_EQ(boot(), FAKE_BOOT_APP_STARTED);
+
+  CHECK_EQ(fake_cc.kdr_loaded, 0xF);
+  CHECK(get_provisioning_cycles() != 0);
+  CHECK(fake_evt_find_any(FAKE_EVT_ACL_VIOLATION) < 0);
+}
+
+TEST(boot_measures_the_image_before_starting_it) {
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(boot(), FAKE_BOOT_APP_STARTED);
+
+  CHECK_EQ(measured_boot.magic, MEASURED_BOOT_MAGIC);
+  CHECK(fake_crypto.hash_calls > 0);
+}
+
+TEST(boot_times_bootloader_init_until_the_application_starts) {
+  boot_probe_stats_t stats;
+
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(boot(), FAKE_BOOT_APP_STARTED);
+
+  boot_probe_get(BOOT_PROBE_BOOTLOADER_INIT, &stats);
+  CHECK_EQ(stats.count, 1);
+}
+
+TEST(boot_in_dfu_mode_neither_measures_nor_starts_the_application) {
+  fixture_secrets_provisioned();
+  fake_boot.dfu_enter = true;
+
+  CHECK_EQ(boot(), FAKE_BOOT_DFU_MODE);
+
+  CHECK(fake_evt_find_any(FAKE_EVT_APP_START) < 0);
+  CHECK_EQ(fake_crypto.hash_calls, 0);
+}
+
+TEST(boot_resets_when_copy_kdr_fails) {
+  CHECK_EQ(boot(), FAKE_BOOT_RESET);
+
+  CHECK(fake_evt_find_any(FAKE_EVT_APP_START) < 0);
+  CHECK(fake_evt_find(FAKE_EVT_ACL_REGION, MEMORY_DEVICE_SECRETS_ADDRESS) < 0);
+}
+
+TEST(boot_resets_when_bootloader_init_fails) {
+  fixture_secrets_provisioned();
+  fake_boot.init_result = NRF_ERROR_INTERNAL;
+
+  CHECK_EQ(boot(), FAKE_BOOT_RESET);
+
+  CHECK(fake_evt_find_any(FAKE_EVT_APP_START) < 0);
+  CHECK_EQ(fake_crypto.hash_calls, 0);
+}
@@ -0,0 +1,194 @@
+#include <stddef.h>
+#include <string.h>
+#include "unit.h"
+#include "fake.h"
+#include "nrf_error.h"
+#include "crc32.h"
+#include "nrf_crypto.h"
+#include "nrf_dfu_settings.h"
+#include "measured_boot.h"
+#include "memory_layout.h"
+
+#define APP_SIZE 0x2345
+
+/*
+* The measured regions hold the top byte of address * 0x9E3779B1, so every
+* region has its own contents. s_dfu_settings holds the pattern of the
+* settings page with bank 0 (offset 24) set to a valid application of
+* 0x2345 bytes. The digests below were computed with Python rather than the
+* fake:
+*
+*   pattern = lambda a, n: bytes((x * 0x9E3779B1 & 0xFFFFFFFF) >> 24 for x in range(a, a + n))
+*   settings = bytearray(pattern(0xFF000, 916))           # sizeof(nrf_dfu_settings_t)
+*   settings[24:28] = struct.pack('<I', 0x2345)           # bank_0.image_size
+*   settings[32:36] = struct.pack('<I', 1)                # bank_0.bank_code
+*   hashlib.sha256(pattern(0xE1000, 0x1D000)).digest()    # bootloader
+*   hashlib.sha256(settings).digest()                     # settings
+*   hashlib.sha256(pattern(0x1000, 0x2345)).digest()      # application
+*   chain = hashlib.sha256(chain + component).digest()    # from 32 zero bytes, in that order
+*/
+static const uint8_t bootloader_digest[MEASUREMENT_SIZE] = {
+  0x15, 0xAB, 0xF5, 0x68, 0xB6, 0x7D, 0xDE, 0x1A, 0x83, 0xD4, 0xDF, 0xB9, 0x80, 0x97, 0xF3, 0x20,
+  0x18, 0xE2, 0x0F, 0xC5, 0x6E, 0x4C, 0x68, 0x94, 0x55, 0xC6, 0xB4, 0x41, 0xEF, 0xC1, 0xD5, 0xC2
+};
+
+static const uint8_t settings_digest[MEASUREMENT_SIZE] = {
+  0x91, 0xDC, 0xCB, 0x07, 0x4C, 0x93, 0x57, 0xD4, 0x29, 0x06, 0x09, 0x35, 0x53, 0xD5, 0x86, 0xE7,
+  0x6C, 0x08, 0x14, 0x72, 0x2D, 0x14, 0xE6, 0xD1, 0xC0, 0xA2, 0xBA, 0x1C, 0x06, 0xA0, 0x9A, 0x7D
+};
+
+static const uint8_t application_digest[MEASUREMENT_SIZE] = {
+  0xE6, 0xBD, 0x2C, 0x27, 0x20, 0xF6, 0x29, 0x04, 0x46, 0xA0, 0x31, 0x21, 0xD3, 0xF6, 0xAE, 0x03,
+  0xC1, 0xDF, 0x16, 0x2C, 0xEF, 0x62, 0x9F, 0x0F, 0x5F, 0xF8, 0x77, 0xEF, 0x4D, 0x06, 0xD0, 0x47
+};
+
+static const uint8_t chain_digest[MEASUREMENT_SIZE] = {
+  0x44, 0x20, 0x72, 0xED, 0x75, 0xAC, 0xCB, 0x8F, 0x90, 0x95, 0x35, 0x1A, 0x78, 0x77, 0x23, 0xAD,
+  0x00, 0x64, 0x01, 0x12, 0x16, 0xD5, 0xDB, 0xEA, 0x8B, 0xD2, 0x32, 0xCB, 0x4E, 0xD3, 0xE1, 0x52
+};
+
+//SHA-256 of nothing, the application component without a valid bank
+static const uint8_t empty_digest[MEASUREMENT_SIZE] = {
+  0xE3, 0xB0, 0xC4, 0x42, 0x98, 0xFC, 0x1C, 0x14, 0x9A, 0xFB, 0xF4, 0xC8, 0x99, 0x6F, 0xB9, 0x24,
+  0x27, 0xAE, 0x41, 0xE4, 0x64, 0x9B, 0x93, 0x4C, 0xA4, 0x95, 0x99, 0x1B, 0x78, 0x52, 0xB8, 0x55
+};
+
+//bank code 0 in the settings
+static const uint8_t chain_without_app_digest[MEASUREMENT_SIZE] = {
+  0xB6, 0xAC, 0x7E, 0x34, 0xAC, 0x72, 0xDF, 0x3B, 0x25, 0x3C, 0xEA, 0x7F, 0xD0, 0xFC, 0x41, 0x07,
+  0xB2, 0x37, 0x08, 0xAD, 0xBC, 0x2E, 0xC8, 0x35, 0xE8, 0x3B, 0x60, 0x64, 0xAE, 0x21, 0x4F, 0x04
+};
+
+static void pattern(uint32_t address, uint8_t * p_data, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+    p_data[i] = (uint8_t)(((address + i) * 0x9E3779B1) >> 24);
+  }
+}
+
+static void fill_pattern(uint32_t address, uint32_t size) {
+  uint8_t page[FAKE_FLASH_PAGE_SIZE];
+
+  while (size > 0) {
+    uint32_t chunk = (size > sizeof(page)) ? sizeof(page) : size;
+
+    pattern(address, page, chunk);
+    fake_flash_program(address, page, chunk);
+    address += chunk;
+    size -= chunk;
+  }
+}
+
+static void image_with_app(uint8_t bank_code) {
+  fill_pattern(MEMORY_BOOTLOADER_ADDRESS, MEMORY_BOOTLOADER_SIZE);
+  fill_pattern(MEMORY_SETTINGS_ADDRESS, MEMORY_SETTINGS_SIZE);
+  fill_pattern(MEMORY_MBR_SIZE, APP_SIZE);
+
+  CHECK_EQ(sizeof(s_dfu_settings), 916);
+  pattern(MEMORY_SETTINGS_ADDRESS, (uint8_t *)&s_dfu_settings, sizeof(s_dfu_settings));
+  s_dfu_settings.bank_0.bank_code = bank_code;
+  s_dfu_settings.bank_0.image_size = APP_SIZE;
+}
+
+static void sha256(char const * p_message, uint8_t * p_digest) {
+  nrf_crypto_hash_context_t context;
+  size_t size = MEASUREMENT_SIZE;
+
+  CHECK_EQ(nrf_crypto_hash_calculate(&context, &g_nrf_crypto_hash_sha256_info, (uint8_t const *)p_message,
+                                     strlen(p_message), p_digest, &size),
+           NRF_SUCCESS);
+  CHECK_EQ(size, MEASUREMENT_SIZE);
+}
+
+/*
+* The one and two block messages of FIPS 180-4, appendix B.
+*/
+TEST(fake_hash_is_sha256) {
+  static const uint8_t abc[MEASUREMENT_SIZE] = {
+    0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+    0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD
+  };
+  static const uint8_t two_blocks[MEASUREMENT_SIZE] = {
+    0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+    0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1
+  };
+  uint8_t digest[MEASUREMENT_SIZE];
+
+  sha256("abc", digest);
+  CHECK_MEM(digest, abc, MEASUREMENT_SIZE);
+
+  sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", digest);
+  CHECK_MEM(digest, two_blocks, MEASUREMENT_SIZE);
+}
+
+TEST(measured_boot_measures_every_component) {
+  image_with_app(NRF_DFU_BANK_VALID_APP);
+
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  CHECK_MEM(measured_boot.components[MEASURED_BOOTLOADER], bootloader_digest, MEASUREMENT_SIZE);
+  CHECK_MEM(measured_boot.components[MEASURED_SETTINGS], settings_digest, MEASUREMENT_SIZE);
+  CHECK_MEM(measured_boot.components[MEASURED_APPLICATION], application_digest, MEASUREMENT_SIZE);
+  CHECK_MEM(measured_boot.chain, chain_digest, MEASUREMENT_SIZE);
+}
+
+TEST(measured_boot_measures_the_loaded_settings_not_the_page) {
+  image_with_app(NRF_DFU_BANK_VALID_APP);
+
+  //a log record behind the snapshot does not change what is measured
+  fake_flash_fill(MEMORY_SETTINGS_ADDRESS + sizeof(s_dfu_settings), 0x00, 64);
+
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  CHECK_MEM(measured_boot.components[MEASURED_SETTINGS], settings_digest, MEASUREMENT_SIZE);
+}
+
+TEST(measured_boot_publishes_a_complete_record) {
+  image_with_app(NRF_DFU_BANK_VALID_APP);
+
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  CHECK_EQ(measured_boot.magic, MEASURED_BOOT_MAGIC);
+  CHECK_EQ(measured_boot.app_size, APP_SIZE);
+  CHECK_EQ(measured_boot.crc,
+           crc32_compute((uint8_t const *)&measured_boot, offsetof(measured_boot_t, crc), NULL));
+}
+
+TEST(measured_boot_skips_an_invalid_bank) {
+  image_with_app(NRF_DFU_BANK_INVALID);
+
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  CHECK_EQ(measured_boot.app_size, 0);
+  CHECK_MEM(measured_boot.components[MEASURED_APPLICATION], empty_digest, MEASUREMENT_SIZE);
+  CHECK_MEM(measured_boot.chain, chain_without_app_digest, MEASUREMENT_SIZE);
+}
+
+TEST(measured_boot_follows_a_changed_application) {
+  image_with_app(NRF_DFU_BANK_VALID_APP);
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  fake_flash_fill(MEMORY_MBR_SIZE + APP_SIZE - 1, 0x00, 1);
+
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+
+  CHECK(memcmp(measured_boot.components[MEASURED_APPLICATION], application_digest, MEASUREMENT_SIZE) != 0);
+  CHECK(memcmp(measured_boot.chain, chain_digest, MEASUREMENT_SIZE) != 0);
+  CHECK_MEM(measured_boot.components[MEASURED_BOOTLOADER], bootloader_digest, MEASUREMENT_SIZE);
+}
+
+TEST(measured_boot_publishes_nothing_when_a_hash_fails) {
+  uint32_t calls;
+
+  image_with_app(NRF_DFU_BANK_VALID_APP);
+  CHECK_EQ(measured_boot_run(), NRF_SUCCESS);
+  calls = fake_crypto.hash_calls;
+
+  //every call of the clean run fails in turn, the last ones extend the chain
+  for (uint32_t call = 1; call <= calls; call++) {
+    fake_crypto.hash_calls = 0;
+    fake_crypto.fail_call = call;
+
+    CHECK_EQ(measured_boot_run(), NRF_ERROR_INTERNAL);
+    CHECK_EQ(measured_boot.magic, 0);
+  }
+}
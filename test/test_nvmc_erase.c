@@ -0,0 +1,98 @@
+#include "unit.h"
+#include "fake.h"
+#include "nrf.h"
+#include "nrf_nvmc.h"
+#include "nvmc_erase.h"
+
+#define PAGE 0x80000
+
+static uint32_t m_slices;
+static uint32_t m_gap_max;
+static uint32_t m_last;
+
+static void slice_handler() {
+  if ((m_slices > 0) && (fake_dwt.CYCCNT - m_last > m_gap_max)) {
+    m_gap_max = fake_dwt.CYCCNT - m_last;
+  }
+
+  m_last = fake_dwt.CYCCNT;
+  m_slices++;
+}
+
+static bool page_blank() {
+  uint32_t const * p_word = (uint32_t const *)PAGE;
+
+  for (uint32_t i = 0; i < FAKE_FLASH_PAGE_SIZE / sizeof(uint32_t); i++) {
+    if (p_word[i] != 0xFFFFFFFF) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static nvmc_erase_stats_t stats() {
+  nvmc_erase_stats_t stats;
+
+  nvmc_erase_stats_get(&stats);
+  return stats;
+}
+
+/*
+* Erases a written page through the SDK function the wrap replaces.
+*/
+static void erase(uint32_t erase_time_ms) {
+  fake_flash.erase_time_ms = erase_time_ms;
+  fake_flash_fill(PAGE, 0, FAKE_FLASH_PAGE_SIZE);
+  nvmc_erase_slice_handler_set(slice_handler);
+
+  nrf_nvmc_page_erase(PAGE);
+  fake_periph_sync();
+}
+
+TEST(page_is_erased_in_slices) {
+  uint32_t start = fake_dwt.CYCCNT;
+
+  erase(NVMC_PAGE_ERASE_TIME_MS);
+
+  CHECK(page_blank());
+  CHECK_EQ(fake_flash.partial_erases, 9);
+  CHECK_EQ(fake_flash.full_erases, 0);
+  CHECK_EQ(fake_dwt.CYCCNT - start, 9 * NVMC_PARTIAL_ERASE_SLICE_MS * FAKE_CYCLES_PER_MS);
+
+  CHECK_EQ(stats().pages, 1);
+  CHECK_EQ(stats().slices, 9);
+  CHECK_EQ(stats().retries, 0);
+}
+
+TEST(slice_handler_runs_after_every_slice) {
+  erase(NVMC_PAGE_ERASE_TIME_MS);
+
+  CHECK_EQ(m_slices, 9);
+  CHECK_EQ(m_gap_max, NVMC_PARTIAL_ERASE_SLICE_MS * FAKE_CYCLES_PER_MS);
+}
+
+TEST(slow_page_gets_more_slices) {
+  erase(120);
+
+  CHECK(page_blank());
+  CHECK_EQ(fake_flash.partial_erases, 12);
+  CHECK_EQ(fake_flash.full_erases, 0);
+  CHECK_EQ(stats().retries, 1);
+  CHECK_EQ(m_slices, 12);
+}
+
+TEST(page_not_blank_after_twice_the_erase_time_gets_a_full_erase) {
+  erase(200);
+
+  CHECK(page_blank());
+  CHECK_EQ(fake_flash.partial_erases, 2 * NVMC_PAGE_ERASE_TIME_MS / NVMC_PARTIAL_ERASE_SLICE_MS);
+  CHECK_EQ(fake_flash.full_erases, 1);
+  CHECK_EQ(stats().retries, 1);
+}
+
+TEST(erase_leaves_the_nvmc_read_only) {
+  erase(NVMC_PAGE_ERASE_TIME_MS);
+
+  CHECK_EQ(NRF_NVMC->CONFIG, NVMC_CONFIG_WEN_Ren);
+}
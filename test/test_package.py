@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""The benchmark of tools/package.py for 100 variants.
+
+nrfutil is replaced by fakes/nrfutil, which only writes the output files, so
+the times are those of the pipeline around nrfutil: hashing, the cache and
+the worker pool. The sequential, parallel and cached wall times are printed.
+Run by make from test/.
+"""
+
+import os
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+NRFUTIL = (os.path.join(HERE, 'fakes', 'nrfutil'),)
+
+sys.path.insert(0, os.path.join(HERE, '..', 'tools'))
+import package  # noqa: E402
+
+VARIANT_COUNT = 100
+IMAGE_SIZE = 256 * 1024
+JOBS = max(2, os.cpu_count() or 1)
+
+
+class BenchmarkTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.root = tempfile.TemporaryDirectory()
+        cls.key = os.path.join(cls.root.name, 'priv_key.pem')
+        with open(cls.key, 'w') as f:
+            f.write('key\n')
+        for name in ('dongle', 'devkit'):
+            with open(os.path.join(cls.root.name, 'app_%s.bin' % name), 'wb') as f:
+                f.write(os.urandom(IMAGE_SIZE))
+        variants = os.path.join(cls.root.name, 'release.json')
+        with open(variants, 'w') as f:
+            f.write('{"variants": [{"name": "dongle", "application": "app_dongle.bin"},'
+                    ' {"name": "devkit", "application": "app_devkit.bin"}]}')
+
+        cls.results = package.benchmark(package.load_variants(variants), cls.key, VARIANT_COUNT, JOBS, NRFUTIL)
+        sequential = cls.results[0][2][3]
+        print()
+        for run, jobs, (packaged, unchanged, failed, elapsed) in cls.results:
+            print('%-10s %2d jobs  %3d packaged  %3d unchanged  %7.3f s  %5.2fx' %
+                  (run, jobs, packaged, unchanged, elapsed, sequential / elapsed))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.root.cleanup()
+
+    def run_counts(self, name):
+        return next(counts for run, _, counts in self.results if run == name)
+
+    def test_every_variant_is_packaged_once_per_run(self):
+        for run in ('sequential', 'parallel'):
+            packaged, unchanged, failed, _ = self.run_counts(run)
+
+            self.assertEqual((packaged, unchanged, failed), (VARIANT_COUNT, 0, 0), run)
+
+    def test_cached_run_packages_nothing_and_is_faster(self):
+        packaged, unchanged, failed, elapsed = self.run_counts('cached')
+
+        self.assertEqual((packaged, unchanged, failed), (0, VARIANT_COUNT, 0))
+        self.assertLess(elapsed, self.run_counts('parallel')[3] / 4)
+
+    def test_copies_differ_in_name_and_versions(self):
+        copies = package.benchmark_variants([dict(package.DEFAULTS, name='a', application='a.bin')], 3)
+
+        self.assertEqual([v['name'] for v in copies], ['a-000', 'a-001', 'a-002'])
+        self.assertEqual(len({package.inputs_digest(v, 'image', 'key') for v in copies}), 3)
+
+    @unittest.skipIf((os.cpu_count() or 1) < 2, 'one core, the jobs only overlap the process start')
+    def test_parallel_run_is_faster_with_more_than_one_core(self):
+        self.assertLess(self.run_counts('parallel')[3], self.run_counts('sequential')[3])
+
+
+if __name__ == '__main__':
+    unittest.main()
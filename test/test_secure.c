@@ -0,0 +1,157 @@
+#include "unit.h"
+#include "fake.h"
+#include "nrf.h"
+#include "fixtures.h"
+#include "nrf_error.h"
+#include "secure.h"
+#include "device_secrets.h"
+#include "key_derivation.h"
+
+extern key_handoff_t key_handoff;
+
+static device_secrets_header_t const * const p_page = (device_secrets_header_t const *)DEVICE_SECRET_ADDRESS;
+
+static void check_kdr_holds(uint8_t const * p_key) {
+  CHECK_EQ(fake_cc.kdr_loaded, 0xF);
+  CHECK_MEM(fake_cc.kdr, p_key, DEVICE_ROOT_KEY_SIZE);
+}
+
+TEST(copy_kdr_loads_the_provisioned_key) {
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  check_kdr_holds(fixture_root_key);
+  CHECK(fake_evt_find_any(FAKE_EVT_RNG) < 0);
+  CHECK(fake_evt_find_any(FAKE_EVT_FLASH_STORE) < 0);
+  CHECK_EQ(get_provisioning_cycles(), 0);
+}
+
+TEST(copy_kdr_loads_a_legacy_key) {
+  fixture_secrets_legacy();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  check_kdr_holds(fixture_root_key);
+}
+
+TEST(copy_kdr_generates_and_writes_the_secrets_once) {
+  device_secrets_t secrets;
+  uint8_t const * p_key;
+  uint16_t length;
+
+  fixture_secrets_unprovisioned();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  CHECK_EQ(p_page->flag, ALREADY_WRITTEN);
+  CHECK(device_secrets_table_valid((uint8_t const *)p_page));
+  CHECK_EQ(device_secrets_open(&secrets, (uint8_t const *)p_page), NRF_SUCCESS);
+  CHECK_EQ(device_secrets_find(&secrets, SECRET_ROOT_KEY, &p_key, &length), NRF_SUCCESS);
+  CHECK_EQ(length, DEVICE_ROOT_KEY_SIZE);
+  check_kdr_holds(p_key);
+
+  CHECK_EQ(fake_flash.stores, 1);
+  CHECK(fake_evt_find(FAKE_EVT_FLASH_ERASE, DEVICE_SECRET_ADDRESS) >= 0);
+  CHECK(fake_evt_find(FAKE_EVT_FLASH_STORE, DEVICE_SECRET_ADDRESS) < fake_evt_find_any(FAKE_EVT_KDR_LOADED));
+}
+
+TEST(copy_kdr_keeps_the_page_when_the_rng_fails) {
+  fixture_secrets_unprovisioned();
+  fake_fault.type = FAKE_FAULT_RNG;
+  fake_fault.at = 0;
+
+  CHECK(copy_kdr() != NRF_SUCCESS);
+
+  CHECK_EQ(p_page->flag, GENERATE_AND_WRITE);
+  CHECK_EQ(fake_flash.stores, 0);
+  CHECK_EQ(fake_cc.kdr_loaded, 0);
+}
+
+TEST(copy_kdr_rejects_an_erased_page) {
+  CHECK_EQ(copy_kdr(), NRF_ERROR_INTERNAL);
+
+  CHECK_EQ(fake_cc.kdr_loaded, 0);
+  CHECK_EQ(fake_flash.stores, 0);
+}
+
+/*
+* RFC 4493 examples 1, 2 and 4, the PRF of the key derivation fake.
+*/
+TEST(fake_key_derivation_prf_is_aes_cmac) {
+  static const uint8_t key[16] = {
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+  };
+  static const uint8_t message[64] = {
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+    0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+    0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+  };
+  static const uint8_t macs[3][16] = {
+    { 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 },
+    { 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C },
+    { 0x51, 0xF0, 0xBE, 0xBF, 0x7E, 0x3B, 0x9D, 0x92, 0xFC, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3C, 0xFE }
+  };
+  static const size_t sizes[3] = { 0, 16, 64 };
+  uint8_t mac[16];
+
+  for (uint32_t i = 0; i < 3; i++) {
+    fake_aes_cmac(key, message, sizes[i], mac);
+    CHECK_MEM(mac, macs[i], sizeof(mac));
+  }
+}
+
+/*
+* The keys of fixture_root_key and the DEVICEID of the fake FICR
+* (0x12345678, 0x9ABCDEF0), computed with OpenSSL rather than the fake:
+*
+*   printf '\x01<label>\x00\x78\x56\x34\x12\xf0\xde\xbc\x9a\x80' |
+*     openssl mac -cipher AES-128-CBC -macopt hexkey:1032547698badcfe0123456789abcdef CMAC
+*/
+TEST(copy_kdr_derives_the_application_keys) {
+  static const uint8_t keys[DERIVED_KEY_COUNT][DERIVED_KEY_SIZE] = {
+    [DERIVED_KEY_STORAGE] =
+      { 0xF0, 0xD6, 0x54, 0x77, 0x83, 0x4F, 0xF6, 0x79, 0x10, 0x38, 0x46, 0xCC, 0x63, 0xAB, 0x69, 0xC0 },
+    [DERIVED_KEY_ATTESTATION] =
+      { 0x8C, 0x85, 0xFD, 0xDA, 0x42, 0x23, 0xF6, 0x2F, 0xAE, 0x5E, 0x59, 0x06, 0xD5, 0xEA, 0x36, 0x71 },
+    [DERIVED_KEY_TRANSPORT] =
+      { 0x50, 0xD2, 0xA1, 0x9E, 0x35, 0xBD, 0x3E, 0xF6, 0x60, 0x24, 0x31, 0x6D, 0x44, 0x5D, 0x63, 0xA1 }
+  };
+
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  CHECK_EQ(key_handoff.magic, KEY_HANDOFF_MAGIC);
+  CHECK_EQ(key_handoff.key_count, DERIVED_KEY_COUNT);
+
+  for (uint32_t i = 0; i < DERIVED_KEY_COUNT; i++) {
+    CHECK_MEM(key_handoff.keys[i], keys[i], DERIVED_KEY_SIZE);
+  }
+}
+
+TEST(copy_kdr_closes_the_cryptocell) {
+  fixture_secrets_provisioned();
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  CHECK_EQ(fake_cc.lib_init, 1);
+  CHECK_EQ(fake_cc.lib_open, 0);
+  CHECK_EQ(fake_cc.rnd_open, 0);
+  CHECK_EQ(fake_cc.lcs, 2);
+}
+
+TEST(provisioning_cycles_are_a_delta_of_the_running_counter) {
+  uint32_t start = 0xFFF00000;
+
+  fixture_secrets_unprovisioned();
+  fake_dwt.CYCCNT = start;
+
+  CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+
+  //the counter wrapped during the page erase and was never reset
+  CHECK(fake_dwt.CYCCNT < start);
+  CHECK_EQ(get_provisioning_cycles(), fake_dwt.CYCCNT - start);
+  CHECK(get_provisioning_cycles() >= fake_flash.erase_time_ms * FAKE_CYCLES_PER_MS);
+}
@@ -0,0 +1,396 @@
+#include <stddef.h>
+#include <stdio.h>
+#include "unit.h"
+#include "fake.h"
+#include "nrf_error.h"
+#include "crc32.h"
+#include "app_util.h"
+#include "nrf_dfu_settings.h"
+#include "settings_log.h"
+
+#define SNAPSHOT ((nrf_dfu_settings_t const *)BOOTLOADER_SETTINGS_ADDRESS)
+#define BACKUP ((nrf_dfu_settings_t const *)NRF_MBR_PARAMS_PAGE_ADDRESS)
+#define LOG_START (BOOTLOADER_SETTINGS_ADDRESS + ALIGN_NUM(sizeof(uint32_t), sizeof(nrf_dfu_settings_t)))
+
+static uint32_t m_callbacks;
+
+static void write_done(void * p_buf) {
+  (void)p_buf;
+  m_callbacks++;
+}
+
+static uint32_t erases() {
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < fake_evt_count; i++) {
+    count += (fake_evts[i].type == FAKE_EVT_FLASH_ERASE) && (fake_evts[i].arg == BOOTLOADER_SETTINGS_ADDRESS);
+  }
+
+  return count;
+}
+
+static settings_log_stats_t stats() {
+  settings_log_stats_t stats;
+
+  settings_log_stats_get(&stats);
+  return stats;
+}
+
+/*
+* Loads the settings like a boot does, from a cleared RAM copy.
+*/
+static void reboot() {
+  memset(&s_dfu_settings, 0, sizeof(s_dfu_settings));
+  CHECK_EQ(nrf_dfu_settings_init(false), NRF_SUCCESS);
+}
+
+TEST(init_writes_a_snapshot_with_an_empty_log) {
+  reboot();
+
+  CHECK_EQ(SNAPSHOT->crc, nrf_dfu_settings_crc_get(SNAPSHOT));
+  CHECK_EQ(SNAPSHOT->settings_version, NRF_DFU_SETTINGS_VERSION);
+  CHECK_EQ(*(uint32_t const *)LOG_START, 0xFFFFFFFF);
+}
+
+TEST(write_appends_a_record_instead_of_erasing_the_page) {
+  uint32_t erased;
+
+  reboot();
+  erased = erases();
+
+  s_dfu_settings.app_version = 7;
+  CHECK_EQ(nrf_dfu_settings_write(write_done), NRF_SUCCESS);
+
+  CHECK_EQ(erases(), erased);
+  CHECK(fake_evt_find(FAKE_EVT_FLASH_STORE, LOG_START) >= 0);
+  CHECK_EQ(SNAPSHOT->app_version, 0);
+  CHECK_EQ(stats().records, 1);
+  CHECK_EQ(m_callbacks, 1);
+}
+
+TEST(init_replays_the_records_onto_the_snapshot) {
+  reboot();
+
+  s_dfu_settings.app_version = 7;
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+  s_dfu_settings.bootloader_version = 3;
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+
+  reboot();
+
+  CHECK_EQ(s_dfu_settings.app_version, 7);
+  CHECK_EQ(s_dfu_settings.bootloader_version, 3);
+  CHECK_EQ(s_dfu_settings.crc, nrf_dfu_settings_crc_get(&s_dfu_settings));
+}
+
+TEST(write_refreshes_the_boot_validation_crc) {
+  uint32_t expected;
+
+  reboot();
+
+  s_dfu_settings.boot_validation_app.type = VALIDATE_CRC;
+  memset(s_dfu_settings.boot_validation_app.bytes, 0x5A, 4);
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+
+  expected = crc32_compute((uint8_t const *)&s_dfu_settings.boot_validation_softdevice, 3 * sizeof(boot_validation_t), NULL);
+  CHECK_EQ(s_dfu_settings.boot_validation_crc, expected);
+
+  reboot();
+
+  CHECK_EQ(s_dfu_settings.boot_validation_app.type, VALIDATE_CRC);
+  CHECK_EQ(s_dfu_settings.boot_validation_crc, expected);
+}
+
+TEST(unchanged_write_is_skipped) {
+  uint32_t stores;
+
+  reboot();
+  stores = fake_flash.stores;
+
+  CHECK_EQ(nrf_dfu_settings_write(write_done), NRF_SUCCESS);
+
+  CHECK_EQ(fake_flash.stores, stores);
+  CHECK_EQ(stats().skipped, 1);
+  CHECK_EQ(m_callbacks, 1);
+}
+
+TEST(full_log_is_compacted_into_a_new_snapshot) {
+  uint32_t i;
+
+  reboot();
+
+  //each record holds most of the init command, a few fill the page
+  for (i = 1; stats().compactions == 0; i++) {
+    memset(s_dfu_settings.init_command, i, sizeof(s_dfu_settings.init_command));
+    s_dfu_settings.app_version = i;
+    CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+    CHECK(i < 16);
+  }
+
+  CHECK_EQ(SNAPSHOT->app_version, i - 1);
+  CHECK_EQ(*(uint32_t const *)LOG_START, 0xFFFFFFFF);
+
+  s_dfu_settings.app_version = 100;
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+
+  reboot();
+
+  CHECK_EQ(s_dfu_settings.app_version, 100);
+  CHECK_EQ(s_dfu_settings.init_command[0], (uint8_t)(i - 1));
+}
+
+TEST(torn_record_is_ignored_and_the_next_write_compacts) {
+  reboot();
+
+  s_dfu_settings.app_version = 1;
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+
+  //power lost in the middle of the second record
+  fake_flash.cut_after = 6;
+
+  if (setjmp(fake_boot_jmp) == 0) {
+    s_dfu_settings.app_version = 2;
+    (void)nrf_dfu_settings_write(NULL);
+    unit_fail(__FILE__, __LINE__, "the store was not cut");
+  }
+
+  reboot();
+  CHECK_EQ(s_dfu_settings.app_version, 1);
+
+  s_dfu_settings.app_version = 3;
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+  CHECK_EQ(stats().compactions, 1);
+
+  reboot();
+  CHECK_EQ(s_dfu_settings.app_version, 3);
+}
+
+TEST(write_and_backup_keeps_the_backup_in_the_sdk_format) {
+  reboot();
+
+  s_dfu_settings.app_version = 9;
+  CHECK_EQ(nrf_dfu_settings_write_and_backup(write_done), NRF_SUCCESS);
+
+  CHECK_EQ(SNAPSHOT->app_version, 0);
+  CHECK_MEM(BACKUP, &s_dfu_settings, sizeof(nrf_dfu_settings_t));
+  CHECK_EQ(BACKUP->crc, nrf_dfu_settings_crc_get(BACKUP));
+  CHECK_EQ(m_callbacks, 1);
+}
+
+TEST(backup_is_used_when_the_page_is_damaged) {
+  reboot();
+
+  s_dfu_settings.app_version = 9;
+  CHECK_EQ(nrf_dfu_settings_write_and_backup(NULL), NRF_SUCCESS);
+
+  fake_flash_fill(BOOTLOADER_SETTINGS_ADDRESS, 0, sizeof(uint32_t));
+  reboot();
+
+  CHECK_EQ(s_dfu_settings.app_version, 9);
+}
+
+#define OBJECT_SIZE 4096
+#define IMAGE_SIZE (10 * OBJECT_SIZE)
+
+//image of the interruption simulation, 800 kB
+#define SIM_IMAGE_SIZE (200 * OBJECT_SIZE)
+#define SIM_INTERRUPTIONS 50
+#define SIM_SEED 0x9E3779B9
+
+static uint8_t m_image[SIM_IMAGE_SIZE];
+
+/*
+* What the request handler does with the settings after every data object
+* it executes, from the object at offset up to end.
+*/
+static void transfer(uint32_t offset, uint32_t end) {
+  for (; offset < end; offset += OBJECT_SIZE) {
+    uint32_t crc = s_dfu_settings.progress.firmware_image_crc;
+
+    crc = crc32_compute(&m_image[offset], OBJECT_SIZE, (offset == 0) ? NULL : &crc);
+
+    s_dfu_settings.progress.firmware_image_crc = crc;
+    s_dfu_settings.progress.firmware_image_crc_last = crc;
+    s_dfu_settings.progress.firmware_image_offset = offset + OBJECT_SIZE;
+    s_dfu_settings.progress.firmware_image_offset_last = offset + OBJECT_SIZE;
+    s_dfu_settings.progress.data_object_size = OBJECT_SIZE;
+    CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+  }
+}
+
+/*
+* Starts a transfer of m_image the way the request handler does once the
+* init command was accepted, which is written to flash before any data.
+*/
+static void transfer_start() {
+  for (uint32_t i = 0; i < sizeof(m_image); i++) {
+    m_image[i] = (uint8_t)(i * 7);
+  }
+
+  reboot();
+  s_dfu_settings.progress.command_size = 64;
+  memset(s_dfu_settings.init_command, 0xC5, 64);
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+}
+
+static void resume_check(uint32_t offset) {
+  CHECK_EQ(s_dfu_settings.progress.firmware_image_offset_last, offset);
+  CHECK_EQ(s_dfu_settings.progress.firmware_image_crc_last, crc32_compute(m_image, offset, NULL));
+  CHECK_EQ(s_dfu_settings.progress.command_size, 64);
+}
+
+TEST(progress_below_the_checkpoint_size_is_deferred) {
+  uint32_t stores;
+
+  transfer_start();
+  stores = fake_flash.stores;
+
+  transfer(0, 3 * OBJECT_SIZE);
+
+  CHECK_EQ(fake_flash.stores, stores);
+  CHECK_EQ(stats().deferred, 3);
+  CHECK_EQ(stats().checkpoints, 0);
+
+  transfer(3 * OBJECT_SIZE, 4 * OBJECT_SIZE);
+
+  CHECK_EQ(fake_flash.stores, stores + 1);
+  CHECK_EQ(stats().checkpoints, 1);
+}
+
+TEST(progress_checkpoint_skips_the_backup) {
+  transfer_start();
+  transfer(0, 3 * OBJECT_SIZE);
+
+  s_dfu_settings.progress.firmware_image_offset_last = NRF_DFU_PROGRESS_CHECKPOINT_SIZE;
+  CHECK_EQ(nrf_dfu_settings_write_and_backup(NULL), NRF_SUCCESS);
+
+  CHECK_EQ(stats().checkpoints, 1);
+  CHECK_EQ(fake_evt_find(FAKE_EVT_FLASH_STORE, NRF_MBR_PARAMS_PAGE_ADDRESS), -1);
+}
+
+TEST(interrupted_transfer_resumes_from_the_last_checkpoint) {
+  transfer_start();
+
+  //reset two objects past the second checkpoint
+  transfer(0, 10 * OBJECT_SIZE - 2 * OBJECT_SIZE);
+  reboot();
+  resume_check(2 * NRF_DFU_PROGRESS_CHECKPOINT_SIZE);
+
+  transfer(2 * NRF_DFU_PROGRESS_CHECKPOINT_SIZE, IMAGE_SIZE);
+
+  //postvalidation moves the image to bank 1 and clears the progress
+  s_dfu_settings.bank_1.image_size = IMAGE_SIZE;
+  s_dfu_settings.bank_1.image_crc = crc32_compute(m_image, IMAGE_SIZE, NULL);
+  memset(&s_dfu_settings.progress, 0, sizeof(dfu_progress_t));
+  CHECK_EQ(nrf_dfu_settings_write(NULL), NRF_SUCCESS);
+
+  reboot();
+  CHECK_EQ(s_dfu_settings.bank_1.image_crc, crc32_compute(m_image, IMAGE_SIZE, NULL));
+  CHECK_EQ(s_dfu_settings.progress.firmware_image_offset_last, 0);
+}
+
+TEST(torn_checkpoint_resumes_from_the_previous_one) {
+  transfer_start();
+  transfer(0, NRF_DFU_PROGRESS_CHECKPOINT_SIZE + 3 * OBJECT_SIZE);
+
+  //power lost while the second checkpoint is stored
+  fake_flash.cut_after = 8;
+
+  if (setjmp(fake_boot_jmp) == 0) {
+    transfer(NRF_DFU_PROGRESS_CHECKPOINT_SIZE + 3 * OBJECT_SIZE, 2 * NRF_DFU_PROGRESS_CHECKPOINT_SIZE);
+    unit_fail(__FILE__, __LINE__, "the store was not cut");
+  }
+
+  reboot();
+  resume_check(NRF_DFU_PROGRESS_CHECKPOINT_SIZE);
+
+  //the next checkpoint compacts the page behind the torn record
+  transfer(NRF_DFU_PROGRESS_CHECKPOINT_SIZE, 2 * NRF_DFU_PROGRESS_CHECKPOINT_SIZE);
+  CHECK_EQ(stats().compactions, 1);
+
+  reboot();
+  resume_check(2 * NRF_DFU_PROGRESS_CHECKPOINT_SIZE);
+}
+
+/*
+* A seeded simulation of an 800 kB transfer reset at SIM_INTERRUPTIONS
+* random points of the image, in the middle of a data object or between two.
+* After every reset the host resumes from the offset the settings report and
+* sends everything after it again, so the bytes from the resume offset to
+* the reset are retransmitted. Each reset loses the objects executed since
+* the last checkpoint and the object in flight, fewer than
+* NRF_DFU_PROGRESS_CHECKPOINT_SIZE + OBJECT_SIZE bytes. Without progress in
+* flash the same resets would retransmit everything sent before them.
+*/
+TEST(random_interruptions_retransmit_less_than_a_checkpoint_each) {
+  static uint32_t crc_at[SIM_IMAGE_SIZE / OBJECT_SIZE + 1];
+  uint32_t cuts[SIM_INTERRUPTIONS];
+  uint32_t state = SIM_SEED;
+  uint32_t offset = 0;
+  uint32_t retransmitted = 0;
+  uint32_t without_progress = 0;
+  uint32_t worst = 0;
+  uint32_t stores;
+
+  transfer_start();
+  stores = fake_flash.stores;
+
+  //the CRC the settings report after each object
+  for (uint32_t i = 1; i < ARRAY_SIZE(crc_at); i++) {
+    crc_at[i] = crc32_compute(&m_image[(i - 1) * OBJECT_SIZE], OBJECT_SIZE, (i == 1) ? NULL : &crc_at[i - 1]);
+  }
+
+  //in order, a quarter of them between two objects
+  for (uint32_t i = 0; i < SIM_INTERRUPTIONS; i++) {
+    uint32_t cut;
+    uint32_t j;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    cut = state % SIM_IMAGE_SIZE;
+
+    if ((state >> 30) == 0) {
+      cut -= cut % OBJECT_SIZE;
+    }
+
+    for (j = i; (j > 0) && (cuts[j - 1] > cut); j--) {
+      cuts[j] = cuts[j - 1];
+    }
+
+    cuts[j] = cut;
+  }
+
+  for (uint32_t i = 0; i < SIM_INTERRUPTIONS; i++) {
+    uint32_t cut = cuts[i];
+    uint32_t resumed;
+
+    transfer(offset, cut - cut % OBJECT_SIZE);
+    reboot();
+
+    resumed = s_dfu_settings.progress.firmware_image_offset_last;
+    CHECK(resumed <= cut);
+    CHECK(cut - resumed < NRF_DFU_PROGRESS_CHECKPOINT_SIZE + OBJECT_SIZE);
+    CHECK_EQ(resumed % OBJECT_SIZE, 0);
+    CHECK_EQ(s_dfu_settings.progress.firmware_image_crc_last, crc_at[resumed / OBJECT_SIZE]);
+    CHECK_EQ(s_dfu_settings.progress.command_size, 64);
+
+    retransmitted += cut - resumed;
+    without_progress += cut;
+    worst = MAX(worst, cut - resumed);
+    offset = resumed;
+  }
+
+  transfer(offset, SIM_IMAGE_SIZE);
+  CHECK_EQ(s_dfu_settings.progress.firmware_image_crc_last, crc_at[SIM_IMAGE_SIZE / OBJECT_SIZE]);
+
+  printf("%u resets during %u bytes, checkpoint every %u bytes: %u bytes retransmitted, %u per reset, at most %u, "
+         "%u without progress in flash\n",
+         SIM_INTERRUPTIONS, SIM_IMAGE_SIZE, NRF_DFU_PROGRESS_CHECKPOINT_SIZE, retransmitted,
+         retransmitted / SIM_INTERRUPTIONS, worst, without_progress);
+  printf("%u checkpoints and %u deferred progress writes, %u flash stores, %u compactions\n", stats().checkpoints,
+         stats().deferred, fake_flash.stores - stores, stats().compactions);
+
+  CHECK(retransmitted / SIM_INTERRUPTIONS < (NRF_DFU_PROGRESS_CHECKPOINT_SIZE + OBJECT_SIZE) * 3 / 4);
+  CHECK(retransmitted < without_progress / 10);
+}
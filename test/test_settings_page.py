@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""tools/settings_page.py against the reference pages of settings/.
+
+The reference pages were built from the SDK 15.3 layout, like the tool, not
+by nrfutil: matching them guards against regressions, the layout and CRCs
+are checked against the SDK headers by test_settings_reference.c. See
+Release Packaging in README.md. The batch throughput is printed.
+Run by make from test/.
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REFERENCE = os.path.join(HERE, 'settings')
+TOOL = os.path.join(HERE, '..', 'tools', 'settings_page.py')
+
+sys.path.insert(0, os.path.dirname(TOOL))
+import settings_page  # noqa: E402
+
+APP_VERSION = 3
+BOOTLOADER_VERSION = 100
+VALIDATION = {1: 'NO_VALIDATION', 2: 'VALIDATE_GENERATED_CRC'}
+BATCH_DEVICES = 5000
+
+
+def reference(name):
+    with open(os.path.join(REFERENCE, name)) as f:
+        return f.read()
+
+
+class SettingsPageTest(unittest.TestCase):
+
+    def setUp(self):
+        self.app = settings_page.Application(os.path.join(REFERENCE, 'app.hex'))
+
+    def page(self, version):
+        validation = settings_page.BOOT_VALIDATION[VALIDATION[version]]
+        return settings_page.build_settings(version, APP_VERSION, BOOTLOADER_VERSION, self.app, 0, validation)
+
+    def test_build_settings_reproduces_the_references(self):
+        for version in VALIDATION:
+            with self.subTest(version=version):
+                self.assertEqual(settings_page.settings_hex(self.page(version), False),
+                                 reference('settings_v%d.hex' % version))
+
+    def test_backup_repeats_the_page(self):
+        with tempfile.TemporaryDirectory() as out:
+            path = os.path.join(out, 'settings.hex')
+            with open(path, 'w') as f:
+                f.write(settings_page.settings_hex(self.page(2), True))
+            segments = settings_page.read_hex(path)
+        self.assertEqual(segments, {settings_page.BACKUP_ADDRESS: self.page(2),
+                                    settings_page.SETTINGS_ADDRESS: self.page(2)})
+
+    def test_generate_command_writes_the_references(self):
+        with tempfile.TemporaryDirectory() as out:
+            for version in VALIDATION:
+                path = os.path.join(out, 'settings_v%d.hex' % version)
+                subprocess.run([sys.executable, TOOL, 'generate', '--application', os.path.join(REFERENCE, 'app.hex'),
+                                '--application-version', str(APP_VERSION),
+                                '--bootloader-version', str(BOOTLOADER_VERSION),
+                                '--bl-settings-version', str(version),
+                                '--app-boot-validation', VALIDATION[version], '-o', path],
+                               check=True, stdout=subprocess.DEVNULL)
+                with open(path) as f:
+                    self.assertEqual(f.read(), reference('settings_v%d.hex' % version))
+
+    def test_batch_writes_thousands_of_pages_per_second(self):
+        with tempfile.TemporaryDirectory() as out:
+            devices = os.path.join(out, 'devices.csv')
+            with open(devices, 'w') as f:
+                f.write('name,application\n')
+                for i in range(BATCH_DEVICES):
+                    f.write('dev%04d,%s\n' % (i, os.path.join(REFERENCE, 'app.hex')))
+
+            # the process start and the CSV are counted, as on the line
+            start = time.time()
+            subprocess.run([sys.executable, TOOL, 'batch', devices, '-o', os.path.join(out, 'settings'),
+                            '--application-version', str(APP_VERSION),
+                            '--bootloader-version', str(BOOTLOADER_VERSION)],
+                           check=True, stdout=subprocess.DEVNULL)
+            rate = BATCH_DEVICES / (time.time() - start)
+            print('\n%d settings pages in one batch, %d per second' % (BATCH_DEVICES, rate))
+
+            self.assertEqual(len(os.listdir(os.path.join(out, 'settings'))), BATCH_DEVICES)
+            with open(os.path.join(out, 'settings', 'dev%04d.hex' % (BATCH_DEVICES - 1))) as f:
+                self.assertEqual(f.read(), reference('settings_v1.hex'))
+            self.assertGreater(rate, 1000)
+
+
+if __name__ == '__main__':
+    unittest.main()
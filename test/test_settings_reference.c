@@ -0,0 +1,157 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit.h"
+#include "fake.h"
+#include "nrf_error.h"
+#include "crc32.h"
+#include "nrf_dfu_settings.h"
+
+/*
+* The reference pages of settings/ against the settings layout and CRCs of
+* SDK 15.3, and the condensed nrf_dfu_settings_init() of the fakes. The same
+* pages are what tools/settings_page.py must reproduce (test_settings_page.py),
+* see Release Packaging in README.md. Run from test/, like make does.
+*/
+#define REFERENCE_DIR "settings/"
+
+#define APP_ADDRESS 0x1000
+#define APP_VERSION 3
+#define BOOTLOADER_VERSION 100
+
+#define V1_SIZE offsetof(nrf_dfu_settings_t, init_command)
+#define V2_SIZE (offsetof(nrf_dfu_settings_t, boot_validation_bootloader) + sizeof(boot_validation_t))
+
+ret_code_t __real_nrf_dfu_settings_init(bool sd_irq_initialized);
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  uint8_t data[FAKE_FLASH_PAGE_SIZE];
+} image_t;
+
+static uint32_t hex_byte(char const * p_text) {
+  char digits[3] = { p_text[0], p_text[1], 0 };
+
+  return strtoul(digits, NULL, 16);
+}
+
+/*
+* Reads an Intel HEX file holding one contiguous range of at most a page.
+*/
+static image_t hex_read(char const * p_path) {
+  image_t image = { 0 };
+  uint32_t base = 0;
+  char line[128];
+  FILE * p_file = fopen(p_path, "r");
+
+  CHECK(p_file != NULL);
+
+  while (fgets(line, sizeof(line), p_file) != NULL) {
+    uint32_t count = hex_byte(line + 1);
+    uint32_t offset = (hex_byte(line + 3) << 8) | hex_byte(line + 5);
+    uint32_t type = hex_byte(line + 7);
+    uint8_t sum = 0;
+
+    CHECK_EQ(line[0], ':');
+
+    for (uint32_t i = 0; i < count + 5; i++) {
+      sum += hex_byte(line + 1 + 2 * i);
+    }
+
+    CHECK_EQ(sum, 0);
+
+    if (type == 0x04) {
+      base = ((hex_byte(line + 9) << 8) | hex_byte(line + 11)) << 16;
+    } else if (type == 0x00) {
+      if (image.size == 0) {
+        image.address = base + offset;
+      }
+
+      CHECK_EQ(base + offset, image.address + image.size);
+      CHECK(image.size + count <= sizeof(image.data));
+
+      for (uint32_t i = 0; i < count; i++) {
+        image.data[image.size++] = hex_byte(line + 9 + 2 * i);
+      }
+    } else {
+      CHECK_EQ(type, 0x01);
+    }
+  }
+
+  fclose(p_file);
+  return image;
+}
+
+static uint32_t app_crc() {
+  image_t app = hex_read(REFERENCE_DIR "app.hex");
+
+  CHECK_EQ(app.address, APP_ADDRESS);
+  return crc32_compute(app.data, app.size, NULL);
+}
+
+/*
+* The settings the SDK keeps after the application of app.hex was
+* transferred, as the bootloader of the given settings version stores them.
+*/
+static nrf_dfu_settings_t expected(uint32_t settings_version) {
+  nrf_dfu_settings_t settings;
+  uint32_t crc = app_crc();
+
+  memset(&settings, 0, sizeof(settings));
+  settings.settings_version = settings_version;
+  settings.app_version = APP_VERSION;
+  settings.bootloader_version = BOOTLOADER_VERSION;
+  settings.bank_0.image_size = hex_read(REFERENCE_DIR "app.hex").size;
+  settings.bank_0.image_crc = crc;
+  settings.bank_0.bank_code = NRF_DFU_BANK_VALID_APP;
+
+  if (settings_version >= 2) {
+    settings.boot_validation_app.type = VALIDATE_CRC;
+    memcpy(settings.boot_validation_app.bytes, &crc, sizeof(crc));
+    settings.boot_validation_crc = crc32_compute((uint8_t const *)&settings.boot_validation_softdevice,
+                                                 3 * sizeof(boot_validation_t), NULL);
+  }
+
+  settings.crc = nrf_dfu_settings_crc_get(&settings);
+  return settings;
+}
+
+TEST(v1_reference_is_the_sdk_header) {
+  image_t page = hex_read(REFERENCE_DIR "settings_v1.hex");
+  nrf_dfu_settings_t settings = expected(1);
+
+  CHECK_EQ(page.address, BOOTLOADER_SETTINGS_ADDRESS);
+  CHECK_EQ(page.size, V1_SIZE);
+  CHECK_MEM(page.data, &settings, V1_SIZE);
+}
+
+TEST(v2_reference_adds_the_boot_validation) {
+  image_t page = hex_read(REFERENCE_DIR "settings_v2.hex");
+  nrf_dfu_settings_t settings = expected(2);
+  nrf_dfu_settings_t const * p_page = (nrf_dfu_settings_t const *)page.data;
+
+  CHECK_EQ(page.address, BOOTLOADER_SETTINGS_ADDRESS);
+  CHECK_EQ(page.size, V2_SIZE);
+  CHECK_MEM(page.data, &settings, V2_SIZE);
+  CHECK_EQ(p_page->boot_validation_app.type, VALIDATE_CRC);
+  CHECK_EQ(p_page->boot_validation_softdevice.type, NO_VALIDATION);
+}
+
+TEST(reference_pages_are_accepted_at_boot) {
+  char const * paths[] = { REFERENCE_DIR "settings_v1.hex", REFERENCE_DIR "settings_v2.hex" };
+
+  for (uint32_t i = 0; i < 2; i++) {
+    image_t page = hex_read(paths[i]);
+
+    fake_flash_fill(BOOTLOADER_SETTINGS_ADDRESS, 0xFF, FAKE_FLASH_PAGE_SIZE);
+    fake_flash_program(page.address, page.data, page.size);
+    fake_evt_count = 0;
+
+    CHECK_EQ(__real_nrf_dfu_settings_init(false), NRF_SUCCESS);
+    CHECK_EQ(s_dfu_settings.settings_version, i + 1);
+    CHECK_EQ(s_dfu_settings.bank_0.image_crc, app_crc());
+    CHECK_EQ(s_dfu_settings.bank_0.bank_code, NRF_DFU_BANK_VALID_APP);
+    CHECK_EQ(fake_evt_find_any(FAKE_EVT_FLASH_ERASE), -1);
+  }
+}
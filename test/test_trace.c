@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include "unit.h"
+#include "fake.h"
+#include "nrf52840.h"
+#include "trace.h"
+
+/*
+* The trace ring of trace.c. The host build cannot give the call sites their
+* IDs in .trace_fmt (the section only has offsets in the ELF32 file of the
+* target), so trace_write() is called with the offsets of the format strings
+* below. trace_ring_dump writes what tools/trace_decode.py needs for the
+* round trip of test_trace_decode.py to build/: the ring, the format
+* strings and the entries as printf() formats them, one per line.
+*/
+#define DUMP_RING "build/trace_ring.bin"
+#define DUMP_FORMATS "build/trace_fmt.bin"
+#define DUMP_EXPECTED "build/trace_expected.txt"
+
+#define DUMP_ENTRIES 200
+
+static const char formats[] = "Boot, reset reason 0x%08x\0"
+                              "copy_kdr returned %u\0"
+                              "DFU event %u\0"
+                              "Offset %d\0"
+                              "Starting application\0"
+                              "Error %u at line %u\0"
+                              "Fault 0x%08x at pc 0x%08x, info 0x%08x";
+
+#define FORMAT_COUNT 7
+
+static uint32_t format_id(uint32_t index) {
+  uint32_t id = 0;
+
+  for (uint32_t i = 0; i < index; i++) {
+    id += strlen(&formats[id]) + 1;
+  }
+
+  return id;
+}
+
+static void write_file(char const * p_path, void const * p_data, size_t size) {
+  FILE * p_file = fopen(p_path, "wb");
+
+  CHECK(p_file != NULL);
+  CHECK_EQ(fwrite(p_data, 1, size, p_file), size);
+  fclose(p_file);
+}
+
+TEST(trace_init_resets_a_ring_without_magic) {
+  memset(&trace_ring, 0x5A, sizeof(trace_ring));
+
+  trace_init();
+
+  CHECK_EQ(trace_ring.magic, TRACE_MAGIC);
+  CHECK_EQ(trace_ring.words, sizeof(trace_ring.data) / sizeof(uint32_t));
+  CHECK_EQ(trace_ring.head, 0);
+  CHECK(fake_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+}
+
+TEST(trace_init_keeps_the_entries_of_the_previous_boot) {
+  trace_init();
+  trace_write(format_id(4), 0);
+
+  trace_init();
+
+  CHECK_EQ(trace_ring.head, 2);
+  CHECK_EQ(trace_ring.data[0], TRACE_HEADER(format_id(4), 0));
+}
+
+TEST(trace_write_stores_header_cycles_and_arguments) {
+  trace_init();
+  fake_cycles_advance(1234);
+
+  trace_write(format_id(5), 2, 7, 99);
+
+  CHECK_EQ(trace_ring.head, 4);
+  CHECK_EQ(trace_ring.data[0], 0xA2000000 | format_id(5));
+  CHECK_EQ(trace_ring.data[1], 1234);
+  CHECK_EQ(trace_ring.data[2], 7);
+  CHECK_EQ(trace_ring.data[3], 99);
+}
+
+TEST(trace_write_keeps_at_most_four_arguments) {
+  trace_init();
+
+  trace_write(format_id(6), 5, 1, 2, 3, 4, 5);
+
+  CHECK_EQ(trace_ring.head, 2 + TRACE_MAX_ARGS);
+  CHECK_EQ(trace_ring.data[0] >> 24, 0xA4);
+}
+
+TEST(trace_write_does_nothing_before_trace_init) {
+  trace_write(format_id(4), 0);
+
+  CHECK_EQ(trace_ring.head, 0);
+}
+
+TEST(trace_ring_dump) {
+  FILE * p_expected = fopen(DUMP_EXPECTED, "w");
+
+  CHECK(p_expected != NULL);
+  trace_init();
+
+  //enough entries to wrap the ring several times
+  for (uint32_t i = 0; i < DUMP_ENTRIES; i++) {
+    uint32_t index = i % FORMAT_COUNT;
+    char const * p_format = &formats[format_id(index)];
+    uint32_t a = i * 0x01010101;
+    uint32_t b = i * 3;
+    uint32_t c = 0x20000000 + i;
+
+    fake_cycles_advance(100 + i);
+    fprintf(p_expected, "%u ", fake_dwt.CYCCNT);
+
+    switch (index) {
+      case 0:
+      case 1:
+      case 2:
+        trace_write(format_id(index), 1, a);
+        fprintf(p_expected, p_format, a);
+        break;
+      case 3:
+        //negative for %d
+        trace_write(format_id(index), 1, -(int32_t)b);
+        fprintf(p_expected, p_format, -(int32_t)b);
+        break;
+      case 4:
+        trace_write(format_id(index), 0);
+        fputs(p_format, p_expected);
+        break;
+      case 5:
+        trace_write(format_id(index), 2, a, b);
+        fprintf(p_expected, p_format, a, b);
+        break;
+      default:
+        trace_write(format_id(index), 3, a, b, c);
+        fprintf(p_expected, p_format, a, b, c);
+        break;
+    }
+
+    fputc('\n', p_expected);
+  }
+
+  fclose(p_expected);
+  CHECK(trace_ring.head > 2 * trace_ring.words);
+
+  write_file(DUMP_RING, &trace_ring, sizeof(trace_ring));
+  write_file(DUMP_FORMATS, formats, sizeof(formats));
+}
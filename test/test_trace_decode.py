@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""tools/trace_decode.py against the ring trace.c writes on the host.
+
+test_trace.c (case trace_ring_dump) fills the ring, wrapping it, and writes
+the ring, its format strings and the entries as printf() formats them to
+build/. The format strings are wrapped into an ELF32 file with a .trace_fmt
+section like the bootloader's. Run by make from test/.
+"""
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BUILD = os.path.join(HERE, 'build')
+
+sys.path.insert(0, os.path.join(HERE, '..', 'tools'))
+import trace_decode  # noqa: E402
+
+
+def elf32(sections):
+    """A little endian ELF32 file with the given (name, data) sections only."""
+    names = b'\0' + b''.join(name + b'\0' for name, _ in sections) + b'.shstrtab\0'
+    body = b''.join(data for _, data in sections) + names
+    shoff = 0x34 + len(body)
+    header = b'\x7fELF\x01\x01\x01' + bytes(9)
+    header += struct.pack('<HHIIIIIHHHHHH', 2, 40, 1, 0, 0, shoff, 0, 0x34, 0, 0, 40, len(sections) + 2,
+                          len(sections) + 1)
+    headers = bytes(40)
+    offset, name = 0x34, 1
+    for section_name, data in sections:
+        headers += struct.pack('<IIIIIIIIII', name, 1, 0, 0, offset, len(data), 0, 0, 1, 0)
+        offset += len(data)
+        name += len(section_name) + 1
+    headers += struct.pack('<IIIIIIIIII', name, 3, 0, 0, offset, len(names), 0, 0, 1, 0)
+    return header + body + headers
+
+
+class TraceDecodeTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        subprocess.run([os.path.join(BUILD, 'test_trace'), 'trace_ring_dump'], cwd=HERE, check=True,
+                       stdout=subprocess.DEVNULL)
+        with open(os.path.join(BUILD, 'trace_fmt.bin'), 'rb') as f:
+            cls.formats = f.read()
+        with open(os.path.join(BUILD, 'trace_expected.txt')) as f:
+            cls.expected = [line.split(' ', 1) for line in f.read().splitlines()]
+
+    def decode(self, elf, ring):
+        with tempfile.TemporaryDirectory() as out:
+            path = os.path.join(out, 'bootloader.out')
+            with open(path, 'wb') as f:
+                f.write(elf)
+            strings = trace_decode.read_format_strings(path)
+        return trace_decode.decode(strings, ring)
+
+    def test_decodes_the_entries_left_in_the_ring(self):
+        ring = trace_decode.read_ring(os.path.join(BUILD, 'trace_ring.bin'))
+        entries = self.decode(elf32([(b'.text', bytes(16)), (b'.trace_fmt', self.formats)]), ring)
+
+        # the ring wrapped, the newest entries are all there and the oldest one at most is cut
+        self.assertGreater(len(entries), 40)
+        self.assertEqual([[str(cycles), text] for cycles, text in entries], self.expected[-len(entries):])
+
+    def test_reads_the_nrfjprog_output(self):
+        with open(os.path.join(BUILD, 'trace_ring.bin'), 'rb') as f:
+            raw = f.read()
+        words = struct.unpack('<%dI' % (len(raw) // 4), raw)
+        text = ''.join('0x%08X: %s\n' % (trace_decode.TRACE_ADDRESS + 16 * i,
+                                         ' '.join('%08X' % w for w in words[4 * i:4 * i + 4]))
+                       for i in range(len(words) // 4))
+        with tempfile.TemporaryDirectory() as out:
+            path = os.path.join(out, 'trace.txt')
+            with open(path, 'w') as f:
+                f.write(text)
+            self.assertEqual(trace_decode.read_ring(path), raw)
+
+    def test_rejects_an_elf_file_without_formats(self):
+        with self.assertRaises(trace_decode.TraceError):
+            self.decode(elf32([(b'.text', bytes(16))]), bytes(trace_decode.TRACE_SIZE))
+
+
+if __name__ == '__main__':
+    unittest.main()
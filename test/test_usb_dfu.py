@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""tools/usb_dfu.py replayed against its model of the bootloader.
+
+A 200 kB image is sent with the adaptive and the fixed PRN intervals through
+SimulatedTransport. The model writes flash at 41 us per word and erases a
+page in 85 ms when a data object is created, the host takes the turnaround
+for every response it reads. The table of every configuration is printed.
+
+The NVMC stall model compares the adaptive PRN with the USB interrupt in RAM
+(RAMFUNC_ENABLED) to the interrupt halted by every page erase and prints the
+throughput gained.
+Run by make from test/.
+"""
+
+import os
+import random
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+sys.path.insert(0, os.path.join(HERE, '..', 'tools'))
+import usb_dfu  # noqa: E402
+
+IMAGE_SIZE = 200 * 1024
+FIXED = (1, 2, 4, 8, 16, 0)
+
+# (name, device parameters), the first one is the bulk interface as configured in sdk_config.h
+CONFIGURATIONS = (
+    ('bulk, 4 kB MTU', dict()),
+    ('512 B MTU', dict(mtu=512)),
+    ('128 B MTU', dict(mtu=128)),
+    ('512 B MTU, 1 buffer', dict(mtu=512, rx_buffers=1)),
+    ('512 B MTU, fast flash', dict(mtu=512, flash_rate=1.0, erase_us=0)),
+)
+
+# the buffers drain during a 4 ms turnaround after the status of the notification was taken
+SHORT_BACKLOG = ((4000, '128 B MTU'), (4000, '512 B MTU, 1 buffer'))
+
+# a host that polls the bus at a tenth of full speed, e.g. behind a busy hub
+SLOW_BUS = ('bulk, 100 kB/s bus', dict(usb_rate=0.1))
+
+
+class ReplayTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        rng = random.Random(0x5EED)
+        cls.init_packet = bytes(rng.getrandbits(8) for _ in range(141))
+        cls.firmware = bytes(rng.getrandbits(8) for _ in range(IMAGE_SIZE))
+        cls.results = {}
+        print()
+        for turnaround in (1000, 4000):
+            for name, device in CONFIGURATIONS:
+                results = usb_dfu.benchmark(cls.init_packet, cls.firmware, (None,) + FIXED,
+                                            turnaround_us=turnaround, **device)
+                cls.results[turnaround, name] = results
+                print('%-22s %d ms  ' % (name, turnaround // 1000) + '  '.join(
+                    '%s %5.1f' % ('adaptive' if prn is None else 'PRN %d' % prn, cls.rate(elapsed))
+                    for prn, elapsed, _notifications, _final in results) + '  kB/s')
+
+    @classmethod
+    def rate(cls, elapsed):
+        return len(cls.firmware) / elapsed / 1024
+
+    def adaptive_and_best(self, turnaround, name):
+        adaptive, *fixed = self.results[turnaround, name]
+        return adaptive, min(fixed, key=lambda result: result[1])
+
+    def test_prn_does_not_matter_with_two_writes_per_object(self):
+        # 2 kB writes into 4 kB objects, the CRC and execute of every object already synchronize
+        for turnaround in (1000, 4000):
+            rates = {round(self.rate(elapsed), 1) for _, elapsed, _, _ in self.results[turnaround, 'bulk, 4 kB MTU']}
+
+            self.assertEqual(len(rates), 1)
+
+    def test_steady_state_is_flash_bound(self):
+        _, best = self.adaptive_and_best(1000, '512 B MTU')
+        # 4 kB in 85 ms of erase and 42 ms of writes
+        self.assertAlmostEqual(self.rate(best[1]), 4096 / 0.127 / 1024, delta=1.0)
+
+    def test_adaptive_is_within_5_percent_of_the_best_fixed_interval(self):
+        for turnaround, name in self.results:
+            if (turnaround, name) in SHORT_BACKLOG:
+                continue
+            adaptive, best = self.adaptive_and_best(turnaround, name)
+
+            self.assertGreaterEqual(best[1] / adaptive[1], 0.95, (turnaround, name))
+
+    def test_adaptive_sends_fewer_notifications_than_prn_1(self):
+        for key, results in self.results.items():
+            adaptive = results[0]
+            prn_1 = results[1 + FIXED.index(1)]
+
+            self.assertLessEqual(adaptive[2], prn_1[2] // 4, key)
+
+    def test_status_at_receipt_cannot_see_a_short_backlog(self):
+        for turnaround, name in SHORT_BACKLOG:
+            adaptive, best = self.adaptive_and_best(turnaround, name)
+
+            self.assertLess(best[1] / adaptive[1], 0.95, (turnaround, name))
+
+    def test_ramfunc_gains_the_bus_time_of_the_writes_during_erases(self):
+        print()
+        for name, device in CONFIGURATIONS + (SLOW_BUS,):
+            for turnaround in (1000, 4000):
+                (_, in_ram, _, _), = usb_dfu.benchmark(self.init_packet, self.firmware, (None,),
+                                                       turnaround_us=turnaround, **device)
+                (_, stalled, _, _), = usb_dfu.benchmark(self.init_packet, self.firmware, (None,),
+                                                        turnaround_us=turnaround, stall=True, **device)
+                gain = stalled / in_ram - 1
+                print('%-22s %d ms  stalled %5.1f  RAM %5.1f kB/s  +%4.1f %%' %
+                      (name, turnaround // 1000, self.rate(stalled), self.rate(in_ram), 100 * gain))
+
+                # a flash bound transfer only gets back the bus time of the writes sent during an erase
+                self.assertGreaterEqual(gain, 0.0, (name, turnaround))
+                if (name, device) == SLOW_BUS:
+                    self.assertGreater(gain, 0.10, turnaround)
+                elif 'erase_us' in device:
+                    self.assertEqual(gain, 0.0, (name, turnaround))
+                else:
+                    self.assertLess(gain, 0.05, (name, turnaround))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,167 @@
+#include "unit.h"
+#include "fake.h"
+#include "nrf52840.h"
+#include "app_usbd.h"
+#include "usb_event_queue.h"
+
+/*
+* The dispatcher of usb_event_queue.c between the app_usbd queue and the
+* scheduler of the fakes, with the latency statistics of the default
+* configuration (USB_EVENT_LATENCY_STATS_ENABLED).
+*/
+#define SIM_STEPS 20000
+#define SIM_SEED 0x2545F491
+
+static usb_evt_latency_t latency(usb_evt_type_t type) {
+  usb_evt_latency_t result;
+
+  usb_event_queue_latency_get(type, &result);
+  return result;
+}
+
+static void raise_during_processing() {
+  static bool raised;
+
+  if (!raised) {
+    raised = true;
+    fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  }
+}
+
+TEST(usb_event_queue_schedules_one_drain_per_burst) {
+  usb_event_queue_init();
+
+  for (uint32_t i = 0; i < 5; i++) {
+    fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  }
+
+  CHECK_EQ(fake_usbd.sched_puts, 1);
+  CHECK_EQ(fake_usbd_sched_run(), 1);
+  CHECK_EQ(fake_usbd.processed, 5);
+}
+
+TEST(usb_event_queue_drains_an_event_raised_while_draining) {
+  usb_event_queue_init();
+  fake_usbd.process_handler = raise_during_processing;
+
+  fake_usbd_event(APP_USBD_EVT_DRV_SETUP);
+  fake_usbd_sched_run();
+
+  //the second drain finds the queue empty
+  CHECK_EQ(fake_usbd.processed, 2);
+  CHECK_EQ(fake_usbd.sched_puts, 2);
+}
+
+TEST(usb_event_queue_retries_a_failed_schedule_on_the_next_event) {
+  usb_event_queue_init();
+  fake_usbd.sched_full = true;
+
+  fake_usbd_event(APP_USBD_EVT_DRV_SETUP);
+  CHECK_EQ(fake_usbd_sched_run(), 0);
+
+  fake_usbd.sched_full = false;
+  fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  CHECK_EQ(fake_usbd_sched_run(), 1);
+
+  CHECK_EQ(fake_usbd.processed, 2);
+}
+
+static uint32_t m_nested_processed;
+
+//what a page erase slice does when it is reached from an event handler
+static void process_from_handler() {
+  uint32_t processed = fake_usbd.processed;
+
+  usb_event_queue_process();
+  m_nested_processed += fake_usbd.processed - processed;
+}
+
+TEST(usb_event_queue_process_does_not_recurse) {
+  usb_event_queue_init();
+  fake_usbd.process_handler = process_from_handler;
+
+  fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  usb_event_queue_process();
+
+  CHECK_EQ(fake_usbd.processed, 2);
+  CHECK_EQ(m_nested_processed, 0);
+}
+
+/*
+* A SOF without a stamp would hand its own latency to the transfer behind it.
+*/
+TEST(usb_event_queue_stamps_sof_events_as_other) {
+  usb_event_queue_init();
+
+  fake_usbd_event(APP_USBD_EVT_DRV_SOF);
+  fake_cycles_advance(100000);
+  fake_usbd_event(APP_USBD_EVT_DRV_EPTRANSFER);
+  fake_cycles_advance(300);
+  fake_usbd_sched_run();
+
+  CHECK_EQ(latency(USB_EVT_TYPE_OTHER).count, 1);
+  CHECK_EQ(latency(USB_EVT_TYPE_OTHER).cycles_max, 100300);
+  CHECK_EQ(latency(USB_EVT_TYPE_TRANSFER).count, 1);
+  CHECK_EQ(latency(USB_EVT_TYPE_TRANSFER).cycles_max, 300);
+  CHECK_EQ(latency(USB_EVT_TYPE_TRANSFER).buckets[1], 1);
+}
+
+/*
+* A seeded stream of bus traffic: a SOF every 64000 cycles (1 ms), bursts of
+* transfers and setup packets and the odd bus event, with the scheduler
+* running at random times. Every queued event is processed once and
+* accounted under its own type.
+*/
+TEST(usb_event_queue_accounts_a_simulated_event_stream) {
+  static const app_usbd_event_type_t events[] = {
+    APP_USBD_EVT_DRV_EPTRANSFER, APP_USBD_EVT_DRV_EPTRANSFER, APP_USBD_EVT_DRV_EPTRANSFER,
+    APP_USBD_EVT_DRV_SETUP, APP_USBD_EVT_DRV_SUSPEND, APP_USBD_EVT_DRV_RESUME
+  };
+  static const usb_evt_type_t types[] = {
+    USB_EVT_TYPE_TRANSFER, USB_EVT_TYPE_TRANSFER, USB_EVT_TYPE_TRANSFER,
+    USB_EVT_TYPE_SETUP, USB_EVT_TYPE_BUS, USB_EVT_TYPE_BUS
+  };
+  uint32_t expected[USB_EVT_TYPE_COUNT] = { 0 };
+  uint32_t state = SIM_SEED;
+  uint32_t next_sof = 0;
+  uint32_t total = 0;
+
+  usb_event_queue_init();
+  fake_usbd.process_cycles = 200;
+
+  for (uint32_t step = 0; step < SIM_STEPS; step++) {
+    uint32_t dropped = fake_usbd.dropped;
+    uint32_t pick;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    pick = state % 16;
+
+    if (fake_dwt.CYCCNT >= next_sof) {
+      next_sof += FAKE_CYCLES_PER_MS;
+      fake_usbd_event(APP_USBD_EVT_DRV_SOF);
+      expected[USB_EVT_TYPE_OTHER] += (fake_usbd.dropped == dropped);
+    } else if (pick < 6) {
+      fake_usbd_event(events[pick]);
+      expected[types[pick]] += (fake_usbd.dropped == dropped);
+    } else if (pick < 9) {
+      fake_usbd_sched_run();
+    } else {
+      fake_cycles_advance((state >> 8) % 4000);
+    }
+  }
+
+  fake_usbd_sched_run();
+
+  CHECK_EQ(fake_usbd.processed, fake_usbd.queued);
+
+  for (uint32_t type = 0; type < USB_EVT_TYPE_COUNT; type++) {
+    CHECK_EQ(latency((usb_evt_type_t)type).count, expected[type]);
+    total += expected[type];
+  }
+
+  CHECK_EQ(total, fake_usbd.queued);
+  CHECK(expected[USB_EVT_TYPE_OTHER] > 0);
+}
@@ -0,0 +1,117 @@
+#include "unit.h"
+#include "fake.h"
+#include "nrf.h"
+#include "nrf_nvmc.h"
+#include "nvmc_erase.h"
+#include "wdt_feed.h"
+
+#define WDT_PERIOD_MS 100
+#define PAGE 0x80000
+#define PAGES 8
+
+void __real_nrf_nvmc_page_erase(uint32_t address);
+void app_sched_execute(void);
+
+static uint32_t m_handler_ms;
+
+static void sched_handler() {
+  fake_cycles_advance(m_handler_ms * FAKE_CYCLES_PER_MS);
+}
+
+static wdt_feed_stats_t stats() {
+  wdt_feed_stats_t stats;
+
+  wdt_feed_stats_get(&stats);
+  return stats;
+}
+
+/*
+* The application left the watchdog running on channel 0 and the cycle
+* counter running as well.
+*/
+static void start() {
+  fake_cycles_advance(12345 * FAKE_CYCLES_PER_MS);
+  fake_wdt_start(WDT_PERIOD_MS, 0x1);
+  wdt_feed_init();
+}
+
+TEST(sliced_erases_keep_the_watchdog_fed) {
+  start();
+
+  for (uint32_t i = 0; i < PAGES; i++) {
+    nrf_nvmc_page_erase(PAGE + i * FAKE_FLASH_PAGE_SIZE);
+  }
+
+  //the erases took 7 times the watchdog period
+  CHECK_EQ(fake_wdt.timeouts, 0);
+  CHECK_EQ(fake_wdt.feeds, PAGES * 9);
+  CHECK_EQ(stats().feeds, PAGES * 9);
+  CHECK_EQ(stats().gap_max_ms, NVMC_PARTIAL_ERASE_SLICE_MS);
+  CHECK_EQ(stats().over_budget, 0);
+}
+
+TEST(full_erases_starve_the_watchdog) {
+  start();
+
+  for (uint32_t i = 0; i < PAGES; i++) {
+    __real_nrf_nvmc_page_erase(PAGE + i * FAKE_FLASH_PAGE_SIZE);
+  }
+
+  CHECK(fake_wdt.timeouts > 0);
+  CHECK(fake_evt_find_any(FAKE_EVT_WDT_TIMEOUT) >= 0);
+  CHECK_EQ(fake_wdt.feeds, 0);
+}
+
+TEST(feed_point_only_reloads_enabled_channels) {
+  fake_wdt_start(WDT_PERIOD_MS, 0);
+  wdt_feed_init();
+
+  wdt_feed_point();
+  fake_cycles_advance(2 * WDT_PERIOD_MS * FAKE_CYCLES_PER_MS);
+
+  CHECK_EQ(fake_wdt.feeds, 0);
+  CHECK_EQ(fake_wdt.timeouts, 1);
+}
+
+TEST(feed_point_without_a_watchdog_only_marks) {
+  wdt_feed_init();
+
+  fake_cycles_advance(250 * FAKE_CYCLES_PER_MS);
+  wdt_feed_point();
+
+  CHECK_EQ(stats().feeds, 0);
+  CHECK_EQ(stats().gap_max_ms, 250);
+  CHECK_EQ(stats().over_budget, 1);
+}
+
+TEST(scheduler_run_is_a_gap_and_the_wait_before_it_is_not) {
+  start();
+  fake_boot.sched_handler = sched_handler;
+
+  //idle in the main loop, then a long scheduler run
+  fake_cycles_advance(500 * FAKE_CYCLES_PER_MS);
+  m_handler_ms = 30;
+  app_sched_execute();
+
+  CHECK_EQ(stats().gap_max_ms, 30);
+  CHECK_EQ(stats().over_budget, 0);
+
+  m_handler_ms = WDT_FEED_GAP_BUDGET_MS + 10;
+  app_sched_execute();
+
+  CHECK_EQ(stats().gap_max_ms, WDT_FEED_GAP_BUDGET_MS + 10);
+  CHECK_EQ(stats().over_budget, 1);
+}
+
+TEST(cycle_counter_is_not_reset) {
+  uint32_t before;
+
+  fake_cycles_advance(777);
+  before = fake_dwt.CYCCNT;
+
+  wdt_feed_init();
+
+  CHECK_EQ(fake_dwt.CYCCNT, before);
+  CHECK(fake_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+  CHECK(fake_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+}
@@ -0,0 +1,131 @@
+#include <stdarg.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "unit.h"
+
+#define UNIT_MAX_TESTS 256
+
+typedef struct {
+  char const * name;
+  unit_test_t test;
+} unit_case_t;
+
+static unit_case_t m_cases[UNIT_MAX_TESTS];
+static uint32_t m_count;
+
+void unit_register(char const * name, unit_test_t test) {
+  if (m_count == UNIT_MAX_TESTS) {
+    fprintf(stderr, "too many tests, raise UNIT_MAX_TESTS\n");
+    exit(2);
+  }
+
+  m_cases[m_count].name = name;
+  m_cases[m_count].test = test;
+  m_count++;
+}
+
+/*
+* Runs in the child of the failing case. exit() rather than _exit() so the
+* coverage counters are written.
+*/
+void unit_fail(char const * file, int line, char const * fmt, ...) {
+  va_list args;
+
+  fprintf(stderr, "%s:%d: ", file, line);
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+
+  exit(1);
+}
+
+static double now_ms() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/*
+* Returns NULL if the case passed, the reason otherwise.
+*/
+static char const * case_run(unit_case_t const * p_case) {
+  static char reason[64];
+  int status;
+  pid_t pid;
+
+  fflush(stdout);
+  fflush(stderr);
+  pid = fork();
+
+  if (pid < 0) {
+    return "fork failed";
+  }
+
+  if (pid == 0) {
+    alarm(UNIT_TIMEOUT_S);
+    p_case->test();
+    exit(0);
+  }
+
+  if (waitpid(pid, &status, 0) != pid) {
+    return "wait failed";
+  }
+
+  if (WIFEXITED(status)) {
+    return (WEXITSTATUS(status) == 0) ? NULL : "failed";
+  }
+
+  if (WTERMSIG(status) == SIGALRM) {
+    snprintf(reason, sizeof(reason), "timeout after %d s", UNIT_TIMEOUT_S);
+  } else {
+    snprintf(reason, sizeof(reason), "killed by signal %d", WTERMSIG(status));
+  }
+
+  return reason;
+}
+
+/*
+* Runs every registered case, or those whose name contains argv[1].
+*/
+int main(int argc, char ** argv) {
+  char const * filter = (argc > 1) ? argv[1] : NULL;
+  char const * program = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+  uint32_t passed = 0;
+  uint32_t failed = 0;
+  double total = 0;
+
+  for (uint32_t i = 0; i < m_count; i++) {
+    char const * reason;
+    double start;
+    double elapsed;
+
+    if ((filter != NULL) && (strstr(m_cases[i].name, filter) == NULL)) {
+      continue;
+    }
+
+    start = now_ms();
+    reason = case_run(&m_cases[i]);
+    elapsed = now_ms() - start;
+    total += elapsed;
+
+    printf("%-4s %9.3f ms  %s: %s%s%s\n", reason ? "FAIL" : "ok", elapsed, program, m_cases[i].name,
+           reason ? ", " : "", reason ? reason : "");
+
+    if (reason) {
+      failed++;
+    } else {
+      passed++;
+    }
+  }
+
+  printf("%s: %u passed, %u failed in %.3f ms\n", program, passed, failed, total);
+
+  return (failed == 0) ? 0 : 1;
+}
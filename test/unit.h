@@ -0,0 +1,57 @@
+#ifndef __UNIT_H__
+#define __UNIT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+* Minimal host test framework. TEST() registers a case, the runner (unit.c)
+* forks a child for every case so a failed check, a sanitizer report or a
+* hang only fails that case and every case starts from the initial state of
+* the statics, the fake peripherals and the fake flash. Each case is given
+* UNIT_TIMEOUT_S seconds and its run time is printed.
+*
+*   TEST(copy_kdr_loads_the_provisioned_key) {
+*     CHECK_EQ(copy_kdr(), NRF_SUCCESS);
+*   }
+*/
+#define UNIT_TIMEOUT_S 10
+
+typedef void (*unit_test_t)(void);
+
+void unit_register(char const * name, unit_test_t test);
+void unit_fail(char const * file, int line, char const * fmt, ...) __attribute__((noreturn, format(printf, 3, 4)));
+
+#define TEST(name)                                                                   \
+  static void name(void);                                                            \
+  __attribute__((constructor)) static void name##_register(void) {                   \
+    unit_register(#name, name);                                                      \
+  }                                                                                  \
+  static void name(void)
+
+#define CHECK(cond)                                                                  \
+  do {                                                                               \
+    if (!(cond)) {                                                                   \
+      unit_fail(__FILE__, __LINE__, "%s", #cond);                                    \
+    }                                                                                \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                   \
+  do {                                                                               \
+    unsigned long long const _actual = (unsigned long long)(actual);                 \
+    unsigned long long const _expected = (unsigned long long)(expected);             \
+    if (_actual != _expected) {                                                      \
+      unit_fail(__FILE__, __LINE__, "%s is 0x%llx, expected %s (0x%llx)",            \
+                #actual, _actual, #expected, _expected);                             \
+    }                                                                                \
+  } while (0)
+
+#define CHECK_MEM(actual, expected, size)                                            \
+  do {                                                                               \
+    if (memcmp((actual), (expected), (size)) != 0) {                                 \
+      unit_fail(__FILE__, __LINE__, "%s differs from %s", #actual, #expected);       \
+    }                                                                                \
+  } while (0)
+
+#endif
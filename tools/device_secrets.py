@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""Build and validate images of the device secrets page (0x000E0000).
+
+The layout mirrors include/device_secrets.h:
+
+    flag | crc | magic | version | size | slots[16] {offset, length} | data
+
+The crc is a standard CRC-32 over the page from magic up to size bytes.
+
+    device_secrets.py build --root-key 00112233445566778899aabbccddeeff \\
+        --certificate device.der -o secrets.hex
+    device_secrets.py build --generate --certificate device.der -o secrets.hex
+    device_secrets.py validate secrets.hex
+
+Program the result after the bootloader with
+`nrfjprog -f nrf52 --program secrets.hex --sectorerase`. The page is directly
+below the bootloader, pass --address when the bootloader is built with a
+different BOOTLOADER_SIZE.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+DEVICE_SECRETS_ADDRESS = 0x000E0000  # MEMORY_DEVICE_SECRETS_ADDRESS in include/memory_layout.h
+DEVICE_SECRETS_PAGE_SIZE = 0x1000
+
+ALREADY_WRITTEN = 0x00000001
+GENERATE_AND_WRITE = 0x00000002
+
+DEVICE_SECRETS_MAGIC = 0x43455344
+DEVICE_SECRETS_VERSION = 1
+DEVICE_SECRETS_MAX_SLOTS = 16
+
+HEADER_FORMAT = '<IIIHH'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT) + DEVICE_SECRETS_MAX_SLOTS * 4
+CRC_START = 8
+
+SECRET_ROOT_KEY = 0
+SECRET_DEVICE_ID = 1
+SECRET_ATTESTATION_SEED = 2
+SECRET_PROVISIONING_DATA = 3
+SECRET_CERTIFICATE = 4
+
+SLOT_NAMES = {
+    SECRET_ROOT_KEY: 'root key',
+    SECRET_DEVICE_ID: 'device id',
+    SECRET_ATTESTATION_SEED: 'attestation seed',
+    SECRET_PROVISIONING_DATA: 'provisioning data',
+    SECRET_CERTIFICATE: 'certificate',
+}
+
+# Slots filled in by the bootloader when the flag is GENERATE_AND_WRITE.
+GENERATED_SLOTS = {
+    SECRET_ROOT_KEY: 16,
+    SECRET_DEVICE_ID: 16,
+    SECRET_ATTESTATION_SEED: 32,
+}
+
+
+def align4(value):
+    return (value + 3) & ~3
+
+
+def build_page(flag, slots):
+    """slots maps slot number to bytes; None reserves an erased slot."""
+    entries = [(0, 0)] * DEVICE_SECRETS_MAX_SLOTS
+    data = bytearray()
+    offset = HEADER_SIZE
+
+    for slot in sorted(slots):
+        content = slots[slot]
+        if content is None:
+            content = b'\xff' * GENERATED_SLOTS[slot]
+        if len(content) == 0 or len(content) > 0xFFFF:
+            raise ValueError('invalid size for slot %d' % slot)
+        entries[slot] = (offset, len(content))
+        padded = content + b'\xff' * (align4(len(content)) - len(content))
+        data += padded
+        offset += len(padded)
+
+    if offset > DEVICE_SECRETS_PAGE_SIZE:
+        raise ValueError('secrets do not fit in the page (%d bytes)' % offset)
+
+    table = b''.join(struct.pack('<HH', *entry) for entry in entries)
+    body = struct.pack('<IHH', DEVICE_SECRETS_MAGIC, DEVICE_SECRETS_VERSION, offset) + table + bytes(data)
+    crc = zlib.crc32(body) & 0xFFFFFFFF
+    return struct.pack('<II', flag, crc) + body
+
+
+def validate_page(page):
+    """Returns (flag, slots) or raises ValueError, same checks as the bootloader."""
+    if len(page) < HEADER_SIZE:
+        raise ValueError('page is shorter than the header')
+
+    flag, crc, magic, version, size = struct.unpack_from(HEADER_FORMAT, page, 0)
+
+    if flag not in (ALREADY_WRITTEN, GENERATE_AND_WRITE):
+        raise ValueError('unknown flag 0x%08x' % flag)
+    if magic != DEVICE_SECRETS_MAGIC or version != DEVICE_SECRETS_VERSION:
+        raise ValueError('no slot table (magic 0x%08x, version %d)' % (magic, version))
+    if size < HEADER_SIZE or size > DEVICE_SECRETS_PAGE_SIZE or size % 4:
+        raise ValueError('invalid size %d' % size)
+    if size > len(page):
+        raise ValueError('image is truncated (%d of %d bytes)' % (len(page), size))
+
+    slots = {}
+    for slot in range(DEVICE_SECRETS_MAX_SLOTS):
+        offset, length = struct.unpack_from('<HH', page, struct.calcsize(HEADER_FORMAT) + slot * 4)
+        if length == 0:
+            continue
+        if offset < HEADER_SIZE or offset % 4 or offset + length > size:
+            raise ValueError('slot %d is out of bounds (offset %d, length %d)' % (slot, offset, length))
+        slots[slot] = (offset, length)
+
+    if crc != zlib.crc32(page[CRC_START:size]) & 0xFFFFFFFF:
+        raise ValueError('crc mismatch')
+
+    if slots.get(SECRET_ROOT_KEY, (0, 0))[1] != 16:
+        raise ValueError('root key slot must be 16 bytes')
+
+    return flag, slots
+
+
+def write_hex(path, address, data):
+    def record(rtype, addr, payload):
+        raw = bytes([len(payload), (addr >> 8) & 0xFF, addr & 0xFF, rtype]) + payload
+        return ':%s%02X\n' % (raw.hex().upper(), (-sum(raw)) & 0xFF)
+
+    with open(path, 'w') as f:
+        upper = None
+        for index in range(0, len(data), 16):
+            addr = address + index
+            if addr >> 16 != upper:
+                upper = addr >> 16
+                f.write(record(0x04, 0, struct.pack('>H', upper)))
+            f.write(record(0x00, addr & 0xFFFF, data[index:index + 16]))
+        f.write(record(0x01, 0, b''))
+
+
+def read_hex(path, address):
+    memory = {}
+    upper = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            raw = bytes.fromhex(line[1:])
+            if sum(raw) & 0xFF:
+                raise ValueError('bad checksum in %s' % line)
+            length, addr, rtype = raw[0], (raw[1] << 8) | raw[2], raw[3]
+            payload = raw[4:4 + length]
+            if rtype == 0x00:
+                for i, byte in enumerate(payload):
+                    memory[upper + addr + i] = byte
+            elif rtype == 0x04:
+                upper = struct.unpack('>H', payload)[0] << 16
+            elif rtype == 0x01:
+                break
+
+    page = bytearray(b'\xff' * DEVICE_SECRETS_PAGE_SIZE)
+    for addr, byte in memory.items():
+        if address <= addr < address + DEVICE_SECRETS_PAGE_SIZE:
+            page[addr - address] = byte
+    return bytes(page)
+
+
+def read_file(path):
+    with open(path, 'rb') as f:
+        return f.read()
+
+
+def cmd_build(args):
+    slots = {}
+
+    if args.generate:
+        flag = GENERATE_AND_WRITE
+        if args.root_key or args.device_id or args.attestation_seed:
+            sys.exit('error: --generate cannot be combined with explicit secrets')
+        slots.update({slot: None for slot in GENERATED_SLOTS})
+    else:
+        flag = ALREADY_WRITTEN
+        if not args.root_key:
+            sys.exit('error: --root-key is required unless --generate is given')
+        slots[SECRET_ROOT_KEY] = bytes.fromhex(args.root_key)
+        if len(slots[SECRET_ROOT_KEY]) != 16:
+            sys.exit('error: the root key must be 16 bytes')
+        if args.device_id:
+            slots[SECRET_DEVICE_ID] = bytes.fromhex(args.device_id)
+        if args.attestation_seed:
+            slots[SECRET_ATTESTATION_SEED] = bytes.fromhex(args.attestation_seed)
+
+    if args.provisioning_data:
+        slots[SECRET_PROVISIONING_DATA] = read_file(args.provisioning_data)
+    if args.certificate:
+        slots[SECRET_CERTIFICATE] = read_file(args.certificate)
+
+    try:
+        page = build_page(flag, slots)
+    except ValueError as e:
+        sys.exit('error: %s' % e)
+
+    if args.output.endswith('.hex'):
+        write_hex(args.output, args.address, page)
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(page)
+
+    print('%s: %d of %d bytes used' % (args.output, len(page), DEVICE_SECRETS_PAGE_SIZE))
+
+
+def cmd_validate(args):
+    page = read_hex(args.image, args.address) if args.image.endswith('.hex') else read_file(args.image)
+
+    try:
+        flag, slots = validate_page(page)
+    except ValueError as e:
+        sys.exit('%s: invalid: %s' % (args.image, e))
+
+    print('%s: valid, flag %s' % (args.image, 'ALREADY_WRITTEN' if flag == ALREADY_WRITTEN else 'GENERATE_AND_WRITE'))
+    for slot, (offset, length) in sorted(slots.items()):
+        print('  slot %2d %-18s offset 0x%03x length %d' % (slot, SLOT_NAMES.get(slot, ''), offset, length))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--address', type=lambda v: int(v, 0), default=DEVICE_SECRETS_ADDRESS,
+                        help='address of the page (default 0x%08X)' % DEVICE_SECRETS_ADDRESS)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    build = sub.add_parser('build', help='build a page image (.hex or raw binary)')
+    build.add_argument('-o', '--output', required=True)
+    build.add_argument('--generate', action='store_true',
+                       help='let the bootloader generate the root key, device ID and attestation seed')
+    build.add_argument('--root-key', help='16 byte root key as hex')
+    build.add_argument('--device-id', help='device ID as hex')
+    build.add_argument('--attestation-seed', help='attestation seed as hex')
+    build.add_argument('--provisioning-data', help='file with provisioning data')
+    build.add_argument('--certificate', help='file with the device certificate')
+    build.set_defaults(func=cmd_build)
+
+    validate = sub.add_parser('validate', help='validate a page image (.hex or raw binary)')
+    validate.add_argument('image')
+    validate.set_defaults(func=cmd_validate)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Render the DFU telemetry streamed by the bootloader on RTT.
+
+Build the bootloader with DFU_TELEMETRY_ENABLED and capture the RTT channel
+(DFU_TELEMETRY_RTT_CHANNEL, 1 by default) during an update:
+
+    JLinkRTTLogger -Device NRF52840_XXAA -If SWD -Speed 4000 -RTTChannel 1 telemetry.bin
+    dfu_telemetry.py telemetry.bin
+    dfu_telemetry.py telemetry.bin --csv > telemetry.csv
+
+The record layout mirrors dfu_telemetry_record_t in include/dfu_telemetry.h.
+"""
+
+import argparse
+import struct
+import sys
+from collections import namedtuple
+
+SYNC = 0xA5
+VERSION = 1
+RECORD_FORMAT = '<BBBBHHIIIIIBB'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+FLAG_TRANSPORT_ACTIVE = 0x01
+FLAG_DFU_IN_PROGRESS = 0x02
+
+Record = namedtuple('Record', 'flags sequence objects_committed time_ms bytes_received bytes_committed '
+                              'flash_backlog rx_held rx_buffers_used')
+
+
+def encode(record):
+    """Packs a record the way the bootloader does, used to check decode()."""
+    body = struct.pack(RECORD_FORMAT[:-1], SYNC, RECORD_SIZE, VERSION, *record)
+    return body + bytes([(0x100 - sum(body)) & 0xFF])
+
+
+def decode(stream):
+    """Returns the valid records of a captured stream and the number of skipped bytes."""
+    records = []
+    skipped = 0
+    i = 0
+    while i + RECORD_SIZE <= len(stream):
+        raw = stream[i:i + RECORD_SIZE]
+        if raw[0] != SYNC or raw[1] != RECORD_SIZE or raw[2] != VERSION or sum(raw) & 0xFF:
+            # partial record or garbage, resync on the next sync byte
+            i += 1
+            skipped += 1
+            continue
+        records.append(Record(*struct.unpack(RECORD_FORMAT, raw)[3:-1]))
+        i += RECORD_SIZE
+    return records, skipped + len(stream) - i
+
+
+def throughput(records):
+    """Yields (record, kB/s received since the previous record)."""
+    previous = None
+    for record in records:
+        rate = 0.0
+        if previous is not None and record.time_ms > previous.time_ms and record.bytes_received >= previous.bytes_received:
+            rate = (record.bytes_received - previous.bytes_received) / (record.time_ms - previous.time_ms) * 1000 / 1024
+        yield record, rate
+        previous = record
+
+
+def render(records, width):
+    rows = list(throughput(records))
+    peak = max([rate for _, rate in rows] + [1.0])
+    lost = 0
+    previous = None
+    for record, rate in rows:
+        if previous is not None:
+            gap = (record.sequence - previous.sequence - 1) & 0xFFFF
+            # a large gap is a restart of DFU mode, not lost records
+            if gap < 0x8000:
+                lost += gap
+        previous = record
+        state = 'dfu' if record.flags & FLAG_DFU_IN_PROGRESS else ('idle' if record.flags & FLAG_TRANSPORT_ACTIVE else 'off')
+        bar = '#' * int(round(rate / peak * width))
+        print('%8.2f s %-4s %8d B %3d obj %6d backlog %2d buf %5d held %7.1f kB/s |%s' %
+              (record.time_ms / 1000, state, record.bytes_received, record.objects_committed,
+               record.flash_backlog, record.rx_buffers_used, record.rx_held, rate, bar))
+    if lost:
+        print('%d records dropped by the device (RTT buffer full)' % lost)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture', help='binary capture of the telemetry RTT channel')
+    parser.add_argument('--csv', action='store_true', help='print the records as CSV instead')
+    parser.add_argument('--width', type=int, default=40, help='width of the throughput bars')
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        records, skipped = decode(f.read())
+
+    if not records:
+        sys.exit('error: no telemetry records in %s' % args.capture)
+
+    if args.csv:
+        print(','.join(Record._fields) + ',kB_per_s')
+        for record, rate in throughput(records):
+            print(','.join(str(v) for v in record) + ',%.1f' % rate)
+    else:
+        render(records, args.width)
+
+    if skipped:
+        print('%d bytes skipped while resyncing' % skipped, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
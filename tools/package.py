@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""Build the settings pages and signed DFU packages of many variants at once.
+
+Every variant of a release gets a bootloader settings page for the factory
+and a signed DFU zip for updates in the field, both made by nrfutil:
+
+    make package VARIANTS=release.json KEY=priv_key.pem
+    package.py release.json --key priv_key.pem -o dist -j 8
+
+The variants file lists the application image and versions of each variant,
+values in "defaults" apply to all of them:
+
+    {
+        "defaults": {"bootloader_version": 100, "hw_version": 52},
+        "variants": [
+            {"name": "dongle", "application": "app_dongle.hex", "application_version": 3},
+            {"name": "devkit", "application": "app_devkit.hex", "application_version": 3}
+        ]
+    }
+
+The variants run in parallel, one nrfutil process per job. A variant is only
+packaged again when its image, the key or one of its parameters changed: the
+digest of the inputs is kept in <output>/.package_cache.json next to the file
+hashes, which are reused while the size and modification time of a file stay
+the same.
+
+--benchmark N packages N copies of the listed variants, each with its own
+hardware and bootloader version, into a temporary directory: once with one
+job, once with -j jobs and once more with the cache of that run. The wall
+times are printed.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+SETTINGS_ADDRESS = 0x000FF000  # MEMORY_SETTINGS_ADDRESS in include/memory_layout.h
+BL_SETTINGS_VERSION = 1
+CACHE_FILE = '.package_cache.json'
+CACHE_VERSION = 1
+
+DEFAULTS = {
+    'application_version': 1,
+    'bootloader_version': 100,
+    'hw_version': 52,
+    'sd_req': '0x00',
+}
+
+
+class PackageError(Exception):
+    pass
+
+
+class Cache(object):
+    """File hashes by path, size and mtime, and the input digest of every variant."""
+
+    def __init__(self, path):
+        self.path = path
+        self.files = {}
+        self.variants = {}
+        try:
+            with open(path) as f:
+                data = json.load(f)
+            if data.get('version') == CACHE_VERSION:
+                self.files = data['files']
+                self.variants = data['variants']
+        except (IOError, ValueError, KeyError):
+            pass
+
+    def file_hash(self, path):
+        path = os.path.abspath(path)
+        st = os.stat(path)
+        stamp = [st.st_size, st.st_mtime_ns]
+        entry = self.files.get(path)
+        if entry is not None and entry[0] == stamp:
+            return entry[1]
+
+        digest = hashlib.sha256()
+        with open(path, 'rb') as f:
+            for block in iter(lambda: f.read(1 << 16), b''):
+                digest.update(block)
+        self.files[path] = [stamp, digest.hexdigest()]
+        return digest.hexdigest()
+
+    def save(self):
+        with open(self.path, 'w') as f:
+            json.dump({'version': CACHE_VERSION, 'files': self.files, 'variants': self.variants}, f, indent=1)
+
+
+def load_variants(path):
+    with open(path) as f:
+        data = json.load(f)
+
+    defaults = dict(DEFAULTS, **data.get('defaults', {}))
+    variants = []
+    names = set()
+    for entry in data.get('variants', []):
+        variant = dict(defaults, **entry)
+        if 'name' not in variant or 'application' not in variant:
+            raise PackageError('every variant needs a name and an application')
+        if variant['name'] in names:
+            raise PackageError('variant %s is listed twice' % variant['name'])
+        names.add(variant['name'])
+        # image paths are relative to the variants file
+        variant['application'] = os.path.join(os.path.dirname(os.path.abspath(path)), variant['application'])
+        variants.append(variant)
+
+    if not variants:
+        raise PackageError('%s lists no variants' % path)
+    return variants
+
+
+def inputs_digest(variant, image_hash, key_hash):
+    params = dict(variant, application=image_hash, key=key_hash)
+    return hashlib.sha256(json.dumps(params, sort_keys=True).encode()).hexdigest()
+
+
+def commands(variant, key, directory, nrfutil=('nrfutil',)):
+    application = variant['application']
+    settings = list(nrfutil) + ['settings', 'generate', '--family', 'NRF52840',
+                '--start-address', '0x%X' % SETTINGS_ADDRESS,
+                '--application', application,
+                '--application-version', str(variant['application_version']),
+                '--bootloader-version', str(variant['bootloader_version']),
+                '--bl-settings-version', str(BL_SETTINGS_VERSION),
+                os.path.join(directory, 'bootloader_settings.hex')]
+    package = list(nrfutil) + ['pkg', 'generate',
+               '--hw-version', str(variant['hw_version']),
+               '--sd-req', str(variant['sd_req']),
+               '--application', application,
+               '--application-version', str(variant['application_version']),
+               '--key-file', key,
+               os.path.join(directory, 'app_dfu_package.zip')]
+    return [settings, package]
+
+
+def package(variant, key, directory, nrfutil=('nrfutil',)):
+    """Runs nrfutil for one variant, returns the time it took."""
+    start = time.time()
+    os.makedirs(directory, exist_ok=True)
+    for command in commands(variant, key, directory, nrfutil):
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        if result.returncode != 0:
+            raise PackageError('%s: %s failed:\n%s' % (variant['name'], ' '.join(command[:3]), result.stdout))
+    return time.time() - start
+
+
+def outputs_present(directory):
+    return all(os.path.isfile(os.path.join(directory, name))
+               for name in ('bootloader_settings.hex', 'app_dfu_package.zip'))
+
+
+def package_all(variants, key, output, jobs, force=False, nrfutil=('nrfutil',), log=print):
+    """Packages the variants that changed since the last run into output.
+
+    Returns (packaged, unchanged, failed, seconds), the hashing included.
+    """
+    start = time.time()
+    os.makedirs(output, exist_ok=True)
+    cache = Cache(os.path.join(output, CACHE_FILE))
+
+    # hashing is cheap next to nrfutil, done up front so the workers share no state
+    key_hash = cache.file_hash(key)
+    pending = []
+    for variant in variants:
+        directory = os.path.join(output, variant['name'])
+        digest = inputs_digest(variant, cache.file_hash(variant['application']), key_hash)
+        if force or cache.variants.get(variant['name']) != digest or not outputs_present(directory):
+            pending.append((variant, directory, digest))
+
+    failed = 0
+    with ThreadPoolExecutor(max_workers=max(1, jobs)) as executor:
+        futures = [(variant, digest, executor.submit(package, variant, key, directory, nrfutil))
+                   for variant, directory, digest in pending]
+        for variant, digest, future in futures:
+            try:
+                elapsed = future.result()
+            except (OSError, PackageError) as e:
+                print('error: %s' % e, file=sys.stderr)
+                cache.variants.pop(variant['name'], None)
+                failed += 1
+                continue
+            cache.variants[variant['name']] = digest
+            log('%-24s %6.2f s' % (variant['name'], elapsed))
+
+    cache.save()
+    return len(pending) - failed, len(variants) - len(pending), failed, time.time() - start
+
+
+def benchmark_variants(variants, count):
+    """count copies of the variants, the versions make every copy a distinct package."""
+    copies = []
+    for i in range(count):
+        variant = dict(variants[i % len(variants)])
+        variant['name'] = '%s-%03d' % (variant['name'], i)
+        variant['hw_version'] = int(variant['hw_version']) + i
+        variant['bootloader_version'] = int(variant['bootloader_version']) + i
+        copies.append(variant)
+    return copies
+
+
+def benchmark(variants, key, count, jobs, nrfutil=('nrfutil',)):
+    """Wall time of packaging count variants sequentially, with jobs and with a warm cache.
+
+    Returns [(run, jobs, (packaged, unchanged, failed, seconds))].
+    """
+    copies = benchmark_variants(variants, count)
+    results = []
+    with tempfile.TemporaryDirectory() as root:
+        for run, run_jobs, output in (('sequential', 1, 'sequential'), ('parallel', jobs, 'parallel'),
+                                      ('cached', jobs, 'parallel')):
+            counts = package_all(copies, key, os.path.join(root, output), run_jobs, nrfutil=nrfutil,
+                                 log=lambda line: None)
+            results.append((run, run_jobs, counts))
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('variants', help='JSON file listing the variants')
+    parser.add_argument('--key', required=True, help='private key the packages are signed with')
+    parser.add_argument('-o', '--output', default='dist', help='output directory, one folder per variant')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count() or 1, help='parallel nrfutil processes')
+    parser.add_argument('--force', action='store_true', help='ignore the cache and package every variant')
+    parser.add_argument('--benchmark', type=int, metavar='N',
+                        help='time packaging N variants with one and with -j jobs, nothing is written to --output')
+    parser.add_argument('--nrfutil', default='nrfutil', help='nrfutil command line')
+    args = parser.parse_args()
+    nrfutil = shlex.split(args.nrfutil)
+
+    try:
+        variants = load_variants(args.variants)
+    except (IOError, ValueError, PackageError) as e:
+        sys.exit('error: %s' % e)
+
+    try:
+        if args.benchmark:
+            results = benchmark(variants, args.key, args.benchmark, args.jobs, nrfutil)
+            sequential = results[0][2][3]
+            for run, jobs, (packaged, unchanged, failed, elapsed) in results:
+                print('%-10s %2d jobs  %3d packaged  %3d unchanged  %3d failed  %7.2f s  %5.2fx' %
+                      (run, jobs, packaged, unchanged, failed, elapsed, sequential / elapsed))
+            if any(result[2][2] for result in results):
+                sys.exit(1)
+            return
+
+        packaged, unchanged, failed, elapsed = package_all(variants, args.key, args.output, args.jobs, args.force,
+                                                           nrfutil)
+    except OSError as e:
+        sys.exit('error: %s' % e)
+
+    print('%d packaged, %d unchanged, %d failed in %.1f s with %d jobs' %
+          (packaged, unchanged, failed, elapsed, args.jobs))
+    if failed:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
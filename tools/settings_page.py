@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""Generate bootloader settings pages without nrfutil.
+
+Builds the page of `nrfutil settings generate` (the nrf_dfu_settings_t of
+SDK 15.3, settings version 1 or 2) in memory from the SDK layout, fast enough
+to make one per device on the production line. The output has not been
+compared with that of nrfutil byte for byte, see compare below:
+
+    settings_page.py generate --application app.hex --application-version 3 -o settings.hex
+    settings_page.py batch devices.csv -o settings/
+    settings_page.py compare settings.hex nrfutil_settings.hex
+
+The CSV of batch has a header row with the columns name and application and
+optionally application_version and bootloader_version, which otherwise come
+from the command line. Every row gives settings/<name>.hex. Application
+images are read and hashed once however many devices use them.
+
+compare decodes two settings hex files and lists the fields that differ, use
+it to check the output against the installed nrfutil before switching a line
+over.
+"""
+
+import argparse
+import binascii
+import csv
+import hashlib
+import os
+import struct
+import sys
+import time
+
+SETTINGS_ADDRESS = 0x000FF000  # MEMORY_SETTINGS_ADDRESS in include/memory_layout.h
+BACKUP_ADDRESS = 0x000FE000  # MEMORY_MBR_PARAMS_ADDRESS, nrf_dfu_settings_backup() copies the page here
+
+BANK_VALID_APP = 0x01
+BANK_INVALID_APP = 0x00
+
+# offsets in nrf_dfu_settings_t
+OFFSET_INIT_COMMAND = 0x5C  # the settings CRC covers the bytes from 4 up to here
+OFFSET_BOOT_VALIDATION_CRC = 0x25C  # version 2, after the 512 byte init command
+OFFSET_BOOT_VALIDATION = 0x260  # softdevice, app, bootloader {type, bytes[64]}
+BOOT_VALIDATION_SIZE = 65
+
+SETTINGS_SIZE = {1: OFFSET_INIT_COMMAND, 2: OFFSET_BOOT_VALIDATION + 3 * BOOT_VALIDATION_SIZE}
+
+# header of the page up to init_command:
+# crc, settings_version, app_version, bootloader_version, bank_layout, bank_current,
+# bank_0 {image_size, image_crc, bank_code}, bank_1, write_offset, sd_size,
+# progress[8], enter_buttonless_dfu
+HEADER_FORMAT = '<IIIIII3I3III8II'
+
+NO_VALIDATION = 0
+VALIDATE_CRC = 1
+VALIDATE_SHA256 = 2
+BOOT_VALIDATION = {
+    'NO_VALIDATION': NO_VALIDATION,
+    'VALIDATE_GENERATED_CRC': VALIDATE_CRC,
+    'VALIDATE_GENERATED_SHA256': VALIDATE_SHA256,
+}
+
+FIELDS = ['crc', 'settings_version', 'app_version', 'bootloader_version', 'bank_layout', 'bank_current',
+          'bank_0.image_size', 'bank_0.image_crc', 'bank_0.bank_code',
+          'bank_1.image_size', 'bank_1.image_crc', 'bank_1.bank_code',
+          'write_offset', 'sd_size'] + ['progress[%d]' % i for i in range(8)] + ['enter_buttonless_dfu']
+
+
+class SettingsError(Exception):
+    pass
+
+
+def read_hex(path):
+    """Returns the contents of an Intel HEX file as {address: bytes} segments."""
+    segments = {}
+    start = None
+    data = bytearray()
+    upper = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line[0] != ':':
+                raise SettingsError('%s is not an Intel HEX file' % path)
+            raw = bytes.fromhex(line[1:])
+            if sum(raw) & 0xFF:
+                raise SettingsError('bad checksum in %s: %s' % (path, line))
+            length, addr, rtype = raw[0], (raw[1] << 8) | raw[2], raw[3]
+            payload = raw[4:4 + length]
+            if rtype == 0x00:
+                addr += upper
+                if start is not None and addr != start + len(data):
+                    segments[start] = bytes(data)
+                    start = None
+                if start is None:
+                    start, data = addr, bytearray()
+                data += payload
+            elif rtype == 0x02:
+                upper = struct.unpack('>H', payload)[0] << 4
+            elif rtype == 0x04:
+                upper = struct.unpack('>H', payload)[0] << 16
+            elif rtype == 0x01:
+                break
+    if start is not None:
+        segments[start] = bytes(data)
+    return segments
+
+
+def image_binary(segments):
+    """The flat image nrfutil hashes: lowest to highest address, gaps filled with 0xFF."""
+    if not segments:
+        return b''
+    low = min(segments)
+    high = max(addr + len(data) for addr, data in segments.items())
+    image = bytearray(b'\xff' * (high - low))
+    for addr, data in segments.items():
+        image[addr - low:addr - low + len(data)] = data
+    return bytes(image)
+
+
+def hex_records(address, data):
+    """Intel HEX lines of data at address, 16 bytes per record like nrfutil."""
+    lines = []
+    upper = None
+    for index in range(0, len(data), 16):
+        addr = address + index
+        if addr >> 16 != upper:
+            upper = addr >> 16
+            raw = struct.pack('>BHBH', 2, 0, 0x04, upper)
+            lines.append(':%s%02X' % (binascii.hexlify(raw).decode().upper(), (-sum(raw)) & 0xFF))
+        chunk = data[index:index + 16]
+        raw = struct.pack('>BHB', len(chunk), addr & 0xFFFF, 0x00) + chunk
+        lines.append(':%s%02X' % (binascii.hexlify(raw).decode().upper(), (-sum(raw)) & 0xFF))
+    return lines
+
+
+class Application(object):
+    """Size and digests of an application image, computed once."""
+
+    def __init__(self, path):
+        image = image_binary(read_hex(path)) if path.lower().endswith('.hex') else open(path, 'rb').read()
+        self.size = len(image)
+        self.crc = binascii.crc32(image) & 0xFFFFFFFF
+        self.sha256 = hashlib.sha256(image).digest()
+
+
+def build_settings(settings_version, app_version, bootloader_version, app=None, sd_size=0,
+                   app_boot_validation=NO_VALIDATION):
+    """Returns the bytes of nrf_dfu_settings_t as nrfutil writes them."""
+    if settings_version not in SETTINGS_SIZE:
+        raise SettingsError('settings version %d is not supported' % settings_version)
+
+    bank_0 = (app.size, app.crc, BANK_VALID_APP) if app is not None else (0, 0, BANK_INVALID_APP)
+    header = struct.pack(HEADER_FORMAT, 0, settings_version, app_version, bootloader_version, 0, 0,
+                         *(bank_0 + (0, 0, 0, 0, sd_size) + (0,) * 8 + (0,)))
+    crc = binascii.crc32(header[4:]) & 0xFFFFFFFF
+    page = bytearray(struct.pack('<I', crc) + header[4:])
+
+    if settings_version >= 2:
+        validation = bytearray(3 * BOOT_VALIDATION_SIZE)
+        if app_boot_validation != NO_VALIDATION:
+            if app is None:
+                raise SettingsError('app boot validation needs an application')
+            # the SHA-256 is stored in reversed byte order, like nrfutil does
+            value = struct.pack('<I', app.crc) if app_boot_validation == VALIDATE_CRC else app.sha256[::-1]
+            validation[BOOT_VALIDATION_SIZE] = app_boot_validation
+            validation[BOOT_VALIDATION_SIZE + 1:BOOT_VALIDATION_SIZE + 1 + len(value)] = value
+        page += bytes(OFFSET_BOOT_VALIDATION_CRC - len(page))
+        page += struct.pack('<I', binascii.crc32(validation) & 0xFFFFFFFF) + validation
+
+    return bytes(page)
+
+
+def settings_hex(page, backup):
+    lines = hex_records(SETTINGS_ADDRESS, page)
+    if backup:
+        lines = hex_records(BACKUP_ADDRESS, page) + lines
+    lines.append(':00000001FF')
+    return '\n'.join(lines) + '\n'
+
+
+def decode(page):
+    values = struct.unpack_from(HEADER_FORMAT, page.ljust(OFFSET_INIT_COMMAND, b'\x00'))
+    return dict(zip(FIELDS, values))
+
+
+def settings_from_hex(path):
+    segments = read_hex(path)
+    page = bytearray(SETTINGS_SIZE[2])
+    for addr, data in segments.items():
+        for i in range(len(data)):
+            if SETTINGS_ADDRESS <= addr + i < SETTINGS_ADDRESS + len(page):
+                page[addr + i - SETTINGS_ADDRESS] = data[i]
+    return bytes(page)
+
+
+def cmd_generate(args):
+    app = Application(args.application) if args.application else None
+    page = build_settings(args.bl_settings_version, args.application_version, args.bootloader_version,
+                          app, args.sd_size, BOOT_VALIDATION[args.app_boot_validation])
+    with open(args.output, 'w') as f:
+        f.write(settings_hex(page, args.backup))
+    print('%s: settings version %d, application %s' %
+          (args.output, args.bl_settings_version, '%d bytes, crc 0x%08X' % (app.size, app.crc) if app else 'none'))
+
+
+def column(row, name, default):
+    # empty or missing columns take the value of the command line
+    return int(row[name], 0) if row.get(name) else default
+
+
+def cmd_batch(args):
+    apps = {}
+    count = 0
+    start = time.time()
+    base = os.path.dirname(os.path.abspath(args.devices))
+    os.makedirs(args.output, exist_ok=True)
+
+    with open(args.devices) as f:
+        for row in csv.DictReader(f):
+            if not row.get('name') or not row.get('application'):
+                raise SettingsError('row %d needs a name and an application' % (count + 2))
+            path = os.path.join(base, row['application'])
+            if path not in apps:
+                apps[path] = Application(path)
+            page = build_settings(args.bl_settings_version,
+                                  column(row, 'application_version', args.application_version),
+                                  column(row, 'bootloader_version', args.bootloader_version),
+                                  apps[path], args.sd_size, BOOT_VALIDATION[args.app_boot_validation])
+            with open(os.path.join(args.output, row['name'] + '.hex'), 'w') as out:
+                out.write(settings_hex(page, args.backup))
+            count += 1
+
+    elapsed = time.time() - start
+    print('%d settings pages for %d applications in %.2f s (%d per second)' %
+          (count, len(apps), elapsed, count / elapsed if elapsed > 0 else count))
+
+
+def cmd_compare(args):
+    pages = [settings_from_hex(path) for path in (args.first, args.second)]
+    fields = [decode(page) for page in pages]
+    differences = [name for name in FIELDS if fields[0][name] != fields[1][name]]
+    for name in differences:
+        print('%-24s 0x%08X 0x%08X' % (name, fields[0][name], fields[1][name]))
+
+    tail = [i for i in range(OFFSET_INIT_COMMAND, len(pages[0])) if pages[0][i] != pages[1][i]]
+    if tail:
+        print('%d bytes differ after the header, first at offset 0x%03X' % (len(tail), tail[0]))
+
+    if differences or tail:
+        sys.exit(1)
+    print('identical')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    def page_options(p):
+        p.add_argument('--bl-settings-version', type=int, default=1, choices=sorted(SETTINGS_SIZE),
+                       help='layout of the settings (default 1, as make generate_settings)')
+        p.add_argument('--application-version', type=lambda v: int(v, 0), default=0)
+        p.add_argument('--bootloader-version', type=lambda v: int(v, 0), default=100)
+        p.add_argument('--sd-size', type=lambda v: int(v, 0), default=0, help='size of the SoftDevice, none by default')
+        p.add_argument('--app-boot-validation', choices=sorted(BOOT_VALIDATION), default='NO_VALIDATION',
+                       help='boot validation of the application, settings version 2 only')
+        p.add_argument('--backup', action='store_true',
+                       help='also write the backup copy at 0x%08X' % BACKUP_ADDRESS)
+
+    generate = sub.add_parser('generate', help='generate one settings page')
+    generate.add_argument('-o', '--output', required=True)
+    generate.add_argument('--application', help='application image, .hex or raw binary')
+    page_options(generate)
+    generate.set_defaults(func=cmd_generate)
+
+    batch = sub.add_parser('batch', help='generate a settings page per row of a CSV file')
+    batch.add_argument('devices', help='CSV with name, application[, application_version, bootloader_version]')
+    batch.add_argument('-o', '--output', required=True, help='output directory')
+    page_options(batch)
+    batch.set_defaults(func=cmd_batch)
+
+    compare = sub.add_parser('compare', help='compare two settings hex files field by field')
+    compare.add_argument('first')
+    compare.add_argument('second')
+    compare.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    try:
+        args.func(args)
+    except (IOError, ValueError, SettingsError) as e:
+        sys.exit('error: %s' % e)
+
+
+if __name__ == '__main__':
+    main()
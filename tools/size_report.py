@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Compare the size of bootloader builds and suggest a BOOTLOADER_SIZE.
+
+    make size_report
+    size_report.py build/nrf52840_xxaa.out build_minimal/nrf52840_xxaa.out
+
+For every ELF file the flash used by the bootloader image (code, read only
+data and the initial values of .data) and the RAM used by .data and .bss are
+printed per section, followed by the smallest page aligned BOOTLOADER_SIZE
+that fits the image with --headroom bytes to spare. The bootloader ends at the
+MBR parameters page, every page it gives up goes to the application.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+PAGE_SIZE = 0x1000
+MBR_PARAMS_ADDRESS = 0x000FE000  # MEMORY_MBR_PARAMS_ADDRESS in include/memory_layout.h
+DEFAULT_BOOTLOADER_SIZE = 0x1D000  # MEMORY_BOOTLOADER_SIZE
+
+SHT_NOBITS = 8
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+PT_LOAD = 1
+
+
+class SizeError(Exception):
+    pass
+
+
+class Image(object):
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            elf = f.read()
+
+        if elf[:4] != b'\x7fELF' or elf[4] != 1 or elf[5] != 1:
+            raise SizeError('%s is not a little endian ELF32 file' % path)
+
+        phoff, shoff = struct.unpack_from('<II', elf, 0x1C)
+        phentsize, phnum, shentsize, shnum, shstrndx = struct.unpack_from('<HHHHH', elf, 0x2A)
+
+        def section(index):
+            return struct.unpack_from('<IIIIIIIIII', elf, shoff + index * shentsize)
+
+        names_offset = section(shstrndx)[4]
+        self.sections = {}
+        self.start = None
+        for index in range(shnum):
+            name, sh_type, flags, addr, _offset, size = section(index)[:6]
+            if not flags & SHF_ALLOC or size == 0:
+                continue
+            name = elf[names_offset + name:elf.index(b'\0', names_offset + name)].decode('ascii')
+            if name == '.isr_vector':
+                self.start = addr
+            self.sections[name] = (addr, size, sh_type == SHT_NOBITS, bool(flags & SHF_WRITE))
+
+        if self.start is None:
+            raise SizeError('%s has no .isr_vector section' % path)
+
+        # flash is taken by the loaded contents, .data included, between the
+        # vector table and the MBR parameters page
+        self.flash_end = self.start
+        for index in range(phnum):
+            p_type, _offset, _vaddr, paddr, filesz = struct.unpack_from('<IIIII', elf, phoff + index * phentsize)
+            if p_type == PT_LOAD and filesz and self.start <= paddr < MBR_PARAMS_ADDRESS:
+                self.flash_end = max(self.flash_end, paddr + filesz)
+
+        self.flash = self.flash_end - self.start
+        self.reserved = MBR_PARAMS_ADDRESS - self.start
+        self.ram = sum(size for addr, size, _nobits, write in self.sections.values() if write and addr >= 0x20000000)
+
+    def suggested_size(self, headroom):
+        return (self.flash + headroom + PAGE_SIZE - 1) // PAGE_SIZE * PAGE_SIZE
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', nargs='+', help='bootloader ELF files, one per profile')
+    parser.add_argument('--headroom', type=lambda v: int(v, 0), default=0x800,
+                        help='spare flash kept for bootloader updates (default 0x800)')
+    args = parser.parse_args()
+
+    try:
+        images = [Image(path) for path in args.elf]
+    except (IOError, SizeError) as e:
+        sys.exit('error: %s' % e)
+
+    names = [os.path.basename(os.path.dirname(os.path.abspath(path))) or path for path in args.elf]
+    width = max(10, max(len(name) for name in names))
+
+    def row(label, values):
+        print('%-24s' % label + ''.join('%*s' % (width + 2, value) for value in values))
+
+    row('', names)
+    sections = sorted(set(name for image in images for name in image.sections),
+                      key=lambda name: min(image.sections[name][0] for image in images if name in image.sections))
+    for name in sections:
+        row(name, [image.sections[name][1] if name in image.sections else '-' for image in images])
+
+    print('')
+    row('flash used', [image.flash for image in images])
+    row('flash reserved', ['0x%X' % image.reserved for image in images])
+    row('RAM used', [image.ram for image in images])
+    row('BOOTLOADER_SIZE', ['0x%X' % image.suggested_size(args.headroom) for image in images])
+    row('reclaimed for the app', ['%d KB' % ((DEFAULT_BOOTLOADER_SIZE - image.suggested_size(args.headroom)) // 1024)
+                                  for image in images])
+
+
+if __name__ == '__main__':
+    main()
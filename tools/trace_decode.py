@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Decode the binary trace of the bootloader.
+
+The trace ring at 0x2003FA00 (see include/trace.h) holds entries of
+
+    header {sync:4, nargs:4, id:24} | cycles | args[nargs]
+
+where id is the offset of the format string in the .trace_fmt section of the
+bootloader ELF file. The ring can be given as a raw binary or as the text
+output of nrfjprog:
+
+    nrfjprog -f nrf52 --memrd 0x2003FA00 --n 0x400 > trace.txt
+    trace_decode.py build/nrf52840_xxaa.out trace.txt
+
+Reading the ring with a debugger requires ALLOW_DEBUGGER_ACCESS, otherwise the
+application has to export the region before it reuses the memory.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+TRACE_ADDRESS = 0x2003FA00  # MEMORY_TRACE_ADDRESS in include/memory_layout.h
+TRACE_SIZE = 0x400
+TRACE_MAGIC = 0x54524345
+TRACE_SYNC = 0xA
+TRACE_MAX_ARGS = 4
+RING_HEADER_FORMAT = '<III'
+
+CPU_FREQUENCY = 64000000
+
+
+class TraceError(Exception):
+    pass
+
+
+def read_format_strings(path):
+    """Returns the .trace_fmt section of a little endian ELF32 file."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != b'\x7fELF' or elf[4] != 1 or elf[5] != 1:
+        raise TraceError('%s is not a little endian ELF32 file' % path)
+
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2E)
+
+    def section(index):
+        return struct.unpack_from('<IIIIIIIIII', elf, shoff + index * shentsize)
+
+    names_offset = section(shstrndx)[4]
+    for index in range(shnum):
+        name, _type, _flags, _addr, offset, size = section(index)[:6]
+        end = elf.index(b'\0', names_offset + name)
+        if elf[names_offset + name:end] == b'.trace_fmt':
+            return elf[offset:offset + size]
+
+    raise TraceError('%s has no .trace_fmt section, was it built with TRACE_ENABLED?' % path)
+
+
+def read_ring(path):
+    """Reads a ring dump, either raw or as 'address: word word ...' lines."""
+    with open(path, 'rb') as f:
+        raw = f.read()
+
+    text = raw.decode('ascii', 'ignore')
+    if re.match(r'\s*0x[0-9a-fA-F]+:', text):
+        words = []
+        for line in text.splitlines():
+            if ':' not in line:
+                continue
+            words += [int(w, 16) for w in re.findall(r'[0-9a-fA-F]{8}', line.split(':', 1)[1])]
+        raw = struct.pack('<%dI' % len(words), *words)
+
+    if len(raw) < TRACE_SIZE:
+        raise TraceError('ring dump is %d bytes, expected %d' % (len(raw), TRACE_SIZE))
+    return raw[:TRACE_SIZE]
+
+
+def format_entry(fmt, args):
+    # arguments are stored as raw words, %d and %i are signed
+    values = []
+    for spec, value in zip(re.findall(r'%[-+ #0-9.]*[a-zA-Z]', fmt.replace('%%', '')), args):
+        if spec[-1] in 'di' and value & 0x80000000:
+            value -= 1 << 32
+        values.append(value)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return '%s %s' % (fmt, ' '.join('0x%08x' % a for a in args))
+
+
+def decode(strings, ring):
+    magic, words, head = struct.unpack_from(RING_HEADER_FORMAT, ring)
+    if magic != TRACE_MAGIC:
+        raise TraceError('no trace in the dump (magic 0x%08x)' % magic)
+
+    data = struct.unpack_from('<%dI' % words, ring, struct.calcsize(RING_HEADER_FORMAT))
+    count = min(head, words)
+    stream = [data[(head - count + i) % words] for i in range(count)]
+
+    entries = []
+    i = 0
+    while i + 2 <= len(stream):
+        header = stream[i]
+        nargs = (header >> 24) & 0xF
+        fmt_id = header & 0x00FFFFFF
+        valid = (header >> 28 == TRACE_SYNC and nargs <= TRACE_MAX_ARGS and
+                 fmt_id < len(strings) and (fmt_id == 0 or strings[fmt_id - 1] == 0))
+        if not valid or i + 2 + nargs > len(stream):
+            # the oldest entry may be partially overwritten, resync on the next header
+            i += 1
+            continue
+
+        fmt = strings[fmt_id:strings.index(b'\0', fmt_id)].decode('ascii', 'replace')
+        entries.append((stream[i + 1], format_entry(fmt, stream[i + 2:i + 2 + nargs])))
+        i += 2 + nargs
+
+    return entries
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', help='bootloader ELF file the device runs')
+    parser.add_argument('ring', help='dump of the trace ring, raw or nrfjprog --memrd output')
+    args = parser.parse_args()
+
+    try:
+        entries = decode(read_format_strings(args.elf), read_ring(args.ring))
+    except TraceError as e:
+        sys.exit('error: %s' % e)
+
+    previous = None
+    for cycles, text in entries:
+        # the counter restarts on every boot, a negative delta marks a reset
+        delta = '' if previous is None or cycles < previous else '+%.1f us' % ((cycles - previous) * 1e6 / CPU_FREQUENCY)
+        print('%10d %12s  %s' % (cycles, delta, text))
+        previous = cycles
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,427 @@
+#!/usr/bin/env python3
+"""Perform a DFU over the vendor bulk interface of the bootloader.
+
+Sends an nrfutil DFU package (.zip) to the bulk interface (class 0xFF,
+subclass 0x44). Requests are the same as on the serial transport but without
+SLIP framing, and every response is followed by the flow status
+{rx_buffers_free u8, rx_buffers_total u8, flash_backlog u32}.
+
+The PRN interval is adapted to that status unless --prn is given:
+
+    usb_dfu.py app_dfu_package.zip
+    usb_dfu.py app_dfu_package.zip --prn 8
+    usb_dfu.py app_dfu_package.zip --benchmark
+
+Requires pyusb (pip install pyusb).
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+import zipfile
+import zlib
+
+DFU_BULK_CLASS = 0xFF
+DFU_BULK_SUBCLASS = 0x44
+
+OP_OBJECT_CREATE = 0x01
+OP_RECEIPT_NOTIF_SET = 0x02
+OP_CRC_GET = 0x03
+OP_OBJECT_EXECUTE = 0x04
+OP_OBJECT_SELECT = 0x06
+OP_MTU_GET = 0x07
+OP_OBJECT_WRITE = 0x08
+OP_FLOW_STATUS = 0x50
+OP_USB_STATS = 0x51
+OP_BOOT_PROBES = 0x52
+OP_RESPONSE = 0x60
+
+RES_SUCCESS = 0x01
+
+OBJ_COMMAND = 0x01
+OBJ_DATA = 0x02
+
+MAX_PACKET_SIZE = 64
+STATUS_FORMAT = '<BBI'
+STATUS_SIZE = struct.calcsize(STATUS_FORMAT)
+EP_STATS_FORMAT = '<IIII'
+PROBE_FORMAT = '<IIII'
+PROBE_NAMES = ('copy_kdr', 'bootloader_init', 'measured_boot', 'dfu_request')
+
+
+class DfuError(Exception):
+    pass
+
+
+class PrnController:
+    """Adapts the PRN interval to the flow status reported by the device.
+
+    Half of the receive buffers or more free at a notification mean the
+    device ran out of data while the host waited for it, so the interval is
+    doubled. No free buffers mean flash is the bottleneck and the wait is
+    hidden behind the backlog, the interval is kept. Halving it there turns
+    every page erase into a run of round trips.
+    """
+
+    def __init__(self, initial=4, maximum=64):
+        self.prn = initial
+        self.maximum = maximum
+
+    def update(self, status):
+        free, total, _backlog = status
+        if free * 2 >= total:
+            self.prn = min(self.maximum, self.prn * 2)
+        return self.prn
+
+
+class BulkTransport:
+    def __init__(self, vid=None, pid=None, timeout=5000):
+        try:
+            import usb.core
+            import usb.util
+        except ImportError:
+            sys.exit('error: pyusb is required (pip install pyusb)')
+
+        def match(dev):
+            if (vid is not None and dev.idVendor != vid) or (pid is not None and dev.idProduct != pid):
+                return False
+            return self._find_interface(dev) is not None
+
+        self.dev = usb.core.find(custom_match=match)
+        if self.dev is None:
+            raise DfuError('no device with a bulk DFU interface found')
+
+        intf = self._find_interface(self.dev)
+        if self.dev.is_kernel_driver_active(intf.bInterfaceNumber):
+            self.dev.detach_kernel_driver(intf.bInterfaceNumber)
+        usb.util.claim_interface(self.dev, intf.bInterfaceNumber)
+
+        direction = usb.util.endpoint_direction
+        self.ep_out = usb.util.find_descriptor(intf, custom_match=lambda e: direction(e.bEndpointAddress) == usb.util.ENDPOINT_OUT)
+        self.ep_in = usb.util.find_descriptor(intf, custom_match=lambda e: direction(e.bEndpointAddress) == usb.util.ENDPOINT_IN)
+        self.timeout = timeout
+        self.status = None
+
+    @staticmethod
+    def _find_interface(dev):
+        for cfg in dev:
+            for intf in cfg:
+                if intf.bInterfaceClass == DFU_BULK_CLASS and intf.bInterfaceSubClass == DFU_BULK_SUBCLASS:
+                    return intf
+        return None
+
+    def send(self, op, payload=b''):
+        data = bytes([op]) + payload
+        self.ep_out.write(data, self.timeout)
+        # a transfer that fills its last packet is ended by a zero length packet
+        if len(data) % MAX_PACKET_SIZE == 0:
+            self.ep_out.write(b'', self.timeout)
+
+    def receive(self, op):
+        raw = bytes(self.ep_in.read(512, self.timeout))
+        if len(raw) < 3 + STATUS_SIZE or raw[0] != OP_RESPONSE:
+            raise DfuError('malformed response %s' % raw.hex())
+        if raw[1] != op:
+            raise DfuError('response to 0x%02x while waiting for 0x%02x' % (raw[1], op))
+        if raw[2] != RES_SUCCESS:
+            raise DfuError('request 0x%02x failed with 0x%02x' % (op, raw[2]))
+        self.status = struct.unpack(STATUS_FORMAT, raw[-STATUS_SIZE:])
+        return raw[3:-STATUS_SIZE]
+
+    def request(self, op, payload=b''):
+        self.send(op, payload)
+        return self.receive(op)
+
+
+class SimulatedTransport:
+    """A model of the bootloader behind the transport interface, for --benchmark.
+
+    Time is simulated in microseconds. A request takes its size over the bus
+    at usb_rate bytes/us and the host waits turnaround_us for every response
+    it reads. A write request holds one of rx_buffers until it was written
+    to flash at flash_rate bytes/us, the bulk OUT endpoint NAKs while none is
+    free. Creating a data object queues the erase of its pages, executing it
+    waits for the flash. PRN notifications are sent when the write is
+    received, with the flow status at that time.
+
+    With stall the USB interrupt runs from flash (RAMFUNC_ENABLED 0): the CPU
+    halts while a page is erased, so nothing moves on the bus and no response
+    is sent until the erase is done. The single packet the interrupt takes
+    between two erase slices and the 41 us stalls of word writes are left out.
+    """
+
+    PAGE_SIZE = 4096
+
+    def __init__(self, rx_buffers=3, mtu=4096, object_size=4096, usb_rate=1.0, flash_rate=0.0976,
+                 erase_us=85000, turnaround_us=1000, stall=False):
+        self.rx_buffers = rx_buffers
+        self.mtu = mtu
+        self.object_size = object_size
+        self.usb_rate = usb_rate
+        self.flash_rate = flash_rate
+        self.erase_us = erase_us
+        self.turnaround_us = turnaround_us
+        self.stall = stall
+        self.now = 0.0
+        self.flash_done = 0.0
+        self.held = []  # (time written to flash, size) of the writes holding a buffer
+        self.responses = []
+        self.prn = 0
+        self.writes = 0
+        self.objects = {OBJ_COMMAND: (0, 0), OBJ_DATA: (0, 0)}
+        self.obj_type = OBJ_COMMAND
+        self.offset = 0
+        self.crc = 0
+        self.status = None
+        self.naks_us = 0.0
+        self.erases = []  # (start, end) of the page erases while stall
+        self.stalled_us = 0.0
+
+    def clock(self):
+        return self.now / 1e6
+
+    def _status(self, at):
+        held = [size for done, size in self.held if done > at]
+        return self.rx_buffers - len(held), self.rx_buffers, sum(held)
+
+    def _erase_end(self, at):
+        for start, end in self.erases:
+            if start <= at < end:
+                return end
+        return at
+
+    def _bus(self, size):
+        # the transfer pauses for every erase that starts before it is done
+        remaining = size / self.usb_rate
+        while True:
+            end = self._erase_end(self.now)
+            self.stalled_us += end - self.now
+            self.now = end
+            start = min((begin for begin, _ in self.erases if begin > self.now), default=float('inf'))
+            if self.now + remaining <= start:
+                self.now += remaining
+                return
+            remaining -= start - self.now
+            self.now = start
+
+    def _respond(self, op, payload=b'', at=None):
+        at = self._erase_end(self.now if at is None else max(self.now, at))
+        self.responses.append((op, payload, at, self._status(at)))
+
+    def _write(self, payload):
+        self.held = [(done, size) for done, size in self.held if done > self.now]
+        if len(self.held) == self.rx_buffers:
+            # NAKed until the oldest write is in flash
+            self.naks_us += self.held[0][0] - self.now
+            self.now = self.held[0][0]
+            self.held.pop(0)
+        self._bus(1 + len(payload))
+        self.flash_done = max(self.now, self.flash_done) + len(payload) / self.flash_rate
+        self.held.append((self.flash_done, len(payload)))
+        self.offset += len(payload)
+        self.crc = zlib.crc32(payload, self.crc) & 0xFFFFFFFF
+        self.writes += 1
+        if self.prn and self.writes % self.prn == 0:
+            self._respond(OP_CRC_GET, struct.pack('<II', self.offset, self.crc))
+
+    def send(self, op, payload=b''):
+        if op == OP_OBJECT_WRITE:
+            self._write(payload)
+            return
+        self._bus(1 + len(payload))
+        if op == OP_RECEIPT_NOTIF_SET:
+            self.prn = struct.unpack('<H', payload)[0]
+            self.writes = 0
+            self._respond(op)
+        elif op == OP_MTU_GET:
+            self._respond(op, struct.pack('<H', self.mtu))
+        elif op == OP_OBJECT_SELECT:
+            self.objects[self.obj_type] = (self.offset, self.crc)
+            self.obj_type = payload[0]
+            self.offset, self.crc = self.objects[self.obj_type]
+            self._respond(op, struct.pack('<III', self.object_size, self.offset, self.crc))
+        elif op == OP_OBJECT_CREATE:
+            obj_type, size = struct.unpack('<BI', payload)
+            if obj_type == OBJ_COMMAND:
+                self.offset, self.crc = 0, 0
+            else:
+                pages = (size + self.PAGE_SIZE - 1) // self.PAGE_SIZE
+                start = max(self.now, self.flash_done)
+                self.flash_done = start + pages * self.erase_us
+                if self.stall:
+                    self.erases = [(begin, end) for begin, end in self.erases if end > self.now] + [(start, self.flash_done)]
+            self.writes = 0
+            self._respond(op)
+        elif op == OP_CRC_GET:
+            self._respond(op, struct.pack('<II', self.offset, self.crc))
+        elif op == OP_OBJECT_EXECUTE:
+            self._respond(op, at=self.flash_done)
+        else:
+            raise DfuError('request 0x%02x is not simulated' % op)
+
+    def receive(self, op):
+        if not self.responses:
+            raise DfuError('no response to 0x%02x' % op)
+        rsp_op, payload, at, self.status = self.responses.pop(0)
+        if rsp_op != op:
+            raise DfuError('response to 0x%02x while waiting for 0x%02x' % (rsp_op, op))
+        self.now = max(self.now, at) + self.turnaround_us
+        return payload
+
+    def request(self, op, payload=b''):
+        self.send(op, payload)
+        return self.receive(op)
+
+
+class Dfu:
+    def __init__(self, transport, prn=None, stats=False, probes=False, clock=time.monotonic):
+        self.transport = transport
+        self.clock = clock
+        self.want_stats = stats
+        self.stats = None
+        self.want_probes = probes
+        self.probes = None
+        self.controller = None if prn is not None else PrnController()
+        self.prn = prn if prn is not None else self.controller.prn
+        self.notifications = 0
+
+    def set_prn(self, prn):
+        self.transport.request(OP_RECEIPT_NOTIF_SET, struct.pack('<H', prn))
+        self.prn = prn
+
+    def crc_get(self):
+        return struct.unpack('<II', self.transport.request(OP_CRC_GET)[:8])
+
+    def wait_notification(self, offset, crc):
+        dev_offset, dev_crc = struct.unpack('<II', self.transport.receive(OP_CRC_GET)[:8])
+        if (dev_offset, dev_crc) != (offset, crc):
+            raise DfuError('crc mismatch at offset %d' % offset)
+        self.notifications += 1
+        if self.controller is not None:
+            prn = self.controller.update(self.transport.status)
+            if prn != self.prn:
+                self.set_prn(prn)
+
+    def usb_stats(self):
+        raw = self.transport.request(OP_USB_STATS)
+        size = struct.calcsize(EP_STATS_FORMAT)
+        return struct.unpack(EP_STATS_FORMAT, raw[:size]), struct.unpack(EP_STATS_FORMAT, raw[size:2 * size])
+
+    def boot_probes(self):
+        raw = self.transport.request(OP_BOOT_PROBES)
+        size = struct.calcsize(PROBE_FORMAT)
+        return [struct.unpack_from(PROBE_FORMAT, raw, offset) for offset in range(0, len(raw) - size + 1, size)]
+
+    def send_object(self, obj_type, data, offset, crc, chunk_size, last=False):
+        self.transport.request(OP_OBJECT_CREATE, struct.pack('<BI', obj_type, len(data)))
+        writes = 0
+        for start in range(0, len(data), chunk_size):
+            chunk = data[start:start + chunk_size]
+            self.transport.send(OP_OBJECT_WRITE, chunk)
+            offset += len(chunk)
+            crc = zlib.crc32(chunk, crc) & 0xFFFFFFFF
+            writes += 1
+            if self.prn and writes % self.prn == 0:
+                self.wait_notification(offset, crc)
+                writes = 0
+
+        dev_offset, dev_crc = self.crc_get()
+        if (dev_offset, dev_crc) != (offset, crc):
+            raise DfuError('crc mismatch after object at offset %d' % offset)
+        # executing the last object starts the new image, ask before that
+        if last and self.want_stats:
+            self.stats = self.usb_stats()
+        if last and self.want_probes:
+            self.probes = self.boot_probes()
+        self.transport.request(OP_OBJECT_EXECUTE)
+        return offset, crc
+
+    def run(self, init_packet, firmware):
+        self.set_prn(self.prn)
+        mtu = struct.unpack('<H', self.transport.request(OP_MTU_GET)[:2])[0]
+        # largest power of two that fits, keeps writes word aligned and dividing the object size
+        chunk_size = 1 << ((mtu - 1).bit_length() - 1)
+
+        self.transport.request(OP_OBJECT_SELECT, bytes([OBJ_COMMAND]))
+        self.send_object(OBJ_COMMAND, init_packet, 0, 0, chunk_size)
+
+        max_size = struct.unpack('<III', self.transport.request(OP_OBJECT_SELECT, bytes([OBJ_DATA]))[:12])[0]
+        offset, crc = 0, 0
+        started = self.clock()
+        for start in range(0, len(firmware), max_size):
+            last = start + max_size >= len(firmware)
+            offset, crc = self.send_object(OBJ_DATA, firmware[start:start + max_size], offset, crc, chunk_size, last)
+        return self.clock() - started
+
+
+def benchmark(init_packet, firmware, prns=(None, 1, 2, 4, 8, 16, 0), **device):
+    """Replays a package against SimulatedTransport with the adaptive and fixed PRN intervals.
+
+    Returns (prn, seconds, notifications, final prn) per interval, None is the adaptive one.
+    """
+    results = []
+    for prn in prns:
+        transport = SimulatedTransport(**device)
+        dfu = Dfu(transport, prn, clock=transport.clock)
+        elapsed = dfu.run(init_packet, firmware)
+        results.append((prn, elapsed, dfu.notifications, dfu.prn))
+    return results
+
+
+def read_package(path):
+    with zipfile.ZipFile(path) as package:
+        manifest = json.loads(package.read('manifest.json'))['manifest']
+        if len(manifest) != 1:
+            sys.exit('error: packages with more than one image are not supported')
+        image = next(iter(manifest.values()))
+        return package.read(image['dat_file']), package.read(image['bin_file'])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('package', help='DFU package created with nrfutil pkg generate')
+    parser.add_argument('--prn', type=int, help='fixed PRN interval instead of adapting it, 0 disables PRN')
+    parser.add_argument('--stats', action='store_true', help='print the bulk endpoint statistics of the device')
+    parser.add_argument('--probes', action='store_true', help='print the boot probes of a debug build of the device')
+    parser.add_argument('--benchmark', action='store_true',
+                        help='replay the package against a model of the device with adaptive and fixed PRN')
+    parser.add_argument('--turnaround', type=float, default=1.0, help='response turnaround of the model in ms')
+    parser.add_argument('--stall', action='store_true',
+                        help='model the USB interrupt running from flash, halted during page erases')
+    parser.add_argument('--vid', type=lambda v: int(v, 0))
+    parser.add_argument('--pid', type=lambda v: int(v, 0))
+    args = parser.parse_args()
+
+    init_packet, firmware = read_package(args.package)
+
+    if args.benchmark:
+        for prn, elapsed, notifications, final in benchmark(init_packet, firmware, turnaround_us=args.turnaround * 1000,
+                                                                 stall=args.stall):
+            print('%-8s %8.2f s %7.1f kB/s %6d notifications, final PRN %d' %
+                  ('adaptive' if prn is None else 'PRN %d' % prn, elapsed, len(firmware) / elapsed / 1024,
+                   notifications, final))
+        return
+
+    try:
+        dfu = Dfu(BulkTransport(args.vid, args.pid), args.prn, args.stats, args.probes)
+        elapsed = dfu.run(init_packet, firmware)
+    except DfuError as e:
+        sys.exit('error: %s' % e)
+
+    print('%d bytes in %.2f s (%.1f kB/s), %d notifications, final PRN %d' %
+          (len(firmware), elapsed, len(firmware) / elapsed / 1024, dfu.notifications, dfu.prn))
+
+    if dfu.stats:
+        for name, (transfers, size, avg, peak) in zip(('OUT', 'IN'), dfu.stats):
+            print('bulk %-3s %6d transfers %8d bytes %8d cycles avg %8d max' % (name, transfers, size, avg, peak))
+
+    if dfu.probes:
+        for index, (count, low, high, avg) in enumerate(dfu.probes):
+            name = PROBE_NAMES[index] if index < len(PROBE_NAMES) else 'probe %d' % index
+            print('%-16s %6d runs %10d min %10d avg %10d max cycles' % (name, count, low, avg, high))
+
+
+if __name__ == '__main__':
+    main()